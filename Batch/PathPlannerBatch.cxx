@@ -0,0 +1,497 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Plan the paths of one case without the Slicer GUI: load the entry and
+// target points from point files or from the annotation hierarchies of a
+// scene (the entry points may also be sampled on a skin model or CT of the
+// scene), evaluate every entry x target path with vtkSlicerPathPlannerLogic
+// and write the feasible ones, shortest first (or the cheapest ones of
+// each target), to a CSV path table, with
+// the labels of a labelmap of the scene that each path crosses and its
+// distance to surface models of the scene.
+// A tracker recording may then be replayed against one of the planned
+// paths, through the same pose filter and deviation computation as the
+// panel, to benchmark their latency and write the deviation of each sample.
+
+// PathPlanner Logic includes
+#include "vtkSlicerPathPlannerDeviation.h"
+#include "vtkSlicerPathPlannerLogic.h"
+#include "vtkSlicerPathPlannerPathStore.h"
+#include "vtkSlicerPathPlannerPointStore.h"
+#include "vtkSlicerPathPlannerPoseFilter.h"
+#include "vtkSlicerPathPlannerTrackerBuffer.h"
+#include "vtkSlicerPathPlannerTrackerRecording.h"
+#include "vtkSlicerPathPlannerTrackerReplay.h"
+
+// MRML includes
+#include <vtkMRMLAnnotationFiducialNode.h>
+#include <vtkMRMLAnnotationHierarchyNode.h>
+#include <vtkMRMLAnnotationLineDisplayNode.h>
+#include <vtkMRMLAnnotationPointDisplayNode.h>
+#include <vtkMRMLAnnotationRulerNode.h>
+#include <vtkMRMLAnnotationTextDisplayNode.h>
+#include <vtkMRMLLabelMapVolumeDisplayNode.h>
+#include <vtkMRMLModelDisplayNode.h>
+#include <vtkMRMLModelNode.h>
+#include <vtkMRMLModelStorageNode.h>
+#include <vtkMRMLScalarVolumeNode.h>
+#include <vtkMRMLScene.h>
+#include <vtkMRMLVolumeArchetypeStorageNode.h>
+
+// VTK includes
+#include <vtkCollection.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+void printUsage(const char* program)
+{
+  std::cerr
+    << "Usage: " << program << " [options] --output paths.csv\n"
+    << "  --entries <file>        entry points (name,R,A,S per line; .csv or .fcsv)\n"
+    << "  --targets <file>        target points (same format)\n"
+    << "  --scene <file.mrml>     read the points from the annotation hierarchies\n"
+    << "                          of a scene instead\n"
+    << "  --entry-list <name>     entry point hierarchy of the scene (default EntryPoint)\n"
+    << "  --target-list <name>    target point hierarchy of the scene (default TargetPoint)\n"
+    << "  --labelmap <name>       labelmap volume of the scene to check the paths against\n"
+    << "  --model <name>          model of the scene to check the paths against\n"
+    << "                          (may be repeated)\n"
+    << "  --skin <name>           model or CT volume of the scene to sample entry\n"
+    << "                          points on (the entry hierarchy is then optional)\n"
+    << "  --skin-threshold <HU>   skin threshold of a CT volume (default -300)\n"
+    << "  --skin-spacing <mm>     distance between the skin samples (default 5)\n"
+    << "  --max-length <mm>       longest feasible path (default: no limit)\n"
+    << "  --max-angle <degrees>   largest feasible insertion angle (default 180)\n"
+    << "  --reference <R> <A> <S> direction of the insertion angle (default 0 0 1)\n"
+    << "  --best <count>          keep only the cheapest paths of each target\n"
+    << "  --output <file>         path table to write\n"
+    << "  --replay <file>         tracker recording to replay against a planned path\n"
+    << "  --replay-speed <factor> 1 for real time (default), 0 for as fast as possible\n"
+    << "  --planned-path <row>    row of the path table the needle follows (default 0)\n"
+    << "  --latency <ms>          tracking latency the pose filter compensates (default 0)\n"
+    << "  --deviations <file>     deviation of each replayed sample to write (CSV)\n";
+}
+
+//-----------------------------------------------------------------------------
+// First annotation hierarchy of the scene whose name starts with name:
+// the panel makes the names of its lists unique (e.g. EntryPoint_1).
+vtkMRMLAnnotationHierarchyNode* findHierarchy(vtkMRMLScene* scene, const char* name)
+{
+  int nNodes = scene->GetNumberOfNodesByClass("vtkMRMLAnnotationHierarchyNode");
+  for (int i = 0; i < nNodes; i ++)
+    {
+    vtkMRMLAnnotationHierarchyNode* hnode = vtkMRMLAnnotationHierarchyNode::SafeDownCast(
+      scene->GetNthNodeByClass(i, "vtkMRMLAnnotationHierarchyNode"));
+    if (hnode && hnode->GetName() &&
+        strncmp(hnode->GetName(), name, strlen(name)) == 0)
+      {
+      return hnode;
+      }
+    }
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+bool readScene(vtkSlicerPathPlannerLogic* logic, const char* fileName,
+               const char* entryList, const char* targetList, const char* labelMap,
+               const std::vector<const char*>& models, const char* skin,
+               double skinThreshold, double skinSpacing)
+{
+  vtkNew<vtkMRMLScene> scene;
+  scene->RegisterNodeClass(vtkSmartPointer<vtkMRMLAnnotationHierarchyNode>::New());
+  scene->RegisterNodeClass(vtkSmartPointer<vtkMRMLAnnotationFiducialNode>::New());
+  scene->RegisterNodeClass(vtkSmartPointer<vtkMRMLAnnotationRulerNode>::New());
+  scene->RegisterNodeClass(vtkSmartPointer<vtkMRMLAnnotationPointDisplayNode>::New());
+  scene->RegisterNodeClass(vtkSmartPointer<vtkMRMLAnnotationLineDisplayNode>::New());
+  scene->RegisterNodeClass(vtkSmartPointer<vtkMRMLAnnotationTextDisplayNode>::New());
+  scene->RegisterNodeClass(vtkSmartPointer<vtkMRMLScalarVolumeNode>::New());
+  scene->RegisterNodeClass(vtkSmartPointer<vtkMRMLLabelMapVolumeDisplayNode>::New());
+  scene->RegisterNodeClass(vtkSmartPointer<vtkMRMLVolumeArchetypeStorageNode>::New());
+  scene->RegisterNodeClass(vtkSmartPointer<vtkMRMLModelNode>::New());
+  scene->RegisterNodeClass(vtkSmartPointer<vtkMRMLModelDisplayNode>::New());
+  scene->RegisterNodeClass(vtkSmartPointer<vtkMRMLModelStorageNode>::New());
+  scene->SetURL(fileName);
+  if (!scene->Connect())
+    {
+    std::cerr << "Cannot read scene " << fileName << std::endl;
+    return false;
+    }
+
+  vtkMRMLAnnotationHierarchyNode* entries = findHierarchy(scene.GetPointer(), entryList);
+  vtkMRMLAnnotationHierarchyNode* targets = findHierarchy(scene.GetPointer(), targetList);
+  if ((!entries && !skin) || !targets)
+    {
+    std::cerr << "No " << (targets ? entryList : targetList)
+              << " annotation hierarchy in " << fileName << std::endl;
+    return false;
+    }
+  if (entries)
+    {
+    logic->ImportPoints(entries, logic->GetEntryPoints());
+    }
+  logic->ImportPoints(targets, logic->GetTargetPoints());
+
+  if (skin)
+    {
+    vtkSmartPointer<vtkCollection> skinNodes;
+    skinNodes.TakeReference(scene->GetNodesByName(skin));
+    vtkIdType nSamples = 0;
+    for (int i = 0; i < skinNodes->GetNumberOfItems() && nSamples == 0; i ++)
+      {
+      vtkObject* node = skinNodes->GetItemAsObject(i);
+      if (vtkMRMLModelNode::SafeDownCast(node))
+        {
+        nSamples = logic->SampleSkinModelNode(vtkMRMLModelNode::SafeDownCast(node),
+                                              skinSpacing);
+        }
+      else if (vtkMRMLScalarVolumeNode::SafeDownCast(node))
+        {
+        nSamples = logic->SampleSkinVolumeNode(vtkMRMLScalarVolumeNode::SafeDownCast(node),
+                                               skinThreshold, skinSpacing);
+        }
+      }
+    if (nSamples == 0)
+      {
+      std::cerr << "No skin sampled on " << skin << " in " << fileName << std::endl;
+      return false;
+      }
+    }
+
+  if (labelMap)
+    {
+    // The logic keeps a reference to the image data of the volume
+    vtkSmartPointer<vtkCollection> volumes;
+    volumes.TakeReference(scene->GetNodesByClassByName("vtkMRMLScalarVolumeNode", labelMap));
+    vtkMRMLScalarVolumeNode* volume = vtkMRMLScalarVolumeNode::SafeDownCast(
+      volumes->GetItemAsObject(0));
+    if (!volume || !volume->GetImageData())
+      {
+      std::cerr << "No " << labelMap << " volume in " << fileName << std::endl;
+      return false;
+      }
+    logic->SetLabelMapVolumeNode(volume);
+    }
+
+  for (size_t i = 0; i < models.size(); i ++)
+    {
+    // The logic keeps a reference to the polydata of the model
+    vtkSmartPointer<vtkCollection> modelNodes;
+    modelNodes.TakeReference(scene->GetNodesByClassByName("vtkMRMLModelNode", models[i]));
+    vtkMRMLModelNode* model = vtkMRMLModelNode::SafeDownCast(
+      modelNodes->GetItemAsObject(0));
+    if (logic->AddSurfaceModelNode(model) < 0)
+      {
+      std::cerr << "No " << models[i] << " model in " << fileName << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+// Replay a tracker recording against the path at plannedRow: the samples go
+// through the tracker buffer, the pose filter of the logic and the deviation
+// one by one, in order. The recorded times are kept, so that the deviations
+// do not depend on the replay speed nor on the load of the machine. Print
+// the latency of the pipeline: from the time each sample is due to its
+// deviation in real time or accelerated replays, the processing time of
+// each sample when replaying as fast as possible.
+bool replayTracker(vtkSlicerPathPlannerLogic* logic, const char* fileName, double speed,
+                   vtkIdType plannedRow, const char* deviationsFile)
+{
+  vtkNew<vtkSlicerPathPlannerTrackerRecording> recording;
+  if (!recording->Open(fileName) || recording->GetNumberOfSamples() == 0)
+    {
+    std::cerr << "Cannot replay " << fileName << std::endl;
+    return false;
+    }
+  vtkSlicerPathPlannerPathStore* paths = logic->GetPaths();
+  if (plannedRow < 0 || plannedRow >= paths->GetNumberOfPaths())
+    {
+    std::cerr << "No path " << plannedRow << " to replay " << fileName
+              << " against" << std::endl;
+    return false;
+    }
+
+  std::ofstream deviations;
+  if (deviationsFile)
+    {
+    deviations.open(deviationsFile);
+    if (!deviations)
+      {
+      std::cerr << "Cannot write " << deviationsFile << std::endl;
+      return false;
+      }
+    deviations << "Time,TipDistance,AngularDeviation,RemainingDepth,NearestPath,NearestPathDistance\n";
+    }
+
+  vtkNew<vtkSlicerPathPlannerTrackerBuffer> buffer;
+  vtkNew<vtkSlicerPathPlannerTrackerReplay> replay;
+  replay->SetRecording(recording.GetPointer());
+  replay->SetBuffer(buffer.GetPointer());
+  replay->SetSpeed(speed);
+  replay->RebaseTimeOff();
+  vtkNew<vtkSlicerPathPlannerDeviation> deviation;
+  deviation->SetPaths(paths);
+  deviation->SetPlannedPathId(paths->GetId(plannedRow));
+  vtkSlicerPathPlannerPoseFilter* filter = logic->GetPoseFilter();
+  filter->Reset();
+
+  vtkIdType nSamples = recording->GetNumberOfSamples();
+  std::vector<double> latencies;
+  latencies.reserve(nSamples);
+  double start = vtkSlicerPathPlannerTrackerBuffer::GetTime();
+  replay->Start();
+  vtkSlicerPathPlannerTrackerBuffer::Sample sample;
+  double pose[16];
+  // the replay stops running after its last push
+  while (replay->IsRunning() || buffer->GetNumberOfSamples() > 0)
+    {
+    if (!buffer->Pop(sample))
+      {
+      std::this_thread::yield();
+      continue;
+      }
+    double popped = vtkSlicerPathPlannerTrackerBuffer::GetTime();
+    filter->AddSample(sample.Time, sample.Matrix);
+    filter->Predict(sample.Time, pose);
+    deviation->Update(pose);
+    double done = vtkSlicerPathPlannerTrackerBuffer::GetTime();
+    vtkIdType index = static_cast<vtkIdType>(latencies.size());
+    latencies.push_back(done - ((speed > 0.0) ? replay->GetScheduledTime(index) : popped));
+
+    if (deviationsFile)
+      {
+      vtkIdType nearest = paths->GetIndex(deviation->GetNearestPathId());
+      deviations << sample.Time << "," << deviation->GetTipDistance() << ","
+                 << deviation->GetAngularDeviation() << ","
+                 << deviation->GetRemainingDepth() << ","
+                 << (nearest >= 0 ? paths->GetName(nearest) : "") << ","
+                 << deviation->GetNearestPathDistance() << "\n";
+      }
+    }
+  replay->Wait();
+  double elapsed = vtkSlicerPathPlannerTrackerBuffer::GetTime() - start;
+
+  std::vector<double> sorted(latencies);
+  std::sort(sorted.begin(), sorted.end());
+  double total = 0.0;
+  for (size_t i = 0; i < sorted.size(); i ++)
+    {
+    total += sorted[i];
+    }
+  size_t n = sorted.size();
+  std::cout << n << " tracker samples (" << recording->GetDuration() << " s) replayed in "
+            << elapsed << " s, " << (elapsed > 0.0 ? n / elapsed : 0.0) << " samples/s\n"
+            << ((speed > 0.0) ? "latency" : "processing time") << " (ms): mean "
+            << 1000.0 * total / n
+            << ", median " << 1000.0 * sorted[n / 2]
+            << ", 99th percentile " << 1000.0 * sorted[std::min(n - 1, (n * 99) / 100)]
+            << ", max " << 1000.0 * sorted[n - 1] << std::endl;
+  return true;
+}
+
+}
+
+//-----------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  const char* entriesFile = 0;
+  const char* targetsFile = 0;
+  const char* sceneFile = 0;
+  const char* entryList = "EntryPoint";
+  const char* targetList = "TargetPoint";
+  const char* labelMap = 0;
+  std::vector<const char*> models;
+  const char* skin = 0;
+  double skinThreshold = -300.0;
+  double skinSpacing = 5.0;
+  const char* outputFile = 0;
+  int pathsPerTarget = 0;
+  const char* replayFile = 0;
+  double replaySpeed = 1.0;
+  vtkIdType plannedRow = 0;
+  const char* deviationsFile = 0;
+
+  vtkNew<vtkSlicerPathPlannerLogic> logic;
+
+  for (int i = 1; i < argc; i ++)
+    {
+    std::string option(argv[i]);
+    bool hasValue = (i + 1 < argc);
+    if (option == "--entries" && hasValue)
+      {
+      entriesFile = argv[++i];
+      }
+    else if (option == "--targets" && hasValue)
+      {
+      targetsFile = argv[++i];
+      }
+    else if (option == "--scene" && hasValue)
+      {
+      sceneFile = argv[++i];
+      }
+    else if (option == "--entry-list" && hasValue)
+      {
+      entryList = argv[++i];
+      }
+    else if (option == "--target-list" && hasValue)
+      {
+      targetList = argv[++i];
+      }
+    else if (option == "--labelmap" && hasValue)
+      {
+      labelMap = argv[++i];
+      }
+    else if (option == "--model" && hasValue)
+      {
+      models.push_back(argv[++i]);
+      }
+    else if (option == "--skin" && hasValue)
+      {
+      skin = argv[++i];
+      }
+    else if (option == "--skin-threshold" && hasValue)
+      {
+      skinThreshold = atof(argv[++i]);
+      }
+    else if (option == "--skin-spacing" && hasValue)
+      {
+      skinSpacing = atof(argv[++i]);
+      }
+    else if (option == "--max-length" && hasValue)
+      {
+      logic->SetMaximumPathLength(atof(argv[++i]));
+      }
+    else if (option == "--max-angle" && hasValue)
+      {
+      logic->SetMaximumInsertionAngle(atof(argv[++i]));
+      }
+    else if (option == "--reference" && i + 3 < argc)
+      {
+      logic->SetReferenceDirection(atof(argv[i+1]), atof(argv[i+2]), atof(argv[i+3]));
+      i += 3;
+      }
+    else if (option == "--best" && hasValue)
+      {
+      pathsPerTarget = atoi(argv[++i]);
+      }
+    else if (option == "--output" && hasValue)
+      {
+      outputFile = argv[++i];
+      }
+    else if (option == "--replay" && hasValue)
+      {
+      replayFile = argv[++i];
+      }
+    else if (option == "--replay-speed" && hasValue)
+      {
+      replaySpeed = std::max(0.0, atof(argv[++i]));
+      }
+    else if (option == "--planned-path" && hasValue)
+      {
+      plannedRow = atoi(argv[++i]);
+      }
+    else if (option == "--latency" && hasValue)
+      {
+      logic->GetPoseFilter()->SetLatency(atof(argv[++i]) / 1000.0);
+      }
+    else if (option == "--deviations" && hasValue)
+      {
+      deviationsFile = argv[++i];
+      }
+    else
+      {
+      printUsage(argv[0]);
+      return EXIT_FAILURE;
+      }
+    }
+
+  if (!outputFile || (!sceneFile && (!entriesFile || !targetsFile)) ||
+      ((labelMap || !models.empty() || skin) && !sceneFile) ||
+      (deviationsFile && !replayFile))
+    {
+    printUsage(argv[0]);
+    return EXIT_FAILURE;
+    }
+
+  if (sceneFile)
+    {
+    if (!readScene(logic.GetPointer(), sceneFile, entryList, targetList, labelMap, models,
+                   skin, skinThreshold, skinSpacing))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+  else if (logic->ReadPoints(entriesFile, logic->GetEntryPoints()) < 0 ||
+           logic->ReadPoints(targetsFile, logic->GetTargetPoints()) < 0)
+    {
+    return EXIT_FAILURE;
+    }
+
+  vtkIdType nPaths = (pathsPerTarget > 0) ?
+    logic->GenerateBestPaths(pathsPerTarget) : logic->GenerateAllPaths();
+  if (!logic->WritePaths(outputFile))
+    {
+    std::cerr << "Cannot write " << outputFile << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << logic->GetEntryPoints()->GetNumberOfPoints() << " entry points, "
+            << logic->GetTargetPoints()->GetNumberOfPoints() << " target points, "
+            << nPaths << " feasible paths written to " << outputFile << std::endl;
+  if (labelMap)
+    {
+    vtkIdType nColliding = 0;
+    for (vtkIdType i = 0; i < nPaths; i ++)
+      {
+      nColliding += (logic->GetPaths()->GetNumberOfHits(i) > 0) ? 1 : 0;
+      }
+    std::cout << nColliding << " of them cross " << labelMap << std::endl;
+    }
+  for (int model = 0; model < logic->GetNumberOfSurfaceModels(); model ++)
+    {
+    vtkIdType nCrossing = 0;
+    for (vtkIdType i = 0; i < nPaths; i ++)
+      {
+      nCrossing += (logic->GetPaths()->GetModelDistance(i, model) == 0.0) ? 1 : 0;
+      }
+    std::cout << nCrossing << " of them cross " << logic->GetSurfaceModelName(model)
+              << std::endl;
+    }
+
+  if (replayFile &&
+      !replayTracker(logic.GetPointer(), replayFile, replaySpeed, plannedRow, deviationsFile))
+    {
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,160 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner Logic includes
+#include "vtkSlicerPathPlannerDeviation.h"
+#include "vtkSlicerPathPlannerPathStore.h"
+
+// VTK includes
+#include <vtkMath.h>
+#include <vtkObjectFactory.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerPathPlannerDeviation);
+vtkCxxSetObjectMacro(vtkSlicerPathPlannerDeviation, Paths, vtkSlicerPathPlannerPathStore);
+
+//----------------------------------------------------------------------------
+namespace
+{
+// Squared distance from position to the line through point along the unit
+// vector direction, and signed position of the projection on the line
+inline double LineDistance2(const double position[3], const double* point,
+                            const double* direction, double* projection)
+{
+  double v[3] = { position[0] - point[0], position[1] - point[1], position[2] - point[2] };
+  double t = v[0] * direction[0] + v[1] * direction[1] + v[2] * direction[2];
+  *projection = t;
+  return std::max(0.0, v[0] * v[0] + v[1] * v[1] + v[2] * v[2] - t * t);
+}
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerDeviation::vtkSlicerPathPlannerDeviation()
+{
+  this->Paths = 0;
+  this->PlannedPathId = -1;
+  this->NeedleAxis[0] = 0.0;
+  this->NeedleAxis[1] = 0.0;
+  this->NeedleAxis[2] = 1.0;
+  this->TipPosition[0] = this->TipPosition[1] = this->TipPosition[2] = 0.0;
+  this->NeedleDirection[0] = this->NeedleDirection[1] = 0.0;
+  this->NeedleDirection[2] = 1.0;
+  this->TipDistance = VTK_DOUBLE_MAX;
+  this->AngularDeviation = VTK_DOUBLE_MAX;
+  this->RemainingDepth = VTK_DOUBLE_MAX;
+  this->NearestPathId = -1;
+  this->NearestPathDistance = VTK_DOUBLE_MAX;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerDeviation::~vtkSlicerPathPlannerDeviation()
+{
+  this->SetPaths(0);
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerDeviation::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "Paths: " << this->Paths << "\n";
+  os << indent << "PlannedPathId: " << this->PlannedPathId << "\n";
+  os << indent << "NeedleAxis: (" << this->NeedleAxis[0] << ", "
+     << this->NeedleAxis[1] << ", " << this->NeedleAxis[2] << ")\n";
+  os << indent << "TipDistance: " << this->TipDistance << "\n";
+  os << indent << "AngularDeviation: " << this->AngularDeviation << "\n";
+  os << indent << "RemainingDepth: " << this->RemainingDepth << "\n";
+  os << indent << "NearestPathId: " << this->NearestPathId << "\n";
+  os << indent << "NearestPathDistance: " << this->NearestPathDistance << "\n";
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerPathPlannerDeviation::Update(const double needleToRAS[16])
+{
+  this->TipDistance = VTK_DOUBLE_MAX;
+  this->AngularDeviation = VTK_DOUBLE_MAX;
+  this->RemainingDepth = VTK_DOUBLE_MAX;
+  this->NearestPathId = -1;
+  this->NearestPathDistance = VTK_DOUBLE_MAX;
+
+  // Tip and insertion direction of the needle
+  double axis[3] = { this->NeedleAxis[0], this->NeedleAxis[1], this->NeedleAxis[2] };
+  vtkMath::Normalize(axis);
+  for (int i = 0; i < 3; i ++)
+    {
+    this->TipPosition[i] = needleToRAS[4 * i + 3];
+    this->NeedleDirection[i] = needleToRAS[4 * i] * axis[0] +
+      needleToRAS[4 * i + 1] * axis[1] + needleToRAS[4 * i + 2] * axis[2];
+    }
+  vtkMath::Normalize(this->NeedleDirection);
+
+  if (!this->Paths)
+    {
+    return false;
+    }
+  vtkIdType nPaths = this->Paths->GetNumberOfPaths();
+  if (nPaths == 0)
+    {
+    return false;
+    }
+  const double* entries = this->Paths->GetEntryPositions();
+  const double* directions = this->Paths->GetDirections();
+  const double* lengths = this->Paths->GetLengths();
+
+  // Nearest path other than the planned one, by a scan of the packed
+  // arrays: a few thousand paths take a few microseconds
+  vtkIdType plannedIndex = this->Paths->GetIndex(this->PlannedPathId);
+  vtkIdType nearestIndex = -1;
+  double nearestDistance2 = VTK_DOUBLE_MAX;
+  for (vtkIdType i = 0; i < nPaths; i ++)
+    {
+    if (i == plannedIndex || lengths[i] <= 0.0)
+      {
+      continue;
+      }
+    double t;
+    double distance2 = LineDistance2(this->TipPosition, entries + 3 * i, directions + 3 * i, &t);
+    if (distance2 < nearestDistance2)
+      {
+      nearestDistance2 = distance2;
+      nearestIndex = i;
+      }
+    }
+  if (nearestIndex >= 0)
+    {
+    this->NearestPathId = this->Paths->GetId(nearestIndex);
+    this->NearestPathDistance = sqrt(nearestDistance2);
+    }
+
+  if (plannedIndex < 0 || lengths[plannedIndex] <= 0.0)
+    {
+    return false;
+    }
+  const double* direction = directions + 3 * plannedIndex;
+  double t;
+  this->TipDistance = sqrt(LineDistance2(this->TipPosition, entries + 3 * plannedIndex,
+                                         direction, &t));
+  this->RemainingDepth = lengths[plannedIndex] - t;
+  double cosine = vtkMath::Dot(this->NeedleDirection, direction);
+  cosine = std::min(1.0, std::max(-1.0, cosine));
+  this->AngularDeviation = vtkMath::DegreesFromRadians(acos(cosine));
+  return true;
+}
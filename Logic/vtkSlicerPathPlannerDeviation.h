@@ -0,0 +1,106 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkSlicerPathPlannerDeviation - deviation of a tracked needle from the plan
+// .SECTION Description
+// Compares the pose of a tracked needle with the paths of a
+// vtkSlicerPathPlannerPathStore: distance from the needle tip to the line
+// of the planned path, angle between the needle and the path, depth left
+// to the target along the path, and the other path whose line is the
+// closest to the tip. The needle pose is a 4x4 matrix whose translation is
+// the tip and which maps NeedleAxis to the insertion direction.
+// Update() only reads the packed arrays of the path store and allocates
+// nothing, so it can run on every tracker sample. The geometry of the paths
+// must be up to date (see vtkSlicerPathPlannerLogic::UpdatePathGeometry()).
+
+#ifndef __vtkSlicerPathPlannerDeviation_h
+#define __vtkSlicerPathPlannerDeviation_h
+
+// VTK includes
+#include <vtkObject.h>
+
+#include "vtkSlicerPathPlannerModuleLogicExport.h"
+
+class vtkSlicerPathPlannerPathStore;
+
+/// \ingroup Slicer_QtModules_PathPlanner
+class VTK_SLICER_PATHPLANNER_MODULE_LOGIC_EXPORT vtkSlicerPathPlannerDeviation :
+  public vtkObject
+{
+public:
+
+  static vtkSlicerPathPlannerDeviation *New();
+  vtkTypeMacro(vtkSlicerPathPlannerDeviation, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Paths the needle is compared with
+  virtual void SetPaths(vtkSlicerPathPlannerPathStore* paths);
+  vtkGetObjectMacro(Paths, vtkSlicerPathPlannerPathStore);
+
+  /// ID of the planned path in Paths, -1 for none
+  vtkSetMacro(PlannedPathId, vtkIdType);
+  vtkGetMacro(PlannedPathId, vtkIdType);
+
+  /// Direction of insertion of the needle in the coordinates of the tracked
+  /// tool, (0, 0, 1) by default. It is normalized by Update().
+  vtkSetVector3Macro(NeedleAxis, double);
+  vtkGetVector3Macro(NeedleAxis, double);
+
+  /// Compute the deviation metrics of the needle pose given by the 16
+  /// row-major elements of a 4x4 matrix (e.g. vtkMatrix4x4::Element[0]).
+  /// Return false if there is no valid planned path, in which case only
+  /// the nearest path is computed.
+  bool Update(const double needleToRAS[16]);
+
+  /// Tip and unit insertion direction of the needle of the last Update()
+  vtkGetVector3Macro(TipPosition, double);
+  vtkGetVector3Macro(NeedleDirection, double);
+
+  /// Distance in mm from the tip to the line of the planned path
+  vtkGetMacro(TipDistance, double);
+  /// Angle in degrees between the needle and the planned path
+  vtkGetMacro(AngularDeviation, double);
+  /// Depth in mm from the tip to the target along the planned path,
+  /// negative once the tip is past the target
+  vtkGetMacro(RemainingDepth, double);
+  /// ID of the path, other than the planned one, whose line is the closest
+  /// to the tip (-1 if there is none) and distance in mm from the tip
+  vtkGetMacro(NearestPathId, vtkIdType);
+  vtkGetMacro(NearestPathDistance, double);
+
+protected:
+  vtkSlicerPathPlannerDeviation();
+  virtual ~vtkSlicerPathPlannerDeviation();
+
+  vtkSlicerPathPlannerPathStore* Paths;
+  vtkIdType PlannedPathId;
+  double NeedleAxis[3];
+
+  double TipPosition[3];
+  double NeedleDirection[3];
+  double TipDistance;
+  double AngularDeviation;
+  double RemainingDepth;
+  vtkIdType NearestPathId;
+  double NearestPathDistance;
+
+private:
+  vtkSlicerPathPlannerDeviation(const vtkSlicerPathPlannerDeviation&); // Not implemented
+  void operator=(const vtkSlicerPathPlannerDeviation&);              // Not implemented
+};
+
+#endif
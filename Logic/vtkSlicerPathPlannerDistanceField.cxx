@@ -0,0 +1,359 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner Logic includes
+#include "vtkSlicerPathPlannerDistanceField.h"
+#include "vtkSlicerPathPlannerParallel.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkObjectFactory.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerPathPlannerDistanceField);
+
+//----------------------------------------------------------------------------
+namespace
+{
+// Squared distance of the voxels that have no feature voxel on their line yet
+const float Infinity = std::numeric_limits<float>::max();
+
+//----------------------------------------------------------------------------
+// Feature voxels of the outside (structure voxels) and inside (background
+// voxels) transforms. Return the number of structure voxels.
+template <class T>
+vtkIdType InitializeFeatures(const T* labels, vtkIdType numberOfVoxels,
+                             float* outside, float* inside)
+{
+  vtkIdType nStructure = 0;
+  for (vtkIdType i = 0; i < numberOfVoxels; i ++)
+    {
+    bool structure = (labels[i] != 0);
+    outside[i] = structure ? 0.0f : Infinity;
+    inside[i] = structure ? Infinity : 0.0f;
+    nStructure += structure ? 1 : 0;
+    }
+  return nStructure;
+}
+
+//----------------------------------------------------------------------------
+// One pass of the separable transform: replace the squared distances of
+// each line along Axis by min_q (Weight * (p - q)^2 + f(q)).
+class TransformPass : public vtkSlicerPathPlannerParallel::Functor
+{
+public:
+  float* Data;
+  int Dimensions[3];
+  int Axis;
+  double Weight;
+
+  vtkIdType GetNumberOfLines() const
+  {
+    return static_cast<vtkIdType>(this->Dimensions[0]) * this->Dimensions[1] *
+      this->Dimensions[2] / this->Dimensions[this->Axis];
+  }
+
+  virtual void operator()(vtkIdType begin, vtkIdType end)
+  {
+    int n = this->Dimensions[this->Axis];
+    vtkIdType sliceSize = static_cast<vtkIdType>(this->Dimensions[0]) * this->Dimensions[1];
+    vtkIdType stride = (this->Axis == 0) ? 1 : (this->Axis == 1) ? this->Dimensions[0] : sliceSize;
+
+    // Scratch buffers of the lower envelope, reused for the lines of the chunk
+    std::vector<double> f(n);
+    std::vector<int> v(n);
+    std::vector<double> z(n + 1);
+
+    for (vtkIdType line = begin; line < end; line ++)
+      {
+      vtkIdType origin;
+      switch (this->Axis)
+        {
+        case 0:
+          origin = line * this->Dimensions[0];
+          break;
+        case 1:
+          origin = line % this->Dimensions[0] + (line / this->Dimensions[0]) * sliceSize;
+          break;
+        default:
+          origin = line;
+          break;
+        }
+      float* data = this->Data + origin;
+
+      // Lower envelope of the parabolas rooted at the finite samples
+      int k = -1;
+      for (int q = 0; q < n; q ++)
+        {
+        f[q] = data[q * stride];
+        if (data[q * stride] == Infinity)
+          {
+          continue;
+          }
+        double s = 0.0;
+        while (k >= 0)
+          {
+          int r = v[k];
+          s = ((f[q] + this->Weight * q * q) - (f[r] + this->Weight * r * r)) /
+            (2.0 * this->Weight * (q - r));
+          if (s > z[k])
+            {
+            break;
+            }
+          k --;
+          }
+        k ++;
+        v[k] = q;
+        z[k] = (k == 0) ? -std::numeric_limits<double>::max() : s;
+        z[k+1] = std::numeric_limits<double>::max();
+        }
+      if (k < 0)
+        {
+        // no feature on this line yet
+        continue;
+        }
+
+      k = 0;
+      for (int q = 0; q < n; q ++)
+        {
+        while (z[k+1] < q)
+          {
+          k ++;
+          }
+        double d = q - v[k];
+        data[q * stride] = static_cast<float>(this->Weight * d * d + f[v[k]]);
+        }
+      }
+  }
+};
+
+//----------------------------------------------------------------------------
+// Signed distance from the squared outside and inside distances
+class SignPass : public vtkSlicerPathPlannerParallel::Functor
+{
+public:
+  float* Outside;
+  const float* Inside;
+
+  virtual void operator()(vtkIdType begin, vtkIdType end)
+  {
+    for (vtkIdType i = begin; i < end; i ++)
+      {
+      this->Outside[i] = (this->Outside[i] > 0.0f) ?
+        sqrtf(this->Outside[i]) : -sqrtf(this->Inside[i]);
+      }
+  }
+};
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerDistanceField::vtkSlicerPathPlannerDistanceField()
+{
+  this->Dimensions[0] = this->Dimensions[1] = this->Dimensions[2] = 0;
+  this->Spacing[0] = this->Spacing[1] = this->Spacing[2] = 1.0;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerDistanceField::~vtkSlicerPathPlannerDistanceField()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerDistanceField::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "Dimensions: (" << this->Dimensions[0] << ", "
+     << this->Dimensions[1] << ", " << this->Dimensions[2] << ")\n";
+  os << indent << "Spacing: (" << this->Spacing[0] << ", "
+     << this->Spacing[1] << ", " << this->Spacing[2] << ")\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerDistanceField::Initialize()
+{
+  this->Dimensions[0] = this->Dimensions[1] = this->Dimensions[2] = 0;
+  // release the memory
+  std::vector<float>().swap(this->Values);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerDistanceField::Compute(vtkImageData* labelMap, const double spacing[3])
+{
+  this->Initialize();
+  if (!labelMap || labelMap->GetNumberOfScalarComponents() != 1 ||
+      !labelMap->GetScalarPointer())
+    {
+    return;
+    }
+  int dimensions[3];
+  labelMap->GetDimensions(dimensions);
+  vtkIdType nVoxels = static_cast<vtkIdType>(dimensions[0]) * dimensions[1] * dimensions[2];
+  if (nVoxels <= 0)
+    {
+    return;
+    }
+
+  // Squared distances to the nearest structure voxel (outside) and to the
+  // nearest background voxel (inside)
+  std::vector<float> outside(nVoxels);
+  std::vector<float> inside(nVoxels);
+  vtkIdType nStructure = 0;
+  switch (labelMap->GetScalarType())
+    {
+    vtkTemplateMacro(
+      nStructure = InitializeFeatures(static_cast<const VTK_TT*>(labelMap->GetScalarPointer()),
+                                      nVoxels, &outside[0], &inside[0]));
+    default:
+      vtkErrorMacro(<< "Compute: unsupported scalar type " << labelMap->GetScalarType());
+      return;
+    }
+  if (nStructure == 0)
+    {
+    return;
+    }
+
+  for (int axis = 0; axis < 3; axis ++)
+    {
+    TransformPass pass;
+    std::copy(dimensions, dimensions + 3, pass.Dimensions);
+    pass.Axis = axis;
+    pass.Weight = spacing[axis] * spacing[axis];
+    pass.Data = &outside[0];
+    vtkSlicerPathPlannerParallel::For(0, pass.GetNumberOfLines(), 64, pass);
+    pass.Data = &inside[0];
+    vtkSlicerPathPlannerParallel::For(0, pass.GetNumberOfLines(), 64, pass);
+    }
+
+  SignPass sign;
+  sign.Outside = &outside[0];
+  sign.Inside = &inside[0];
+  vtkSlicerPathPlannerParallel::For(0, nVoxels, 1 << 16, sign);
+
+  this->Values.swap(outside);
+  std::copy(dimensions, dimensions + 3, this->Dimensions);
+  std::copy(spacing, spacing + 3, this->Spacing);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerPathPlannerDistanceField::IsEmpty() const
+{
+  return this->Values.empty();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerDistanceField::GetDimensions(int dimensions[3]) const
+{
+  std::copy(this->Dimensions, this->Dimensions + 3, dimensions);
+}
+
+//----------------------------------------------------------------------------
+const float* vtkSlicerPathPlannerDistanceField::GetValues() const
+{
+  return this->Values.empty() ? 0 : &this->Values[0];
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerPathPlannerDistanceField::GetDistance(const double ijk[3]) const
+{
+  if (this->Values.empty())
+    {
+    return VTK_DOUBLE_MAX;
+    }
+
+  int lower[3];
+  int upper[3];
+  double weight[3];
+  for (int axis = 0; axis < 3; axis ++)
+    {
+    double c = std::min(std::max(ijk[axis], 0.0), this->Dimensions[axis] - 1.0);
+    lower[axis] = static_cast<int>(floor(c));
+    upper[axis] = std::min(lower[axis] + 1, this->Dimensions[axis] - 1);
+    weight[axis] = c - lower[axis];
+    }
+
+  vtkIdType sliceSize = static_cast<vtkIdType>(this->Dimensions[0]) * this->Dimensions[1];
+  const float* values = &this->Values[0];
+  double distance = 0.0;
+  for (int corner = 0; corner < 8; corner ++)
+    {
+    int i = (corner & 1) ? upper[0] : lower[0];
+    int j = (corner & 2) ? upper[1] : lower[1];
+    int k = (corner & 4) ? upper[2] : lower[2];
+    double w = ((corner & 1) ? weight[0] : 1.0 - weight[0]) *
+               ((corner & 2) ? weight[1] : 1.0 - weight[1]) *
+               ((corner & 4) ? weight[2] : 1.0 - weight[2]);
+    distance += w * values[i + j * this->Dimensions[0] + k * sliceSize];
+    }
+  return distance;
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerPathPlannerDistanceField
+::ComputeMinimum(const double start[3], const double end[3], double length,
+                 double* fraction) const
+{
+  if (fraction)
+    {
+    *fraction = 0.0;
+    }
+  if (this->Values.empty())
+    {
+    return VTK_DOUBLE_MAX;
+    }
+
+  double direction[3] = { end[0] - start[0], end[1] - start[1], end[2] - start[2] };
+  double extent = std::max(std::max(fabs(direction[0]), fabs(direction[1])), fabs(direction[2]));
+  double minimumStep = (extent > 0.5) ? 0.5 / extent : 1.0;
+  // Two neighbouring voxels differ by at most twice their spacing: once
+  // across the surface, where the sign changes. The interpolated field thus
+  // changes by at most 2 sqrt(3) mm per mm, and a sample at distance d
+  // cannot be followed by a smaller value than the minimum within
+  // (d - minimum) / (2 sqrt(3)) mm.
+  double skipScale = (length > 0.0) ? 1.0 / (2.0 * sqrt(3.0) * length) : 0.0;
+
+  double minimum = VTK_DOUBLE_MAX;
+  double t = 0.0;
+  for (;;)
+    {
+    double p[3] = { start[0] + t * direction[0],
+                    start[1] + t * direction[1],
+                    start[2] + t * direction[2] };
+    double d = this->GetDistance(p);
+    if (d < minimum)
+      {
+      minimum = d;
+      if (fraction)
+        {
+        *fraction = t;
+        }
+      }
+    if (t >= 1.0)
+      {
+      break;
+      }
+    t = std::min(1.0, t + std::max(minimumStep, (d - minimum) * skipScale));
+    }
+  return minimum;
+}
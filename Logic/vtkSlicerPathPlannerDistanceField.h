@@ -0,0 +1,88 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkSlicerPathPlannerDistanceField - signed distance to the structures of a labelmap
+// .SECTION Description
+// Euclidean signed distance field of the non-zero labels of a labelmap, in
+// mm, sampled on the voxel grid: positive outside of the structures
+// (distance to the nearest structure voxel), negative inside (distance to
+// the nearest background voxel). It is computed with the separable
+// lower-envelope transform of Felzenszwalb and Huttenlocher, one pass per
+// axis, the lines of each pass being spread across the cores.
+// Coordinates are continuous IJK indices counted from the first voxel.
+
+#ifndef __vtkSlicerPathPlannerDistanceField_h
+#define __vtkSlicerPathPlannerDistanceField_h
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <vector>
+
+#include "vtkSlicerPathPlannerModuleLogicExport.h"
+
+class vtkImageData;
+
+/// \ingroup Slicer_QtModules_PathPlanner
+class VTK_SLICER_PATHPLANNER_MODULE_LOGIC_EXPORT vtkSlicerPathPlannerDistanceField :
+  public vtkObject
+{
+public:
+
+  static vtkSlicerPathPlannerDistanceField *New();
+  vtkTypeMacro(vtkSlicerPathPlannerDistanceField, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Compute the field of a single component labelmap whose voxels are
+  /// spacing mm apart along I, J and K. The field is empty if the labelmap
+  /// has no structure (no non-zero voxel).
+  void Compute(vtkImageData* labelMap, const double spacing[3]);
+  void Initialize();
+
+  bool IsEmpty() const;
+  void GetDimensions(int dimensions[3]) const;
+  const float* GetValues() const;
+
+  /// Trilinear interpolation of the field at continuous IJK coordinates.
+  /// Coordinates outside of the volume are clamped to it.
+  double GetDistance(const double ijk[3]) const;
+
+  /// Smallest interpolated distance along the segment from start to end
+  /// (IJK coordinates), length mm long. fraction, if not NULL, receives the
+  /// position of the minimum (0 at start, 1 at end). The segment is sampled
+  /// every half voxel at most; samples that cannot be closer than the
+  /// current minimum are skipped. Return VTK_DOUBLE_MAX if the field is empty.
+  double ComputeMinimum(const double start[3], const double end[3], double length,
+                        double* fraction = 0) const;
+
+protected:
+  vtkSlicerPathPlannerDistanceField();
+  virtual ~vtkSlicerPathPlannerDistanceField();
+
+  int Dimensions[3];
+  double Spacing[3];
+  //BTX
+  std::vector<float> Values;
+  //ETX
+
+private:
+  vtkSlicerPathPlannerDistanceField(const vtkSlicerPathPlannerDistanceField&); // Not implemented
+  void operator=(const vtkSlicerPathPlannerDistanceField&);                  // Not implemented
+};
+
+#endif
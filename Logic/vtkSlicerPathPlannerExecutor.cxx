@@ -0,0 +1,480 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner Logic includes
+#include "vtkSlicerPathPlannerExecutor.h"
+
+// VTK includes
+#include <vtkMultiThreader.h>
+#include <vtkObjectFactory.h>
+
+// STD includes
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerPathPlannerExecutor);
+
+typedef vtkSlicerPathPlannerExecutor::CancellationToken CancellationToken;
+
+//----------------------------------------------------------------------------
+namespace
+{
+// A parallel loop being run: the functor, and the number of items that are
+// neither done nor skipped yet. The thread that started the loop owns it
+// and waits for Remaining to drop to 0.
+struct Loop
+{
+  vtkSlicerPathPlannerParallel::Functor* Functor;
+  vtkIdType Grain;
+  CancellationToken Token;
+  std::atomic<vtkIdType> Remaining;
+  std::atomic<bool> Skipped;
+};
+
+// Subrange of a loop waiting in a deque
+struct Range
+{
+  Loop* Owner;
+  vtkIdType Begin;
+  vtkIdType End;
+};
+
+struct QueuedJob
+{
+  vtkSlicerPathPlannerExecutor::Job* Job;
+  CancellationToken Token;
+};
+
+struct Worker
+{
+  std::mutex Mutex;
+  std::deque<Range> Ranges;
+  std::thread Thread;
+};
+
+// Executor, worker index and job token of the calling thread, if it is a
+// worker
+thread_local vtkSlicerPathPlannerExecutor* CurrentExecutor = 0;
+thread_local int CurrentWorker = -1;
+thread_local const CancellationToken* CurrentToken = 0;
+}
+
+//----------------------------------------------------------------------------
+class vtkSlicerPathPlannerExecutor::vtkInternal
+{
+public:
+  vtkInternal()
+  {
+    this->NumberOfQueuedItems.store(0);
+    this->Stopping = false;
+    this->NumberOfPendingJobs = 0;
+  }
+
+  // Worker threads, each with its deque of ranges
+  std::mutex StartMutex;
+  std::vector<Worker*> Workers;
+
+  // Ranges split by threads that are not workers, and the submitted jobs
+  std::mutex SharedMutex;
+  std::deque<Range> SharedRanges;
+  std::deque<QueuedJob> Jobs;
+
+  // Idle workers sleep until something is queued
+  std::atomic<int> NumberOfQueuedItems;
+  std::mutex SleepMutex;
+  std::condition_variable WakeUp;
+  bool Stopping;
+
+  // Jobs queued or running
+  std::mutex IdleMutex;
+  std::condition_variable Idle;
+  int NumberOfPendingJobs;
+
+  //--------------------------------------------------------------------------
+  void Notify()
+  {
+    this->NumberOfQueuedItems.fetch_add(1);
+    // A worker that saw nothing queued is waiting once the mutex is free
+    {
+    std::lock_guard<std::mutex> lock(this->SleepMutex);
+    }
+    this->WakeUp.notify_one();
+  }
+
+  //--------------------------------------------------------------------------
+  void PushRange(int worker, const Range& range)
+  {
+    if (worker >= 0)
+      {
+      std::lock_guard<std::mutex> lock(this->Workers[worker]->Mutex);
+      this->Workers[worker]->Ranges.push_back(range);
+      }
+    else
+      {
+      std::lock_guard<std::mutex> lock(this->SharedMutex);
+      this->SharedRanges.push_back(range);
+      }
+    this->Notify();
+  }
+
+  //--------------------------------------------------------------------------
+  // Last range pushed by the worker itself, else the oldest shared range,
+  // else the oldest range of another worker
+  bool TakeRange(int worker, Range& range)
+  {
+    if (this->NumberOfQueuedItems.load() <= 0)
+      {
+      return false;
+      }
+    if (worker >= 0)
+      {
+      Worker* self = this->Workers[worker];
+      std::lock_guard<std::mutex> lock(self->Mutex);
+      if (!self->Ranges.empty())
+        {
+        range = self->Ranges.back();
+        self->Ranges.pop_back();
+        this->NumberOfQueuedItems.fetch_sub(1);
+        return true;
+        }
+      }
+      {
+      std::lock_guard<std::mutex> lock(this->SharedMutex);
+      if (!this->SharedRanges.empty())
+        {
+        range = this->SharedRanges.front();
+        this->SharedRanges.pop_front();
+        this->NumberOfQueuedItems.fetch_sub(1);
+        return true;
+        }
+      }
+    int nWorkers = static_cast<int>(this->Workers.size());
+    for (int i = 1; i <= nWorkers; i ++)
+      {
+      Worker* victim = this->Workers[(std::max(worker, 0) + i) % nWorkers];
+      std::lock_guard<std::mutex> lock(victim->Mutex);
+      if (!victim->Ranges.empty())
+        {
+        range = victim->Ranges.front();
+        victim->Ranges.pop_front();
+        this->NumberOfQueuedItems.fetch_sub(1);
+        return true;
+        }
+      }
+    return false;
+  }
+
+  //--------------------------------------------------------------------------
+  bool TakeJob(QueuedJob& job)
+  {
+    std::lock_guard<std::mutex> lock(this->SharedMutex);
+    if (this->Jobs.empty())
+      {
+      return false;
+      }
+    job = this->Jobs.front();
+    this->Jobs.pop_front();
+    this->NumberOfQueuedItems.fetch_sub(1);
+    return true;
+  }
+
+  //--------------------------------------------------------------------------
+  // Split the range in halves down to a chunk, pushing the upper halves
+  // for the other threads to steal, and run the chunk left
+  void RunRange(int worker, Range range)
+  {
+    Loop* loop = range.Owner;
+    while (range.End - range.Begin > loop->Grain && !loop->Token.IsCanceled())
+      {
+      vtkIdType nChunks = (range.End - range.Begin + loop->Grain - 1) / loop->Grain;
+      Range upper = range;
+      upper.Begin = range.Begin + (nChunks / 2) * loop->Grain;
+      range.End = upper.Begin;
+      this->PushRange(worker, upper);
+      }
+    if (loop->Token.IsCanceled())
+      {
+      loop->Skipped.store(true);
+      }
+    else
+      {
+      const CancellationToken* token = CurrentToken;
+      CurrentToken = &loop->Token;
+      (*loop->Functor)(range.Begin, range.End);
+      CurrentToken = token;
+      }
+    // The owner of the loop may return as soon as this reaches 0
+    loop->Remaining.fetch_sub(range.End - range.Begin);
+  }
+
+  //--------------------------------------------------------------------------
+  void RunJob(QueuedJob& job)
+  {
+    if (!job.Token.IsCanceled())
+      {
+      CurrentToken = &job.Token;
+      job.Job->Run(job.Token);
+      CurrentToken = 0;
+      }
+    delete job.Job;
+    std::lock_guard<std::mutex> lock(this->IdleMutex);
+    if (-- this->NumberOfPendingJobs == 0)
+      {
+      this->Idle.notify_all();
+      }
+  }
+
+  //--------------------------------------------------------------------------
+  void RunWorker(vtkSlicerPathPlannerExecutor* executor, int worker)
+  {
+    CurrentExecutor = executor;
+    CurrentWorker = worker;
+    for (;;)
+      {
+      Range range;
+      if (this->TakeRange(worker, range))
+        {
+        this->RunRange(worker, range);
+        continue;
+        }
+      QueuedJob job;
+      if (this->TakeJob(job))
+        {
+        this->RunJob(job);
+        continue;
+        }
+      std::unique_lock<std::mutex> lock(this->SleepMutex);
+      while (!this->Stopping && this->NumberOfQueuedItems.load() <= 0)
+        {
+        this->WakeUp.wait(lock);
+        }
+      if (this->Stopping)
+        {
+        break;
+        }
+      }
+  }
+};
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerExecutor::CancellationToken::CancellationToken()
+  : Canceled(new std::atomic<bool>(false))
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerExecutor::CancellationToken::Cancel()
+{
+  this->Canceled->store(true);
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerPathPlannerExecutor::CancellationToken::IsCanceled() const
+{
+  return this->Canceled->load();
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerExecutor::vtkSlicerPathPlannerExecutor()
+{
+  this->Internal = new vtkInternal;
+  this->NumberOfThreads = std::max(1, vtkMultiThreader::GetGlobalDefaultNumberOfThreads());
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerExecutor::~vtkSlicerPathPlannerExecutor()
+{
+  this->Wait();
+  this->Stop();
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerExecutor::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+  os << indent << "NumberOfPendingJobs: " << this->GetNumberOfPendingJobs() << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerExecutor::Start()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->StartMutex);
+  if (!this->Internal->Workers.empty())
+    {
+    return;
+    }
+  // All the deques exist before any worker may steal from them
+  for (int i = 0; i < this->NumberOfThreads; i ++)
+    {
+    this->Internal->Workers.push_back(new Worker);
+    }
+  for (int i = 0; i < this->NumberOfThreads; i ++)
+    {
+    this->Internal->Workers[i]->Thread =
+      std::thread(&vtkInternal::RunWorker, this->Internal, this, i);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerExecutor::Stop()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->StartMutex);
+  if (this->Internal->Workers.empty())
+    {
+    return;
+    }
+    {
+    std::lock_guard<std::mutex> sleepLock(this->Internal->SleepMutex);
+    this->Internal->Stopping = true;
+    }
+  this->Internal->WakeUp.notify_all();
+  for (size_t i = 0; i < this->Internal->Workers.size(); i ++)
+    {
+    this->Internal->Workers[i]->Thread.join();
+    delete this->Internal->Workers[i];
+    }
+  this->Internal->Workers.clear();
+  this->Internal->Stopping = false;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerExecutor::SetNumberOfThreads(int numberOfThreads)
+{
+  numberOfThreads = std::max(numberOfThreads, 1);
+  if (numberOfThreads == this->NumberOfThreads)
+    {
+    return;
+    }
+  this->Wait();
+  this->Stop();
+  this->NumberOfThreads = numberOfThreads;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerPathPlannerExecutor::GetNumberOfThreads() const
+{
+  return this->NumberOfThreads;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerPathPlannerExecutor::GetNumberOfPendingJobs() const
+{
+  std::lock_guard<std::mutex> lock(this->Internal->IdleMutex);
+  return this->Internal->NumberOfPendingJobs;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerExecutor::Submit(Job* job, const CancellationToken& token)
+{
+  if (!job)
+    {
+    return;
+    }
+  this->Start();
+    {
+    std::lock_guard<std::mutex> lock(this->Internal->IdleMutex);
+    this->Internal->NumberOfPendingJobs ++;
+    }
+  QueuedJob queued;
+  queued.Job = job;
+  queued.Token = token;
+    {
+    std::lock_guard<std::mutex> lock(this->Internal->SharedMutex);
+    this->Internal->Jobs.push_back(queued);
+    }
+  this->Internal->Notify();
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerPathPlannerExecutor
+::For(vtkIdType first, vtkIdType last, vtkIdType grain,
+      vtkSlicerPathPlannerParallel::Functor& functor, const CancellationToken& token)
+{
+  if (first >= last)
+    {
+    return true;
+    }
+  grain = std::max(grain, static_cast<vtkIdType>(1));
+  if (last - first <= grain)
+    {
+    if (token.IsCanceled())
+      {
+      return false;
+      }
+    functor(first, last);
+    return true;
+    }
+  this->Start();
+
+  Loop loop;
+  loop.Functor = &functor;
+  loop.Grain = grain;
+  loop.Token = token;
+  loop.Remaining.store(last - first);
+  loop.Skipped.store(false);
+
+  // Start on the range, then help with any range until the loop is done
+  int worker = (CurrentExecutor == this) ? CurrentWorker : -1;
+  Range range;
+  range.Owner = &loop;
+  range.Begin = first;
+  range.End = last;
+  this->Internal->RunRange(worker, range);
+  while (loop.Remaining.load() > 0)
+    {
+    if (this->Internal->TakeRange(worker, range))
+      {
+      this->Internal->RunRange(worker, range);
+      }
+    else
+      {
+      std::this_thread::yield();
+      }
+    }
+  return !loop.Skipped.load();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerExecutor::Wait()
+{
+  std::unique_lock<std::mutex> lock(this->Internal->IdleMutex);
+  while (this->Internal->NumberOfPendingJobs > 0)
+    {
+    this->Internal->Idle.wait(lock);
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerExecutor* vtkSlicerPathPlannerExecutor::GetCurrent()
+{
+  return CurrentExecutor;
+}
+
+//----------------------------------------------------------------------------
+const CancellationToken* vtkSlicerPathPlannerExecutor::GetCurrentToken()
+{
+  return CurrentToken;
+}
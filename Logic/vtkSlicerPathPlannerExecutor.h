@@ -0,0 +1,132 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkSlicerPathPlannerExecutor - work-stealing pool running evaluation jobs
+// .SECTION Description
+// Fixed set of worker threads (one per core by default, started on the
+// first use) running the jobs submitted from any thread, e.g. the path
+// updates of vtkSlicerPathPlannerLogic, so that the GUI thread never blocks
+// on an evaluation. The parallel loops of a job are split on the pool: each
+// worker pushes and pops the subranges it splits at the back of its own
+// deque, so that they stay in its cache, and idle workers steal from the
+// front of the deques of the others, where the largest subranges are.
+// vtkSlicerPathPlannerParallel::For() called from a job runs this way.
+//
+// Cancellation is cooperative: every job is submitted with a
+// CancellationToken. A job whose token is canceled before it starts is
+// dropped, and the loops of a running job skip their remaining chunks, so
+// that a stale job returns within a chunk. Jobs should check their token
+// before publishing any result.
+
+#ifndef __vtkSlicerPathPlannerExecutor_h
+#define __vtkSlicerPathPlannerExecutor_h
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <atomic>
+#include <memory>
+
+// PathPlanner includes
+#include "vtkSlicerPathPlannerParallel.h"
+
+#include "vtkSlicerPathPlannerModuleLogicExport.h"
+
+/// \ingroup Slicer_QtModules_PathPlanner
+class VTK_SLICER_PATHPLANNER_MODULE_LOGIC_EXPORT vtkSlicerPathPlannerExecutor :
+  public vtkObject
+{
+public:
+
+  static vtkSlicerPathPlannerExecutor *New();
+  vtkTypeMacro(vtkSlicerPathPlannerExecutor, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  //BTX
+  /// Cancellation flag shared by the copies of a token: canceling one
+  /// cancels them all. A default constructed token is a new, live flag.
+  class CancellationToken
+  {
+  public:
+    CancellationToken();
+    void Cancel();
+    bool IsCanceled() const;
+  private:
+    std::shared_ptr< std::atomic<bool> > Canceled;
+  };
+
+  /// Work submitted to the pool
+  class Job
+  {
+  public:
+    virtual ~Job() {}
+    /// Called on a worker thread. token is the token the job was
+    /// submitted with.
+    virtual void Run(const CancellationToken& token) = 0;
+  };
+
+  /// Queue job to run on a worker and return at once. The executor takes
+  /// ownership of the job and deletes it once it ran or was dropped.
+  void Submit(Job* job, const CancellationToken& token);
+
+  /// Run functor on [first, last) split in chunks of at most grain items
+  /// across the workers, the calling thread helping. The chunks that are
+  /// not started yet are skipped once token is canceled. Return when all the
+  /// chunks are done or skipped: true if none was skipped.
+  bool For(vtkIdType first, vtkIdType last, vtkIdType grain,
+           vtkSlicerPathPlannerParallel::Functor& functor,
+           const CancellationToken& token);
+
+  /// Executor of the calling thread and token of the job it runs if it is
+  /// a worker, NULL otherwise.
+  static vtkSlicerPathPlannerExecutor* GetCurrent();
+  static const CancellationToken* GetCurrentToken();
+  //ETX
+
+  /// Number of workers. Setting it waits for the running jobs and restarts
+  /// the pool. Defaults to the vtkMultiThreader default number of threads.
+  void SetNumberOfThreads(int numberOfThreads);
+  int GetNumberOfThreads() const;
+
+  /// Number of jobs queued or running
+  int GetNumberOfPendingJobs() const;
+
+  /// Block until every submitted job ran or was dropped. Must not be called
+  /// from a job.
+  void Wait();
+
+protected:
+  vtkSlicerPathPlannerExecutor();
+  virtual ~vtkSlicerPathPlannerExecutor();
+
+  void Start();
+  void Stop();
+
+  //BTX
+  class vtkInternal;
+  vtkInternal* Internal;
+  //ETX
+
+  int NumberOfThreads;
+
+private:
+  vtkSlicerPathPlannerExecutor(const vtkSlicerPathPlannerExecutor&); // Not implemented
+  void operator=(const vtkSlicerPathPlannerExecutor&);              // Not implemented
+};
+
+#endif
@@ -16,33 +16,339 @@
 ==============================================================================*/
 
 // PathPlanner Logic includes
+#include "vtkSlicerPathPlannerDistanceField.h"
+#include "vtkSlicerPathPlannerExecutor.h"
 #include "vtkSlicerPathPlannerLogic.h"
+#include "vtkSlicerPathPlannerParallel.h"
+#include "vtkSlicerPathPlannerPathSet.h"
+#include "vtkSlicerPathPlannerPathStore.h"
+#include "vtkSlicerPathPlannerPointStore.h"
+#include "vtkSlicerPathPlannerPointTree.h"
+#include "vtkSlicerPathPlannerPoseFilter.h"
+#include "vtkSlicerPathPlannerProfiler.h"
+#include "vtkSlicerPathPlannerSkinSampler.h"
+#include "vtkSlicerPathPlannerTrajectoryKernel.h"
+#include "vtkSlicerPathPlannerTriangleTree.h"
+#include "vtkSlicerPathPlannerVoxelTraversal.h"
 
 // MRML includes
+#include <vtkMRMLAnnotationFiducialNode.h>
+#include <vtkMRMLAnnotationHierarchyNode.h>
+#include <vtkMRMLModelNode.h>
+#include <vtkMRMLScalarVolumeNode.h>
 
 // VTK includes
+#include <vtkCollection.h>
+#include <vtkDoubleArray.h>
+#include <vtkIdList.h>
+#include <vtkImageData.h>
+#include <vtkIntArray.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
 #include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPolyData.h>
+#include <vtkUnsignedCharArray.h>
 
 // STD includes
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
 
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerPathPlannerLogic);
 
+//----------------------------------------------------------------------------
+namespace
+{
+// Split a CSV line into trimmed fields. Fields may be double quoted, a
+// quote being escaped by another one.
+void SplitFields(const std::string& line, std::vector<std::string>& fields)
+{
+  fields.clear();
+  std::string field;
+  bool quoted = false;
+  for (size_t i = 0; i <= line.size(); i ++)
+    {
+    char c = (i < line.size()) ? line[i] : ',';
+    if (quoted)
+      {
+      if (c == '"' && i + 1 < line.size() && line[i + 1] == '"')
+        {
+        field += '"';
+        i ++;
+        }
+      else if (c == '"')
+        {
+        quoted = false;
+        }
+      else
+        {
+        field += c;
+        }
+      }
+    else if (c == '"')
+      {
+      quoted = true;
+      }
+    else if (c == ',')
+      {
+      size_t first = field.find_first_not_of(" \t\r");
+      size_t last = field.find_last_not_of(" \t\r");
+      fields.push_back(first == std::string::npos ?
+                       std::string() : field.substr(first, last - first + 1));
+      field.clear();
+      }
+    else
+      {
+      field += c;
+      }
+    }
+}
+
+// Quote a CSV field if it contains a separator or a quote
+std::string QuoteField(const char* field)
+{
+  std::string text(field ? field : "");
+  if (text.find_first_of(",\"\n") == std::string::npos)
+    {
+    return text;
+    }
+  std::string quoted("\"");
+  for (size_t i = 0; i < text.size(); i ++)
+    {
+    if (text[i] == '"')
+      {
+      quoted += '"';
+      }
+    quoted += text[i];
+    }
+  return quoted + "\"";
+}
+
+// Whether the job run by the calling thread, if any, was canceled: the
+// paths it did not evaluate yet are not worth evaluating
+bool IsJobCanceled()
+{
+  const vtkSlicerPathPlannerExecutor::CancellationToken* token =
+    vtkSlicerPathPlannerExecutor::GetCurrentToken();
+  return token && token->IsCanceled();
+}
+
+// Set a limit or a weight read by the background updates, once they are
+// canceled
+void SetEvaluationParameter(vtkSlicerPathPlannerLogic* logic, double& parameter,
+                            double value)
+{
+  if (parameter == value)
+    {
+    return;
+    }
+  logic->CancelPathUpdates();
+  parameter = value;
+  logic->Modified();
+}
+}
+
+//----------------------------------------------------------------------------
+// Background path updates. Each one evaluates a copy of the paths of a
+// point on the executor; the copies that were not canceled wait in
+// Finished until CollectPathUpdates().
+class vtkSlicerPathPlannerLogic::vtkPathUpdates
+{
+public:
+  typedef vtkSlicerPathPlannerExecutor::CancellationToken CancellationToken;
+
+  // What an update is keyed by: a later update with the same key cancels it
+  enum Kind
+  {
+    EntryPoint,
+    TargetPoint,
+    Paths
+  };
+
+  vtkPathUpdates()
+  {
+    this->Callback = 0;
+    this->ClientData = 0;
+    this->NextKey = 0;
+    this->Preparing = false;
+  }
+
+  // Copy of paths, with the ID of the path each one copies
+  struct Update
+  {
+    vtkSlicerPathPlannerPathStore* Paths;
+    std::vector<vtkIdType> Ids;
+  };
+
+  class Job : public vtkSlicerPathPlannerExecutor::Job
+  {
+  public:
+    Job(vtkSlicerPathPlannerLogic* logic, const Update& update, bool prepare)
+      : Logic(logic), Result(update), Prepare(prepare)
+    {
+    }
+    virtual ~Job()
+    {
+      if (this->Result.Paths)
+        {
+        this->Result.Paths->Delete();
+        }
+      // Dropped before it ran
+      if (this->Prepare)
+        {
+        this->Logic->PathUpdates->Preparing = false;
+        }
+    }
+    virtual void Run(const CancellationToken& token)
+    {
+      if (this->Prepare)
+        {
+        this->Logic->BuildEvaluationData();
+        this->Logic->PathUpdates->Preparing = false;
+        this->Prepare = false;
+        }
+      if (token.IsCanceled())
+        {
+        return;
+        }
+      this->Logic->EvaluatePaths(this->Result.Paths);
+      vtkPathUpdates* updates = this->Logic->PathUpdates;
+      void (*callback)(void*) = 0;
+      void* clientData = 0;
+        {
+        std::lock_guard<std::mutex> lock(updates->Mutex);
+        if (token.IsCanceled())
+          {
+          return;
+          }
+        updates->Finished.push_back(this->Result);
+        this->Result.Paths = 0;
+        callback = updates->Callback;
+        clientData = updates->ClientData;
+        }
+      if (callback)
+        {
+        (*callback)(clientData);
+        }
+    }
+  private:
+    vtkSlicerPathPlannerLogic* Logic;
+    Update Result;
+    // Compute the distance field and the surface model trees first
+    bool Prepare;
+  };
+
+  std::mutex Mutex;
+  std::vector<Update> Finished;
+  void (*Callback)(void* clientData);
+  void* ClientData;
+  // Token of the latest update of each key: (kind, point ID or serial
+  // number). Only used from the thread owning the logic.
+  std::map<std::pair<int, vtkIdType>, CancellationToken> Tokens;
+  vtkIdType NextKey;
+  // true while the job of UpdateAllPathsAsync() computes the distance
+  // field and the surface model trees
+  std::atomic<bool> Preparing;
+};
+
 //----------------------------------------------------------------------------
 vtkSlicerPathPlannerLogic::vtkSlicerPathPlannerLogic()
 {
+  this->EntryPoints = vtkSlicerPathPlannerPointStore::New();
+  this->TargetPoints = vtkSlicerPathPlannerPointStore::New();
+  this->Paths = vtkSlicerPathPlannerPathStore::New();
+  this->EntryPointTree = vtkSlicerPathPlannerPointTree::New();
+  this->EntryPointTree->SetPoints(this->EntryPoints);
+  this->ReferenceDirection[0] = 0.0;
+  this->ReferenceDirection[1] = 0.0;
+  this->ReferenceDirection[2] = 1.0;
+  this->MaximumPathLength = 0.0;
+  this->MaximumInsertionAngle = 180.0;
+  this->LengthWeight = 1.0;
+  this->InsertionAngleWeight = 1.0;
+  this->ClearanceWeight = 10.0;
+  this->CrossingWeight = 1000.0;
+  this->ClearanceMargin = 10.0;
+  this->LabelMap = 0;
+  this->RASToIJK = vtkMatrix4x4::New();
+  this->DistanceField = vtkSlicerPathPlannerDistanceField::New();
+  this->Executor = vtkSlicerPathPlannerExecutor::New();
+  this->PathUpdates = new vtkPathUpdates;
+  this->PoseFilter = vtkSlicerPathPlannerPoseFilter::New();
+  this->PathSet = vtkSlicerPathPlannerPathSet::New();
+  this->PathSet->SetPaths(this->Paths);
 }
 
 //----------------------------------------------------------------------------
 vtkSlicerPathPlannerLogic::~vtkSlicerPathPlannerLogic()
 {
+  // The running updates use the members below
+  this->CancelPathUpdates();
+  this->Executor->Delete();
+  delete this->PathUpdates;
+  this->PathUpdates = 0;
+  // Before the path store, whose model columns it resets
+  this->RemoveAllSurfaceModels();
+  this->EntryPoints->Delete();
+  this->TargetPoints->Delete();
+  this->PathSet->Delete();
+  this->Paths->Delete();
+  this->EntryPointTree->Delete();
+  if (this->LabelMap)
+    {
+    this->LabelMap->UnRegister(this);
+    }
+  this->RASToIJK->Delete();
+  this->DistanceField->Delete();
+  this->PoseFilter->Delete();
 }
 
 //----------------------------------------------------------------------------
 void vtkSlicerPathPlannerLogic::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "ReferenceDirection: ("
+     << this->ReferenceDirection[0] << ", "
+     << this->ReferenceDirection[1] << ", "
+     << this->ReferenceDirection[2] << ")\n";
+  os << indent << "MaximumPathLength: " << this->MaximumPathLength << "\n";
+  os << indent << "MaximumInsertionAngle: " << this->MaximumInsertionAngle << "\n";
+  os << indent << "LengthWeight: " << this->LengthWeight << "\n";
+  os << indent << "InsertionAngleWeight: " << this->InsertionAngleWeight << "\n";
+  os << indent << "ClearanceWeight: " << this->ClearanceWeight << "\n";
+  os << indent << "CrossingWeight: " << this->CrossingWeight << "\n";
+  os << indent << "ClearanceMargin: " << this->ClearanceMargin << "\n";
+  os << indent << "EntryPoints: " << this->EntryPoints->GetNumberOfPoints() << "\n";
+  os << indent << "TargetPoints: " << this->TargetPoints->GetNumberOfPoints() << "\n";
+  os << indent << "Paths: " << this->Paths->GetNumberOfPaths() << "\n";
+  os << indent << "LabelMap: " << this->LabelMap << "\n";
+  os << indent << "SurfaceModels:";
+  for (size_t model = 0; model < this->SurfaceModelNames.size(); model ++)
+    {
+    os << " " << this->SurfaceModelNames[model];
+    }
+  os << "\n";
+  os << indent << "PendingPathUpdates: " << this->GetNumberOfPendingPathUpdates() << "\n";
+  os << indent << "Executor:\n";
+  this->Executor->PrintSelf(os, indent.GetNextIndent());
+  os << indent << "PoseFilter:\n";
+  this->PoseFilter->PrintSelf(os, indent.GetNextIndent());
+  os << indent << "PathSet:\n";
+  this->PathSet->PrintSelf(os, indent.GetNextIndent());
+  os << indent << "Probes:\n";
+  vtkSlicerPathPlannerProfiler::PrintProbes(os);
 }
 
 //---------------------------------------------------------------------------
@@ -79,3 +385,1959 @@ void vtkSlicerPathPlannerLogic
 {
 }
 
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic
+::ComputeTrajectories(const double* entryPoints, const double* targetPoints,
+                      vtkIdType numberOfTrajectories, double* lengths,
+                      double* directions, double* insertionAngles)
+{
+  if (!entryPoints || !targetPoints || numberOfTrajectories <= 0)
+    {
+    return;
+    }
+
+  double reference[3] =
+    {
+    this->ReferenceDirection[0],
+    this->ReferenceDirection[1],
+    this->ReferenceDirection[2]
+    };
+  if (vtkMath::Normalize(reference) == 0.0)
+    {
+    reference[2] = 1.0;
+    }
+  const double radiansToDegrees = vtkMath::DegreesFromRadians(1.0);
+
+  for (vtkIdType i = 0; i < numberOfTrajectories; i ++)
+    {
+    const double* entry = entryPoints + 3 * i;
+    const double* target = targetPoints + 3 * i;
+
+    double dx = target[0] - entry[0];
+    double dy = target[1] - entry[1];
+    double dz = target[2] - entry[2];
+    double length = sqrt(dx*dx + dy*dy + dz*dz);
+    double inverse = (length > 0.0) ? 1.0 / length : 0.0;
+    dx *= inverse;
+    dy *= inverse;
+    dz *= inverse;
+
+    if (lengths)
+      {
+      lengths[i] = length;
+      }
+    if (directions)
+      {
+      directions[3*i]   = dx;
+      directions[3*i+1] = dy;
+      directions[3*i+2] = dz;
+      }
+    if (insertionAngles)
+      {
+      double cosine = dx*reference[0] + dy*reference[1] + dz*reference[2];
+      cosine = (cosine > 1.0) ? 1.0 : ((cosine < -1.0) ? -1.0 : cosine);
+      insertionAngles[i] = (length > 0.0) ? acos(cosine) * radiansToDegrees : 0.0;
+      }
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic
+::ComputeTrajectories(vtkDoubleArray* entryPoints, vtkDoubleArray* targetPoints,
+                      vtkDoubleArray* lengths, vtkDoubleArray* directions,
+                      vtkDoubleArray* insertionAngles)
+{
+  if (!entryPoints || !targetPoints ||
+      entryPoints->GetNumberOfComponents() != 3 ||
+      targetPoints->GetNumberOfComponents() != 3 ||
+      entryPoints->GetNumberOfTuples() != targetPoints->GetNumberOfTuples())
+    {
+    vtkErrorMacro(<< "ComputeTrajectories: entry and target points must be "
+                  "3-component arrays of the same size");
+    return;
+    }
+
+  vtkIdType n = entryPoints->GetNumberOfTuples();
+  if (lengths)
+    {
+    lengths->SetNumberOfComponents(1);
+    lengths->SetNumberOfTuples(n);
+    }
+  if (directions)
+    {
+    directions->SetNumberOfComponents(3);
+    directions->SetNumberOfTuples(n);
+    }
+  if (insertionAngles)
+    {
+    insertionAngles->SetNumberOfComponents(1);
+    insertionAngles->SetNumberOfTuples(n);
+    }
+
+  this->ComputeTrajectories(entryPoints->GetPointer(0), targetPoints->GetPointer(0), n,
+                            lengths ? lengths->GetPointer(0) : 0,
+                            directions ? directions->GetPointer(0) : 0,
+                            insertionAngles ? insertionAngles->GetPointer(0) : 0);
+}
+
+//---------------------------------------------------------------------------
+double vtkSlicerPathPlannerLogic
+::ComputeTrajectory(const double entryPoint[3], const double targetPoint[3],
+                    double direction[3], double* insertionAngle)
+{
+  double length = 0.0;
+  this->ComputeTrajectories(entryPoint, targetPoint, 1, &length,
+                            direction, insertionAngle);
+  return length;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic
+::ComputeTrajectoryMatrix(const double* const entryPoints[3], vtkIdType numberOfEntryPoints,
+                          const double* const targetPoints[3], vtkIdType numberOfTargetPoints,
+                          double* lengths, double* const directions[3],
+                          unsigned char* feasible)
+{
+  if (!entryPoints || !targetPoints || !lengths || !feasible ||
+      numberOfEntryPoints <= 0 || numberOfTargetPoints <= 0)
+    {
+    return;
+    }
+
+  // The kernel compares cosines rather than angles to avoid acos().
+  double reference[3];
+  double maximumLength;
+  double minimumCosine;
+  this->GetFeasibilityLimits(reference, &maximumLength, &minimumCosine);
+
+  for (vtkIdType t = 0; t < numberOfTargetPoints; t ++)
+    {
+    double target[3] = { targetPoints[0][t], targetPoints[1][t], targetPoints[2][t] };
+    vtkIdType offset = t * numberOfEntryPoints;
+    vtkSlicerPathPlannerTrajectoryKernel::EvaluateTarget(
+      entryPoints[0], entryPoints[1], entryPoints[2], numberOfEntryPoints,
+      target, reference, maximumLength, minimumCosine,
+      lengths + offset,
+      directions ? directions[0] + offset : 0,
+      directions ? directions[1] + offset : 0,
+      directions ? directions[2] + offset : 0,
+      feasible + offset);
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic
+::ComputeTrajectoryMatrix(vtkDoubleArray* entryPoints, vtkDoubleArray* targetPoints,
+                          vtkDoubleArray* lengths, vtkDoubleArray* directions,
+                          vtkUnsignedCharArray* feasible)
+{
+  if (!entryPoints || !targetPoints || !lengths ||
+      entryPoints->GetNumberOfComponents() != 3 ||
+      targetPoints->GetNumberOfComponents() != 3)
+    {
+    vtkErrorMacro(<< "ComputeTrajectoryMatrix: entry and target points must be "
+                  "3-component arrays");
+    return;
+    }
+
+  vtkIdType nEntries = entryPoints->GetNumberOfTuples();
+  vtkIdType nTargets = targetPoints->GetNumberOfTuples();
+  vtkIdType n = nEntries * nTargets;
+
+  // Split the packed coordinates into structure of arrays for the kernel
+  std::vector<double> entrySoA(3 * nEntries);
+  std::vector<double> targetSoA(3 * nTargets);
+  const double* e = entryPoints->GetPointer(0);
+  const double* t = targetPoints->GetPointer(0);
+  for (vtkIdType i = 0; i < nEntries; i ++)
+    {
+    entrySoA[i] = e[3*i];
+    entrySoA[nEntries + i] = e[3*i+1];
+    entrySoA[2*nEntries + i] = e[3*i+2];
+    }
+  for (vtkIdType i = 0; i < nTargets; i ++)
+    {
+    targetSoA[i] = t[3*i];
+    targetSoA[nTargets + i] = t[3*i+1];
+    targetSoA[2*nTargets + i] = t[3*i+2];
+    }
+  if (n == 0)
+    {
+    lengths->SetNumberOfTuples(0);
+    return;
+    }
+  const double* entryArrays[3] = { &entrySoA[0], &entrySoA[nEntries], &entrySoA[2*nEntries] };
+  const double* targetArrays[3] = { &targetSoA[0], &targetSoA[nTargets], &targetSoA[2*nTargets] };
+
+  std::vector<double> directionSoA(directions ? 3 * n : 0);
+  double* directionArrays[3] = { 0, 0, 0 };
+  if (directions)
+    {
+    directionArrays[0] = &directionSoA[0];
+    directionArrays[1] = &directionSoA[n];
+    directionArrays[2] = &directionSoA[2*n];
+    }
+  std::vector<unsigned char> feasibleMask(n);
+
+  lengths->SetNumberOfComponents(1);
+  lengths->SetNumberOfTuples(n);
+  this->ComputeTrajectoryMatrix(entryArrays, nEntries, targetArrays, nTargets,
+                                lengths->GetPointer(0),
+                                directions ? directionArrays : 0,
+                                &feasibleMask[0]);
+
+  if (directions)
+    {
+    directions->SetNumberOfComponents(3);
+    directions->SetNumberOfTuples(n);
+    double* d = directions->GetPointer(0);
+    for (vtkIdType i = 0; i < n; i ++)
+      {
+      d[3*i]   = directionArrays[0][i];
+      d[3*i+1] = directionArrays[1][i];
+      d[3*i+2] = directionArrays[2][i];
+      }
+    }
+  if (feasible)
+    {
+    feasible->SetNumberOfComponents(1);
+    feasible->SetNumberOfTuples(n);
+    std::copy(feasibleMask.begin(), feasibleMask.end(), feasible->GetPointer(0));
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic::UpdatePathGeometry(vtkIdType pathIndex)
+{
+  vtkIdType nPaths = this->Paths->GetNumberOfPaths();
+  vtkIdType first = (pathIndex < 0) ? 0 : pathIndex;
+  vtkIdType last = (pathIndex < 0) ? nPaths : pathIndex + 1;
+  if (first >= last || last > nPaths)
+    {
+    return;
+    }
+
+  this->UpdateEndPointPositions(pathIndex);
+  this->PrepareEvaluation();
+  this->EvaluatePaths(this->Paths, pathIndex);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic::UpdateEndPointPositions(vtkIdType pathIndex)
+{
+  vtkIdType nPaths = this->Paths->GetNumberOfPaths();
+  vtkIdType first = (pathIndex < 0) ? 0 : pathIndex;
+  vtkIdType last = (pathIndex < 0) ? nPaths : pathIndex + 1;
+  if (first >= last || last > nPaths)
+    {
+    return;
+    }
+
+  double* targets = this->Paths->GetTargetPositions();
+  double* entries = this->Paths->GetEntryPositions();
+  for (vtkIdType i = first; i < last; i ++)
+    {
+    vtkIdType target = this->TargetPoints->GetIndex(this->Paths->GetTargetPointId(i));
+    if (target >= 0)
+      {
+      this->TargetPoints->GetPosition(target, targets + 3 * i);
+      }
+    vtkIdType entry = this->EntryPoints->GetIndex(this->Paths->GetEntryPointId(i));
+    if (entry >= 0)
+      {
+      this->EntryPoints->GetPosition(entry, entries + 3 * i);
+      }
+    }
+  this->Paths->Modified();
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic::PrepareEvaluation()
+{
+  this->WaitForPreparation();
+  // Compute the distance field and build the trees of the new or modified
+  // surfaces before the concurrent (read-only) queries, once the updates
+  // reading the old ones are done
+  if (this->NeedsPreparation())
+    {
+    this->CancelPathUpdates();
+    }
+  this->BuildEvaluationData();
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerPathPlannerLogic::NeedsPreparation()
+{
+  if (this->LabelMap && this->DistanceFieldNeedsUpdate())
+    {
+    return true;
+    }
+  for (size_t model = 0; model < this->SurfaceModels.size(); model ++)
+    {
+    if (this->SurfaceModels[model]->NeedsUpdate())
+      {
+      return true;
+      }
+    }
+  return false;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic::BuildEvaluationData()
+{
+  if (this->LabelMap)
+    {
+    this->UpdateDistanceField();
+    }
+  for (size_t model = 0; model < this->SurfaceModels.size(); model ++)
+    {
+    this->SurfaceModels[model]->Update();
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic::WaitForPreparation()
+{
+  if (this->PathUpdates && this->PathUpdates->Preparing)
+    {
+    this->Executor->Wait();
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic
+::EvaluatePaths(vtkSlicerPathPlannerPathStore* paths, vtkIdType pathIndex)
+{
+  vtkIdType nPaths = paths->GetNumberOfPaths();
+  vtkIdType first = (pathIndex < 0) ? 0 : pathIndex;
+  vtkIdType last = (pathIndex < 0) ? nPaths : pathIndex + 1;
+  if (first >= last || last > nPaths)
+    {
+    return;
+    }
+
+  this->ComputeTrajectories(paths->GetEntryPositions() + 3 * first,
+                            paths->GetTargetPositions() + 3 * first, last - first,
+                            paths->GetLengths() + first,
+                            paths->GetDirections() + 3 * first,
+                            paths->GetInsertionAngles() + first);
+  paths->Modified();
+
+  // A canceled background update stops between the passes, and within
+  // them between the paths: its copy of the paths is dropped anyway
+  if (this->LabelMap && !IsJobCanceled())
+    {
+    this->CheckCollisions(paths, pathIndex);
+    if (!IsJobCanceled())
+      {
+      this->ComputeClearances(paths, pathIndex);
+      }
+    }
+  if (!this->SurfaceModels.empty() && !IsJobCanceled())
+    {
+    this->CheckSurfaceModels(paths, pathIndex);
+    }
+  if (!IsJobCanceled())
+    {
+    this->ComputePathCosts(paths, pathIndex);
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic
+::FindPathsOfPoint(vtkIdType pointId, bool target, vtkIdList* pathIndices)
+{
+  pathIndices->Reset();
+  vtkIdType nPaths = this->Paths->GetNumberOfPaths();
+  for (vtkIdType i = 0; i < nPaths; i ++)
+    {
+    vtkIdType id = target ? this->Paths->GetTargetPointId(i) : this->Paths->GetEntryPointId(i);
+    if (id == pointId)
+      {
+      pathIndices->InsertNextId(i);
+      }
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic::UpdatePaths(vtkIdList* pathIndices)
+{
+  vtkIdType nIndices = pathIndices->GetNumberOfIds();
+  if (nIndices == 0)
+    {
+    return;
+    }
+
+  // Same as the background updates: the paths are gathered in a copy so
+  // that the checks run once over all of them
+  vtkNew<vtkSlicerPathPlannerPathStore> copy;
+  copy->SetNumberOfSurfaceModels(this->Paths->GetNumberOfSurfaceModels());
+  for (vtkIdType k = 0; k < nIndices; k ++)
+    {
+    vtkIdType i = pathIndices->GetId(k);
+    this->UpdateEndPointPositions(i);
+    vtkIdType index = copy->GetIndex(copy->AddPath(0));
+    copy->CopyPath(index, this->Paths, i);
+    }
+  this->PrepareEvaluation();
+  this->EvaluatePaths(copy.GetPointer());
+  for (vtkIdType k = 0; k < nIndices; k ++)
+    {
+    this->Paths->CopyPath(pathIndices->GetId(k), copy.GetPointer(), k);
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic::UpdatePathsOfEntryPoint(vtkIdType pointId, vtkIdList* pathIndices)
+{
+  vtkNew<vtkIdList> indices;
+  this->FindPathsOfPoint(pointId, false, indices.GetPointer());
+  this->UpdatePaths(indices.GetPointer());
+  if (pathIndices)
+    {
+    pathIndices->DeepCopy(indices.GetPointer());
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic::UpdatePathsOfTargetPoint(vtkIdType pointId, vtkIdList* pathIndices)
+{
+  vtkNew<vtkIdList> indices;
+  this->FindPathsOfPoint(pointId, true, indices.GetPointer());
+  this->UpdatePaths(indices.GetPointer());
+  if (pathIndices)
+    {
+    pathIndices->DeepCopy(indices.GetPointer());
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic::UpdatePathsOfEntryPointAsync(vtkIdType pointId)
+{
+  this->UpdatePathsOfPointAsync(pointId, false);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic::UpdatePathsOfTargetPointAsync(vtkIdType pointId)
+{
+  this->UpdatePathsOfPointAsync(pointId, true);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic::UpdatePathsOfPointAsync(vtkIdType pointId, bool target)
+{
+  vtkNew<vtkIdList> pathIndices;
+  this->FindPathsOfPoint(pointId, target, pathIndices.GetPointer());
+  // Only the latest position of the point is worth evaluating
+  this->SubmitPathUpdate(pathIndices.GetPointer(),
+                         target ? vtkPathUpdates::TargetPoint : vtkPathUpdates::EntryPoint,
+                         pointId);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic::UpdatePathsAsync(vtkIdList* pathIndices)
+{
+  this->SubmitPathUpdate(pathIndices, vtkPathUpdates::Paths, this->PathUpdates->NextKey++);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic::UpdateAllPathsAsync()
+{
+  this->CancelPathUpdates();
+  vtkNew<vtkIdList> pathIndices;
+  vtkIdType nPaths = this->Paths->GetNumberOfPaths();
+  pathIndices->SetNumberOfIds(nPaths);
+  for (vtkIdType i = 0; i < nPaths; i ++)
+    {
+    pathIndices->SetId(i, i);
+    }
+  this->SubmitPathUpdate(pathIndices.GetPointer(), vtkPathUpdates::Paths,
+                         this->PathUpdates->NextKey++, true);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic
+::SubmitPathUpdate(vtkIdList* pathIndices, int kind, vtkIdType key, bool prepare)
+{
+  vtkIdType nIndices = pathIndices ? pathIndices->GetNumberOfIds() : 0;
+  vtkIdType nPaths = this->Paths->GetNumberOfPaths();
+
+  // Move the end points at once and copy the paths for the job
+  vtkPathUpdates::Update update;
+  update.Paths = vtkSlicerPathPlannerPathStore::New();
+  update.Paths->SetNumberOfSurfaceModels(this->Paths->GetNumberOfSurfaceModels());
+  for (vtkIdType k = 0; k < nIndices; k ++)
+    {
+    vtkIdType i = pathIndices->GetId(k);
+    if (i < 0 || i >= nPaths)
+      {
+      continue;
+      }
+    this->UpdateEndPointPositions(i);
+    vtkIdType index = update.Paths->GetIndex(update.Paths->AddPath(0));
+    update.Paths->CopyPath(index, this->Paths, i);
+    update.Ids.push_back(this->Paths->GetId(i));
+    }
+  prepare = prepare && this->NeedsPreparation();
+  if (update.Ids.empty() && !prepare)
+    {
+    update.Paths->Delete();
+    return;
+    }
+
+  // Cancel the update this one supersedes
+  vtkPathUpdates::CancellationToken& token =
+    this->PathUpdates->Tokens[std::make_pair(kind, key)];
+  token.Cancel();
+  token = vtkPathUpdates::CancellationToken();
+
+  if (prepare)
+    {
+    // The job computes them first, the evaluations submitted meanwhile
+    // wait for it (see WaitForPreparation())
+    this->PathUpdates->Preparing = true;
+    }
+  else
+    {
+    this->PrepareEvaluation();
+    }
+  this->Executor->Submit(new vtkPathUpdates::Job(this, update, prepare), token);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic
+::SetPathUpdateCallback(void (*callback)(void* clientData), void* clientData)
+{
+  std::lock_guard<std::mutex> lock(this->PathUpdates->Mutex);
+  this->PathUpdates->Callback = callback;
+  this->PathUpdates->ClientData = clientData;
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerLogic::CollectPathUpdates(vtkIdList* pathIndices)
+{
+  if (pathIndices)
+    {
+    pathIndices->Reset();
+    }
+  std::vector<vtkPathUpdates::Update> finished;
+    {
+    std::lock_guard<std::mutex> lock(this->PathUpdates->Mutex);
+    finished.swap(this->PathUpdates->Finished);
+    }
+
+  vtkIdType nUpdated = 0;
+  for (size_t u = 0; u < finished.size(); u ++)
+    {
+    vtkSlicerPathPlannerPathStore* paths = finished[u].Paths;
+    for (size_t i = 0; i < finished[u].Ids.size(); i ++)
+      {
+      vtkIdType index = this->Paths->GetIndex(finished[u].Ids[i]);
+      if (index < 0)
+        {
+        continue;
+        }
+      // Drop the result if an end point changed since the copy
+      vtkIdType copy = static_cast<vtkIdType>(i);
+      double position[3];
+      double copyPosition[3];
+      bool same = this->Paths->GetTargetPointId(index) == paths->GetTargetPointId(copy) &&
+                  this->Paths->GetEntryPointId(index) == paths->GetEntryPointId(copy);
+      this->Paths->GetTargetPosition(index, position);
+      paths->GetTargetPosition(copy, copyPosition);
+      same = same && std::equal(position, position + 3, copyPosition);
+      this->Paths->GetEntryPosition(index, position);
+      paths->GetEntryPosition(copy, copyPosition);
+      same = same && std::equal(position, position + 3, copyPosition);
+      if (!same)
+        {
+        continue;
+        }
+      this->Paths->CopyPath(index, paths, copy);
+      nUpdated ++;
+      if (pathIndices)
+        {
+        pathIndices->InsertUniqueId(index);
+        }
+      }
+    paths->Delete();
+    }
+
+  if (this->Executor->GetNumberOfPendingJobs() == 0)
+    {
+    this->PathUpdates->Tokens.clear();
+    }
+  return nUpdated;
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerPathPlannerLogic::GetNumberOfPendingPathUpdates()
+{
+  // Jobs first: a job publishes its result before it stops being pending
+  int nPending = this->Executor->GetNumberOfPendingJobs();
+  std::lock_guard<std::mutex> lock(this->PathUpdates->Mutex);
+  return nPending + static_cast<int>(this->PathUpdates->Finished.size());
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic::CancelPathUpdates()
+{
+  if (!this->PathUpdates)
+    {
+    return;
+    }
+  std::map<std::pair<int, vtkIdType>, vtkPathUpdates::CancellationToken>::iterator it;
+  for (it = this->PathUpdates->Tokens.begin(); it != this->PathUpdates->Tokens.end(); ++ it)
+    {
+    it->second.Cancel();
+    }
+  this->Executor->Wait();
+  this->PathUpdates->Tokens.clear();
+
+  std::lock_guard<std::mutex> lock(this->PathUpdates->Mutex);
+  for (size_t u = 0; u < this->PathUpdates->Finished.size(); u ++)
+    {
+    this->PathUpdates->Finished[u].Paths->Delete();
+    }
+  this->PathUpdates->Finished.clear();
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic::SetReferenceDirection(double x, double y, double z)
+{
+  if (this->ReferenceDirection[0] == x && this->ReferenceDirection[1] == y &&
+      this->ReferenceDirection[2] == z)
+    {
+    return;
+    }
+  this->CancelPathUpdates();
+  this->ReferenceDirection[0] = x;
+  this->ReferenceDirection[1] = y;
+  this->ReferenceDirection[2] = z;
+  this->Modified();
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic::SetReferenceDirection(double direction[3])
+{
+  this->SetReferenceDirection(direction[0], direction[1], direction[2]);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic::SetMaximumPathLength(double maximumPathLength)
+{
+  SetEvaluationParameter(this, this->MaximumPathLength, maximumPathLength);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic::SetMaximumInsertionAngle(double maximumInsertionAngle)
+{
+  SetEvaluationParameter(this, this->MaximumInsertionAngle,
+                         std::max(0.0, std::min(maximumInsertionAngle, 180.0)));
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic::SetLengthWeight(double lengthWeight)
+{
+  SetEvaluationParameter(this, this->LengthWeight, std::max(0.0, lengthWeight));
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic::SetInsertionAngleWeight(double insertionAngleWeight)
+{
+  SetEvaluationParameter(this, this->InsertionAngleWeight, std::max(0.0, insertionAngleWeight));
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic::SetClearanceWeight(double clearanceWeight)
+{
+  SetEvaluationParameter(this, this->ClearanceWeight, std::max(0.0, clearanceWeight));
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic::SetCrossingWeight(double crossingWeight)
+{
+  SetEvaluationParameter(this, this->CrossingWeight, std::max(0.0, crossingWeight));
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic::SetClearanceMargin(double clearanceMargin)
+{
+  SetEvaluationParameter(this, this->ClearanceMargin, std::max(0.0, clearanceMargin));
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic
+::GetFeasibilityLimits(double reference[3], double* maximumLength,
+                       double* minimumCosine) const
+{
+  reference[0] = this->ReferenceDirection[0];
+  reference[1] = this->ReferenceDirection[1];
+  reference[2] = this->ReferenceDirection[2];
+  if (vtkMath::Normalize(reference) == 0.0)
+    {
+    reference[2] = 1.0;
+    }
+  *maximumLength = (this->MaximumPathLength > 0.0) ?
+    this->MaximumPathLength : VTK_DOUBLE_MAX;
+  *minimumCosine = (this->MaximumInsertionAngle >= 180.0) ? -2.0 :
+    cos(vtkMath::RadiansFromDegrees(this->MaximumInsertionAngle));
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerPathPlannerLogic::IsFeasible(double length, const double direction[3]) const
+{
+  double reference[3];
+  double maximumLength;
+  double minimumCosine;
+  this->GetFeasibilityLimits(reference, &maximumLength, &minimumCosine);
+  return vtkSlicerPathPlannerTrajectoryKernel::IsFeasible(
+    length, vtkMath::Dot(direction, reference), maximumLength, minimumCosine);
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerLogic
+::FindFeasiblePaths(vtkIdList* targetPointIds, vtkIdList* entryPointIds)
+{
+  return this->FindFeasiblePaths(this->EntryPoints, this->TargetPoints,
+                                 targetPointIds, entryPointIds);
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerLogic
+::FindFeasiblePaths(vtkSlicerPathPlannerPointStore* entryPoints,
+                    vtkSlicerPathPlannerPointStore* targetPoints,
+                    vtkIdList* targetPointIds, vtkIdList* entryPointIds)
+{
+  if (!targetPointIds || !entryPointIds)
+    {
+    return 0;
+    }
+  targetPointIds->Reset();
+  entryPointIds->Reset();
+
+  vtkIdType nEntries = entryPoints->GetNumberOfPoints();
+  vtkIdType nTargets = targetPoints->GetNumberOfPoints();
+  if (nEntries == 0 || nTargets == 0)
+    {
+    return 0;
+    }
+
+  // Evaluate the whole entry x target matrix in one call
+  const double* entryArrays[3] =
+    { entryPoints->GetR(), entryPoints->GetA(), entryPoints->GetS() };
+  const double* targetArrays[3] =
+    { targetPoints->GetR(), targetPoints->GetA(), targetPoints->GetS() };
+  std::vector<double> lengths(nEntries * nTargets);
+  std::vector<unsigned char> feasible(nEntries * nTargets);
+  this->ComputeTrajectoryMatrix(entryArrays, nEntries, targetArrays, nTargets,
+                                &lengths[0], 0, &feasible[0]);
+
+  // Shortest feasible paths first
+  std::vector< std::pair<double, vtkIdType> > candidates;
+  for (vtkIdType i = 0; i < nEntries * nTargets; i ++)
+    {
+    if (feasible[i])
+      {
+      candidates.push_back(std::make_pair(lengths[i], i));
+      }
+    }
+  std::sort(candidates.begin(), candidates.end());
+
+  vtkIdType nPaths = static_cast<vtkIdType>(candidates.size());
+  targetPointIds->SetNumberOfIds(nPaths);
+  entryPointIds->SetNumberOfIds(nPaths);
+  for (vtkIdType c = 0; c < nPaths; c ++)
+    {
+    targetPointIds->SetId(c, targetPoints->GetId(candidates[c].second / nEntries));
+    entryPointIds->SetId(c, entryPoints->GetId(candidates[c].second % nEntries));
+    }
+  return nPaths;
+}
+
+//---------------------------------------------------------------------------
+vtkSlicerPathPlannerPointTree* vtkSlicerPathPlannerLogic::GetEntryPointTree()
+{
+  this->EntryPointTree->Update();
+  return this->EntryPointTree;
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerLogic
+::SuggestEntryPoints(vtkIdType targetPointId, int numberOfEntryPoints,
+                     vtkIdList* entryPointIds)
+{
+  if (!entryPointIds)
+    {
+    return 0;
+    }
+  entryPointIds->Reset();
+  vtkIdType target = this->TargetPoints->GetIndex(targetPointId);
+  if (target < 0 || numberOfEntryPoints <= 0)
+    {
+    return 0;
+    }
+  double targetPosition[3];
+  this->TargetPoints->GetPosition(target, targetPosition);
+
+  // With a length limit the candidates are the entry points within reach;
+  // otherwise take more and more of the closest ones until enough of them
+  // are feasible.
+  vtkSlicerPathPlannerPointTree* tree = this->GetEntryPointTree();
+  vtkIdType nEntries = tree->GetNumberOfPoints();
+  vtkNew<vtkIdList> candidates;
+  vtkIdType nCandidates = std::min(static_cast<vtkIdType>(numberOfEntryPoints), nEntries);
+  vtkIdType nChecked = 0;
+  for (;;)
+    {
+    if (this->MaximumPathLength > 0.0)
+      {
+      tree->FindPointsWithinRadius(targetPosition, this->MaximumPathLength,
+                                   candidates.GetPointer());
+      }
+    else
+      {
+      tree->FindClosestPoints(targetPosition, static_cast<int>(nCandidates),
+                              candidates.GetPointer());
+      }
+
+    // The candidates are sorted by distance, then ID: the ones checked in
+    // the previous round come first again, ties included
+    for (vtkIdType c = nChecked; c < candidates->GetNumberOfIds(); c ++)
+      {
+      vtkIdType entry = this->EntryPoints->GetIndex(candidates->GetId(c));
+      double entryPosition[3];
+      this->EntryPoints->GetPosition(entry, entryPosition);
+      double direction[3];
+      double length = this->ComputeTrajectory(entryPosition, targetPosition, direction);
+      if (this->IsFeasible(length, direction))
+        {
+        entryPointIds->InsertNextId(candidates->GetId(c));
+        if (entryPointIds->GetNumberOfIds() == numberOfEntryPoints)
+          {
+          return numberOfEntryPoints;
+          }
+        }
+      }
+    nChecked = candidates->GetNumberOfIds();
+    if (this->MaximumPathLength > 0.0 || nChecked >= nEntries)
+      {
+      break;
+      }
+    nCandidates = std::min(2 * nCandidates, nEntries);
+    }
+  return entryPointIds->GetNumberOfIds();
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerLogic::GenerateAllPaths()
+{
+  this->PrepareEvaluation();
+  return this->PlanPaths(this->EntryPoints, this->TargetPoints, 0, this->Paths);
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerLogic::GenerateBestPaths(int numberOfPathsPerTarget)
+{
+  if (numberOfPathsPerTarget <= 0)
+    {
+    this->Paths->RemoveAllPaths();
+    return 0;
+    }
+  this->PrepareEvaluation();
+  return this->PlanPaths(this->EntryPoints, this->TargetPoints, numberOfPathsPerTarget,
+                         this->Paths);
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerLogic
+::PlanPaths(vtkSlicerPathPlannerPointStore* entryPoints,
+            vtkSlicerPathPlannerPointStore* targetPoints,
+            int numberOfPathsPerTarget, vtkSlicerPathPlannerPathStore* paths)
+{
+  if (!entryPoints || !targetPoints || !paths)
+    {
+    return 0;
+    }
+  vtkNew<vtkIdList> targetPointIds;
+  vtkNew<vtkIdList> entryPointIds;
+  if (numberOfPathsPerTarget > 0)
+    {
+    this->RankPaths(entryPoints, targetPoints, numberOfPathsPerTarget,
+                    targetPointIds.GetPointer(), entryPointIds.GetPointer(), 0);
+    }
+  else
+    {
+    this->FindFeasiblePaths(entryPoints, targetPoints,
+                            targetPointIds.GetPointer(), entryPointIds.GetPointer());
+    }
+  paths->SetNumberOfSurfaceModels(static_cast<int>(this->SurfaceModels.size()));
+  vtkIdType nPaths = this->SetPaths(entryPoints, targetPoints, targetPointIds.GetPointer(),
+                                    entryPointIds.GetPointer(), paths);
+  this->EvaluatePaths(paths);
+  return nPaths;
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerLogic
+::SetPaths(vtkSlicerPathPlannerPointStore* entryPoints,
+           vtkSlicerPathPlannerPointStore* targetPoints,
+           vtkIdList* targetPointIds, vtkIdList* entryPointIds,
+           vtkSlicerPathPlannerPathStore* paths)
+{
+  vtkIdType nPaths = targetPointIds->GetNumberOfIds();
+  paths->RemoveAllPaths();
+  for (vtkIdType i = 0; i < nPaths; i ++)
+    {
+    std::stringstream name;
+    name << "P_" << (i + 1);
+    vtkIdType index = paths->GetIndex(paths->AddPath(name.str().c_str()));
+
+    double position[3];
+    vtkIdType targetId = targetPointIds->GetId(i);
+    targetPoints->GetPosition(targetPoints->GetIndex(targetId), position);
+    paths->SetTarget(index, targetId, position);
+    vtkIdType entryId = entryPointIds->GetId(i);
+    entryPoints->GetPosition(entryPoints->GetIndex(entryId), position);
+    paths->SetEntry(index, entryId, position);
+    }
+  return nPaths;
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerLogic
+::ReadPoints(const char* fileName, vtkSlicerPathPlannerPointStore* points)
+{
+  if (!fileName || !points)
+    {
+    return -1;
+    }
+  std::ifstream file(fileName);
+  if (!file)
+    {
+    vtkErrorMacro(<< "ReadPoints: cannot open " << fileName);
+    return -1;
+    }
+
+  vtkIdType nPoints = 0;
+  std::string line;
+  std::vector<std::string> fields;
+  while (std::getline(file, line))
+    {
+    size_t first = line.find_first_not_of(" \t\r");
+    if (first == std::string::npos || line[first] == '#')
+      {
+      continue;
+      }
+    SplitFields(line, fields);
+    if (fields.size() < 4)
+      {
+      continue;
+      }
+
+    double position[3];
+    bool numeric = true;
+    for (int i = 0; i < 3 && numeric; i ++)
+      {
+      const char* text = fields[i + 1].c_str();
+      char* end = 0;
+      position[i] = strtod(text, &end);
+      numeric = (end != text && *end == '\0');
+      }
+    if (!numeric)
+      {
+      continue;
+      }
+    points->AddPoint(position, fields[0].c_str());
+    nPoints ++;
+    }
+  return nPoints;
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerLogic
+::ImportPoints(vtkMRMLAnnotationHierarchyNode* hierarchy,
+               vtkSlicerPathPlannerPointStore* points)
+{
+  if (!hierarchy || !points)
+    {
+    return 0;
+    }
+
+  vtkNew<vtkCollection> children;
+  hierarchy->GetDirectChildren(children.GetPointer());
+  vtkIdType nPoints = 0;
+  int nItems = children->GetNumberOfItems();
+  children->InitTraversal();
+  for (int i = 0; i < nItems; i ++)
+    {
+    vtkMRMLAnnotationFiducialNode* fnode =
+      vtkMRMLAnnotationFiducialNode::SafeDownCast(children->GetNextItemAsObject());
+    if (!fnode)
+      {
+      continue;
+      }
+    double coord[4];
+    fnode->GetFiducialCoordinates(coord);
+    points->AddPoint(coord, fnode->GetName(), fnode->GetID());
+    nPoints ++;
+    }
+  return nPoints;
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerLogic::SampleSkinSurface(vtkPolyData* skin, double spacing)
+{
+  std::vector<double> positions;
+  std::vector<double> normals;
+  vtkIdType nSamples = vtkSlicerPathPlannerSkinSampler::SampleSurface(skin, spacing,
+                                                                      positions, normals);
+  if (nSamples > 0)
+    {
+    this->EntryPoints->AddPoints(nSamples, &positions[0], &normals[0], "Skin_");
+    }
+  return nSamples;
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerLogic::SampleSkinModelNode(vtkMRMLModelNode* modelNode, double spacing)
+{
+  if (!modelNode)
+    {
+    return 0;
+    }
+  return this->SampleSkinSurface(modelNode->GetPolyData(), spacing);
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerLogic
+::SampleSkinVolume(vtkImageData* volume, vtkMatrix4x4* rasToIJK,
+                   double threshold, double spacing)
+{
+  if (!volume || !rasToIJK)
+    {
+    return 0;
+    }
+  vtkNew<vtkMatrix4x4> ijkToRAS;
+  vtkMatrix4x4::Invert(rasToIJK, ijkToRAS.GetPointer());
+  std::vector<double> positions;
+  std::vector<double> normals;
+  vtkIdType nSamples = vtkSlicerPathPlannerSkinSampler::SampleVolume(
+    volume, ijkToRAS.GetPointer(), threshold, spacing, positions, normals);
+  if (nSamples > 0)
+    {
+    this->EntryPoints->AddPoints(nSamples, &positions[0], &normals[0], "Skin_");
+    }
+  return nSamples;
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerLogic
+::SampleSkinVolumeNode(vtkMRMLScalarVolumeNode* volumeNode, double threshold, double spacing)
+{
+  if (!volumeNode || !volumeNode->GetImageData())
+    {
+    return 0;
+    }
+  vtkNew<vtkMatrix4x4> rasToIJK;
+  volumeNode->GetRASToIJKMatrix(rasToIJK.GetPointer());
+  return this->SampleSkinVolume(volumeNode->GetImageData(), rasToIJK.GetPointer(),
+                                threshold, spacing);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic::SetLabelMap(vtkImageData* labelMap, vtkMatrix4x4* rasToIJK)
+{
+  this->CancelPathUpdates();
+  if (labelMap && labelMap->GetNumberOfScalarComponents() != 1)
+    {
+    vtkErrorMacro(<< "SetLabelMap: the labelmap must have a single component");
+    labelMap = 0;
+    }
+  if (labelMap != this->LabelMap)
+    {
+    if (this->LabelMap)
+      {
+      this->LabelMap->UnRegister(this);
+      }
+    this->LabelMap = labelMap;
+    if (this->LabelMap)
+      {
+      this->LabelMap->Register(this);
+      }
+    }
+  if (rasToIJK)
+    {
+    this->RASToIJK->DeepCopy(rasToIJK);
+    }
+  else
+    {
+    this->RASToIJK->Identity();
+    }
+  this->LabelMapTime.Modified();
+
+  if (!this->LabelMap)
+    {
+    vtkIdType nPaths = this->Paths->GetNumberOfPaths();
+    for (vtkIdType i = 0; i < nPaths; i ++)
+      {
+      this->Paths->SetHits(i, 0, 0, 0);
+      }
+    // release the distance field
+    this->ComputeClearances();
+    }
+  this->Modified();
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic::SetLabelMapVolumeNode(vtkMRMLScalarVolumeNode* volumeNode)
+{
+  if (!volumeNode || !volumeNode->GetImageData())
+    {
+    this->SetLabelMap(0, 0);
+    return;
+    }
+  vtkNew<vtkMatrix4x4> rasToIJK;
+  volumeNode->GetRASToIJKMatrix(rasToIJK.GetPointer());
+  this->SetLabelMap(volumeNode->GetImageData(), rasToIJK.GetPointer());
+}
+
+//---------------------------------------------------------------------------
+namespace
+{
+// Work on a chunk of paths, with their end points in the IJK coordinates
+// of the labelmap
+class PathFunctor : public vtkSlicerPathPlannerParallel::Functor
+{
+public:
+  double Origin[3];
+  double RASToIJK[16];
+  const double* Entries;
+  const double* Targets;
+
+  void ToIJK(const double ras[3], double ijk[3]) const
+  {
+    for (int row = 0; row < 3; row ++)
+      {
+      const double* m = this->RASToIJK + 4 * row;
+      ijk[row] = m[0] * ras[0] + m[1] * ras[1] + m[2] * ras[2] + m[3] - this->Origin[row];
+      }
+  }
+
+  void GetSegment(vtkIdType i, double start[3], double end[3]) const
+  {
+    this->ToIJK(this->Entries + 3 * i, start);
+    this->ToIJK(this->Targets + 3 * i, end);
+  }
+
+  void Initialize(vtkImageData* labelMap, vtkMatrix4x4* rasToIJK,
+                  vtkSlicerPathPlannerPathStore* paths)
+  {
+    // The IJK indices of the matrix count from the first voxel of the extent
+    int* extent = labelMap->GetExtent();
+    this->Origin[0] = extent[0];
+    this->Origin[1] = extent[2];
+    this->Origin[2] = extent[4];
+    for (int row = 0; row < 4; row ++)
+      {
+      for (int column = 0; column < 4; column ++)
+        {
+        this->RASToIJK[4 * row + column] = rasToIJK->GetElement(row, column);
+        }
+      }
+    this->Entries = paths ? paths->GetEntryPositions() : 0;
+    this->Targets = paths ? paths->GetTargetPositions() : 0;
+  }
+};
+
+//---------------------------------------------------------------------------
+// Traverse the labelmap along a chunk of paths. The hits of path i are
+// written to Labels[i - First] and Fractions[i - First] only, so that the
+// chunks can run concurrently.
+class CollisionFunctor : public PathFunctor
+{
+public:
+  const void* Scalars;
+  int ScalarType;
+  int Dimensions[3];
+  vtkIdType First;
+  std::vector< std::vector<int> > Labels;
+  std::vector< std::vector<double> > Fractions;
+
+  virtual void operator()(vtkIdType begin, vtkIdType end)
+  {
+    for (vtkIdType i = begin; i < end && !IsJobCanceled(); i ++)
+      {
+      double start[3];
+      double stop[3];
+      this->GetSegment(i, start, stop);
+      vtkSlicerPathPlannerVoxelTraversal::TraceSegment(
+        this->Scalars, this->ScalarType, this->Dimensions, start, stop,
+        this->Labels[i - this->First], this->Fractions[i - this->First]);
+      }
+  }
+};
+
+//---------------------------------------------------------------------------
+// Smallest distance field value along a chunk of paths, written to the
+// clearance arrays of the path store at the index of each path
+class ClearanceFunctor : public PathFunctor
+{
+public:
+  vtkSlicerPathPlannerDistanceField* Field;
+  const double* Lengths;
+  double* Clearances;
+  double* Depths;
+
+  virtual void operator()(vtkIdType begin, vtkIdType end)
+  {
+    for (vtkIdType i = begin; i < end && !IsJobCanceled(); i ++)
+      {
+      double start[3];
+      double stop[3];
+      this->GetSegment(i, start, stop);
+      double fraction = 0.0;
+      this->Clearances[i] = this->Field->ComputeMinimum(start, stop, this->Lengths[i], &fraction);
+      this->Depths[i] = fraction * this->Lengths[i];
+      }
+  }
+};
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerLogic::CheckCollisions(vtkIdType pathIndex)
+{
+  return this->CheckCollisions(this->Paths, pathIndex);
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerLogic
+::CheckCollisions(vtkSlicerPathPlannerPathStore* paths, vtkIdType pathIndex)
+{
+  vtkIdType nPaths = paths->GetNumberOfPaths();
+  vtkIdType first = (pathIndex < 0) ? 0 : pathIndex;
+  vtkIdType last = (pathIndex < 0) ? nPaths : pathIndex + 1;
+  if (!this->LabelMap || first >= last || last > nPaths)
+    {
+    return 0;
+    }
+
+  CollisionFunctor functor;
+  functor.Initialize(this->LabelMap, this->RASToIJK, paths);
+  functor.Scalars = this->LabelMap->GetScalarPointer();
+  functor.ScalarType = this->LabelMap->GetScalarType();
+  this->LabelMap->GetDimensions(functor.Dimensions);
+  functor.First = first;
+  functor.Labels.resize(last - first);
+  functor.Fractions.resize(last - first);
+
+  // A path crosses a few hundred voxels: chunks of 16 paths keep the
+  // scheduling overhead low while balancing long and short paths.
+  vtkSlicerPathPlannerParallel::For(first, last, 16, functor);
+
+  vtkIdType nColliding = 0;
+  std::vector<double> depths;
+  for (vtkIdType i = first; i < last; i ++)
+    {
+    const std::vector<int>& labels = functor.Labels[i - first];
+    const std::vector<double>& fractions = functor.Fractions[i - first];
+    double length = paths->GetLength(i);
+    depths.resize(fractions.size());
+    for (size_t k = 0; k < fractions.size(); k ++)
+      {
+      depths[k] = fractions[k] * length;
+      }
+    int nHits = static_cast<int>(labels.size());
+    paths->SetHits(i, nHits, nHits ? &labels[0] : 0, nHits ? &depths[0] : 0);
+    if (nHits > 0)
+      {
+      nColliding ++;
+      }
+    }
+  return nColliding;
+}
+
+//---------------------------------------------------------------------------
+vtkSlicerPathPlannerDistanceField* vtkSlicerPathPlannerLogic::GetDistanceField()
+{
+  this->WaitForPreparation();
+  if (this->DistanceFieldNeedsUpdate())
+    {
+    this->CancelPathUpdates();
+    }
+  this->UpdateDistanceField();
+  return this->DistanceField;
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerPathPlannerLogic::DistanceFieldNeedsUpdate()
+{
+  if (!this->LabelMap)
+    {
+    return !this->DistanceField->IsEmpty();
+    }
+  return !(this->DistanceFieldTime > this->LabelMapTime &&
+           this->DistanceFieldTime.GetMTime() > this->LabelMap->GetMTime());
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic::UpdateDistanceField()
+{
+  if (!this->DistanceFieldNeedsUpdate())
+    {
+    return;
+    }
+  if (!this->LabelMap)
+    {
+    this->DistanceField->Initialize();
+    return;
+    }
+
+  // Voxel size: length of the IJK axes in RAS
+  vtkNew<vtkMatrix4x4> ijkToRAS;
+  vtkMatrix4x4::Invert(this->RASToIJK, ijkToRAS.GetPointer());
+  double spacing[3];
+  for (int column = 0; column < 3; column ++)
+    {
+    double axis[3] = { ijkToRAS->GetElement(0, column),
+                       ijkToRAS->GetElement(1, column),
+                       ijkToRAS->GetElement(2, column) };
+    spacing[column] = vtkMath::Norm(axis);
+    }
+  this->DistanceField->Compute(this->LabelMap, spacing);
+  // The passes of a canceled job skipped chunks: leave the field out of date
+  if (IsJobCanceled())
+    {
+    return;
+    }
+  this->DistanceFieldTime.Modified();
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic::ComputeClearances(vtkIdType pathIndex)
+{
+  this->GetDistanceField();
+  this->ComputeClearances(this->Paths, pathIndex);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic
+::ComputeClearances(vtkSlicerPathPlannerPathStore* paths, vtkIdType pathIndex)
+{
+  vtkSlicerPathPlannerDistanceField* field = this->DistanceField;
+  vtkIdType nPaths = paths->GetNumberOfPaths();
+  vtkIdType first = (pathIndex < 0) ? 0 : pathIndex;
+  vtkIdType last = (pathIndex < 0) ? nPaths : pathIndex + 1;
+  if (first >= last || last > nPaths)
+    {
+    return;
+    }
+
+  if (field->IsEmpty())
+    {
+    std::fill(paths->GetClearances() + first, paths->GetClearances() + last,
+              VTK_DOUBLE_MAX);
+    std::fill(paths->GetClearanceDepths() + first,
+              paths->GetClearanceDepths() + last, 0.0);
+    paths->Modified();
+    return;
+    }
+
+  ClearanceFunctor functor;
+  functor.Initialize(this->LabelMap, this->RASToIJK, paths);
+  functor.Field = field;
+  functor.Lengths = paths->GetLengths();
+  functor.Clearances = paths->GetClearances();
+  functor.Depths = paths->GetClearanceDepths();
+  vtkSlicerPathPlannerParallel::For(first, last, 16, functor);
+  paths->Modified();
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerPathPlannerLogic::AddSurfaceModel(vtkPolyData* surface, const char* name)
+{
+  if (!surface)
+    {
+    vtkErrorMacro(<< "AddSurfaceModel: no surface");
+    return -1;
+    }
+  this->CancelPathUpdates();
+  vtkSlicerPathPlannerTriangleTree* tree = vtkSlicerPathPlannerTriangleTree::New();
+  tree->SetSurface(surface);
+  this->SurfaceModels.push_back(tree);
+  this->SurfaceModelNames.push_back(name ? name : "");
+  this->Paths->SetNumberOfSurfaceModels(static_cast<int>(this->SurfaceModels.size()));
+  this->Modified();
+  return static_cast<int>(this->SurfaceModels.size()) - 1;
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerPathPlannerLogic::AddSurfaceModelNode(vtkMRMLModelNode* modelNode)
+{
+  if (!modelNode || !modelNode->GetPolyData())
+    {
+    return -1;
+    }
+  return this->AddSurfaceModel(modelNode->GetPolyData(), modelNode->GetName());
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic::RemoveAllSurfaceModels()
+{
+  if (this->SurfaceModels.empty())
+    {
+    return;
+    }
+  this->CancelPathUpdates();
+  for (size_t model = 0; model < this->SurfaceModels.size(); model ++)
+    {
+    this->SurfaceModels[model]->Delete();
+    }
+  this->SurfaceModels.clear();
+  this->SurfaceModelNames.clear();
+  this->Paths->SetNumberOfSurfaceModels(0);
+  this->Modified();
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerPathPlannerLogic::GetNumberOfSurfaceModels() const
+{
+  return static_cast<int>(this->SurfaceModels.size());
+}
+
+//---------------------------------------------------------------------------
+const char* vtkSlicerPathPlannerLogic::GetSurfaceModelName(int model) const
+{
+  if (model < 0 || model >= static_cast<int>(this->SurfaceModelNames.size()))
+    {
+    return 0;
+    }
+  return this->SurfaceModelNames[model].c_str();
+}
+
+//---------------------------------------------------------------------------
+namespace
+{
+// Intersect a chunk of paths with every surface model. The results of path
+// i are written at i * number of models in the model arrays of the path
+// store.
+class SurfaceModelFunctor : public vtkSlicerPathPlannerParallel::Functor
+{
+public:
+  const std::vector<vtkSlicerPathPlannerTriangleTree*>* Trees;
+  const double* Entries;
+  const double* Targets;
+  const double* Lengths;
+  double* Distances;
+  double* Depths;
+
+  virtual void operator()(vtkIdType begin, vtkIdType end)
+  {
+    size_t nModels = this->Trees->size();
+    for (vtkIdType i = begin; i < end && !IsJobCanceled(); i ++)
+      {
+      const double* entry = this->Entries + 3 * i;
+      const double* target = this->Targets + 3 * i;
+      for (size_t model = 0; model < nModels; model ++)
+        {
+        const vtkSlicerPathPlannerTriangleTree* tree = (*this->Trees)[model];
+        double fraction = 0.0;
+        double distance = 0.0;
+        if (!tree->IntersectSegment(entry, target, &fraction))
+          {
+          distance = tree->ComputeDistance(entry, target, &fraction);
+          }
+        this->Distances[i * nModels + model] = distance;
+        this->Depths[i * nModels + model] = fraction * this->Lengths[i];
+        }
+      }
+  }
+};
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerLogic::CheckSurfaceModels(vtkIdType pathIndex)
+{
+  this->WaitForPreparation();
+  for (size_t model = 0; model < this->SurfaceModels.size(); model ++)
+    {
+    this->SurfaceModels[model]->Update();
+    }
+  return this->CheckSurfaceModels(this->Paths, pathIndex);
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerLogic
+::CheckSurfaceModels(vtkSlicerPathPlannerPathStore* paths, vtkIdType pathIndex)
+{
+  vtkIdType nPaths = paths->GetNumberOfPaths();
+  vtkIdType first = (pathIndex < 0) ? 0 : pathIndex;
+  vtkIdType last = (pathIndex < 0) ? nPaths : pathIndex + 1;
+  int nModels = static_cast<int>(this->SurfaceModels.size());
+  if (nModels == 0 || first >= last || last > nPaths)
+    {
+    return 0;
+    }
+  if (paths->GetNumberOfSurfaceModels() != nModels)
+    {
+    paths->SetNumberOfSurfaceModels(nModels);
+    }
+
+  SurfaceModelFunctor functor;
+  functor.Trees = &this->SurfaceModels;
+  functor.Entries = paths->GetEntryPositions();
+  functor.Targets = paths->GetTargetPositions();
+  functor.Lengths = paths->GetLengths();
+  functor.Distances = paths->GetModelDistances();
+  functor.Depths = paths->GetModelDepths();
+  // A closest distance query visits up to a few hundred leaves per model
+  vtkSlicerPathPlannerParallel::For(first, last, 4, functor);
+  paths->Modified();
+
+  vtkIdType nCrossing = 0;
+  for (vtkIdType i = first; i < last; i ++)
+    {
+    for (int model = 0; model < nModels; model ++)
+      {
+      if (paths->GetModelDistance(i, model) == 0.0)
+        {
+        nCrossing ++;
+        break;
+        }
+      }
+    }
+  return nCrossing;
+}
+
+//---------------------------------------------------------------------------
+double vtkSlicerPathPlannerLogic
+::ComputePathCost(double length, double insertionAngle,
+                  double clearance, int numberOfCrossings) const
+{
+  double cost = this->LengthWeight * length +
+    this->InsertionAngleWeight * insertionAngle +
+    this->CrossingWeight * numberOfCrossings;
+  if (clearance < this->ClearanceMargin)
+    {
+    cost += this->ClearanceWeight * (this->ClearanceMargin - clearance);
+    }
+  return cost;
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic::ComputePathCosts(vtkIdType pathIndex)
+{
+  this->ComputePathCosts(this->Paths, pathIndex);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic
+::ComputePathCosts(vtkSlicerPathPlannerPathStore* paths, vtkIdType pathIndex)
+{
+  vtkIdType nPaths = paths->GetNumberOfPaths();
+  vtkIdType first = (pathIndex < 0) ? 0 : pathIndex;
+  vtkIdType last = (pathIndex < 0) ? nPaths : pathIndex + 1;
+  if (first >= last || last > nPaths)
+    {
+    return;
+    }
+
+  double* costs = paths->GetCosts();
+  int nModels = paths->GetNumberOfSurfaceModels();
+  std::set<int> labels;
+  for (vtkIdType i = first; i < last && !IsJobCanceled(); i ++)
+    {
+    // Structures crossed: distinct labels entered and models crossed
+    labels.clear();
+    int nHits = paths->GetNumberOfHits(i);
+    for (int k = 0; k < nHits; k ++)
+      {
+      labels.insert(paths->GetHitLabel(i, k));
+      }
+    int nCrossings = static_cast<int>(labels.size());
+    double clearance = paths->GetClearance(i);
+    for (int model = 0; model < nModels; model ++)
+      {
+      double distance = paths->GetModelDistance(i, model);
+      nCrossings += (distance == 0.0) ? 1 : 0;
+      clearance = std::min(clearance, distance);
+      }
+    costs[i] = this->ComputePathCost(paths->GetLength(i),
+                                     paths->GetInsertionAngle(i),
+                                     clearance, nCrossings);
+    }
+  paths->Modified();
+}
+
+//---------------------------------------------------------------------------
+namespace
+{
+// (cost, entry point index) of a ranked path. The heaps are max-heaps:
+// the most expensive path kept is at the front.
+typedef std::pair<double, vtkIdType> RankedPath;
+
+//---------------------------------------------------------------------------
+// Evaluate a chunk of the entry x target candidates, the candidate
+// t * NumberOfEntries + e being the path from entry point e to target
+// point t. The chunk keeps the cheapest paths of each target it covers in
+// a local heap, merged into the shared heap of the target at the end.
+// The cost terms are added cheapest first, and a candidate is dropped as
+// soon as its partial cost exceeds the most expensive path kept, since
+// the other terms can only add to it.
+class RankingFunctor : public PathFunctor
+{
+public:
+  vtkSlicerPathPlannerLogic* Logic;
+  const double* EntryCoordinates[3];
+  const double* TargetCoordinates[3];
+  vtkIdType NumberOfEntries;
+  // See GetFeasibilityLimits()
+  double Reference[3];
+  double MaximumLength;
+  double MinimumCosine;
+  // Labelmap (NULL Scalars if none) and its distance field (NULL if empty)
+  const void* Scalars;
+  int ScalarType;
+  int Dimensions[3];
+  const vtkSlicerPathPlannerDistanceField* Field;
+  const std::vector<vtkSlicerPathPlannerTriangleTree*>* Trees;
+  size_t NumberOfPathsPerTarget;
+  std::vector< std::vector<RankedPath> > Heaps;
+  std::mutex Mutex;
+
+  virtual void operator()(vtkIdType begin, vtkIdType end)
+  {
+    std::vector<RankedPath> heap;
+    std::vector<int> labels;
+    std::vector<double> fractions;
+    std::vector<bool> crossed(this->Trees->size());
+    double margin = this->Logic->GetClearanceMargin();
+
+    vtkIdType i = begin;
+    while (i < end)
+      {
+      vtkIdType t = i / this->NumberOfEntries;
+      vtkIdType last = std::min(end, (t + 1) * this->NumberOfEntries);
+      double target[3] = { this->TargetCoordinates[0][t],
+                           this->TargetCoordinates[1][t],
+                           this->TargetCoordinates[2][t] };
+
+      // Start from the most expensive path kept by the other chunks
+      double bound = VTK_DOUBLE_MAX;
+        {
+        std::lock_guard<std::mutex> lock(this->Mutex);
+        const std::vector<RankedPath>& shared = this->Heaps[t];
+        if (shared.size() == this->NumberOfPathsPerTarget)
+          {
+          bound = shared.front().first;
+          }
+        }
+
+      heap.clear();
+      for (; i < last; i ++)
+        {
+        vtkIdType e = i - t * this->NumberOfEntries;
+        double entry[3] = { this->EntryCoordinates[0][e],
+                            this->EntryCoordinates[1][e],
+                            this->EntryCoordinates[2][e] };
+        double direction[3];
+        double insertionAngle = 0.0;
+        double length = this->Logic->ComputeTrajectory(entry, target, direction,
+                                                       &insertionAngle);
+        if (!vtkSlicerPathPlannerTrajectoryKernel::IsFeasible(
+              length, vtkMath::Dot(direction, this->Reference),
+              this->MaximumLength, this->MinimumCosine))
+          {
+          continue;
+          }
+        if (heap.size() == this->NumberOfPathsPerTarget)
+          {
+          bound = std::min(bound, heap.front().first);
+          }
+        if (this->Logic->ComputePathCost(length, insertionAngle, VTK_DOUBLE_MAX, 0) > bound)
+          {
+          continue;
+          }
+
+        // Structures crossed: distinct labels entered and models crossed
+        double start[3];
+        double stop[3];
+        int nCrossings = 0;
+        if (this->Scalars)
+          {
+          this->ToIJK(entry, start);
+          this->ToIJK(target, stop);
+          labels.clear();
+          fractions.clear();
+          vtkSlicerPathPlannerVoxelTraversal::TraceSegment(
+            this->Scalars, this->ScalarType, this->Dimensions, start, stop, labels, fractions);
+          std::sort(labels.begin(), labels.end());
+          nCrossings += static_cast<int>(std::unique(labels.begin(), labels.end()) -
+                                         labels.begin());
+          }
+        for (size_t model = 0; model < this->Trees->size(); model ++)
+          {
+          double fraction;
+          crossed[model] = (*this->Trees)[model]->IntersectSegment(entry, target, &fraction);
+          nCrossings += crossed[model] ? 1 : 0;
+          }
+        if (this->Logic->ComputePathCost(length, insertionAngle, VTK_DOUBLE_MAX,
+                                         nCrossings) > bound)
+          {
+          continue;
+          }
+
+        // Clearance, which only counts below the margin
+        double clearance = VTK_DOUBLE_MAX;
+        if (this->Field)
+          {
+          clearance = this->Field->ComputeMinimum(start, stop, length);
+          }
+        for (size_t model = 0; model < this->Trees->size(); model ++)
+          {
+          clearance = std::min(clearance, crossed[model] ? 0.0 :
+            (*this->Trees)[model]->ComputeDistance(entry, target, 0,
+                                                   std::min(clearance, margin)));
+          }
+        RankedPath path(this->Logic->ComputePathCost(length, insertionAngle,
+                                                     clearance, nCrossings), e);
+        if (heap.size() < this->NumberOfPathsPerTarget)
+          {
+          heap.push_back(path);
+          std::push_heap(heap.begin(), heap.end());
+          }
+        else if (path < heap.front())
+          {
+          std::pop_heap(heap.begin(), heap.end());
+          heap.back() = path;
+          std::push_heap(heap.begin(), heap.end());
+          }
+        }
+
+      std::lock_guard<std::mutex> lock(this->Mutex);
+      std::vector<RankedPath>& shared = this->Heaps[t];
+      for (size_t k = 0; k < heap.size(); k ++)
+        {
+        if (shared.size() < this->NumberOfPathsPerTarget)
+          {
+          shared.push_back(heap[k]);
+          std::push_heap(shared.begin(), shared.end());
+          }
+        else if (heap[k] < shared.front())
+          {
+          std::pop_heap(shared.begin(), shared.end());
+          shared.back() = heap[k];
+          std::push_heap(shared.begin(), shared.end());
+          }
+        }
+      }
+  }
+};
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerLogic
+::RankPaths(int numberOfPathsPerTarget, vtkIdList* targetPointIds,
+            vtkIdList* entryPointIds, vtkDoubleArray* costs)
+{
+  this->PrepareEvaluation();
+  return this->RankPaths(this->EntryPoints, this->TargetPoints, numberOfPathsPerTarget,
+                         targetPointIds, entryPointIds, costs);
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerLogic
+::RankPaths(vtkSlicerPathPlannerPointStore* entryPoints,
+            vtkSlicerPathPlannerPointStore* targetPoints, int numberOfPathsPerTarget,
+            vtkIdList* targetPointIds, vtkIdList* entryPointIds, vtkDoubleArray* costs)
+{
+  if (!targetPointIds || !entryPointIds)
+    {
+    return 0;
+    }
+  targetPointIds->Reset();
+  entryPointIds->Reset();
+  if (costs)
+    {
+    costs->Reset();
+    }
+  vtkIdType nEntries = entryPoints->GetNumberOfPoints();
+  vtkIdType nTargets = targetPoints->GetNumberOfPoints();
+  if (nEntries == 0 || nTargets == 0 || numberOfPathsPerTarget <= 0)
+    {
+    return 0;
+    }
+
+  RankingFunctor functor;
+  functor.Logic = this;
+  functor.EntryCoordinates[0] = entryPoints->GetR();
+  functor.EntryCoordinates[1] = entryPoints->GetA();
+  functor.EntryCoordinates[2] = entryPoints->GetS();
+  functor.TargetCoordinates[0] = targetPoints->GetR();
+  functor.TargetCoordinates[1] = targetPoints->GetA();
+  functor.TargetCoordinates[2] = targetPoints->GetS();
+  functor.NumberOfEntries = nEntries;
+  this->GetFeasibilityLimits(functor.Reference, &functor.MaximumLength,
+                             &functor.MinimumCosine);
+  functor.Scalars = 0;
+  functor.Field = 0;
+  if (this->LabelMap)
+    {
+    functor.Initialize(this->LabelMap, this->RASToIJK, 0);
+    functor.Scalars = this->LabelMap->GetScalarPointer();
+    functor.ScalarType = this->LabelMap->GetScalarType();
+    this->LabelMap->GetDimensions(functor.Dimensions);
+    functor.Field = this->DistanceField->IsEmpty() ? 0 : this->DistanceField;
+    }
+  functor.Trees = &this->SurfaceModels;
+  functor.NumberOfPathsPerTarget = static_cast<size_t>(numberOfPathsPerTarget);
+  functor.Heaps.resize(nTargets);
+
+  // Most candidates are dropped after the length and angle terms
+  vtkSlicerPathPlannerParallel::For(0, nEntries * nTargets, 256, functor);
+
+  vtkIdType nPaths = 0;
+  for (vtkIdType t = 0; t < nTargets; t ++)
+    {
+    std::vector<RankedPath>& heap = functor.Heaps[t];
+    std::sort_heap(heap.begin(), heap.end());
+    for (size_t k = 0; k < heap.size(); k ++)
+      {
+      targetPointIds->InsertNextId(targetPoints->GetId(t));
+      entryPointIds->InsertNextId(entryPoints->GetId(heap[k].second));
+      if (costs)
+        {
+        costs->InsertNextValue(heap[k].first);
+        }
+      nPaths ++;
+      }
+    }
+  return nPaths;
+}
+
+//---------------------------------------------------------------------------
+bool vtkSlicerPathPlannerLogic::WritePaths(const char* fileName)
+{
+  if (!fileName)
+    {
+    return false;
+    }
+  std::ofstream file(fileName);
+  if (!file)
+    {
+    vtkErrorMacro(<< "WritePaths: cannot open " << fileName);
+    return false;
+    }
+
+  file << "Name,Target,Entry,TargetR,TargetA,TargetS,EntryR,EntryA,EntryS,"
+          "Length,DirectionR,DirectionA,DirectionS,InsertionAngle,Feasible,Hits,"
+          "Clearance,ClearanceDepth,Models,Cost\n";
+  file.precision(10);
+
+  vtkIdType nPaths = this->Paths->GetNumberOfPaths();
+  for (vtkIdType i = 0; i < nPaths; i ++)
+    {
+    vtkIdType target = this->TargetPoints->GetIndex(this->Paths->GetTargetPointId(i));
+    vtkIdType entry = this->EntryPoints->GetIndex(this->Paths->GetEntryPointId(i));
+    double targetPosition[3];
+    double entryPosition[3];
+    double direction[3];
+    this->Paths->GetTargetPosition(i, targetPosition);
+    this->Paths->GetEntryPosition(i, entryPosition);
+    this->Paths->GetDirection(i, direction);
+    double length = this->Paths->GetLength(i);
+    double insertionAngle = this->Paths->GetInsertionAngle(i);
+
+    file << QuoteField(this->Paths->GetName(i)) << ","
+         << QuoteField(target >= 0 ? this->TargetPoints->GetName(target) : "") << ","
+         << QuoteField(entry >= 0 ? this->EntryPoints->GetName(entry) : "") << ","
+         << targetPosition[0] << "," << targetPosition[1] << "," << targetPosition[2] << ","
+         << entryPosition[0] << "," << entryPosition[1] << "," << entryPosition[2] << ","
+         << length << ","
+         << direction[0] << "," << direction[1] << "," << direction[2] << ","
+         << insertionAngle << ","
+         << (this->IsFeasible(length, direction) ? 1 : 0) << ",";
+    int nHits = this->Paths->GetNumberOfHits(i);
+    for (int k = 0; k < nHits; k ++)
+      {
+      file << (k ? ";" : "") << this->Paths->GetHitLabel(i, k) << "@"
+           << this->Paths->GetHitDepth(i, k);
+      }
+    file << ",";
+    if (this->Paths->GetClearance(i) < VTK_DOUBLE_MAX)
+      {
+      file << this->Paths->GetClearance(i) << "," << this->Paths->GetClearanceDepth(i);
+      }
+    else
+      {
+      file << ",";
+      }
+    file << ",";
+    int nModels = this->Paths->GetNumberOfSurfaceModels();
+    std::string models;
+    for (int model = 0; model < nModels; model ++)
+      {
+      if (this->Paths->GetModelDistance(i, model) == VTK_DOUBLE_MAX)
+        {
+        continue;
+        }
+      std::ostringstream text;
+      text.precision(10);
+      text << (models.empty() ? "" : ";") << this->GetSurfaceModelName(model) << ":"
+           << this->Paths->GetModelDistance(i, model) << "@"
+           << this->Paths->GetModelDepth(i, model);
+      models += text.str();
+      }
+    file << QuoteField(models.c_str()) << "," << this->Paths->GetCost(i) << "\n";
+    }
+  return file.good();
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerPathPlannerLogic::GetNumberOfProbes()
+{
+  return vtkSlicerPathPlannerProfiler::GetNumberOfProbes();
+}
+
+//---------------------------------------------------------------------------
+const char* vtkSlicerPathPlannerLogic::GetProbeName(int probe)
+{
+  return vtkSlicerPathPlannerProfiler::GetProbeName(probe);
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerPathPlannerLogic::GetProbeIndex(const char* name)
+{
+  return vtkSlicerPathPlannerProfiler::GetProbeIndex(name);
+}
+
+//---------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerLogic::GetProbeCallCount(int probe)
+{
+  return vtkSlicerPathPlannerProfiler::GetCallCount(probe);
+}
+
+//---------------------------------------------------------------------------
+double vtkSlicerPathPlannerLogic::GetProbeLatencyPercentile(int probe, double percentile)
+{
+  return vtkSlicerPathPlannerProfiler::GetLatencyPercentile(probe, percentile);
+}
+
+//---------------------------------------------------------------------------
+double vtkSlicerPathPlannerLogic::GetProbeMaximumLatency(int probe)
+{
+  return vtkSlicerPathPlannerProfiler::GetMaximumLatency(probe);
+}
+
+//---------------------------------------------------------------------------
+int vtkSlicerPathPlannerLogic::GetProbeMaximumDepth(int probe)
+{
+  return vtkSlicerPathPlannerProfiler::GetMaximumDepth(probe);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerPathPlannerLogic::ResetProbes()
+{
+  vtkSlicerPathPlannerProfiler::Reset();
+}
@@ -15,10 +15,11 @@
 
 ==============================================================================*/
 
-// .NAME vtkSlicerPathPlannerLogic - slicer logic class for volumes manipulation
+// .NAME vtkSlicerPathPlannerLogic - slicer logic class for needle path planning
 // .SECTION Description
-// This class manages the logic associated with reading, saving,
-// and changing propertied of the volumes
+// This class manages the logic associated with planning needle trajectories
+// between entry and target points. The trajectory geometry is computed here,
+// on plain coordinate arrays, so that paths can be planned without the GUI.
 
 
 #ifndef __vtkSlicerPathPlannerLogic_h
@@ -28,9 +29,32 @@
 #include "vtkSlicerModuleLogic.h"
 
 // MRML includes
+class vtkMRMLAnnotationHierarchyNode;
+class vtkMRMLModelNode;
+class vtkMRMLScalarVolumeNode;
+
+// VTK includes
+class vtkDoubleArray;
+class vtkIdList;
+class vtkImageData;
+class vtkMatrix4x4;
+class vtkPolyData;
+class vtkUnsignedCharArray;
+
+// PathPlanner includes
+class vtkSlicerPathPlannerDistanceField;
+class vtkSlicerPathPlannerExecutor;
+class vtkSlicerPathPlannerPathSet;
+class vtkSlicerPathPlannerPathStore;
+class vtkSlicerPathPlannerPointStore;
+class vtkSlicerPathPlannerPointTree;
+class vtkSlicerPathPlannerPoseFilter;
+class vtkSlicerPathPlannerTriangleTree;
 
 // STD includes
 #include <cstdlib>
+#include <string>
+#include <vector>
 
 #include "vtkSlicerPathPlannerModuleLogicExport.h"
 
@@ -45,6 +69,320 @@ public:
   vtkTypeMacro(vtkSlicerPathPlannerLogic, vtkSlicerModuleLogic);
   void PrintSelf(ostream& os, vtkIndent indent);
 
+  /// Entry points, target points and paths of the current plan.
+  /// The stores are owned by the logic.
+  vtkGetObjectMacro(EntryPoints, vtkSlicerPathPlannerPointStore);
+  vtkGetObjectMacro(TargetPoints, vtkSlicerPathPlannerPointStore);
+  vtkGetObjectMacro(Paths, vtkSlicerPathPlannerPathStore);
+
+  /// Polydata of all the paths of the path store, one line cell each,
+  /// to draw them at once instead of one ruler per path. Call its Update()
+  /// after the paths changed.
+  vtkGetObjectMacro(PathSet, vtkSlicerPathPlannerPathSet);
+
+  /// Refresh the end point coordinates of the path at pathIndex from the
+  /// entry and target point stores and recompute its geometry.
+  /// All the paths are updated in one batch if pathIndex is -1.
+  void UpdatePathGeometry(vtkIdType pathIndex = -1);
+
+  /// Only refresh the end point coordinates of the path at pathIndex (all
+  /// the paths if -1) from the point stores.
+  void UpdateEndPointPositions(vtkIdType pathIndex = -1);
+
+  /// Recompute only the paths that start at the entry point (end at the
+  /// target point) of the given ID, e.g. after the point was moved.
+  /// The indices of the updated paths are returned in pathIndices if not NULL.
+  void UpdatePathsOfEntryPoint(vtkIdType pointId, vtkIdList* pathIndices = 0);
+  void UpdatePathsOfTargetPoint(vtkIdType pointId, vtkIdList* pathIndices = 0);
+
+  /// Background versions of the above, e.g. while the point is dragged:
+  /// the end point positions of the paths are refreshed at once, the rest
+  /// of the evaluation runs on the executor against a copy of the paths.
+  /// A queued or running update of the same point is canceled: only its
+  /// latest position is evaluated. See CollectPathUpdates().
+  void UpdatePathsOfEntryPointAsync(vtkIdType pointId);
+  void UpdatePathsOfTargetPointAsync(vtkIdType pointId);
+
+  /// Same for the paths at the given indices, e.g. the paths whose end
+  /// points were refreshed. Such updates are not canceled by later ones.
+  void UpdatePathsAsync(vtkIdList* pathIndices);
+
+  /// Evaluate all the paths again in the background, e.g. once the
+  /// labelmap or the surface models changed, after canceling the updates
+  /// in progress. The distance field and the surface model trees are
+  /// computed by the job first: until they are, PrepareEvaluation() and
+  /// the checks run on the calling thread wait for it.
+  void UpdateAllPathsAsync();
+
+  /// Function called on the worker thread whenever a background update
+  /// finished, e.g. to schedule CollectPathUpdates() on the GUI thread. It
+  /// must not call the logic. NULL (default) for none.
+  void SetPathUpdateCallback(void (*callback)(void* clientData), void* clientData);
+
+  /// Copy the results of the finished background updates into the path
+  /// store. The results of paths removed or whose end points moved since
+  /// are dropped. The indices of the updated paths are returned in
+  /// pathIndices if not NULL. Return the number of paths updated.
+  vtkIdType CollectPathUpdates(vtkIdList* pathIndices = 0);
+
+  /// Number of background updates queued, running or not collected yet
+  int GetNumberOfPendingPathUpdates();
+
+  /// Cancel the background updates, wait for the running ones to return
+  /// and drop their results. Done before the labelmap, the distance field
+  /// or the surface models change under them.
+  void CancelPathUpdates();
+
+  /// Pool of worker threads running the background updates
+  vtkGetObjectMacro(Executor, vtkSlicerPathPlannerExecutor);
+
+  /// Latency compensating filter of the tracked needle pose, between the
+  /// tracker and the deviation from the plan. Configure it here (e.g.
+  /// its Latency from Python).
+  vtkGetObjectMacro(PoseFilter, vtkSlicerPathPlannerPoseFilter);
+
+  /// Compute the distance field and the trees of the surface models if
+  /// they are out of date, so that EvaluatePaths() may run on any thread.
+  void PrepareEvaluation();
+
+  /// Compute the geometry, collisions, clearance, surface model distances
+  /// and cost of the path at pathIndex (all the paths if -1) of a path
+  /// store, e.g. a copy of the paths evaluated on a worker thread. The end
+  /// point positions are used as they are. Call PrepareEvaluation() first.
+  void EvaluatePaths(vtkSlicerPathPlannerPathStore* paths, vtkIdType pathIndex = -1);
+
+  /// Direction against which the insertion angle of a trajectory is measured.
+  /// It does not need to be normalized. (0,0,1) (superior) by default.
+  /// Changing it, like the limits and weights below, cancels the background
+  /// updates, which read it.
+  void SetReferenceDirection(double x, double y, double z);
+  void SetReferenceDirection(double direction[3]);
+  vtkGetVector3Macro(ReferenceDirection, double);
+
+  /// Compute the geometry of a batch of trajectories.
+  /// entryPoints and targetPoints hold numberOfTrajectories packed (R,A,S)
+  /// triplets. lengths and insertionAngles receive numberOfTrajectories values,
+  /// directions receives numberOfTrajectories packed unit vectors pointing
+  /// from the entry point to the target point. Any output may be NULL.
+  /// The insertion angle is given in degrees against ReferenceDirection.
+  void ComputeTrajectories(const double* entryPoints, const double* targetPoints,
+                           vtkIdType numberOfTrajectories, double* lengths,
+                           double* directions, double* insertionAngles);
+
+  /// Same as above, on 3-component arrays. The output arrays are resized to
+  /// the number of tuples of entryPoints. Any output may be NULL.
+  void ComputeTrajectories(vtkDoubleArray* entryPoints, vtkDoubleArray* targetPoints,
+                           vtkDoubleArray* lengths, vtkDoubleArray* directions,
+                           vtkDoubleArray* insertionAngles);
+
+  /// Compute the geometry of a single trajectory and return its length.
+  /// direction and insertionAngle are optional outputs.
+  double ComputeTrajectory(const double entryPoint[3], const double targetPoint[3],
+                           double direction[3] = 0, double* insertionAngle = 0);
+
+  /// Longest feasible trajectory, in mm. 0 (default) means no limit.
+  void SetMaximumPathLength(double maximumPathLength);
+  vtkGetMacro(MaximumPathLength, double);
+
+  /// Largest feasible insertion angle against ReferenceDirection, in degrees.
+  /// 180 (default) means no limit.
+  void SetMaximumInsertionAngle(double maximumInsertionAngle);
+  vtkGetMacro(MaximumInsertionAngle, double);
+
+  /// Evaluate every entry x target trajectory in one call.
+  /// Coordinates are given as structure of arrays: entryPoints[0], [1] and [2]
+  /// hold the R, A and S coordinates of the numberOfEntryPoints entry points
+  /// (same for the target points). The outputs hold
+  /// numberOfTargetPoints * numberOfEntryPoints values, the trajectory from
+  /// entry point e to target point t being at index
+  /// t * numberOfEntryPoints + e. directions (three arrays, entry -> target
+  /// unit vector) is optional. feasible is set to 1 for the trajectories
+  /// of non-zero length within MaximumPathLength and MaximumInsertionAngle,
+  /// 0 otherwise. Every planner of the logic uses this definition.
+  void ComputeTrajectoryMatrix(const double* const entryPoints[3], vtkIdType numberOfEntryPoints,
+                               const double* const targetPoints[3], vtkIdType numberOfTargetPoints,
+                               double* lengths, double* const directions[3],
+                               unsigned char* feasible);
+
+  /// Same as above, on 3-component (packed R,A,S) arrays. directions is
+  /// filled with 3-component tuples. Any output but lengths may be NULL.
+  void ComputeTrajectoryMatrix(vtkDoubleArray* entryPoints, vtkDoubleArray* targetPoints,
+                               vtkDoubleArray* lengths, vtkDoubleArray* directions,
+                               vtkUnsignedCharArray* feasible);
+
+  /// Find the feasible entry x target paths, shortest first. The target
+  /// and entry point IDs of the paths are returned in targetPointIds and
+  /// entryPointIds. Return the number of paths found.
+  vtkIdType FindFeasiblePaths(vtkIdList* targetPointIds, vtkIdList* entryPointIds);
+
+  /// Replace the paths by every feasible entry x target path, shortest
+  /// first, named P_1, P_2... and compute their geometry.
+  /// Return the number of paths.
+  vtkIdType GenerateAllPaths();
+
+  /// Weights of the cost of a path (see ComputePathCost()): per mm of
+  /// length (1 by default), per degree of insertion angle (1), per mm of
+  /// clearance below ClearanceMargin (10) and per structure crossed (1000).
+  void SetLengthWeight(double lengthWeight);
+  vtkGetMacro(LengthWeight, double);
+  void SetInsertionAngleWeight(double insertionAngleWeight);
+  vtkGetMacro(InsertionAngleWeight, double);
+  void SetClearanceWeight(double clearanceWeight);
+  vtkGetMacro(ClearanceWeight, double);
+  void SetCrossingWeight(double crossingWeight);
+  vtkGetMacro(CrossingWeight, double);
+
+  /// Clearance in mm beyond which a path is not penalized (10 by default)
+  void SetClearanceMargin(double clearanceMargin);
+  vtkGetMacro(ClearanceMargin, double);
+
+  /// Weighted cost of a path, the lower the better. clearance is the
+  /// smallest distance to the structures of the labelmap and to the
+  /// surface models (VTK_DOUBLE_MAX if there are none), numberOfCrossings
+  /// the number of labels and surface models crossed.
+  double ComputePathCost(double length, double insertionAngle,
+                         double clearance, int numberOfCrossings) const;
+
+  /// Store in the path store the cost of the path at pathIndex (all the
+  /// paths if -1), from its geometry and its labelmap and surface model
+  /// checks. Done by UpdatePathGeometry().
+  void ComputePathCosts(vtkIdType pathIndex = -1);
+
+  /// Rank every feasible entry x target path by cost and keep the
+  /// numberOfPathsPerTarget cheapest ones of each target. The candidates
+  /// are evaluated across the available cores, each keeping a bounded heap
+  /// per target; the labelmap and surface models are only checked for the
+  /// candidates that may still enter the heap. The paths are returned
+  /// target by target (in the order of the target store), cheapest first:
+  /// target and entry point IDs in targetPointIds and entryPointIds, cost
+  /// in costs if not NULL. Return the number of paths.
+  vtkIdType RankPaths(int numberOfPathsPerTarget, vtkIdList* targetPointIds,
+                      vtkIdList* entryPointIds, vtkDoubleArray* costs = 0);
+
+  /// Replace the paths by the numberOfPathsPerTarget cheapest paths of each
+  /// target (see RankPaths()), named P_1, P_2... and compute their
+  /// geometry. Return the number of paths.
+  vtkIdType GenerateBestPaths(int numberOfPathsPerTarget);
+
+  /// Planning pipeline behind GenerateBestPaths() (GenerateAllPaths() if
+  /// numberOfPathsPerTarget is 0) on snapshots of the point stores (see
+  /// vtkSlicerPathPlannerPointStore::DeepCopy()), so that it may run on a
+  /// worker thread while the stores keep changing: paths is filled with
+  /// the paths found, which are evaluated (see EvaluatePaths()). Call
+  /// PrepareEvaluation() first. Return the number of paths.
+  vtkIdType PlanPaths(vtkSlicerPathPlannerPointStore* entryPoints,
+                      vtkSlicerPathPlannerPointStore* targetPoints,
+                      int numberOfPathsPerTarget, vtkSlicerPathPlannerPathStore* paths);
+
+  /// k-d tree over the entry points, rebuilt on the first query after the
+  /// entry point store is modified.
+  vtkSlicerPathPlannerPointTree* GetEntryPointTree();
+
+  /// Find the numberOfEntryPoints entry points closest to the target point
+  /// of the given ID whose path to it is feasible (within
+  /// MaximumPathLength and MaximumInsertionAngle). Their IDs are returned
+  /// in entryPointIds, closest first. Return the number of points found.
+  vtkIdType SuggestEntryPoints(vtkIdType targetPointId, int numberOfEntryPoints,
+                               vtkIdList* entryPointIds);
+
+  /// Append the points of a text file to a point store, one point per line:
+  /// name,R,A,S[,...] (.csv, or a Slicer .fcsv fiducial list). Empty lines,
+  /// comments (#) and lines without 3 numeric coordinates (e.g. a header)
+  /// are skipped. Return the number of points read, -1 on error.
+  vtkIdType ReadPoints(const char* fileName, vtkSlicerPathPlannerPointStore* points);
+
+  /// Append the fiducials of an annotation hierarchy to a point store.
+  /// Return the number of points added.
+  vtkIdType ImportPoints(vtkMRMLAnnotationHierarchyNode* hierarchy,
+                         vtkSlicerPathPlannerPointStore* points);
+
+  /// Append to the entry points candidates sampled about spacing mm apart
+  /// on a skin surface (RAS coordinates), with their outward normals (see
+  /// vtkSlicerPathPlannerSkinSampler). The points are not backed by MRML
+  /// nodes. Return the number of points added.
+  vtkIdType SampleSkinSurface(vtkPolyData* skin, double spacing);
+  vtkIdType SampleSkinModelNode(vtkMRMLModelNode* modelNode, double spacing);
+
+  /// Same as above on the outer boundary of the voxels of a volume (e.g. a
+  /// CT) at or above threshold, -300 HU being a good skin threshold. The
+  /// IJK indices of rasToIJK are those of the volume extent.
+  vtkIdType SampleSkinVolume(vtkImageData* volume, vtkMatrix4x4* rasToIJK,
+                             double threshold, double spacing);
+  vtkIdType SampleSkinVolumeNode(vtkMRMLScalarVolumeNode* volumeNode,
+                                 double threshold, double spacing);
+
+  /// Labelmap against which the paths are checked (see CheckCollisions()),
+  /// NULL (default) for none. rasToIJK maps the RAS coordinates to the
+  /// continuous IJK indices of the labelmap; it is copied. The labelmap
+  /// must have a single scalar component.
+  void SetLabelMap(vtkImageData* labelMap, vtkMatrix4x4* rasToIJK);
+  vtkGetObjectMacro(LabelMap, vtkImageData);
+
+  /// Same as above, from the image data and RAS to IJK matrix of a
+  /// labelmap volume node. NULL clears the labelmap.
+  void SetLabelMapVolumeNode(vtkMRMLScalarVolumeNode* volumeNode);
+
+  /// Walk the voxels of the labelmap crossed by the path at pathIndex (all
+  /// the paths, across the available cores, if -1) and store in the path
+  /// store the labels it enters, with their depth in mm from the entry
+  /// point. Done by UpdatePathGeometry() when a labelmap is set.
+  /// Return the number of checked paths that hit at least one label.
+  vtkIdType CheckCollisions(vtkIdType pathIndex = -1);
+
+  /// Signed distance field of the structures of the labelmap. It is
+  /// computed on the first call after the labelmap (or its matrix) is
+  /// modified, and cached.
+  vtkSlicerPathPlannerDistanceField* GetDistanceField();
+
+  /// Store in the path store the smallest distance from the path at
+  /// pathIndex (all the paths, across the available cores, if -1) to the
+  /// structures of the labelmap and the depth at which it is reached, from
+  /// trilinear lookups in the distance field. Done by UpdatePathGeometry()
+  /// when a labelmap is set.
+  void ComputeClearances(vtkIdType pathIndex = -1);
+
+  /// Add a surface (e.g. a vessel or skull model, in RAS coordinates)
+  /// against which the paths are checked (see CheckSurfaceModels()). A
+  /// bounding volume hierarchy of its triangles is built on the first check
+  /// and rebuilt only when the surface is modified. The model distances of
+  /// the path store are reset. Return the index of the model.
+  int AddSurfaceModel(vtkPolyData* surface, const char* name);
+
+  /// Same as above, from the polydata and name of a model node. Return -1
+  /// if the node has no polydata.
+  int AddSurfaceModelNode(vtkMRMLModelNode* modelNode);
+
+  void RemoveAllSurfaceModels();
+  int GetNumberOfSurfaceModels() const;
+  const char* GetSurfaceModelName(int model) const;
+
+  /// Intersect the path at pathIndex (all the paths, across the available
+  /// cores, if -1) with each surface model and store in the path store its
+  /// distance to the model (0 if it crosses it) and the depth in mm from
+  /// the entry point of the first crossing or of the closest point. Done by
+  /// UpdatePathGeometry() when surface models are set.
+  /// Return the number of checked paths that cross at least one model.
+  vtkIdType CheckSurfaceModels(vtkIdType pathIndex = -1);
+
+  /// Write the path table as CSV: name, target and entry point names and
+  /// positions, length, direction, insertion angle, feasibility, the
+  /// labels hit (label@depth, separated by ';'), the clearance with its
+  /// depth (empty without labelmap), the distance to each surface model
+  /// (name:distance@depth, separated by ';') and the cost.
+  /// Return false if the file cannot be written.
+  bool WritePaths(const char* fileName);
+
+  /// Latency of the instrumented handlers (see vtkSlicerPathPlannerProfiler).
+  /// probe is an index in [0, GetNumberOfProbes()), latencies are in ms.
+  int GetNumberOfProbes();
+  const char* GetProbeName(int probe);
+  int GetProbeIndex(const char* name);
+  vtkIdType GetProbeCallCount(int probe);
+  double GetProbeLatencyPercentile(int probe, double percentile);
+  double GetProbeMaximumLatency(int probe);
+  int GetProbeMaximumDepth(int probe);
+  void ResetProbes();
+
 protected:
   vtkSlicerPathPlannerLogic();
   virtual ~vtkSlicerPathPlannerLogic();
@@ -55,7 +393,99 @@ protected:
   virtual void UpdateFromMRMLScene();
   virtual void OnMRMLSceneNodeAdded(vtkMRMLNode* node);
   virtual void OnMRMLSceneNodeRemoved(vtkMRMLNode* node);
+
+  /// Same as the public versions, on the paths of the given store
+  vtkIdType CheckCollisions(vtkSlicerPathPlannerPathStore* paths, vtkIdType pathIndex);
+  void ComputeClearances(vtkSlicerPathPlannerPathStore* paths, vtkIdType pathIndex);
+  vtkIdType CheckSurfaceModels(vtkSlicerPathPlannerPathStore* paths, vtkIdType pathIndex);
+  void ComputePathCosts(vtkSlicerPathPlannerPathStore* paths, vtkIdType pathIndex);
+
+  // Indices of the paths starting at the entry point (ending at the target
+  // point) of the given ID
+  void FindPathsOfPoint(vtkIdType pointId, bool target, vtkIdList* pathIndices);
+  // Refresh the end points of the paths at pathIndices and evaluate them
+  // together, in one EvaluatePaths() pass over a copy
+  void UpdatePaths(vtkIdList* pathIndices);
+  void UpdatePathsOfPointAsync(vtkIdType pointId, bool target);
+  // Evaluate a copy of the paths at pathIndices on the executor, canceling
+  // the previous update of the same kind (vtkPathUpdates::Kind) and key.
+  // If prepare is true, the job also computes the distance field and the
+  // surface model trees beforehand.
+  void SubmitPathUpdate(vtkIdList* pathIndices, int kind, vtkIdType key,
+                        bool prepare = false);
+
+  // Whether the distance field or a surface model tree is out of date
+  bool DistanceFieldNeedsUpdate();
+  bool NeedsPreparation();
+  // Compute them without canceling the background updates: only when no
+  // job reads them, e.g. from the job of UpdateAllPathsAsync()
+  void UpdateDistanceField();
+  void BuildEvaluationData();
+  // Block until the job of UpdateAllPathsAsync() computed them
+  void WaitForPreparation();
+
+  vtkSlicerPathPlannerPointStore* EntryPoints;
+  vtkSlicerPathPlannerPointStore* TargetPoints;
+  vtkSlicerPathPlannerPathStore* Paths;
+  vtkSlicerPathPlannerPointTree* EntryPointTree;
+
+  double ReferenceDirection[3];
+  double MaximumPathLength;
+  double MaximumInsertionAngle;
+
+  double LengthWeight;
+  double InsertionAngleWeight;
+  double ClearanceWeight;
+  double CrossingWeight;
+  double ClearanceMargin;
+
+  vtkImageData* LabelMap;
+  vtkMatrix4x4* RASToIJK;
+  vtkSlicerPathPlannerDistanceField* DistanceField;
+  vtkTimeStamp LabelMapTime;
+  vtkTimeStamp DistanceFieldTime;
+
+  //BTX
+  std::vector<vtkSlicerPathPlannerTriangleTree*> SurfaceModels;
+  std::vector<std::string> SurfaceModelNames;
+
+  // Background path updates: finished results and token of the latest
+  // update of each point
+  class vtkPathUpdates;
+  vtkPathUpdates* PathUpdates;
+  //ETX
+  vtkSlicerPathPlannerExecutor* Executor;
+  vtkSlicerPathPlannerPoseFilter* PoseFilter;
+  vtkSlicerPathPlannerPathSet* PathSet;
+
 private:
+  /// Normalized ReferenceDirection and limits of the feasibility test of
+  /// vtkSlicerPathPlannerTrajectoryKernel::IsFeasible(): MaximumPathLength
+  /// (VTK_DOUBLE_MAX if there is no limit) and the cosine of
+  /// MaximumInsertionAngle
+  void GetFeasibilityLimits(double reference[3], double* maximumLength,
+                            double* minimumCosine) const;
+  /// Return true if the trajectory of the given length and unit direction
+  /// (entry -> target, see ComputeTrajectory()) is feasible
+  bool IsFeasible(double length, const double direction[3]) const;
+
+  /// Same as the public versions, on the given point stores
+  vtkIdType FindFeasiblePaths(vtkSlicerPathPlannerPointStore* entryPoints,
+                              vtkSlicerPathPlannerPointStore* targetPoints,
+                              vtkIdList* targetPointIds, vtkIdList* entryPointIds);
+  vtkIdType RankPaths(vtkSlicerPathPlannerPointStore* entryPoints,
+                      vtkSlicerPathPlannerPointStore* targetPoints, int numberOfPathsPerTarget,
+                      vtkIdList* targetPointIds, vtkIdList* entryPointIds,
+                      vtkDoubleArray* costs);
+
+  /// Replace the paths of a path store by the given target and entry point
+  /// pairs, named P_1, P_2..., at the positions of the points in the given
+  /// stores. Return the number of paths.
+  vtkIdType SetPaths(vtkSlicerPathPlannerPointStore* entryPoints,
+                     vtkSlicerPathPlannerPointStore* targetPoints,
+                     vtkIdList* targetPointIds, vtkIdList* entryPointIds,
+                     vtkSlicerPathPlannerPathStore* paths);
+
 
   vtkSlicerPathPlannerLogic(const vtkSlicerPathPlannerLogic&); // Not implemented
   void operator=(const vtkSlicerPathPlannerLogic&);               // Not implemented
@@ -0,0 +1,105 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner Logic includes
+#include "vtkSlicerPathPlannerExecutor.h"
+#include "vtkSlicerPathPlannerParallel.h"
+
+// VTK includes
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <algorithm>
+#include <atomic>
+
+//----------------------------------------------------------------------------
+namespace
+{
+struct ParallelForData
+{
+  vtkSlicerPathPlannerParallel::Functor* Functor;
+  vtkIdType Last;
+  vtkIdType Grain;
+  std::atomic<vtkIdType> Next;
+};
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE ParallelForThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  ParallelForData* data = static_cast<ParallelForData*>(info->UserData);
+
+  for (;;)
+    {
+    vtkIdType begin = data->Next.fetch_add(data->Grain);
+    if (begin >= data->Last)
+      {
+      break;
+      }
+    (*data->Functor)(begin, std::min(begin + data->Grain, data->Last));
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerParallel
+::For(vtkIdType first, vtkIdType last, vtkIdType grain, Functor& functor)
+{
+  if (first >= last)
+    {
+    return;
+    }
+  // In a job of an executor: split the range on its pool, with the token
+  // of the job
+  vtkSlicerPathPlannerExecutor* executor = vtkSlicerPathPlannerExecutor::GetCurrent();
+  const vtkSlicerPathPlannerExecutor::CancellationToken* token =
+    vtkSlicerPathPlannerExecutor::GetCurrentToken();
+  if (executor && token)
+    {
+    executor->For(first, last, grain, functor, *token);
+    return;
+    }
+
+  grain = std::max(grain, static_cast<vtkIdType>(1));
+  vtkIdType nChunks = (last - first + grain - 1) / grain;
+  int nThreads = static_cast<int>(std::min(
+    static_cast<vtkIdType>(vtkSlicerPathPlannerParallel::GetNumberOfThreads()), nChunks));
+  if (nThreads <= 1)
+    {
+    functor(first, last);
+    return;
+    }
+
+  ParallelForData data;
+  data.Functor = &functor;
+  data.Last = last;
+  data.Grain = grain;
+  data.Next.store(first);
+
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(nThreads);
+  threader->SetSingleMethod(ParallelForThread, &data);
+  threader->SingleMethodExecute();
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerPathPlannerParallel::GetNumberOfThreads()
+{
+  return vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+}
@@ -0,0 +1,57 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkSlicerPathPlannerParallel - parallel loop over a range of items
+// .SECTION Description
+// For() splits [first, last) into chunks of grain items that the threads of
+// a vtkMultiThreader pick one after the other, so that uneven chunks (e.g.
+// paths of different lengths) are balanced. The functor must only write
+// the items of the chunk it is given. Called from a job of a
+// vtkSlicerPathPlannerExecutor, For() runs on the work-stealing pool of the
+// executor instead, and skips the chunks not started yet once the job is
+// canceled: a canceled job must not trust what its loops computed.
+
+#ifndef __vtkSlicerPathPlannerParallel_h
+#define __vtkSlicerPathPlannerParallel_h
+
+// VTK includes
+#include <vtkType.h>
+
+#include "vtkSlicerPathPlannerModuleLogicExport.h"
+
+/// \ingroup Slicer_QtModules_PathPlanner
+class VTK_SLICER_PATHPLANNER_MODULE_LOGIC_EXPORT vtkSlicerPathPlannerParallel
+{
+public:
+  /// Work done on a chunk [begin, end) of the range
+  class Functor
+  {
+  public:
+    virtual ~Functor() {}
+    virtual void operator()(vtkIdType begin, vtkIdType end) = 0;
+  };
+
+  /// Run functor on [first, last) split in chunks of grain items (at least
+  /// 1). The range is processed on the calling thread if it fits in one
+  /// chunk. Return when all the chunks are done.
+  static void For(vtkIdType first, vtkIdType last, vtkIdType grain, Functor& functor);
+
+  /// Number of threads used by For(), the vtkMultiThreader default
+  static int GetNumberOfThreads();
+};
+
+#endif
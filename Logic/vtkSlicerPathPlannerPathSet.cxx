@@ -0,0 +1,197 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner Logic includes
+#include "vtkSlicerPathPlannerPathSet.h"
+#include "vtkSlicerPathPlannerPathStore.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkObjectFactory.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkUnsignedCharArray.h>
+
+// STD includes
+#include <algorithm>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerPathPlannerPathSet);
+vtkCxxSetObjectMacro(vtkSlicerPathPlannerPathSet, Paths, vtkSlicerPathPlannerPathStore);
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerPathSet::vtkSlicerPathPlannerPathSet()
+{
+  this->Paths = 0;
+  this->SelectedPathId = -1;
+  this->ScalarMode = CostScalars;
+  this->CostRange[0] = 0.0;
+  this->CostRange[1] = 1.0;
+  this->UpdateTime = 0;
+
+  this->Coordinates = vtkFloatArray::New();
+  this->Coordinates->SetNumberOfComponents(3);
+  this->Points = vtkPoints::New();
+  this->Points->SetData(this->Coordinates);
+
+  this->Connectivity = vtkIdTypeArray::New();
+  this->Lines = vtkCellArray::New();
+
+  this->Costs = vtkFloatArray::New();
+  this->Costs->SetName("Cost");
+  this->Selection = vtkUnsignedCharArray::New();
+  this->Selection->SetName("Selected");
+
+  this->Output = vtkPolyData::New();
+  this->Output->SetPoints(this->Points);
+  this->Output->SetLines(this->Lines);
+  this->Output->GetCellData()->AddArray(this->Costs);
+  this->Output->GetCellData()->AddArray(this->Selection);
+  this->Output->GetCellData()->SetActiveScalars("Cost");
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerPathSet::~vtkSlicerPathPlannerPathSet()
+{
+  this->SetPaths(0);
+  this->Output->Delete();
+  this->Points->Delete();
+  this->Coordinates->Delete();
+  this->Lines->Delete();
+  this->Connectivity->Delete();
+  this->Costs->Delete();
+  this->Selection->Delete();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPathSet::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "Paths: " << this->Paths << "\n";
+  os << indent << "SelectedPathId: " << this->SelectedPathId << "\n";
+  os << indent << "ScalarMode: "
+     << (this->ScalarMode == CostScalars ? "Cost" : "Selection") << "\n";
+  os << indent << "CostRange: " << this->CostRange[0] << ", " << this->CostRange[1] << "\n";
+}
+
+//----------------------------------------------------------------------------
+vtkPolyData* vtkSlicerPathPlannerPathSet::GetOutput()
+{
+  return this->Output;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPathSet::Update()
+{
+  unsigned long time = this->GetMTime();
+  if (this->Paths)
+    {
+    time = std::max(time, this->Paths->GetMTime());
+    }
+  if (time <= this->UpdateTime)
+    {
+    return;
+    }
+  this->UpdateTime = time;
+
+  // The paths backed by a ruler node are drawn by the ruler: they have
+  // points but no cell
+  vtkIdType nPaths = this->Paths ? this->Paths->GetNumberOfPaths() : 0;
+  vtkIdType nCells = 0;
+  for (vtkIdType i = 0; i < nPaths; i ++)
+    {
+    if (this->Paths->GetNodeID(i)[0] == '\0')
+      {
+      nCells ++;
+      }
+    }
+  // Shrinking the arrays keeps their memory: they are only reallocated
+  // when they grow
+  this->Coordinates->SetNumberOfTuples(2 * nPaths);
+  this->Costs->SetNumberOfTuples(nCells);
+  this->Selection->SetNumberOfTuples(nCells);
+  this->Connectivity->SetNumberOfValues(3 * nCells);
+
+  if (nPaths > 0)
+    {
+    const double* entries = this->Paths->GetEntryPositions();
+    const double* targets = this->Paths->GetTargetPositions();
+    const double* pathCosts = this->Paths->GetCosts();
+    vtkIdType selectedIndex = this->Paths->GetIndex(this->SelectedPathId);
+    float* coordinates = this->Coordinates->GetPointer(0);
+    this->CostRange[0] = VTK_DOUBLE_MAX;
+    this->CostRange[1] = VTK_DOUBLE_MIN;
+    for (vtkIdType i = 0; i < nPaths; i ++)
+      {
+      std::copy(entries + 3 * i, entries + 3 * i + 3, coordinates + 6 * i);
+      std::copy(targets + 3 * i, targets + 3 * i + 3, coordinates + 6 * i + 3);
+      if (pathCosts[i] != VTK_DOUBLE_MAX)
+        {
+        this->CostRange[0] = std::min(this->CostRange[0], pathCosts[i]);
+        this->CostRange[1] = std::max(this->CostRange[1], pathCosts[i]);
+        }
+      }
+    if (this->CostRange[0] > this->CostRange[1])
+      {
+      this->CostRange[0] = 0.0;
+      this->CostRange[1] = 1.0;
+      }
+
+    // One line from point 2 i to point 2 i + 1 per path without ruler;
+    // the paths not evaluated yet are drawn as the most expensive ones
+    vtkIdType* cell = this->Connectivity->GetPointer(0);
+    float* costs = this->Costs->GetPointer(0);
+    unsigned char* selection = this->Selection->GetPointer(0);
+    vtkIdType c = 0;
+    for (vtkIdType i = 0; i < nPaths; i ++)
+      {
+      if (this->Paths->GetNodeID(i)[0] != '\0')
+        {
+        continue;
+        }
+      cell[3 * c] = 2;
+      cell[3 * c + 1] = 2 * i;
+      cell[3 * c + 2] = 2 * i + 1;
+      costs[c] = static_cast<float>(
+        pathCosts[i] != VTK_DOUBLE_MAX ? pathCosts[i] : this->CostRange[1]);
+      selection[c] = (i == selectedIndex) ? 1 : 0;
+      c ++;
+      }
+    }
+  else
+    {
+    this->CostRange[0] = 0.0;
+    this->CostRange[1] = 1.0;
+    }
+
+  this->Lines->SetCells(nCells, this->Connectivity);
+  this->Output->GetCellData()->SetActiveScalars(
+    this->ScalarMode == CostScalars ? "Cost" : "Selected");
+
+  // The arrays were written in place: invalidate what the mappers cached
+  this->Coordinates->Modified();
+  this->Points->Modified();
+  this->Connectivity->Modified();
+  this->Lines->Modified();
+  this->Costs->Modified();
+  this->Selection->Modified();
+  this->Output->Modified();
+}
@@ -0,0 +1,118 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkSlicerPathPlannerPathSet - all the paths of a path store in one polydata
+// .SECTION Description
+// Draws the paths of a vtkSlicerPathPlannerPathStore as the line cells of a
+// single vtkPolyData, from the entry point (point 2 i) to the target point
+// (point 2 i + 1) of the path at index i, so that thousands of paths go
+// through one render pipeline instead of one ruler widget each. The paths
+// backed by a ruler node (see GetNodeID()) are left to their ruler: they
+// have their points but no cell, so that no path is drawn twice. The cells
+// carry the cost of their path ("Cost", float) and whether it is selected
+// ("Selected", unsigned char), one of which is the active scalars (see
+// ScalarMode). Update() refreshes the output in place: the arrays are only
+// reallocated when they grow, and nothing is done if neither the path
+// store nor the selection changed.
+
+#ifndef __vtkSlicerPathPlannerPathSet_h
+#define __vtkSlicerPathPlannerPathSet_h
+
+// VTK includes
+#include <vtkObject.h>
+
+#include "vtkSlicerPathPlannerModuleLogicExport.h"
+
+class vtkCellArray;
+class vtkFloatArray;
+class vtkIdTypeArray;
+class vtkPoints;
+class vtkPolyData;
+class vtkUnsignedCharArray;
+class vtkSlicerPathPlannerPathStore;
+
+/// \ingroup Slicer_QtModules_PathPlanner
+class VTK_SLICER_PATHPLANNER_MODULE_LOGIC_EXPORT vtkSlicerPathPlannerPathSet :
+  public vtkObject
+{
+public:
+
+  static vtkSlicerPathPlannerPathSet *New();
+  vtkTypeMacro(vtkSlicerPathPlannerPathSet, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Paths drawn
+  virtual void SetPaths(vtkSlicerPathPlannerPathStore* paths);
+  vtkGetObjectMacro(Paths, vtkSlicerPathPlannerPathStore);
+
+  /// ID of the selected path in Paths, -1 (default) for none
+  vtkSetMacro(SelectedPathId, vtkIdType);
+  vtkGetMacro(SelectedPathId, vtkIdType);
+
+  //BTX
+  enum
+    {
+    CostScalars = 0,
+    SelectionScalars
+    };
+  //ETX
+  /// Cell array set as the active scalars: the cost (default) or the
+  /// selection state of the paths
+  vtkSetClampMacro(ScalarMode, int, CostScalars, SelectionScalars);
+  vtkGetMacro(ScalarMode, int);
+  void SetScalarModeToCost() { this->SetScalarMode(CostScalars); }
+  void SetScalarModeToSelection() { this->SetScalarMode(SelectionScalars); }
+
+  /// Refresh the output from the path store. The paths whose cost is not
+  /// computed yet are given the highest cost of the others.
+  void Update();
+
+  /// Polydata of the paths. It is the same object for the lifetime of the
+  /// path set, so that a model node may observe it.
+  vtkPolyData* GetOutput();
+
+  /// Range of the costs of the evaluated paths, as of the last Update(),
+  /// e.g. the scalar range of a display node. (0, 1) if there are none.
+  vtkGetVector2Macro(CostRange, double);
+
+protected:
+  vtkSlicerPathPlannerPathSet();
+  virtual ~vtkSlicerPathPlannerPathSet();
+
+  vtkSlicerPathPlannerPathStore* Paths;
+  vtkIdType SelectedPathId;
+  int ScalarMode;
+  double CostRange[2];
+
+  vtkPolyData* Output;
+  vtkPoints* Points;
+  vtkFloatArray* Coordinates;
+  vtkCellArray* Lines;
+  vtkIdTypeArray* Connectivity;
+  vtkFloatArray* Costs;
+  vtkUnsignedCharArray* Selection;
+
+  // Modification time of the path set and of the path store as of the
+  // last Update()
+  unsigned long UpdateTime;
+
+private:
+  vtkSlicerPathPlannerPathSet(const vtkSlicerPathPlannerPathSet&); // Not implemented
+  void operator=(const vtkSlicerPathPlannerPathSet&);            // Not implemented
+};
+
+#endif
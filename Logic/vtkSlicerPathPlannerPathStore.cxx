@@ -0,0 +1,605 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner Logic includes
+#include "vtkSlicerPathPlannerPathStore.h"
+
+// VTK includes
+#include <vtkIdList.h>
+#include <vtkObjectFactory.h>
+
+// STD includes
+#include <algorithm>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerPathPlannerPathStore);
+
+//----------------------------------------------------------------------------
+namespace
+{
+template <class T>
+void EraseTuple(std::vector<T>& v, vtkIdType index, int numberOfComponents)
+{
+  v.erase(v.begin() + index * numberOfComponents,
+          v.begin() + (index + 1) * numberOfComponents);
+}
+
+// Move the tuples that are kept to the front, in order, and drop the rest
+template <class T>
+void EraseTuples(std::vector<T>& v, const std::vector<bool>& removed, int numberOfComponents)
+{
+  size_t kept = 0;
+  for (size_t i = 0; i < removed.size(); i ++)
+    {
+    if (removed[i])
+      {
+      continue;
+      }
+    for (int j = 0; j < numberOfComponents; j ++, kept ++)
+      {
+      if (kept != i * numberOfComponents + j)
+        {
+        std::swap(v[kept], v[i * numberOfComponents + j]);
+        }
+      }
+    }
+  v.resize(kept);
+}
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerPathStore::vtkSlicerPathPlannerPathStore()
+{
+  this->FirstId = 0;
+  this->NextId = 0;
+  this->NumberOfSurfaceModels = 0;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerPathStore::~vtkSlicerPathPlannerPathStore()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPathStore::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "NumberOfPaths: " << this->GetNumberOfPaths() << "\n";
+  os << indent << "NextId: " << this->NextId << "\n";
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerPathStore::AddPath(const char* name, const char* nodeID)
+{
+  vtkIdType id = this->NextId++;
+  this->IdToIndex.push_back(static_cast<vtkIdType>(this->Ids.size()));
+  this->Ids.push_back(id);
+  this->Names.push_back(name ? name : "");
+  this->NodeIDs.push_back(nodeID ? nodeID : "");
+  if (nodeID && *nodeID)
+    {
+    this->NodeIDToId.insert(std::make_pair(std::string(nodeID), id));
+    }
+  this->TargetPointIds.push_back(-1);
+  this->EntryPointIds.push_back(-1);
+  for (int j = 0; j < 3; j ++)
+    {
+    this->TargetPositions.push_back(0.0);
+    this->EntryPositions.push_back(0.0);
+    this->Directions.push_back(0.0);
+    }
+  this->Lengths.push_back(0.0);
+  this->InsertionAngles.push_back(0.0);
+  this->HitLabels.push_back(std::vector<int>());
+  this->HitDepths.push_back(std::vector<double>());
+  this->Clearances.push_back(VTK_DOUBLE_MAX);
+  this->ClearanceDepths.push_back(0.0);
+  this->Costs.push_back(VTK_DOUBLE_MAX);
+  this->ModelDistances.resize(this->ModelDistances.size() + this->NumberOfSurfaceModels,
+                              VTK_DOUBLE_MAX);
+  this->ModelDepths.resize(this->ModelDepths.size() + this->NumberOfSurfaceModels, 0.0);
+  this->Modified();
+  return id;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPathStore::RemovePath(vtkIdType index)
+{
+  if (index < 0 || index >= this->GetNumberOfPaths())
+    {
+    return;
+    }
+  this->IdToIndex[this->Ids[index] - this->FirstId] = -1;
+  this->RemoveNodeID(index);
+  EraseTuple(this->Ids, index, 1);
+  EraseTuple(this->Names, index, 1);
+  EraseTuple(this->NodeIDs, index, 1);
+  EraseTuple(this->TargetPointIds, index, 1);
+  EraseTuple(this->EntryPointIds, index, 1);
+  EraseTuple(this->TargetPositions, index, 3);
+  EraseTuple(this->EntryPositions, index, 3);
+  EraseTuple(this->Lengths, index, 1);
+  EraseTuple(this->Directions, index, 3);
+  EraseTuple(this->InsertionAngles, index, 1);
+  EraseTuple(this->HitLabels, index, 1);
+  EraseTuple(this->HitDepths, index, 1);
+  EraseTuple(this->Clearances, index, 1);
+  EraseTuple(this->ClearanceDepths, index, 1);
+  EraseTuple(this->Costs, index, 1);
+  EraseTuple(this->ModelDistances, index, this->NumberOfSurfaceModels);
+  EraseTuple(this->ModelDepths, index, this->NumberOfSurfaceModels);
+  this->UpdateIndices(index);
+  this->CompactIndices();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPathStore::RemovePaths(vtkIdList* indices)
+{
+  vtkIdType n = this->GetNumberOfPaths();
+  std::vector<bool> removed(n, false);
+  vtkIdType first = n;
+  for (vtkIdType k = 0; k < indices->GetNumberOfIds(); k ++)
+    {
+    vtkIdType index = indices->GetId(k);
+    if (index >= 0 && index < n && !removed[index])
+      {
+      removed[index] = true;
+      this->IdToIndex[this->Ids[index] - this->FirstId] = -1;
+      this->RemoveNodeID(index);
+      first = std::min(first, index);
+      }
+    }
+  if (first == n)
+    {
+    return;
+    }
+  EraseTuples(this->Ids, removed, 1);
+  EraseTuples(this->Names, removed, 1);
+  EraseTuples(this->NodeIDs, removed, 1);
+  EraseTuples(this->TargetPointIds, removed, 1);
+  EraseTuples(this->EntryPointIds, removed, 1);
+  EraseTuples(this->TargetPositions, removed, 3);
+  EraseTuples(this->EntryPositions, removed, 3);
+  EraseTuples(this->Lengths, removed, 1);
+  EraseTuples(this->Directions, removed, 3);
+  EraseTuples(this->InsertionAngles, removed, 1);
+  EraseTuples(this->HitLabels, removed, 1);
+  EraseTuples(this->HitDepths, removed, 1);
+  EraseTuples(this->Clearances, removed, 1);
+  EraseTuples(this->ClearanceDepths, removed, 1);
+  EraseTuples(this->Costs, removed, 1);
+  EraseTuples(this->ModelDistances, removed, this->NumberOfSurfaceModels);
+  EraseTuples(this->ModelDepths, removed, this->NumberOfSurfaceModels);
+  this->UpdateIndices(first);
+  this->CompactIndices();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPathStore::RemoveAllPaths()
+{
+  this->Ids.clear();
+  this->Names.clear();
+  this->NodeIDs.clear();
+  this->TargetPointIds.clear();
+  this->EntryPointIds.clear();
+  this->TargetPositions.clear();
+  this->EntryPositions.clear();
+  this->Lengths.clear();
+  this->Directions.clear();
+  this->InsertionAngles.clear();
+  this->HitLabels.clear();
+  this->HitDepths.clear();
+  this->Clearances.clear();
+  this->ClearanceDepths.clear();
+  this->Costs.clear();
+  this->ModelDistances.clear();
+  this->ModelDepths.clear();
+  this->NodeIDToId.clear();
+  this->CompactIndices();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPathStore::UpdateIndices(vtkIdType first)
+{
+  vtkIdType n = this->GetNumberOfPaths();
+  for (vtkIdType i = first; i < n; i ++)
+    {
+    this->IdToIndex[this->Ids[i] - this->FirstId] = i;
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPathStore::CompactIndices()
+{
+  // The paths stay in the order of their IDs: the first one is the oldest
+  vtkIdType oldestId = this->Ids.empty() ? this->NextId : this->Ids[0];
+  vtkIdType nDropped = oldestId - this->FirstId;
+  if (2 * nDropped < static_cast<vtkIdType>(this->IdToIndex.size()))
+    {
+    return;
+    }
+  this->IdToIndex.erase(this->IdToIndex.begin(), this->IdToIndex.begin() + nDropped);
+  this->FirstId = oldestId;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPathStore::RemoveNodeID(vtkIdType index)
+{
+  if (this->NodeIDs[index].empty())
+    {
+    return;
+    }
+  typedef std::unordered_multimap<std::string, vtkIdType>::iterator Iterator;
+  std::pair<Iterator, Iterator> range = this->NodeIDToId.equal_range(this->NodeIDs[index]);
+  for (Iterator it = range.first; it != range.second; ++ it)
+    {
+    if (it->second == this->Ids[index])
+      {
+      this->NodeIDToId.erase(it);
+      return;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerPathStore::GetNumberOfPaths() const
+{
+  return static_cast<vtkIdType>(this->Ids.size());
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerPathStore::GetIndex(vtkIdType id) const
+{
+  if (id < this->FirstId || id >= this->NextId)
+    {
+    return -1;
+    }
+  return this->IdToIndex[id - this->FirstId];
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerPathStore::GetId(vtkIdType index) const
+{
+  if (index < 0 || index >= this->GetNumberOfPaths())
+    {
+    return -1;
+    }
+  return this->Ids[index];
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerPathStore::FindIndexByNodeID(const char* nodeID) const
+{
+  if (!nodeID || !*nodeID)
+    {
+    return -1;
+    }
+  // the oldest path backed by the node comes first
+  typedef std::unordered_multimap<std::string, vtkIdType>::const_iterator Iterator;
+  std::pair<Iterator, Iterator> range = this->NodeIDToId.equal_range(nodeID);
+  vtkIdType id = this->NextId;
+  for (Iterator it = range.first; it != range.second; ++ it)
+    {
+    id = std::min(id, it->second);
+    }
+  return this->GetIndex(id);
+}
+
+//----------------------------------------------------------------------------
+const char* vtkSlicerPathPlannerPathStore::GetName(vtkIdType index) const
+{
+  return this->Names[index].c_str();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPathStore::SetName(vtkIdType index, const char* name)
+{
+  std::string newName(name ? name : "");
+  if (this->Names[index] == newName)
+    {
+    return;
+    }
+  this->Names[index] = newName;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+const char* vtkSlicerPathPlannerPathStore::GetNodeID(vtkIdType index) const
+{
+  return this->NodeIDs[index].c_str();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPathStore
+::SetTarget(vtkIdType index, vtkIdType pointId, const double position[3])
+{
+  this->TargetPointIds[index] = pointId;
+  for (int j = 0; j < 3; j ++)
+    {
+    this->TargetPositions[3*index+j] = position[j];
+    }
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPathStore
+::SetEntry(vtkIdType index, vtkIdType pointId, const double position[3])
+{
+  this->EntryPointIds[index] = pointId;
+  for (int j = 0; j < 3; j ++)
+    {
+    this->EntryPositions[3*index+j] = position[j];
+    }
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerPathStore::GetTargetPointId(vtkIdType index) const
+{
+  return this->TargetPointIds[index];
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerPathStore::GetEntryPointId(vtkIdType index) const
+{
+  return this->EntryPointIds[index];
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPathStore
+::GetTargetPosition(vtkIdType index, double position[3]) const
+{
+  for (int j = 0; j < 3; j ++)
+    {
+    position[j] = this->TargetPositions[3*index+j];
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPathStore
+::GetEntryPosition(vtkIdType index, double position[3]) const
+{
+  for (int j = 0; j < 3; j ++)
+    {
+    position[j] = this->EntryPositions[3*index+j];
+    }
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerPathPlannerPathStore::GetLength(vtkIdType index) const
+{
+  return this->Lengths[index];
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPathStore
+::GetDirection(vtkIdType index, double direction[3]) const
+{
+  for (int j = 0; j < 3; j ++)
+    {
+    direction[j] = this->Directions[3*index+j];
+    }
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerPathPlannerPathStore::GetInsertionAngle(vtkIdType index) const
+{
+  return this->InsertionAngles[index];
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPathStore
+::SetHits(vtkIdType index, int numberOfHits, const int* labels, const double* depths)
+{
+  if (numberOfHits <= 0 && this->HitLabels[index].empty())
+    {
+    return;
+    }
+  numberOfHits = std::max(numberOfHits, 0);
+  this->HitLabels[index].assign(labels, labels + numberOfHits);
+  this->HitDepths[index].assign(depths, depths + numberOfHits);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerPathPlannerPathStore::GetNumberOfHits(vtkIdType index) const
+{
+  return static_cast<int>(this->HitLabels[index].size());
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerPathPlannerPathStore::GetHitLabel(vtkIdType index, int hit) const
+{
+  return this->HitLabels[index][hit];
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerPathPlannerPathStore::GetHitDepth(vtkIdType index, int hit) const
+{
+  return this->HitDepths[index][hit];
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerPathPlannerPathStore::GetClearance(vtkIdType index) const
+{
+  return this->Clearances[index];
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerPathPlannerPathStore::GetClearanceDepth(vtkIdType index) const
+{
+  return this->ClearanceDepths[index];
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPathStore
+::SetClearance(vtkIdType index, double clearance, double depth)
+{
+  this->Clearances[index] = clearance;
+  this->ClearanceDepths[index] = depth;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerPathPlannerPathStore::GetCost(vtkIdType index) const
+{
+  return this->Costs[index];
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPathStore::SetCost(vtkIdType index, double cost)
+{
+  this->Costs[index] = cost;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPathStore
+::CopyPath(vtkIdType index, vtkSlicerPathPlannerPathStore* source, vtkIdType sourceIndex)
+{
+  if (!source)
+    {
+    return;
+    }
+  this->TargetPointIds[index] = source->TargetPointIds[sourceIndex];
+  this->EntryPointIds[index] = source->EntryPointIds[sourceIndex];
+  for (int j = 0; j < 3; j ++)
+    {
+    this->TargetPositions[3*index+j] = source->TargetPositions[3*sourceIndex+j];
+    this->EntryPositions[3*index+j] = source->EntryPositions[3*sourceIndex+j];
+    this->Directions[3*index+j] = source->Directions[3*sourceIndex+j];
+    }
+  this->Lengths[index] = source->Lengths[sourceIndex];
+  this->InsertionAngles[index] = source->InsertionAngles[sourceIndex];
+  this->HitLabels[index] = source->HitLabels[sourceIndex];
+  this->HitDepths[index] = source->HitDepths[sourceIndex];
+  this->Clearances[index] = source->Clearances[sourceIndex];
+  this->ClearanceDepths[index] = source->ClearanceDepths[sourceIndex];
+  this->Costs[index] = source->Costs[sourceIndex];
+  int nModels = this->NumberOfSurfaceModels;
+  if (nModels > 0 && nModels == source->NumberOfSurfaceModels)
+    {
+    std::copy(source->ModelDistances.begin() + sourceIndex * nModels,
+              source->ModelDistances.begin() + (sourceIndex + 1) * nModels,
+              this->ModelDistances.begin() + index * nModels);
+    std::copy(source->ModelDepths.begin() + sourceIndex * nModels,
+              source->ModelDepths.begin() + (sourceIndex + 1) * nModels,
+              this->ModelDepths.begin() + index * nModels);
+    }
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPathStore::SetNumberOfSurfaceModels(int numberOfModels)
+{
+  numberOfModels = std::max(numberOfModels, 0);
+  size_t size = this->Ids.size() * numberOfModels;
+  this->NumberOfSurfaceModels = numberOfModels;
+  this->ModelDistances.assign(size, VTK_DOUBLE_MAX);
+  this->ModelDepths.assign(size, 0.0);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerPathPlannerPathStore::GetNumberOfSurfaceModels() const
+{
+  return this->NumberOfSurfaceModels;
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerPathPlannerPathStore::GetModelDistance(vtkIdType index, int model) const
+{
+  return this->ModelDistances[index * this->NumberOfSurfaceModels + model];
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerPathPlannerPathStore::GetModelDepth(vtkIdType index, int model) const
+{
+  return this->ModelDepths[index * this->NumberOfSurfaceModels + model];
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPathStore
+::SetModelDistance(vtkIdType index, int model, double distance, double depth)
+{
+  this->ModelDistances[index * this->NumberOfSurfaceModels + model] = distance;
+  this->ModelDepths[index * this->NumberOfSurfaceModels + model] = depth;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+double* vtkSlicerPathPlannerPathStore::GetTargetPositions()
+{
+  return this->TargetPositions.empty() ? 0 : &this->TargetPositions[0];
+}
+
+//----------------------------------------------------------------------------
+double* vtkSlicerPathPlannerPathStore::GetEntryPositions()
+{
+  return this->EntryPositions.empty() ? 0 : &this->EntryPositions[0];
+}
+
+//----------------------------------------------------------------------------
+double* vtkSlicerPathPlannerPathStore::GetLengths()
+{
+  return this->Lengths.empty() ? 0 : &this->Lengths[0];
+}
+
+//----------------------------------------------------------------------------
+double* vtkSlicerPathPlannerPathStore::GetDirections()
+{
+  return this->Directions.empty() ? 0 : &this->Directions[0];
+}
+
+//----------------------------------------------------------------------------
+double* vtkSlicerPathPlannerPathStore::GetInsertionAngles()
+{
+  return this->InsertionAngles.empty() ? 0 : &this->InsertionAngles[0];
+}
+
+//----------------------------------------------------------------------------
+double* vtkSlicerPathPlannerPathStore::GetClearances()
+{
+  return this->Clearances.empty() ? 0 : &this->Clearances[0];
+}
+
+//----------------------------------------------------------------------------
+double* vtkSlicerPathPlannerPathStore::GetClearanceDepths()
+{
+  return this->ClearanceDepths.empty() ? 0 : &this->ClearanceDepths[0];
+}
+
+//----------------------------------------------------------------------------
+double* vtkSlicerPathPlannerPathStore::GetCosts()
+{
+  return this->Costs.empty() ? 0 : &this->Costs[0];
+}
+
+//----------------------------------------------------------------------------
+double* vtkSlicerPathPlannerPathStore::GetModelDistances()
+{
+  return this->ModelDistances.empty() ? 0 : &this->ModelDistances[0];
+}
+
+//----------------------------------------------------------------------------
+double* vtkSlicerPathPlannerPathStore::GetModelDepths()
+{
+  return this->ModelDepths.empty() ? 0 : &this->ModelDepths[0];
+}
@@ -0,0 +1,189 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkSlicerPathPlannerPathStore - growable list of planned paths
+// .SECTION Description
+// A path joins a target point and an entry point, referenced by their stable
+// IDs in the target and entry vtkSlicerPathPlannerPointStore (-1 when not
+// set yet). The end point coordinates are cached as packed (R,A,S) triplets
+// next to the computed geometry (length, unit entry -> target direction and
+// insertion angle) so that vtkSlicerPathPlannerLogic::ComputeTrajectories()
+// can run on the whole store at once. The labels crossed by each path, its
+// clearance to the structures of the labelmap and its distance to each
+// surface model are kept as well. Like the point store, every path gets a
+// stable ID and the store owns the path names and node IDs.
+
+#ifndef __vtkSlicerPathPlannerPathStore_h
+#define __vtkSlicerPathPlannerPathStore_h
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "vtkSlicerPathPlannerModuleLogicExport.h"
+
+class vtkIdList;
+
+/// \ingroup Slicer_QtModules_PathPlanner
+class VTK_SLICER_PATHPLANNER_MODULE_LOGIC_EXPORT vtkSlicerPathPlannerPathStore :
+  public vtkObject
+{
+public:
+
+  static vtkSlicerPathPlannerPathStore *New();
+  vtkTypeMacro(vtkSlicerPathPlannerPathStore, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Append a path without end points and return its ID.
+  vtkIdType AddPath(const char* name, const char* nodeID = 0);
+
+  /// Remove the path at index. Following paths move up by one.
+  void RemovePath(vtkIdType index);
+  /// Remove the paths at the given indices (in any order, out of range
+  /// indices are ignored) in one pass over the store.
+  void RemovePaths(vtkIdList* indices);
+  void RemoveAllPaths();
+
+  vtkIdType GetNumberOfPaths() const;
+
+  /// Index of the path with the given ID, -1 if there is none.
+  vtkIdType GetIndex(vtkIdType id) const;
+  vtkIdType GetId(vtkIdType index) const;
+
+  /// Index of the path backed by nodeID, -1 if none.
+  vtkIdType FindIndexByNodeID(const char* nodeID) const;
+
+  const char* GetName(vtkIdType index) const;
+  void SetName(vtkIdType index, const char* name);
+  const char* GetNodeID(vtkIdType index) const;
+
+  /// Set an end point: ID of the point in its point store, and coordinates.
+  void SetTarget(vtkIdType index, vtkIdType pointId, const double position[3]);
+  void SetEntry(vtkIdType index, vtkIdType pointId, const double position[3]);
+  vtkIdType GetTargetPointId(vtkIdType index) const;
+  vtkIdType GetEntryPointId(vtkIdType index) const;
+  void GetTargetPosition(vtkIdType index, double position[3]) const;
+  void GetEntryPosition(vtkIdType index, double position[3]) const;
+
+  double GetLength(vtkIdType index) const;
+  void GetDirection(vtkIdType index, double direction[3]) const;
+  double GetInsertionAngle(vtkIdType index) const;
+
+  /// Labels entered by the path, in order from the entry point, and the
+  /// depth at which each one is entered, in mm from the entry point
+  /// (see vtkSlicerPathPlannerLogic::CheckCollisions()).
+  void SetHits(vtkIdType index, int numberOfHits, const int* labels, const double* depths);
+  int GetNumberOfHits(vtkIdType index) const;
+  int GetHitLabel(vtkIdType index, int hit) const;
+  double GetHitDepth(vtkIdType index, int hit) const;
+
+  /// Smallest signed distance in mm from the path to the structures of the
+  /// labelmap (negative inside a structure), and its depth in mm from the
+  /// entry point (see vtkSlicerPathPlannerLogic::ComputeClearances()).
+  /// VTK_DOUBLE_MAX when it has not been computed.
+  double GetClearance(vtkIdType index) const;
+  double GetClearanceDepth(vtkIdType index) const;
+  void SetClearance(vtkIdType index, double clearance, double depth);
+
+  /// Number of surface models each path is checked against (see
+  /// vtkSlicerPathPlannerLogic::CheckSurfaceModels()). Setting it resets
+  /// the model distances of all the paths.
+  void SetNumberOfSurfaceModels(int numberOfModels);
+  int GetNumberOfSurfaceModels() const;
+
+  /// Distance in mm from the path to a surface model (0 if the path crosses
+  /// it) and depth in mm from the entry point of the first crossing or of
+  /// the closest point. VTK_DOUBLE_MAX when it has not been computed.
+  double GetModelDistance(vtkIdType index, int model) const;
+  double GetModelDepth(vtkIdType index, int model) const;
+  void SetModelDistance(vtkIdType index, int model, double distance, double depth);
+
+  /// Weighted cost of the path (see vtkSlicerPathPlannerLogic::ComputePathCost()).
+  /// VTK_DOUBLE_MAX when it has not been computed.
+  double GetCost(vtkIdType index) const;
+  void SetCost(vtkIdType index, double cost);
+
+  /// Copy the end points and everything computed (geometry, hits,
+  /// clearance, model distances, cost) of the path at sourceIndex in
+  /// source into the path at index, e.g. between the path store and a copy
+  /// evaluated in the background. Name, node ID and ID are left as they are.
+  /// The model distances are copied only if both stores have the same number
+  /// of surface models.
+  void CopyPath(vtkIdType index, vtkSlicerPathPlannerPathStore* source, vtkIdType sourceIndex);
+
+  /// Packed arrays of GetNumberOfPaths() triplets (positions, directions)
+  /// or values (lengths, angles, clearances, costs), for batch computations.
+  /// The pointers are invalidated when paths are added or removed.
+  double* GetTargetPositions();
+  double* GetEntryPositions();
+  double* GetLengths();
+  double* GetDirections();
+  double* GetInsertionAngles();
+  double* GetClearances();
+  double* GetClearanceDepths();
+  double* GetCosts();
+  /// GetNumberOfSurfaceModels() values per path
+  double* GetModelDistances();
+  double* GetModelDepths();
+
+protected:
+  vtkSlicerPathPlannerPathStore();
+  virtual ~vtkSlicerPathPlannerPathStore();
+
+  void UpdateIndices(vtkIdType first);
+  void CompactIndices();
+  void RemoveNodeID(vtkIdType index);
+
+  //BTX
+  std::vector<vtkIdType> Ids;
+  std::vector<std::string> Names;
+  std::vector<std::string> NodeIDs;
+  std::vector<vtkIdType> TargetPointIds;
+  std::vector<vtkIdType> EntryPointIds;
+  std::vector<double> TargetPositions;
+  std::vector<double> EntryPositions;
+  std::vector<double> Lengths;
+  std::vector<double> Directions;
+  std::vector<double> InsertionAngles;
+  std::vector< std::vector<int> > HitLabels;
+  std::vector< std::vector<double> > HitDepths;
+  std::vector<double> Clearances;
+  std::vector<double> ClearanceDepths;
+  std::vector<double> Costs;
+  std::vector<double> ModelDistances;
+  std::vector<double> ModelDepths;
+  // Index of each ID from FirstId on, -1 once removed. IDs are issued in
+  // sequence so that the lookup is a plain array access. The IDs older than
+  // the first path are dropped from the front once they fill half of it.
+  std::vector<vtkIdType> IdToIndex;
+  // IDs of the paths backed by each node
+  std::unordered_multimap<std::string, vtkIdType> NodeIDToId;
+  //ETX
+  vtkIdType FirstId;
+  vtkIdType NextId;
+  int NumberOfSurfaceModels;
+
+private:
+  vtkSlicerPathPlannerPathStore(const vtkSlicerPathPlannerPathStore&); // Not implemented
+  void operator=(const vtkSlicerPathPlannerPathStore&);              // Not implemented
+};
+
+#endif
@@ -0,0 +1,417 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner Logic includes
+#include "vtkSlicerPathPlannerPointStore.h"
+
+// VTK includes
+#include <vtkIdList.h>
+#include <vtkObjectFactory.h>
+
+// STD includes
+#include <algorithm>
+#include <sstream>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerPathPlannerPointStore);
+
+//----------------------------------------------------------------------------
+namespace
+{
+// Move the tuples that are kept to the front, in order, and drop the rest
+template <class T>
+void EraseTuples(std::vector<T>& v, const std::vector<bool>& removed, int numberOfComponents)
+{
+  size_t kept = 0;
+  for (size_t i = 0; i < removed.size(); i ++)
+    {
+    if (removed[i])
+      {
+      continue;
+      }
+    for (int j = 0; j < numberOfComponents; j ++, kept ++)
+      {
+      if (kept != i * numberOfComponents + j)
+        {
+        std::swap(v[kept], v[i * numberOfComponents + j]);
+        }
+      }
+    }
+  v.resize(kept);
+}
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerPointStore::vtkSlicerPathPlannerPointStore()
+{
+  this->FirstId = 0;
+  this->NextId = 0;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerPointStore::~vtkSlicerPathPlannerPointStore()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPointStore::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "NumberOfPoints: " << this->GetNumberOfPoints() << "\n";
+  os << indent << "NextId: " << this->NextId << "\n";
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerPointStore
+::AddPoint(const double position[3], const char* name, const char* nodeID)
+{
+  vtkIdType id = this->NextId++;
+  this->IdToIndex.push_back(static_cast<vtkIdType>(this->Ids.size()));
+  this->Ids.push_back(id);
+  this->R.push_back(position[0]);
+  this->A.push_back(position[1]);
+  this->S.push_back(position[2]);
+  this->Normals.resize(this->Normals.size() + 3, 0.0);
+  this->Names.push_back(name ? name : "");
+  this->NodeIDs.push_back(nodeID ? nodeID : "");
+  if (nodeID && *nodeID)
+    {
+    this->NodeIDToId.insert(std::make_pair(std::string(nodeID), id));
+    }
+  this->Modified();
+  return id;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerPointStore
+::AddPoints(vtkIdType numberOfPoints, const double* positions, const double* normals,
+            const char* namePrefix)
+{
+  vtkIdType firstId = this->NextId;
+  if (numberOfPoints <= 0 || !positions)
+    {
+    return firstId;
+    }
+  size_t size = this->Ids.size() + numberOfPoints;
+  this->IdToIndex.reserve(this->IdToIndex.size() + numberOfPoints);
+  this->Ids.reserve(size);
+  this->R.reserve(size);
+  this->A.reserve(size);
+  this->S.reserve(size);
+  this->Names.reserve(size);
+  this->NodeIDs.resize(size);
+  if (normals)
+    {
+    this->Normals.insert(this->Normals.end(), normals, normals + 3 * numberOfPoints);
+    }
+  else
+    {
+    this->Normals.resize(3 * size, 0.0);
+    }
+  std::string prefix(namePrefix ? namePrefix : "");
+  for (vtkIdType i = 0; i < numberOfPoints; i ++)
+    {
+    vtkIdType id = this->NextId++;
+    this->IdToIndex.push_back(static_cast<vtkIdType>(this->Ids.size()));
+    this->Ids.push_back(id);
+    this->R.push_back(positions[3 * i]);
+    this->A.push_back(positions[3 * i + 1]);
+    this->S.push_back(positions[3 * i + 2]);
+    std::ostringstream name;
+    name << prefix << id;
+    this->Names.push_back(name.str());
+    }
+  this->Modified();
+  return firstId;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPointStore::RemovePoint(vtkIdType index)
+{
+  if (index < 0 || index >= this->GetNumberOfPoints())
+    {
+    return;
+    }
+  this->IdToIndex[this->Ids[index] - this->FirstId] = -1;
+  this->RemoveNodeID(index);
+  this->Ids.erase(this->Ids.begin() + index);
+  this->R.erase(this->R.begin() + index);
+  this->A.erase(this->A.begin() + index);
+  this->S.erase(this->S.begin() + index);
+  this->Normals.erase(this->Normals.begin() + 3 * index, this->Normals.begin() + 3 * index + 3);
+  this->Names.erase(this->Names.begin() + index);
+  this->NodeIDs.erase(this->NodeIDs.begin() + index);
+  this->UpdateIndices(index);
+  this->CompactIndices();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPointStore::RemovePoints(vtkIdList* indices)
+{
+  vtkIdType n = this->GetNumberOfPoints();
+  std::vector<bool> removed(n, false);
+  vtkIdType first = n;
+  for (vtkIdType k = 0; k < indices->GetNumberOfIds(); k ++)
+    {
+    vtkIdType index = indices->GetId(k);
+    if (index >= 0 && index < n && !removed[index])
+      {
+      removed[index] = true;
+      this->IdToIndex[this->Ids[index] - this->FirstId] = -1;
+      this->RemoveNodeID(index);
+      first = std::min(first, index);
+      }
+    }
+  if (first == n)
+    {
+    return;
+    }
+  EraseTuples(this->Ids, removed, 1);
+  EraseTuples(this->R, removed, 1);
+  EraseTuples(this->A, removed, 1);
+  EraseTuples(this->S, removed, 1);
+  EraseTuples(this->Normals, removed, 3);
+  EraseTuples(this->Names, removed, 1);
+  EraseTuples(this->NodeIDs, removed, 1);
+  this->UpdateIndices(first);
+  this->CompactIndices();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPointStore::RemoveAllPoints()
+{
+  this->Ids.clear();
+  this->R.clear();
+  this->A.clear();
+  this->S.clear();
+  this->Normals.clear();
+  this->Names.clear();
+  this->NodeIDs.clear();
+  this->NodeIDToId.clear();
+  this->CompactIndices();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPointStore::DeepCopy(vtkSlicerPathPlannerPointStore* source)
+{
+  if (!source || source == this)
+    {
+    return;
+    }
+  this->R = source->R;
+  this->A = source->A;
+  this->S = source->S;
+  this->Normals = source->Normals;
+  this->Ids = source->Ids;
+  this->Names = source->Names;
+  this->NodeIDs = source->NodeIDs;
+  this->IdToIndex = source->IdToIndex;
+  this->NodeIDToId = source->NodeIDToId;
+  this->FirstId = source->FirstId;
+  this->NextId = source->NextId;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPointStore::UpdateIndices(vtkIdType first)
+{
+  vtkIdType n = this->GetNumberOfPoints();
+  for (vtkIdType i = first; i < n; i ++)
+    {
+    this->IdToIndex[this->Ids[i] - this->FirstId] = i;
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPointStore::CompactIndices()
+{
+  // The points stay in the order of their IDs: the first one is the oldest
+  vtkIdType oldestId = this->Ids.empty() ? this->NextId : this->Ids[0];
+  vtkIdType nDropped = oldestId - this->FirstId;
+  if (2 * nDropped < static_cast<vtkIdType>(this->IdToIndex.size()))
+    {
+    return;
+    }
+  this->IdToIndex.erase(this->IdToIndex.begin(), this->IdToIndex.begin() + nDropped);
+  this->FirstId = oldestId;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPointStore::RemoveNodeID(vtkIdType index)
+{
+  if (this->NodeIDs[index].empty())
+    {
+    return;
+    }
+  typedef std::unordered_multimap<std::string, vtkIdType>::iterator Iterator;
+  std::pair<Iterator, Iterator> range = this->NodeIDToId.equal_range(this->NodeIDs[index]);
+  for (Iterator it = range.first; it != range.second; ++ it)
+    {
+    if (it->second == this->Ids[index])
+      {
+      this->NodeIDToId.erase(it);
+      return;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerPointStore::GetNumberOfPoints() const
+{
+  return static_cast<vtkIdType>(this->Ids.size());
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerPointStore::GetIndex(vtkIdType id) const
+{
+  if (id < this->FirstId || id >= this->NextId)
+    {
+    return -1;
+    }
+  return this->IdToIndex[id - this->FirstId];
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerPointStore::GetId(vtkIdType index) const
+{
+  if (index < 0 || index >= this->GetNumberOfPoints())
+    {
+    return -1;
+    }
+  return this->Ids[index];
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerPointStore::FindIndexByNodeID(const char* nodeID) const
+{
+  if (!nodeID || !*nodeID)
+    {
+    return -1;
+    }
+  // the oldest point backed by the node comes first
+  typedef std::unordered_multimap<std::string, vtkIdType>::const_iterator Iterator;
+  std::pair<Iterator, Iterator> range = this->NodeIDToId.equal_range(nodeID);
+  vtkIdType id = this->NextId;
+  for (Iterator it = range.first; it != range.second; ++ it)
+    {
+    id = std::min(id, it->second);
+    }
+  return this->GetIndex(id);
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerPointStore::FindIndexByName(const char* name) const
+{
+  if (!name)
+    {
+    return -1;
+    }
+  vtkIdType n = this->GetNumberOfPoints();
+  for (vtkIdType i = 0; i < n; i ++)
+    {
+    if (this->Names[i] == name)
+      {
+      return i;
+      }
+    }
+  return -1;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPointStore
+::GetPosition(vtkIdType index, double position[3]) const
+{
+  position[0] = this->R[index];
+  position[1] = this->A[index];
+  position[2] = this->S[index];
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPointStore
+::SetPosition(vtkIdType index, const double position[3])
+{
+  if (this->R[index] == position[0] &&
+      this->A[index] == position[1] &&
+      this->S[index] == position[2])
+    {
+    return;
+    }
+  this->R[index] = position[0];
+  this->A[index] = position[1];
+  this->S[index] = position[2];
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPointStore
+::GetNormal(vtkIdType index, double normal[3]) const
+{
+  std::copy(&this->Normals[3 * index], &this->Normals[3 * index] + 3, normal);
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPointStore
+::SetNormal(vtkIdType index, const double normal[3])
+{
+  std::copy(normal, normal + 3, &this->Normals[3 * index]);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+const char* vtkSlicerPathPlannerPointStore::GetName(vtkIdType index) const
+{
+  return this->Names[index].c_str();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPointStore::SetName(vtkIdType index, const char* name)
+{
+  std::string newName(name ? name : "");
+  if (this->Names[index] == newName)
+    {
+    return;
+    }
+  this->Names[index] = newName;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+const char* vtkSlicerPathPlannerPointStore::GetNodeID(vtkIdType index) const
+{
+  return this->NodeIDs[index].c_str();
+}
+
+//----------------------------------------------------------------------------
+const double* vtkSlicerPathPlannerPointStore::GetR() const
+{
+  return this->R.empty() ? 0 : &this->R[0];
+}
+
+//----------------------------------------------------------------------------
+const double* vtkSlicerPathPlannerPointStore::GetA() const
+{
+  return this->A.empty() ? 0 : &this->A[0];
+}
+
+//----------------------------------------------------------------------------
+const double* vtkSlicerPathPlannerPointStore::GetS() const
+{
+  return this->S.empty() ? 0 : &this->S[0];
+}
@@ -0,0 +1,137 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkSlicerPathPlannerPointStore - growable list of entry or target points
+// .SECTION Description
+// The coordinates are kept as structure of arrays (one contiguous array per
+// R, A and S axis) so that they can be handed to the trajectory kernels
+// without copying. Every point gets a stable ID when it is added; IDs are
+// never reused, while indices shift when a point is removed. The store owns
+// the names and the IDs of the MRML nodes the points come from, and the
+// surface normals of the points sampled on the skin.
+
+#ifndef __vtkSlicerPathPlannerPointStore_h
+#define __vtkSlicerPathPlannerPointStore_h
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "vtkSlicerPathPlannerModuleLogicExport.h"
+
+class vtkIdList;
+
+/// \ingroup Slicer_QtModules_PathPlanner
+class VTK_SLICER_PATHPLANNER_MODULE_LOGIC_EXPORT vtkSlicerPathPlannerPointStore :
+  public vtkObject
+{
+public:
+
+  static vtkSlicerPathPlannerPointStore *New();
+  vtkTypeMacro(vtkSlicerPathPlannerPointStore, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Append a point and return its ID. nodeID may be NULL for points that
+  /// are not backed by a MRML node.
+  vtkIdType AddPoint(const double position[3], const char* name, const char* nodeID = 0);
+
+  /// Append numberOfPoints points that are not backed by MRML nodes, e.g.
+  /// candidate entry points sampled on the skin, named namePrefix followed
+  /// by their ID. positions and normals (may be NULL) hold packed (R,A,S)
+  /// triplets. Return the ID of the first point; the IDs are consecutive.
+  vtkIdType AddPoints(vtkIdType numberOfPoints, const double* positions,
+                      const double* normals, const char* namePrefix);
+
+  /// Remove the point at index. Following points move up by one.
+  void RemovePoint(vtkIdType index);
+
+  /// Remove the points at the given indices (in any order, out of range
+  /// indices are ignored) in one pass over the store.
+  void RemovePoints(vtkIdList* indices);
+
+  /// Remove all the points. IDs are not reused.
+  void RemoveAllPoints();
+
+  /// Copy the points of source, with their IDs, e.g. to take a snapshot
+  /// that a background computation reads while source keeps changing.
+  void DeepCopy(vtkSlicerPathPlannerPointStore* source);
+
+  vtkIdType GetNumberOfPoints() const;
+
+  /// Index of the point with the given ID, -1 if there is none.
+  vtkIdType GetIndex(vtkIdType id) const;
+  vtkIdType GetId(vtkIdType index) const;
+
+  /// Index of the first point backed by nodeID (or named name), -1 if none.
+  vtkIdType FindIndexByNodeID(const char* nodeID) const;
+  vtkIdType FindIndexByName(const char* name) const;
+
+  void GetPosition(vtkIdType index, double position[3]) const;
+  void SetPosition(vtkIdType index, const double position[3]);
+
+  /// Unit outward normal of the surface at the point, (0,0,0) if unknown
+  void GetNormal(vtkIdType index, double normal[3]) const;
+  void SetNormal(vtkIdType index, const double normal[3]);
+
+  const char* GetName(vtkIdType index) const;
+  void SetName(vtkIdType index, const char* name);
+
+  /// Empty string if the point is not backed by a MRML node.
+  const char* GetNodeID(vtkIdType index) const;
+
+  /// Contiguous R, A and S coordinate arrays (GetNumberOfPoints() values).
+  /// The pointers are invalidated when points are added or removed.
+  const double* GetR() const;
+  const double* GetA() const;
+  const double* GetS() const;
+
+protected:
+  vtkSlicerPathPlannerPointStore();
+  virtual ~vtkSlicerPathPlannerPointStore();
+
+  void UpdateIndices(vtkIdType first);
+  void CompactIndices();
+  void RemoveNodeID(vtkIdType index);
+
+  //BTX
+  std::vector<double> R;
+  std::vector<double> A;
+  std::vector<double> S;
+  std::vector<double> Normals;
+  std::vector<vtkIdType> Ids;
+  std::vector<std::string> Names;
+  std::vector<std::string> NodeIDs;
+  // Index of each ID from FirstId on, -1 once removed. IDs are issued in
+  // sequence so that the lookup is a plain array access. The IDs older than
+  // the first point are dropped from the front once they fill half of it.
+  std::vector<vtkIdType> IdToIndex;
+  // IDs of the points backed by each node
+  std::unordered_multimap<std::string, vtkIdType> NodeIDToId;
+  //ETX
+  vtkIdType FirstId;
+  vtkIdType NextId;
+
+private:
+  vtkSlicerPathPlannerPointStore(const vtkSlicerPathPlannerPointStore&); // Not implemented
+  void operator=(const vtkSlicerPathPlannerPointStore&);               // Not implemented
+};
+
+#endif
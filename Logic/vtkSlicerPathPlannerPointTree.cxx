@@ -0,0 +1,283 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner Logic includes
+#include "vtkSlicerPathPlannerPointStore.h"
+#include "vtkSlicerPathPlannerPointTree.h"
+
+// VTK includes
+#include <vtkIdList.h>
+#include <vtkObjectFactory.h>
+
+// STD includes
+#include <algorithm>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerPathPlannerPointTree);
+vtkCxxSetObjectMacro(vtkSlicerPathPlannerPointTree, Points, vtkSlicerPathPlannerPointStore);
+
+//----------------------------------------------------------------------------
+namespace
+{
+// Order points by one of their coordinate arrays
+struct CoordinateLess
+{
+  const double* Values;
+  bool operator()(vtkIdType a, vtkIdType b) const
+  {
+    return this->Values[a] < this->Values[b];
+  }
+};
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerPointTree::vtkSlicerPathPlannerPointTree()
+{
+  this->Points = 0;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerPointTree::~vtkSlicerPathPlannerPointTree()
+{
+  this->SetPoints(0);
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPointTree::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "Points: " << this->Points << "\n";
+  os << indent << "NumberOfPoints: " << this->GetNumberOfPoints() << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPointTree::Update()
+{
+  if (this->BuildTime.GetMTime() < this->GetMTime() ||
+      (this->Points && this->BuildTime.GetMTime() < this->Points->GetMTime()))
+    {
+    this->Build();
+    this->BuildTime.Modified();
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerPointTree::GetNumberOfPoints() const
+{
+  return static_cast<vtkIdType>(this->Ids.size());
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPointTree::Build()
+{
+  this->Coordinates.clear();
+  this->Ids.clear();
+  this->Axes.clear();
+  vtkIdType nPoints = this->Points ? this->Points->GetNumberOfPoints() : 0;
+  if (nPoints == 0)
+    {
+    return;
+    }
+
+  this->Order.resize(nPoints);
+  for (vtkIdType i = 0; i < nPoints; i ++)
+    {
+    this->Order[i] = i;
+    }
+  this->Axes.resize(nPoints, 0);
+  this->BuildRange(0, nPoints);
+
+  const double* coordinates[3] =
+    { this->Points->GetR(), this->Points->GetA(), this->Points->GetS() };
+  this->Coordinates.resize(3 * nPoints);
+  this->Ids.resize(nPoints);
+  for (vtkIdType i = 0; i < nPoints; i ++)
+    {
+    vtkIdType index = this->Order[i];
+    this->Coordinates[3 * i] = coordinates[0][index];
+    this->Coordinates[3 * i + 1] = coordinates[1][index];
+    this->Coordinates[3 * i + 2] = coordinates[2][index];
+    this->Ids[i] = this->Points->GetId(index);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPointTree::BuildRange(vtkIdType first, vtkIdType last)
+{
+  if (last - first <= 1)
+    {
+    return;
+    }
+
+  // Split along the axis of largest spread
+  const double* coordinates[3] =
+    { this->Points->GetR(), this->Points->GetA(), this->Points->GetS() };
+  int axis = 0;
+  double largestSpread = -1.0;
+  for (int a = 0; a < 3; a ++)
+    {
+    double lower = VTK_DOUBLE_MAX;
+    double upper = -VTK_DOUBLE_MAX;
+    for (vtkIdType i = first; i < last; i ++)
+      {
+      double x = coordinates[a][this->Order[i]];
+      lower = std::min(lower, x);
+      upper = std::max(upper, x);
+      }
+    if (upper - lower > largestSpread)
+      {
+      largestSpread = upper - lower;
+      axis = a;
+      }
+    }
+
+  vtkIdType middle = first + (last - first) / 2;
+  CoordinateLess less;
+  less.Values = coordinates[axis];
+  std::nth_element(this->Order.begin() + first, this->Order.begin() + middle,
+                   this->Order.begin() + last, less);
+  this->Axes[middle] = static_cast<unsigned char>(axis);
+
+  this->BuildRange(first, middle);
+  this->BuildRange(middle + 1, last);
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPointTree
+::FindClosestPoints(const double position[3], int numberOfPoints, vtkIdList* pointIds) const
+{
+  if (!pointIds)
+    {
+    return;
+    }
+  std::vector<Neighbor> heap;
+  if (numberOfPoints > 0)
+    {
+    heap.reserve(numberOfPoints);
+    this->SearchClosest(0, this->GetNumberOfPoints(), position,
+                        static_cast<size_t>(numberOfPoints), heap);
+    }
+  this->GetIds(heap, pointIds);
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPointTree
+::FindPointsWithinRadius(const double position[3], double radius, vtkIdList* pointIds) const
+{
+  if (!pointIds)
+    {
+    return;
+    }
+  std::vector<Neighbor> neighbors;
+  if (radius >= 0.0)
+    {
+    this->SearchRadius(0, this->GetNumberOfPoints(), position, radius * radius, neighbors);
+    }
+  this->GetIds(neighbors, pointIds);
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPointTree
+::SearchClosest(vtkIdType first, vtkIdType last, const double position[3],
+                size_t numberOfPoints, std::vector<Neighbor>& heap) const
+{
+  if (first >= last)
+    {
+    return;
+    }
+  vtkIdType middle = first + (last - first) / 2;
+  const double* point = &this->Coordinates[3 * middle];
+  double d[3] = { position[0] - point[0], position[1] - point[1], position[2] - point[2] };
+  double distance2 = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+  Neighbor neighbor(distance2, this->Ids[middle]);
+
+  // heap is a max-heap of the closest points found so far
+  if (heap.size() < numberOfPoints)
+    {
+    heap.push_back(neighbor);
+    std::push_heap(heap.begin(), heap.end());
+    }
+  else if (neighbor < heap.front())
+    {
+    std::pop_heap(heap.begin(), heap.end());
+    heap.back() = neighbor;
+    std::push_heap(heap.begin(), heap.end());
+    }
+
+  // The side of the split containing the query first; the other one only
+  // if the split plane is not farther than the farthest point kept (a
+  // point on the plane may tie with it and have a lower ID)
+  double offset = d[this->Axes[middle]];
+  if (offset < 0.0)
+    {
+    this->SearchClosest(first, middle, position, numberOfPoints, heap);
+    if (heap.size() < numberOfPoints || offset * offset <= heap.front().first)
+      {
+      this->SearchClosest(middle + 1, last, position, numberOfPoints, heap);
+      }
+    }
+  else
+    {
+    this->SearchClosest(middle + 1, last, position, numberOfPoints, heap);
+    if (heap.size() < numberOfPoints || offset * offset <= heap.front().first)
+      {
+      this->SearchClosest(first, middle, position, numberOfPoints, heap);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPointTree
+::SearchRadius(vtkIdType first, vtkIdType last, const double position[3],
+               double radius2, std::vector<Neighbor>& neighbors) const
+{
+  if (first >= last)
+    {
+    return;
+    }
+  vtkIdType middle = first + (last - first) / 2;
+  const double* point = &this->Coordinates[3 * middle];
+  double d[3] = { position[0] - point[0], position[1] - point[1], position[2] - point[2] };
+  double distance2 = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+  if (distance2 <= radius2)
+    {
+    neighbors.push_back(Neighbor(distance2, this->Ids[middle]));
+    }
+
+  double offset = d[this->Axes[middle]];
+  if (offset < 0.0 || offset * offset <= radius2)
+    {
+    this->SearchRadius(first, middle, position, radius2, neighbors);
+    }
+  if (offset >= 0.0 || offset * offset <= radius2)
+    {
+    this->SearchRadius(middle + 1, last, position, radius2, neighbors);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPointTree
+::GetIds(std::vector<Neighbor>& neighbors, vtkIdList* pointIds) const
+{
+  std::sort(neighbors.begin(), neighbors.end());
+  pointIds->SetNumberOfIds(static_cast<vtkIdType>(neighbors.size()));
+  for (size_t i = 0; i < neighbors.size(); i ++)
+    {
+    pointIds->SetId(static_cast<vtkIdType>(i), neighbors[i].second);
+    }
+}
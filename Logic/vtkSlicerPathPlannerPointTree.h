@@ -0,0 +1,108 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkSlicerPathPlannerPointTree - k-d tree over the points of a point store
+// .SECTION Description
+// Balanced k-d tree over the points of a vtkSlicerPathPlannerPointStore,
+// split at the median along the axis of largest spread. The tree is
+// implicit: the points are sorted so that the median of each range is its
+// node, and only the split axis of each node is kept. Update() rebuilds it
+// when the store was modified (points added, moved or removed) since the
+// last build, which takes about a millisecond for thousands of points.
+// Queries return point IDs, nearest first, and may run concurrently.
+
+#ifndef __vtkSlicerPathPlannerPointTree_h
+#define __vtkSlicerPathPlannerPointTree_h
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <vector>
+
+#include "vtkSlicerPathPlannerModuleLogicExport.h"
+
+class vtkIdList;
+class vtkSlicerPathPlannerPointStore;
+
+/// \ingroup Slicer_QtModules_PathPlanner
+class VTK_SLICER_PATHPLANNER_MODULE_LOGIC_EXPORT vtkSlicerPathPlannerPointTree :
+  public vtkObject
+{
+public:
+
+  static vtkSlicerPathPlannerPointTree *New();
+  vtkTypeMacro(vtkSlicerPathPlannerPointTree, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Point store whose points are indexed
+  virtual void SetPoints(vtkSlicerPathPlannerPointStore* points);
+  vtkGetObjectMacro(Points, vtkSlicerPathPlannerPointStore);
+
+  /// Build the tree if the point store was modified since the last build
+  void Update();
+
+  vtkIdType GetNumberOfPoints() const;
+
+  /// IDs of the numberOfPoints points closest to position, nearest first
+  /// (fewer if the store has fewer points). Points at the same distance come
+  /// by increasing ID, so that the result for n points is the beginning of
+  /// the result for more.
+  void FindClosestPoints(const double position[3], int numberOfPoints,
+                         vtkIdList* pointIds) const;
+
+  /// IDs of the points within radius mm of position, nearest first (then by
+  /// increasing ID)
+  void FindPointsWithinRadius(const double position[3], double radius,
+                              vtkIdList* pointIds) const;
+
+protected:
+  vtkSlicerPathPlannerPointTree();
+  virtual ~vtkSlicerPathPlannerPointTree();
+
+  void Build();
+  void BuildRange(vtkIdType first, vtkIdType last);
+
+  //BTX
+  // (squared distance, ID) of a query result: equal distances are ordered
+  // by ID rather than by the arbitrary position in the tree
+  typedef std::pair<double, vtkIdType> Neighbor;
+
+  void SearchClosest(vtkIdType first, vtkIdType last, const double position[3],
+                     size_t numberOfPoints, std::vector<Neighbor>& heap) const;
+  void SearchRadius(vtkIdType first, vtkIdType last, const double position[3],
+                    double radius2, std::vector<Neighbor>& neighbors) const;
+  void GetIds(std::vector<Neighbor>& neighbors, vtkIdList* pointIds) const;
+
+  // Coordinates (3 values per point) and ID of the points in tree order,
+  // and split axis of the node at the median of each range
+  std::vector<double> Coordinates;
+  std::vector<vtkIdType> Ids;
+  std::vector<unsigned char> Axes;
+  // Scratch of the build: point order
+  std::vector<vtkIdType> Order;
+  //ETX
+
+  vtkSlicerPathPlannerPointStore* Points;
+  vtkTimeStamp BuildTime;
+
+private:
+  vtkSlicerPathPlannerPointTree(const vtkSlicerPathPlannerPointTree&); // Not implemented
+  void operator=(const vtkSlicerPathPlannerPointTree&);              // Not implemented
+};
+
+#endif
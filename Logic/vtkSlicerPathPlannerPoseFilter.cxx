@@ -0,0 +1,199 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner Logic includes
+#include "vtkSlicerPathPlannerPoseFilter.h"
+
+// VTK includes
+#include <vtkMath.h>
+#include <vtkObjectFactory.h>
+
+// STD includes
+#include <algorithm>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerPathPlannerPoseFilter);
+
+//----------------------------------------------------------------------------
+namespace
+{
+// The translation is the last column of the 3x4 affine elements
+inline bool IsTranslation(int element)
+{
+  return (element % 4) == 3;
+}
+
+//----------------------------------------------------------------------------
+// Propagate the covariance (P00, P01, P11) of a constant velocity state
+// over dt under white noise acceleration of spectral density q
+inline void PredictCovariance(double covariance[3], double dt, double q)
+{
+  double p00 = covariance[0];
+  double p01 = covariance[1];
+  double p11 = covariance[2];
+  covariance[0] = p00 + dt * (2.0 * p01 + dt * p11) + q * dt * dt * dt / 3.0;
+  covariance[1] = p01 + dt * p11 + q * dt * dt / 2.0;
+  covariance[2] = p11 + q * dt;
+}
+
+//----------------------------------------------------------------------------
+// Kalman gains of a measurement of variance r, and covariance update
+inline void CorrectCovariance(double covariance[3], double r, double gain[2])
+{
+  double s = covariance[0] + r;
+  gain[0] = covariance[0] / s;
+  gain[1] = covariance[1] / s;
+  double p00 = covariance[0];
+  double p01 = covariance[1];
+  covariance[0] = (1.0 - gain[0]) * p00;
+  covariance[1] = (1.0 - gain[0]) * p01;
+  covariance[2] -= gain[1] * p01;
+}
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerPoseFilter::vtkSlicerPathPlannerPoseFilter()
+{
+  this->Enabled = true;
+  this->Latency = 0.0;
+  this->PositionProcessNoise = 1.0e4;
+  this->PositionMeasurementNoise = 0.0625;
+  this->RotationProcessNoise = 1.0;
+  this->RotationMeasurementNoise = 1.0e-4;
+  this->MaximumGap = 0.5;
+  this->Reset();
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerPoseFilter::~vtkSlicerPathPlannerPoseFilter()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPoseFilter::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "Enabled: " << this->Enabled << "\n";
+  os << indent << "Latency: " << this->Latency << "\n";
+  os << indent << "PositionProcessNoise: " << this->PositionProcessNoise << "\n";
+  os << indent << "PositionMeasurementNoise: " << this->PositionMeasurementNoise << "\n";
+  os << indent << "RotationProcessNoise: " << this->RotationProcessNoise << "\n";
+  os << indent << "RotationMeasurementNoise: " << this->RotationMeasurementNoise << "\n";
+  os << indent << "MaximumGap: " << this->MaximumGap << "\n";
+  os << indent << "LastTime: " << this->LastTime << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPoseFilter::Reset()
+{
+  std::fill(this->Values, this->Values + 12, 0.0);
+  std::fill(this->Velocities, this->Velocities + 12, 0.0);
+  std::fill(this->PositionCovariance, this->PositionCovariance + 3, 0.0);
+  std::fill(this->RotationCovariance, this->RotationCovariance + 3, 0.0);
+  this->LastTime = -1.0;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPoseFilter::Restart(double time, const double matrix[16])
+{
+  // Known value, unknown velocity: the variance a second of process noise
+  // gives it
+  std::copy(matrix, matrix + 12, this->Values);
+  std::fill(this->Velocities, this->Velocities + 12, 0.0);
+  this->PositionCovariance[0] = this->PositionMeasurementNoise;
+  this->PositionCovariance[1] = 0.0;
+  this->PositionCovariance[2] = this->PositionProcessNoise;
+  this->RotationCovariance[0] = this->RotationMeasurementNoise;
+  this->RotationCovariance[1] = 0.0;
+  this->RotationCovariance[2] = this->RotationProcessNoise;
+  this->LastTime = time;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerPoseFilter::AddSample(double time, const double matrix[16])
+{
+  double dt = time - this->LastTime;
+  if (this->LastTime < 0.0 || dt > this->MaximumGap || !this->Enabled)
+    {
+    this->Restart(time, matrix);
+    return;
+    }
+  if (dt < 0.0)
+    {
+    return;
+    }
+
+  PredictCovariance(this->PositionCovariance, dt, this->PositionProcessNoise);
+  PredictCovariance(this->RotationCovariance, dt, this->RotationProcessNoise);
+  double positionGain[2];
+  double rotationGain[2];
+  CorrectCovariance(this->PositionCovariance, this->PositionMeasurementNoise, positionGain);
+  CorrectCovariance(this->RotationCovariance, this->RotationMeasurementNoise, rotationGain);
+
+  for (int i = 0; i < 12; i ++)
+    {
+    const double* gain = IsTranslation(i) ? positionGain : rotationGain;
+    double predicted = this->Values[i] + dt * this->Velocities[i];
+    double innovation = matrix[i] - predicted;
+    this->Values[i] = predicted + gain[0] * innovation;
+    this->Velocities[i] += gain[1] * innovation;
+    }
+  this->LastTime = time;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerPathPlannerPoseFilter::Predict(double time, double matrix[16]) const
+{
+  if (this->LastTime < 0.0)
+    {
+    return false;
+    }
+  // Extrapolate no further than the longest gap coasted over
+  double dt = 0.0;
+  if (this->Enabled)
+    {
+    dt = std::min(std::max(time + this->Latency - this->LastTime, 0.0), this->MaximumGap);
+    }
+  for (int i = 0; i < 12; i ++)
+    {
+    matrix[i] = this->Values[i] + dt * this->Velocities[i];
+    }
+  matrix[12] = matrix[13] = matrix[14] = 0.0;
+  matrix[15] = 1.0;
+
+  // Nearest rotation by Gram-Schmidt on the columns, keeping the first
+  // one and the handedness
+  double x[3] = { matrix[0], matrix[4], matrix[8] };
+  double y[3] = { matrix[1], matrix[5], matrix[9] };
+  double z[3];
+  vtkMath::Normalize(x);
+  double dot = vtkMath::Dot(x, y);
+  for (int i = 0; i < 3; i ++)
+    {
+    y[i] -= dot * x[i];
+    }
+  vtkMath::Normalize(y);
+  vtkMath::Cross(x, y, z);
+  for (int i = 0; i < 3; i ++)
+    {
+    matrix[4 * i] = x[i];
+    matrix[4 * i + 1] = y[i];
+    matrix[4 * i + 2] = z[i];
+    }
+  return true;
+}
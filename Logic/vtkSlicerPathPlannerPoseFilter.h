@@ -0,0 +1,120 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkSlicerPathPlannerPoseFilter - latency compensation of tracker poses
+// .SECTION Description
+// Constant velocity Kalman filter of the tracked needle pose, predicting
+// it forward to compensate the delay of the tracking pipeline. Each of the
+// 12 affine elements of the 4x4 pose (translation and rotation) is a
+// (value, velocity) state driven by white noise acceleration; since all the
+// translation elements (rotation elements) share their noise parameters and
+// sample times, they share one 2x2 covariance. AddSample() runs for every
+// tracker sample, Predict() whenever a pose is needed, and neither
+// allocates. The predicted rotation is orthonormalized.
+// When the filter is disabled, Predict() returns the latest sample.
+
+#ifndef __vtkSlicerPathPlannerPoseFilter_h
+#define __vtkSlicerPathPlannerPoseFilter_h
+
+// VTK includes
+#include <vtkObject.h>
+
+#include "vtkSlicerPathPlannerModuleLogicExport.h"
+
+/// \ingroup Slicer_QtModules_PathPlanner
+class VTK_SLICER_PATHPLANNER_MODULE_LOGIC_EXPORT vtkSlicerPathPlannerPoseFilter :
+  public vtkObject
+{
+public:
+
+  static vtkSlicerPathPlannerPoseFilter *New();
+  vtkTypeMacro(vtkSlicerPathPlannerPoseFilter, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Filter and predict the poses (default), or pass the latest one
+  vtkSetMacro(Enabled, bool);
+  vtkGetMacro(Enabled, bool);
+  vtkBooleanMacro(Enabled, bool);
+
+  /// Delay in seconds between the motion of the needle and the time stamp
+  /// of its sample, e.g. measured against a video of the tracked tool.
+  /// Predict() looks this far ahead of the requested time. 0 by default.
+  vtkSetClampMacro(Latency, double, 0.0, 1.0);
+  vtkGetMacro(Latency, double);
+
+  /// Spectral density of the acceleration of the translation, in
+  /// mm^2/s^3, and variance of its measurement, in mm^2 (a tracker
+  /// accurate to 0.25 mm by default)
+  vtkSetMacro(PositionProcessNoise, double);
+  vtkGetMacro(PositionProcessNoise, double);
+  vtkSetMacro(PositionMeasurementNoise, double);
+  vtkGetMacro(PositionMeasurementNoise, double);
+
+  /// Same for the elements of the rotation, in 1/s^3 and unitless
+  vtkSetMacro(RotationProcessNoise, double);
+  vtkGetMacro(RotationProcessNoise, double);
+  vtkSetMacro(RotationMeasurementNoise, double);
+  vtkGetMacro(RotationMeasurementNoise, double);
+
+  /// Longest gap in seconds between two samples the filter coasts over;
+  /// after a longer one it restarts from the new sample. 0.5 by default.
+  vtkSetMacro(MaximumGap, double);
+  vtkGetMacro(MaximumGap, double);
+
+  /// Correct the state with a sample: time in seconds and the 16 row-major
+  /// elements of the 4x4 pose. Samples older than the previous one are
+  /// ignored.
+  void AddSample(double time, const double matrix[16]);
+
+  /// Pose predicted at time + Latency, into the 16 row-major elements of
+  /// matrix. Return false, leaving matrix as it is, if there was no sample.
+  bool Predict(double time, double matrix[16]) const;
+
+  /// Forget the samples
+  void Reset();
+
+  /// Time of the latest sample, -1 if there was none
+  vtkGetMacro(LastTime, double);
+
+protected:
+  vtkSlicerPathPlannerPoseFilter();
+  virtual ~vtkSlicerPathPlannerPoseFilter();
+
+  void Restart(double time, const double matrix[16]);
+
+  bool Enabled;
+  double Latency;
+  double PositionProcessNoise;
+  double PositionMeasurementNoise;
+  double RotationProcessNoise;
+  double RotationMeasurementNoise;
+  double MaximumGap;
+
+  // Value and velocity of the 12 affine elements (row-major 3x4), and
+  // covariance (P00, P01, P11) of the translation and rotation elements
+  double Values[12];
+  double Velocities[12];
+  double PositionCovariance[3];
+  double RotationCovariance[3];
+  double LastTime;
+
+private:
+  vtkSlicerPathPlannerPoseFilter(const vtkSlicerPathPlannerPoseFilter&); // Not implemented
+  void operator=(const vtkSlicerPathPlannerPoseFilter&);              // Not implemented
+};
+
+#endif
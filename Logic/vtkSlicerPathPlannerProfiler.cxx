@@ -0,0 +1,384 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner includes
+#include "vtkSlicerPathPlannerProfiler.h"
+
+// VTK includes
+#include <vtkObjectFactory.h>
+
+// STD includes
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerPathPlannerProfiler);
+
+//----------------------------------------------------------------------------
+namespace
+{
+const char* ProbeNames[vtkSlicerPathPlannerProfiler::NumberOfProbes] =
+{
+  "updateTable",
+  "updateRulerTable",
+  "identifyTipOfPath",
+  "calculatePath",
+  "selectTargetPoint",
+  "selectEntryPoint",
+  "selectPathsTable",
+  "onTrackerTransformModified"
+};
+
+// 4 buckets per power of two: bucket b covers [Lower(b), Lower(b+1)) ns
+const int NumberOfBuckets = 256;
+
+//----------------------------------------------------------------------------
+int BucketOf(vtkTypeUInt64 ns)
+{
+  if (ns < 4)
+    {
+    return static_cast<int>(ns);
+    }
+  int exponent = 2;
+  while ((ns >> (exponent + 1)) != 0)
+    {
+    exponent ++;
+    }
+  int mantissa = static_cast<int>((ns >> (exponent - 2)) & 3);
+  return 4 * (exponent - 1) + mantissa;
+}
+
+//----------------------------------------------------------------------------
+double LowerBoundOf(int bucket)
+{
+  if (bucket < 4)
+    {
+    return bucket;
+    }
+  int exponent = bucket / 4 + 1;
+  return std::ldexp(static_cast<double>(4 + bucket % 4), exponent - 2);
+}
+
+//----------------------------------------------------------------------------
+// Histogram of one probe on one thread. Only the owner thread writes it,
+// hence plain load/store instead of read-modify-write operations; the
+// atomics only make the values safe to read from another thread.
+struct ProbeHistogram
+{
+  std::atomic<vtkTypeUInt64> Buckets[NumberOfBuckets];
+  std::atomic<vtkTypeUInt64> Count;
+  std::atomic<vtkTypeUInt64> Total;
+  std::atomic<vtkTypeUInt64> Maximum;
+  std::atomic<int> MaximumDepth;
+  int Depth;
+
+  ProbeHistogram()
+  {
+    this->Clear();
+    this->Depth = 0;
+  }
+
+  void Clear()
+  {
+    for (int i = 0; i < NumberOfBuckets; i ++)
+      {
+      this->Buckets[i].store(0, std::memory_order_relaxed);
+      }
+    this->Count.store(0, std::memory_order_relaxed);
+    this->Total.store(0, std::memory_order_relaxed);
+    this->Maximum.store(0, std::memory_order_relaxed);
+    this->MaximumDepth.store(0, std::memory_order_relaxed);
+  }
+
+  void Add(vtkTypeUInt64 ns)
+  {
+    std::atomic<vtkTypeUInt64>& bucket = this->Buckets[BucketOf(ns)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    this->Total.store(this->Total.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+    if (ns > this->Maximum.load(std::memory_order_relaxed))
+      {
+      this->Maximum.store(ns, std::memory_order_relaxed);
+      }
+    // published last: a reader never sees more calls than bucket entries
+    this->Count.store(this->Count.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+  }
+};
+
+struct ThreadHistograms
+{
+  ProbeHistogram Probes[vtkSlicerPathPlannerProfiler::NumberOfProbes];
+};
+
+//----------------------------------------------------------------------------
+// The histograms of every thread that ever recorded a probe. They are kept
+// after the thread ends so that its calls are still counted.
+struct Registry
+{
+  std::mutex Mutex;
+  std::vector<ThreadHistograms*> Threads;
+
+  ~Registry()
+  {
+    for (size_t i = 0; i < this->Threads.size(); i ++)
+      {
+      delete this->Threads[i];
+      }
+  }
+};
+
+Registry& GetRegistry()
+{
+  static Registry registry;
+  return registry;
+}
+
+//----------------------------------------------------------------------------
+ProbeHistogram& GetLocalHistogram(int probe)
+{
+  static thread_local ThreadHistograms* local = 0;
+  if (!local)
+    {
+    // first probe of this thread: the only time a lock is taken
+    Registry& registry = GetRegistry();
+    std::lock_guard<std::mutex> lock(registry.Mutex);
+    local = new ThreadHistograms;
+    registry.Threads.push_back(local);
+    }
+  return local->Probes[probe];
+}
+
+//----------------------------------------------------------------------------
+vtkTypeInt64 Now()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//----------------------------------------------------------------------------
+// Histogram of a probe merged over all the threads
+struct Summary
+{
+  vtkTypeUInt64 Buckets[NumberOfBuckets];
+  vtkTypeUInt64 Count;
+  vtkTypeUInt64 Total;
+  vtkTypeUInt64 Maximum;
+  int MaximumDepth;
+};
+
+bool Summarize(int probe, Summary& summary)
+{
+  memset(&summary, 0, sizeof(summary));
+  if (probe < 0 || probe >= vtkSlicerPathPlannerProfiler::NumberOfProbes)
+    {
+    return false;
+    }
+
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.Mutex);
+  for (size_t t = 0; t < registry.Threads.size(); t ++)
+    {
+    const ProbeHistogram& histogram = registry.Threads[t]->Probes[probe];
+    summary.Count += histogram.Count.load(std::memory_order_acquire);
+    for (int i = 0; i < NumberOfBuckets; i ++)
+      {
+      summary.Buckets[i] += histogram.Buckets[i].load(std::memory_order_relaxed);
+      }
+    summary.Total += histogram.Total.load(std::memory_order_relaxed);
+    summary.Maximum = std::max(summary.Maximum, histogram.Maximum.load(std::memory_order_relaxed));
+    summary.MaximumDepth = std::max(summary.MaximumDepth, histogram.MaximumDepth.load(std::memory_order_relaxed));
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+double Percentile(const Summary& summary, double percentile)
+{
+  vtkTypeUInt64 entries = 0;
+  for (int i = 0; i < NumberOfBuckets; i ++)
+    {
+    entries += summary.Buckets[i];
+    }
+  if (entries == 0)
+    {
+    return 0.0;
+    }
+
+  percentile = std::min(std::max(percentile, 0.0), 100.0);
+  double rank = percentile / 100.0 * entries;
+  vtkTypeUInt64 cumulated = 0;
+  for (int i = 0; i < NumberOfBuckets; i ++)
+    {
+    cumulated += summary.Buckets[i];
+    if (summary.Buckets[i] > 0 && cumulated >= rank)
+      {
+      // middle of the bucket, never beyond the longest call
+      double ns = 0.5 * (LowerBoundOf(i) + LowerBoundOf(i + 1));
+      return std::min(ns, static_cast<double>(summary.Maximum)) * 1e-6;
+      }
+    }
+  return summary.Maximum * 1e-6;
+}
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerProfiler::Scope::Scope(int probe)
+{
+  this->Probe = probe;
+  ProbeHistogram& histogram = GetLocalHistogram(probe);
+  histogram.Depth ++;
+  if (histogram.Depth > histogram.MaximumDepth.load(std::memory_order_relaxed))
+    {
+    histogram.MaximumDepth.store(histogram.Depth, std::memory_order_relaxed);
+    }
+  this->Start = Now();
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerProfiler::Scope::~Scope()
+{
+  vtkTypeInt64 elapsed = Now() - this->Start;
+  ProbeHistogram& histogram = GetLocalHistogram(this->Probe);
+  histogram.Add(elapsed > 0 ? static_cast<vtkTypeUInt64>(elapsed) : 0);
+  histogram.Depth --;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerProfiler::vtkSlicerPathPlannerProfiler()
+{
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerProfiler::~vtkSlicerPathPlannerProfiler()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerProfiler::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "Probes:\n";
+  vtkSlicerPathPlannerProfiler::PrintProbes(os);
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerPathPlannerProfiler::GetNumberOfProbes()
+{
+  return NumberOfProbes;
+}
+
+//----------------------------------------------------------------------------
+const char* vtkSlicerPathPlannerProfiler::GetProbeName(int probe)
+{
+  if (probe < 0 || probe >= NumberOfProbes)
+    {
+    return 0;
+    }
+  return ProbeNames[probe];
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerPathPlannerProfiler::GetProbeIndex(const char* name)
+{
+  if (!name)
+    {
+    return -1;
+    }
+  for (int i = 0; i < NumberOfProbes; i ++)
+    {
+    if (strcmp(ProbeNames[i], name) == 0)
+      {
+      return i;
+      }
+    }
+  return -1;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerProfiler::GetCallCount(int probe)
+{
+  Summary summary;
+  Summarize(probe, summary);
+  return static_cast<vtkIdType>(summary.Count);
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerPathPlannerProfiler::GetLatencyPercentile(int probe, double percentile)
+{
+  Summary summary;
+  Summarize(probe, summary);
+  return Percentile(summary, percentile);
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerPathPlannerProfiler::GetMeanLatency(int probe)
+{
+  Summary summary;
+  Summarize(probe, summary);
+  return summary.Count > 0 ? summary.Total * 1e-6 / summary.Count : 0.0;
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerPathPlannerProfiler::GetMaximumLatency(int probe)
+{
+  Summary summary;
+  Summarize(probe, summary);
+  return summary.Maximum * 1e-6;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerPathPlannerProfiler::GetMaximumDepth(int probe)
+{
+  Summary summary;
+  Summarize(probe, summary);
+  return summary.MaximumDepth;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerProfiler::Reset()
+{
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.Mutex);
+  for (size_t t = 0; t < registry.Threads.size(); t ++)
+    {
+    for (int i = 0; i < NumberOfProbes; i ++)
+      {
+      registry.Threads[t]->Probes[i].Clear();
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerProfiler::PrintProbes(ostream& os)
+{
+  for (int i = 0; i < NumberOfProbes; i ++)
+    {
+    Summary summary;
+    Summarize(i, summary);
+    os << ProbeNames[i]
+       << ": calls " << static_cast<vtkIdType>(summary.Count)
+       << ", p50 " << Percentile(summary, 50.0)
+       << " ms, p95 " << Percentile(summary, 95.0)
+       << " ms, p99 " << Percentile(summary, 99.0)
+       << " ms, max " << summary.Maximum * 1e-6
+       << " ms, depth " << summary.MaximumDepth << "\n";
+    }
+}
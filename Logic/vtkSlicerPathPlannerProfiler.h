@@ -0,0 +1,117 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkSlicerPathPlannerProfiler - latency counters of the path planner
+// .SECTION Description
+// The handlers of the path planner are instrumented with
+// vtkSlicerPathPlannerProbeMacro, which times the enclosing scope. Each
+// thread records into its own log-scale histograms (4 buckets per power of
+// two nanoseconds) without taking any lock; the histograms of all the
+// threads are merged when statistics are queried. Call counts, latency
+// percentiles and the maximum re-entrancy depth are available per probe,
+// also through vtkSlicerPathPlannerLogic.
+
+#ifndef __vtkSlicerPathPlannerProfiler_h
+#define __vtkSlicerPathPlannerProfiler_h
+
+// VTK includes
+#include <vtkObject.h>
+
+#include "vtkSlicerPathPlannerModuleLogicExport.h"
+
+//BTX
+/// Time the enclosing scope under the given vtkSlicerPathPlannerProfiler
+/// probe, e.g. vtkSlicerPathPlannerProbeMacro(UpdateTableProbe);
+#define vtkSlicerPathPlannerProbeMacro(probe)                     \
+  vtkSlicerPathPlannerProfiler::Scope vtkSlicerPathPlannerProbeScope( \
+    vtkSlicerPathPlannerProfiler::probe)
+//ETX
+
+/// \ingroup Slicer_QtModules_PathPlanner
+class VTK_SLICER_PATHPLANNER_MODULE_LOGIC_EXPORT vtkSlicerPathPlannerProfiler :
+  public vtkObject
+{
+public:
+
+  static vtkSlicerPathPlannerProfiler *New();
+  vtkTypeMacro(vtkSlicerPathPlannerProfiler, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  //BTX
+  enum Probes
+    {
+    UpdateTableProbe = 0,
+    UpdateRulerTableProbe,
+    IdentifyTipOfPathProbe,
+    CalculatePathProbe,
+    SelectTargetPointProbe,
+    SelectEntryPointProbe,
+    SelectPathsTableProbe,
+    TrackerTransformModifiedProbe,
+    NumberOfProbes
+    };
+  //ETX
+
+  /// Number of probes and their names (e.g. "updateTable")
+  static int GetNumberOfProbes();
+  static const char* GetProbeName(int probe);
+  /// Return the probe of the given name, -1 if there is none
+  static int GetProbeIndex(const char* name);
+
+  /// Number of completed calls
+  static vtkIdType GetCallCount(int probe);
+  /// Latency under which the given percentage (e.g. 95) of the calls
+  /// completed, in ms. The value is exact to within 13% (half a bucket).
+  static double GetLatencyPercentile(int probe, double percentile);
+  /// Mean and longest latency, in ms
+  static double GetMeanLatency(int probe);
+  static double GetMaximumLatency(int probe);
+  /// Deepest nesting of the probe on a thread (1 if never re-entered)
+  static int GetMaximumDepth(int probe);
+
+  /// Forget the recorded calls. Calls recorded concurrently on other
+  /// threads may be partially kept.
+  static void Reset();
+
+  /// Print one line per probe: calls, p50, p95, p99, max (ms) and depth
+  static void PrintProbes(ostream& os);
+
+  //BTX
+  /// Record the duration of its lifetime under a probe
+  class VTK_SLICER_PATHPLANNER_MODULE_LOGIC_EXPORT Scope
+  {
+  public:
+    explicit Scope(int probe);
+    ~Scope();
+  private:
+    Scope(const Scope&);          // Not implemented
+    void operator=(const Scope&); // Not implemented
+    int Probe;
+    vtkTypeInt64 Start;
+  };
+  //ETX
+
+protected:
+  vtkSlicerPathPlannerProfiler();
+  virtual ~vtkSlicerPathPlannerProfiler();
+
+private:
+  vtkSlicerPathPlannerProfiler(const vtkSlicerPathPlannerProfiler&); // Not implemented
+  void operator=(const vtkSlicerPathPlannerProfiler&);               // Not implemented
+};
+
+#endif
@@ -0,0 +1,577 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner Logic includes
+#include "vtkSlicerPathPlannerParallel.h"
+#include "vtkSlicerPathPlannerSkinSampler.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSetGet.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+//----------------------------------------------------------------------------
+namespace
+{
+// Additive recurrence of the plastic number (the R2 sequence): successive
+// samples cover the unit square evenly, without clumps or grid artifacts
+const double R2Steps[2] = { 0.7548776662466927, 0.5698402909980532 };
+
+// Voxel classes of the volume sampler
+enum
+{
+  Background = 0,
+  Body = 1,
+  Outside = 2
+};
+
+//----------------------------------------------------------------------------
+// Twice the area vector (cross product of the edges) of each triangle
+class AreaPass : public vtkSlicerPathPlannerParallel::Functor
+{
+public:
+  const double* Triangles;
+  double* Normals;
+
+  virtual void operator()(vtkIdType begin, vtkIdType end)
+  {
+    for (vtkIdType i = begin; i < end; i ++)
+      {
+      const double* t = this->Triangles + 9 * i;
+      double e1[3] = { t[3] - t[0], t[4] - t[1], t[5] - t[2] };
+      double e2[3] = { t[6] - t[0], t[7] - t[1], t[8] - t[2] };
+      vtkMath::Cross(e1, e2, this->Normals + 3 * i);
+      }
+  }
+};
+
+//----------------------------------------------------------------------------
+// Samples of each triangle: samples First[i] to First[i+1] - 1 of the
+// surface fall in triangle i
+class SurfaceFillPass : public vtkSlicerPathPlannerParallel::Functor
+{
+public:
+  const double* Triangles;
+  const double* Normals;
+  const vtkIdType* First;
+  double Orientation;
+  double* Positions;
+  double* SampleNormals;
+
+  virtual void operator()(vtkIdType begin, vtkIdType end)
+  {
+    for (vtkIdType i = begin; i < end; i ++)
+      {
+      if (this->First[i] == this->First[i+1])
+        {
+        continue;
+        }
+      const double* t = this->Triangles + 9 * i;
+      double e1[3] = { t[3] - t[0], t[4] - t[1], t[5] - t[2] };
+      double e2[3] = { t[6] - t[0], t[7] - t[1], t[8] - t[2] };
+      double normal[3] = { this->Normals[3 * i], this->Normals[3 * i + 1], this->Normals[3 * i + 2] };
+      double norm = vtkMath::Normalize(normal);
+      for (int axis = 0; axis < 3; axis ++)
+        {
+        normal[axis] = (norm > 0.0) ? this->Orientation * normal[axis] : 0.0;
+        }
+
+      for (vtkIdType sample = this->First[i]; sample < this->First[i+1]; sample ++)
+        {
+        // Fold the point of the unit square into the triangle
+        double u = 0.5 + sample * R2Steps[0];
+        double v = 0.5 + sample * R2Steps[1];
+        u -= floor(u);
+        v -= floor(v);
+        if (u + v > 1.0)
+          {
+          u = 1.0 - u;
+          v = 1.0 - v;
+          }
+        double* position = this->Positions + 3 * sample;
+        double* sampleNormal = this->SampleNormals + 3 * sample;
+        for (int axis = 0; axis < 3; axis ++)
+          {
+          position[axis] = t[axis] + u * e1[axis] + v * e2[axis];
+          sampleNormal[axis] = normal[axis];
+          }
+        }
+      }
+  }
+};
+
+//----------------------------------------------------------------------------
+// Body and background voxels
+template <class T>
+class ThresholdPass : public vtkSlicerPathPlannerParallel::Functor
+{
+public:
+  const T* Scalars;
+  T Threshold;
+  unsigned char* Classes;
+
+  virtual void operator()(vtkIdType begin, vtkIdType end)
+  {
+    for (vtkIdType i = begin; i < end; i ++)
+      {
+      this->Classes[i] = (this->Scalars[i] >= this->Threshold) ? Body : Background;
+      }
+  }
+};
+
+template <class T>
+void Threshold(const T* scalars, vtkIdType numberOfVoxels, double threshold,
+               unsigned char* classes)
+{
+  // Compare in the scalar type: the smallest value at or above threshold
+  double lowest = std::numeric_limits<T>::is_integer ? ceil(threshold) : threshold;
+  if (lowest > std::numeric_limits<T>::max())
+    {
+    std::fill(classes, classes + numberOfVoxels, static_cast<unsigned char>(Background));
+    return;
+    }
+  double smallest = std::numeric_limits<T>::is_integer ?
+    static_cast<double>(std::numeric_limits<T>::min()) :
+    -static_cast<double>(std::numeric_limits<T>::max());
+  ThresholdPass<T> pass;
+  pass.Scalars = scalars;
+  pass.Threshold = static_cast<T>(std::max(lowest, smallest));
+  pass.Classes = classes;
+  vtkSlicerPathPlannerParallel::For(0, numberOfVoxels, 1 << 16, pass);
+}
+
+//----------------------------------------------------------------------------
+// Flood fill the background of each axial slice from its border, a row
+// span at a time: the background reached is outside, the rest (air in the
+// bowels, lungs) is not.
+class OutsidePass : public vtkSlicerPathPlannerParallel::Functor
+{
+public:
+  unsigned char* Classes;
+  int Dimensions[3];
+
+  virtual void operator()(vtkIdType begin, vtkIdType end)
+  {
+    int nx = this->Dimensions[0];
+    int ny = this->Dimensions[1];
+    vtkIdType sliceSize = static_cast<vtkIdType>(nx) * ny;
+    std::vector<vtkIdType> seeds;
+    for (vtkIdType k = begin; k < end; k ++)
+      {
+      unsigned char* slice = this->Classes + k * sliceSize;
+      seeds.clear();
+      this->SeedRow(slice, 0, 0, nx - 1, seeds);
+      this->SeedRow(slice, ny - 1, 0, nx - 1, seeds);
+      for (int j = 1; j < ny - 1; j ++)
+        {
+        this->SeedRow(slice, j, 0, 0, seeds);
+        this->SeedRow(slice, j, nx - 1, nx - 1, seeds);
+        }
+      while (!seeds.empty())
+        {
+        vtkIdType pixel = seeds.back();
+        seeds.pop_back();
+        if (slice[pixel] != Background)
+          {
+          continue;
+          }
+        // Fill the background span of the seed, then seed the background
+        // spans above and below it
+        int j = static_cast<int>(pixel / nx);
+        unsigned char* row = slice + static_cast<vtkIdType>(j) * nx;
+        int first = static_cast<int>(pixel % nx);
+        int last = first;
+        while (first > 0 && row[first - 1] == Background)
+          {
+          first --;
+          }
+        while (last < nx - 1 && row[last + 1] == Background)
+          {
+          last ++;
+          }
+        std::fill(row + first, row + last + 1, static_cast<unsigned char>(Outside));
+        if (j > 0)
+          {
+          this->SeedRow(slice, j - 1, first, last, seeds);
+          }
+        if (j < ny - 1)
+          {
+          this->SeedRow(slice, j + 1, first, last, seeds);
+          }
+        }
+      }
+  }
+
+  // Push a seed per background span of row j within [first, last]
+  void SeedRow(const unsigned char* slice, int j, int first, int last,
+               std::vector<vtkIdType>& seeds) const
+  {
+    vtkIdType row = static_cast<vtkIdType>(j) * this->Dimensions[0];
+    bool inSpan = false;
+    for (int i = first; i <= last; i ++)
+      {
+      bool background = (slice[row + i] == Background);
+      if (background && !inSpan)
+        {
+        seeds.push_back(row + i);
+        }
+      inSpan = background;
+      }
+  }
+};
+
+//----------------------------------------------------------------------------
+// Skin voxels of each layer of cells (the slices of the same cell index
+// along K), the one closest to the center of its cell being kept. Layer l
+// writes to Positions[l] and Normals[l] only, so that the layers can run
+// concurrently.
+class SkinPass : public vtkSlicerPathPlannerParallel::Functor
+{
+public:
+  const unsigned char* Classes;
+  int Dimensions[3];
+  int Origin[3];
+  // Cell size in voxels along each axis, and number of cells along I and J
+  double CellSize[3];
+  int NumberOfCells[2];
+  const int* LayerSlices;
+  // RAS of the voxel indices, and the inverse transpose of its linear part
+  // to transform the gradients
+  double IJKToRAS[3][4];
+  double GradientToRAS[3][3];
+  std::vector<double>* Positions;
+  std::vector<double>* Normals;
+
+  bool IsOutside(int i, int j, int k) const
+  {
+    if (i < 0 || j < 0 || k < 0 ||
+        i >= this->Dimensions[0] || j >= this->Dimensions[1] || k >= this->Dimensions[2])
+      {
+      // The body is cut by the border of the volume: no skin there
+      return false;
+      }
+    vtkIdType index = i + this->Dimensions[0] * (j + static_cast<vtkIdType>(this->Dimensions[1]) * k);
+    return this->Classes[index] == Outside;
+  }
+
+  // Whether the voxel at index (i,j,k) has an outside face neighbor
+  bool IsSkin(vtkIdType index, int i, int j, int k) const
+  {
+    vtkIdType sliceSize = static_cast<vtkIdType>(this->Dimensions[0]) * this->Dimensions[1];
+    const unsigned char* voxel = this->Classes + index;
+    return (i > 0 && voxel[-1] == Outside) ||
+           (i < this->Dimensions[0] - 1 && voxel[1] == Outside) ||
+           (j > 0 && voxel[-this->Dimensions[0]] == Outside) ||
+           (j < this->Dimensions[1] - 1 && voxel[this->Dimensions[0]] == Outside) ||
+           (k > 0 && voxel[-sliceSize] == Outside) ||
+           (k < this->Dimensions[2] - 1 && voxel[sliceSize] == Outside);
+  }
+
+  // Unit gradient of the outside (a 3x3x3 Sobel operator) in RAS
+  void ComputeNormal(int i, int j, int k, double normal[3]) const
+  {
+    static const double weights[3] = { 1.0, 2.0, 1.0 };
+    double gradient[3] = { 0.0, 0.0, 0.0 };
+    for (int c = -1; c <= 1; c ++)
+      {
+      for (int b = -1; b <= 1; b ++)
+        {
+        double w = weights[b + 1] * weights[c + 1];
+        gradient[0] += w * (this->IsOutside(i + 1, j + b, k + c) - this->IsOutside(i - 1, j + b, k + c));
+        gradient[1] += w * (this->IsOutside(i + b, j + 1, k + c) - this->IsOutside(i + b, j - 1, k + c));
+        gradient[2] += w * (this->IsOutside(i + b, j + c, k + 1) - this->IsOutside(i + b, j + c, k - 1));
+        }
+      }
+    for (int row = 0; row < 3; row ++)
+      {
+      normal[row] = this->GradientToRAS[row][0] * gradient[0] +
+                    this->GradientToRAS[row][1] * gradient[1] +
+                    this->GradientToRAS[row][2] * gradient[2];
+      }
+    vtkMath::Normalize(normal);
+  }
+
+  virtual void operator()(vtkIdType begin, vtkIdType end)
+  {
+    vtkIdType nCells = static_cast<vtkIdType>(this->NumberOfCells[0]) * this->NumberOfCells[1];
+    std::vector<double> distances;
+    std::vector<vtkIdType> voxels;
+    for (vtkIdType layer = begin; layer < end; layer ++)
+      {
+      // Skin voxel closest to the center of each cell of the layer
+      distances.assign(nCells, VTK_DOUBLE_MAX);
+      voxels.assign(nCells, -1);
+      double center[3];
+      center[2] = (layer + 0.5) * this->CellSize[2] - 0.5;
+      for (int k = this->LayerSlices[layer]; k < this->LayerSlices[layer + 1]; k ++)
+        {
+        for (int j = 0; j < this->Dimensions[1]; j ++)
+          {
+          int cellJ = static_cast<int>(j / this->CellSize[1]);
+          center[1] = (cellJ + 0.5) * this->CellSize[1] - 0.5;
+          vtkIdType row = this->Dimensions[0] * (j + static_cast<vtkIdType>(this->Dimensions[1]) * k);
+          for (int i = 0; i < this->Dimensions[0]; i ++)
+            {
+            if (this->Classes[row + i] != Body || !this->IsSkin(row + i, i, j, k))
+              {
+              continue;
+              }
+            int cellI = static_cast<int>(i / this->CellSize[0]);
+            center[0] = (cellI + 0.5) * this->CellSize[0] - 0.5;
+            // Offsets in cells, so that the axes weigh alike
+            double d[3] = { (i - center[0]) / this->CellSize[0],
+                            (j - center[1]) / this->CellSize[1],
+                            (k - center[2]) / this->CellSize[2] };
+            double distance2 = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+            vtkIdType cell = cellI + static_cast<vtkIdType>(this->NumberOfCells[0]) * cellJ;
+            if (distance2 < distances[cell])
+              {
+              distances[cell] = distance2;
+              voxels[cell] = row + i;
+              }
+            }
+          }
+        }
+
+      std::vector<double>& positions = this->Positions[layer];
+      std::vector<double>& normals = this->Normals[layer];
+      vtkIdType sliceSize = static_cast<vtkIdType>(this->Dimensions[0]) * this->Dimensions[1];
+      for (vtkIdType cell = 0; cell < nCells; cell ++)
+        {
+        if (voxels[cell] < 0)
+          {
+          continue;
+          }
+        int ijk[3] = { static_cast<int>(voxels[cell] % this->Dimensions[0]),
+                       static_cast<int>((voxels[cell] % sliceSize) / this->Dimensions[0]),
+                       static_cast<int>(voxels[cell] / sliceSize) };
+        for (int row = 0; row < 3; row ++)
+          {
+          const double* m = this->IJKToRAS[row];
+          positions.push_back(m[0] * (ijk[0] + this->Origin[0]) +
+                              m[1] * (ijk[1] + this->Origin[1]) +
+                              m[2] * (ijk[2] + this->Origin[2]) + m[3]);
+          }
+        double normal[3];
+        this->ComputeNormal(ijk[0], ijk[1], ijk[2], normal);
+        normals.insert(normals.end(), normal, normal + 3);
+        }
+      }
+  }
+};
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerSkinSampler
+::SampleSurface(vtkPolyData* surface, double spacing,
+                std::vector<double>& positions, std::vector<double>& normals)
+{
+  vtkPoints* points = surface ? surface->GetPoints() : 0;
+  if (!points || spacing <= 0.0)
+    {
+    return 0;
+    }
+
+  // Triangles of the polygons (fans) and of the strips, the odd triangles
+  // of the strips flipped to keep the winding of the strip
+  std::vector<double> triangles;
+  vtkCellArray* cellArrays[2] = { surface->GetPolys(), surface->GetStrips() };
+  for (int strips = 0; strips < 2; strips ++)
+    {
+    vtkCellArray* cells = cellArrays[strips];
+    if (!cells)
+      {
+      continue;
+      }
+    vtkIdType npts = 0;
+    vtkIdType* pts = 0;
+    for (cells->InitTraversal(); cells->GetNextCell(npts, pts);)
+      {
+      for (vtkIdType k = 0; k + 2 < npts; k ++)
+        {
+        vtkIdType ids[3] = { strips ? pts[k] : pts[0], pts[k+1], pts[k+2] };
+        if (strips && (k % 2))
+          {
+          std::swap(ids[1], ids[2]);
+          }
+        for (int vertex = 0; vertex < 3; vertex ++)
+          {
+          double p[3];
+          points->GetPoint(ids[vertex], p);
+          triangles.insert(triangles.end(), p, p + 3);
+          }
+        }
+      }
+    }
+  vtkIdType nTriangles = static_cast<vtkIdType>(triangles.size() / 9);
+  if (nTriangles == 0)
+    {
+    return 0;
+    }
+
+  std::vector<double> triangleNormals(3 * nTriangles);
+  AreaPass areas;
+  areas.Triangles = &triangles[0];
+  areas.Normals = &triangleNormals[0];
+  vtkSlicerPathPlannerParallel::For(0, nTriangles, 4096, areas);
+
+  // One sample per spacing^2 of cumulated area: the samples of a triangle
+  // are the multiples of spacing^2 crossed by its area. The signed volume
+  // tells whether the triangles wind around the outward normals.
+  std::vector<vtkIdType> first(nTriangles + 1);
+  double sampleArea = spacing * spacing;
+  double area = 0.0;
+  double volume = 0.0;
+  first[0] = 0;
+  for (vtkIdType i = 0; i < nTriangles; i ++)
+    {
+    const double* n = &triangleNormals[3 * i];
+    area += 0.5 * vtkMath::Norm(n);
+    volume += vtkMath::Dot(&triangles[9 * i], n) / 6.0;
+    first[i + 1] = static_cast<vtkIdType>(floor(area / sampleArea));
+    }
+  vtkIdType nSamples = first[nTriangles];
+  if (nSamples == 0)
+    {
+    return 0;
+    }
+
+  size_t offset = positions.size();
+  positions.resize(offset + 3 * nSamples);
+  normals.resize(offset + 3 * nSamples);
+  SurfaceFillPass fill;
+  fill.Triangles = &triangles[0];
+  fill.Normals = &triangleNormals[0];
+  fill.First = &first[0];
+  fill.Orientation = (volume < 0.0) ? -1.0 : 1.0;
+  fill.Positions = &positions[offset];
+  fill.SampleNormals = &normals[offset];
+  vtkSlicerPathPlannerParallel::For(0, nTriangles, 4096, fill);
+  return nSamples;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerSkinSampler
+::SampleVolume(vtkImageData* volume, vtkMatrix4x4* ijkToRAS, double threshold,
+               double spacing, std::vector<double>& positions, std::vector<double>& normals)
+{
+  if (!volume || !ijkToRAS || spacing <= 0.0 ||
+      volume->GetNumberOfScalarComponents() != 1 || !volume->GetScalarPointer())
+    {
+    return 0;
+    }
+  int dimensions[3];
+  volume->GetDimensions(dimensions);
+  vtkIdType nVoxels = static_cast<vtkIdType>(dimensions[0]) * dimensions[1] * dimensions[2];
+  if (nVoxels <= 0)
+    {
+    return 0;
+    }
+
+  std::vector<unsigned char> classes(nVoxels);
+  switch (volume->GetScalarType())
+    {
+    vtkTemplateMacro(
+      Threshold(static_cast<const VTK_TT*>(volume->GetScalarPointer()), nVoxels,
+                threshold, &classes[0]));
+    default:
+      vtkGenericWarningMacro(<< "SampleVolume: unsupported scalar type " << volume->GetScalarType());
+      return 0;
+    }
+
+  OutsidePass outside;
+  outside.Classes = &classes[0];
+  std::copy(dimensions, dimensions + 3, outside.Dimensions);
+  vtkSlicerPathPlannerParallel::For(0, dimensions[2], 1, outside);
+
+  SkinPass skin;
+  skin.Classes = &classes[0];
+  std::copy(dimensions, dimensions + 3, skin.Dimensions);
+  int* extent = volume->GetExtent();
+  skin.Origin[0] = extent[0];
+  skin.Origin[1] = extent[2];
+  skin.Origin[2] = extent[4];
+  double m[3][3];
+  for (int row = 0; row < 3; row ++)
+    {
+    for (int column = 0; column < 4; column ++)
+      {
+      skin.IJKToRAS[row][column] = ijkToRAS->GetElement(row, column);
+      }
+    std::copy(skin.IJKToRAS[row], skin.IJKToRAS[row] + 3, m[row]);
+    }
+  // Inverse transpose of the linear part: its cofactors over its determinant
+  double determinant = vtkMath::Determinant3x3(m);
+  if (determinant == 0.0)
+    {
+    return 0;
+    }
+  for (int row = 0; row < 3; row ++)
+    {
+    for (int column = 0; column < 3; column ++)
+      {
+      int r1 = (row + 1) % 3, r2 = (row + 2) % 3;
+      int c1 = (column + 1) % 3, c2 = (column + 2) % 3;
+      skin.GradientToRAS[row][column] =
+        (m[r1][c1] * m[r2][c2] - m[r1][c2] * m[r2][c1]) / determinant;
+      }
+    }
+
+  // Cells of about spacing mm, at least a voxel
+  for (int axis = 0; axis < 3; axis ++)
+    {
+    double voxelSize[3] = { m[0][axis], m[1][axis], m[2][axis] };
+    double size = vtkMath::Norm(voxelSize);
+    skin.CellSize[axis] = (size > 0.0) ? std::max(1.0, spacing / size) : 1.0;
+    }
+  skin.NumberOfCells[0] = static_cast<int>((dimensions[0] - 1) / skin.CellSize[0]) + 1;
+  skin.NumberOfCells[1] = static_cast<int>((dimensions[1] - 1) / skin.CellSize[1]) + 1;
+  std::vector<int> layerSlices(1, 0);
+  for (int k = 1; k < dimensions[2]; k ++)
+    {
+    if (static_cast<int>(k / skin.CellSize[2]) != static_cast<int>((k - 1) / skin.CellSize[2]))
+      {
+      layerSlices.push_back(k);
+      }
+    }
+  layerSlices.push_back(dimensions[2]);
+  vtkIdType nLayers = static_cast<vtkIdType>(layerSlices.size()) - 1;
+  skin.LayerSlices = &layerSlices[0];
+  std::vector<std::vector<double> > layerPositions(nLayers);
+  std::vector<std::vector<double> > layerNormals(nLayers);
+  skin.Positions = &layerPositions[0];
+  skin.Normals = &layerNormals[0];
+  vtkSlicerPathPlannerParallel::For(0, nLayers, 1, skin);
+
+  vtkIdType nSamples = 0;
+  for (vtkIdType layer = 0; layer < nLayers; layer ++)
+    {
+    positions.insert(positions.end(), layerPositions[layer].begin(), layerPositions[layer].end());
+    normals.insert(normals.end(), layerNormals[layer].begin(), layerNormals[layer].end());
+    nSamples += static_cast<vtkIdType>(layerPositions[layer].size() / 3);
+    }
+  return nSamples;
+}
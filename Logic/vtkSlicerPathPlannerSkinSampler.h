@@ -0,0 +1,69 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkSlicerPathPlannerSkinSampler - entry point candidates on the skin
+// .SECTION Description
+// Samples the skin into dense entry point candidates about Spacing mm
+// apart, each with its outward unit normal, either from a skin surface
+// model or directly from a CT. Samples are returned as packed (x,y,z)
+// triplets ready for vtkSlicerPathPlannerPointStore::AddPoints(). Both
+// samplers run in parallel and are deterministic: the same input gives the
+// same points in the same order whatever the number of threads.
+
+#ifndef __vtkSlicerPathPlannerSkinSampler_h
+#define __vtkSlicerPathPlannerSkinSampler_h
+
+// VTK includes
+#include <vtkType.h>
+
+// STD includes
+#include <vector>
+
+#include "vtkSlicerPathPlannerModuleLogicExport.h"
+
+class vtkImageData;
+class vtkMatrix4x4;
+class vtkPolyData;
+
+/// \ingroup Slicer_QtModules_PathPlanner
+class VTK_SLICER_PATHPLANNER_MODULE_LOGIC_EXPORT vtkSlicerPathPlannerSkinSampler
+{
+public:
+  /// Sample the triangles (polygons and triangle strips) of surface with one
+  /// point per spacing^2 mm^2 of area, spread over each triangle with a
+  /// low discrepancy sequence. Normals are the triangle normals, flipped if
+  /// needed so that they point out of the enclosed volume. Positions and
+  /// normals are appended; return the number of samples appended.
+  static vtkIdType SampleSurface(vtkPolyData* surface, double spacing,
+                                 std::vector<double>& positions,
+                                 std::vector<double>& normals);
+
+  /// Sample the skin of a single component volume (e.g. a CT): the body is
+  /// the voxels at or above threshold, the outside is the rest of each axial
+  /// slice that is connected to the slice border, and the skin is the body
+  /// voxels next to the outside. At most one skin voxel, the closest to the
+  /// center, is kept per cell of a spacing mm grid. ijkToRAS maps the IJK
+  /// indices of the volume extent to RAS. Normals are the gradient of the
+  /// outside. Positions (RAS) and normals are appended; return the number of
+  /// samples appended.
+  static vtkIdType SampleVolume(vtkImageData* volume, vtkMatrix4x4* ijkToRAS,
+                                double threshold, double spacing,
+                                std::vector<double>& positions,
+                                std::vector<double>& normals);
+};
+
+#endif
@@ -0,0 +1,134 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner includes
+#include "vtkSlicerPathPlannerTrace.h"
+
+// VTK includes
+#include <vtkCriticalSection.h>
+#include <vtkObjectFactory.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <cstring>
+#include <fstream>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerPathPlannerTrace);
+
+//----------------------------------------------------------------------------
+namespace
+{
+struct TraceRecord
+{
+  double Time;
+  char Message[vtkSlicerPathPlannerTrace::MaximumMessageLength + 1];
+};
+
+// The ring buffer is preallocated: Record() copies the message into it
+// without allocating. The macro still formats the message with a string
+// stream, which does allocate, so it is kept out of Release builds.
+TraceRecord TraceRecords[vtkSlicerPathPlannerTrace::NumberOfRecords];
+int TraceNext = 0;
+int TraceCount = 0;
+vtkSimpleCriticalSection TraceLock;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerTrace::vtkSlicerPathPlannerTrace()
+{
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerTrace::~vtkSlicerPathPlannerTrace()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerTrace::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "NumberOfRecords: " << vtkSlicerPathPlannerTrace::GetNumberOfRecords() << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerTrace::Record(const char* message)
+{
+  double time = vtkTimerLog::GetUniversalTime();
+
+  TraceLock.Lock();
+  TraceRecord& record = TraceRecords[TraceNext];
+  record.Time = time;
+  strncpy(record.Message, message ? message : "", MaximumMessageLength);
+  record.Message[MaximumMessageLength] = '\0';
+  TraceNext = (TraceNext + 1) % NumberOfRecords;
+  if (TraceCount < NumberOfRecords)
+    {
+    TraceCount ++;
+    }
+  TraceLock.Unlock();
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerPathPlannerTrace::GetNumberOfRecords()
+{
+  TraceLock.Lock();
+  int count = TraceCount;
+  TraceLock.Unlock();
+  return count;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerTrace::Clear()
+{
+  TraceLock.Lock();
+  TraceNext = 0;
+  TraceCount = 0;
+  TraceLock.Unlock();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerTrace::Dump(ostream& os)
+{
+  std::ios::fmtflags flags = os.flags();
+  TraceLock.Lock();
+  int first = (TraceNext - TraceCount + NumberOfRecords) % NumberOfRecords;
+  for (int i = 0; i < TraceCount; i ++)
+    {
+    const TraceRecord& record = TraceRecords[(first + i) % NumberOfRecords];
+    os << std::fixed << record.Time << " " << record.Message << "\n";
+    }
+  TraceLock.Unlock();
+  os.flags(flags);
+  os.flush();
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerPathPlannerTrace::DumpToFile(const char* fileName)
+{
+  if (!fileName)
+    {
+    return false;
+    }
+  std::ofstream file(fileName);
+  if (!file)
+    {
+    return false;
+    }
+  vtkSlicerPathPlannerTrace::Dump(file);
+  return file.good();
+}
@@ -0,0 +1,93 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkSlicerPathPlannerTrace - in-memory trace of the path planner
+// .SECTION Description
+// Diagnostic messages are recorded with vtkSlicerPathPlannerTraceMacro into
+// a fixed size ring buffer instead of being written to the console; the
+// latest messages can be dumped on demand. The macro compiles to nothing
+// unless PATHPLANNER_ENABLE_TRACE is defined, which is the case in Debug
+// builds only.
+
+#ifndef __vtkSlicerPathPlannerTrace_h
+#define __vtkSlicerPathPlannerTrace_h
+
+// VTK includes
+#include <vtkObject.h>
+
+#include "vtkSlicerPathPlannerModuleLogicExport.h"
+
+#ifdef PATHPLANNER_ENABLE_TRACE
+//BTX
+# include <sstream>
+# define vtkSlicerPathPlannerTraceMacro(x)                  \
+  do                                                        \
+    {                                                       \
+    std::ostringstream vtkSlicerPathPlannerTraceStream;     \
+    vtkSlicerPathPlannerTraceStream << x;                   \
+    vtkSlicerPathPlannerTrace::Record(                      \
+      vtkSlicerPathPlannerTraceStream.str().c_str());       \
+    }                                                       \
+  while (0)
+//ETX
+#else
+# define vtkSlicerPathPlannerTraceMacro(x) do {} while (0)
+#endif
+
+/// \ingroup Slicer_QtModules_PathPlanner
+class VTK_SLICER_PATHPLANNER_MODULE_LOGIC_EXPORT vtkSlicerPathPlannerTrace :
+  public vtkObject
+{
+public:
+
+  static vtkSlicerPathPlannerTrace *New();
+  vtkTypeMacro(vtkSlicerPathPlannerTrace, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Record a message, overwriting the oldest one once the buffer is full.
+  /// Messages longer than MaximumMessageLength are truncated.
+  static void Record(const char* message);
+
+  /// Number of messages currently held by the buffer
+  static int GetNumberOfRecords();
+
+  /// Forget all the messages
+  static void Clear();
+
+  /// Write the messages, oldest first, prefixed with their time in seconds
+  static void Dump(ostream& os);
+  /// Same as Dump() into a text file. Return false if it cannot be written.
+  static bool DumpToFile(const char* fileName);
+
+  //BTX
+  enum
+    {
+    NumberOfRecords = 4096,
+    MaximumMessageLength = 120
+    };
+  //ETX
+
+protected:
+  vtkSlicerPathPlannerTrace();
+  virtual ~vtkSlicerPathPlannerTrace();
+
+private:
+  vtkSlicerPathPlannerTrace(const vtkSlicerPathPlannerTrace&); // Not implemented
+  void operator=(const vtkSlicerPathPlannerTrace&);            // Not implemented
+};
+
+#endif
@@ -0,0 +1,147 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner Logic includes
+#include "vtkSlicerPathPlannerTrackerBuffer.h"
+
+// VTK includes
+#include <vtkObjectFactory.h>
+
+// STD includes
+#include <algorithm>
+#include <chrono>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerPathPlannerTrackerBuffer);
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerTrackerBuffer::vtkSlicerPathPlannerTrackerBuffer()
+  : Mask(0), Head(0), Tail(0), Dropped(0)
+{
+  this->SetCapacity(255);
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerTrackerBuffer::~vtkSlicerPathPlannerTrackerBuffer()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerTrackerBuffer::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "Capacity: " << this->GetCapacity() << "\n";
+  os << indent << "NumberOfSamples: " << this->GetNumberOfSamples() << "\n";
+  os << indent << "NumberOfDroppedSamples: " << this->GetNumberOfDroppedSamples() << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerTrackerBuffer::SetCapacity(int capacity)
+{
+  // One slot stays free to tell a full buffer from an empty one
+  size_t size = 2;
+  while (size < static_cast<size_t>(std::max(capacity, 1)) + 1)
+    {
+    size *= 2;
+    }
+  this->Samples.resize(size);
+  this->Mask = size - 1;
+  this->Clear();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerPathPlannerTrackerBuffer::GetCapacity() const
+{
+  return static_cast<int>(this->Mask);
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerPathPlannerTrackerBuffer::Push(double time, const double matrix[16])
+{
+  size_t tail = this->Tail.load(std::memory_order_relaxed);
+  size_t next = (tail + 1) & this->Mask;
+  if (next == this->Head.load(std::memory_order_acquire))
+    {
+    this->Dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+    }
+  Sample& sample = this->Samples[tail];
+  sample.Time = time;
+  std::copy(matrix, matrix + 16, sample.Matrix);
+  // publish the sample to the consumer
+  this->Tail.store(next, std::memory_order_release);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerPathPlannerTrackerBuffer::Pop(Sample& sample)
+{
+  size_t head = this->Head.load(std::memory_order_relaxed);
+  if (head == this->Tail.load(std::memory_order_acquire))
+    {
+    return false;
+    }
+  sample = this->Samples[head];
+  // hand the slot back to the producer
+  this->Head.store((head + 1) & this->Mask, std::memory_order_release);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerPathPlannerTrackerBuffer::PopLatest(Sample& sample)
+{
+  size_t head = this->Head.load(std::memory_order_relaxed);
+  size_t tail = this->Tail.load(std::memory_order_acquire);
+  if (head == tail)
+    {
+    return 0;
+    }
+  sample = this->Samples[(tail - 1) & this->Mask];
+  this->Head.store(tail, std::memory_order_release);
+  return static_cast<int>((tail - head) & this->Mask);
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerPathPlannerTrackerBuffer::GetNumberOfSamples() const
+{
+  size_t head = this->Head.load(std::memory_order_acquire);
+  size_t tail = this->Tail.load(std::memory_order_acquire);
+  return static_cast<int>((tail - head) & this->Mask);
+}
+
+//----------------------------------------------------------------------------
+vtkTypeUInt64 vtkSlicerPathPlannerTrackerBuffer::GetNumberOfDroppedSamples() const
+{
+  return this->Dropped.load(std::memory_order_relaxed);
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerTrackerBuffer::Clear()
+{
+  this->Head.store(0);
+  this->Tail.store(0);
+  this->Dropped.store(0);
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerPathPlannerTrackerBuffer::GetTime()
+{
+  return std::chrono::duration_cast< std::chrono::duration<double> >(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
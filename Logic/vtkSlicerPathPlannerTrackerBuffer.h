@@ -0,0 +1,112 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkSlicerPathPlannerTrackerBuffer - lock-free queue of tracker poses
+// .SECTION Description
+// Fixed size single-producer / single-consumer ring buffer of timestamped
+// 4x4 tracker poses. The producer (the transform observer, or a replay)
+// pushes every sample as it arrives and the consumer (the display, about
+// once per frame) pops them in batches, so that a burst of tracker data
+// only costs a copy per sample. Push() and Pop() never lock nor allocate;
+// a sample pushed while the buffer is full is dropped and counted.
+// One thread may push while another pops; SetCapacity() and Clear() must
+// not run concurrently with either.
+
+#ifndef __vtkSlicerPathPlannerTrackerBuffer_h
+#define __vtkSlicerPathPlannerTrackerBuffer_h
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <atomic>
+#include <vector>
+
+#include "vtkSlicerPathPlannerModuleLogicExport.h"
+
+/// \ingroup Slicer_QtModules_PathPlanner
+class VTK_SLICER_PATHPLANNER_MODULE_LOGIC_EXPORT vtkSlicerPathPlannerTrackerBuffer :
+  public vtkObject
+{
+public:
+
+  static vtkSlicerPathPlannerTrackerBuffer *New();
+  vtkTypeMacro(vtkSlicerPathPlannerTrackerBuffer, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  //BTX
+  /// Tracker pose: time in seconds (see GetTime()) and the 16 row-major
+  /// elements of the 4x4 matrix (e.g. vtkMatrix4x4::Element[0])
+  struct Sample
+    {
+    double Time;
+    double Matrix[16];
+    };
+  //ETX
+
+  /// Number of samples the buffer holds, rounded up to a power of two
+  /// minus one (255 by default, about half a second at 500 Hz). Setting it
+  /// clears the buffer.
+  void SetCapacity(int capacity);
+  int GetCapacity() const;
+
+  /// Producer: queue a sample. Return false if the buffer is full, in
+  /// which case the sample is dropped.
+  bool Push(double time, const double matrix[16]);
+
+  //BTX
+  /// Consumer: dequeue the oldest sample. Return false if there is none.
+  bool Pop(Sample& sample);
+  /// Consumer: dequeue every sample, the last one into sample, and return
+  /// their number (0 if there was none: sample is left as it is).
+  int PopLatest(Sample& sample);
+  //ETX
+
+  /// Number of samples queued. Exact only from the producer or consumer
+  /// thread while the other one is idle.
+  int GetNumberOfSamples() const;
+  /// Number of samples dropped because the buffer was full
+  vtkTypeUInt64 GetNumberOfDroppedSamples() const;
+
+  /// Drop the queued samples and reset the drop count
+  void Clear();
+
+  /// Seconds of a steady clock, for the time of the samples
+  static double GetTime();
+
+protected:
+  vtkSlicerPathPlannerTrackerBuffer();
+  virtual ~vtkSlicerPathPlannerTrackerBuffer();
+
+  //BTX
+  std::vector<Sample> Samples;
+  size_t Mask;
+  // Pop and push positions, a cache line apart so that the producer and
+  // the consumer do not invalidate each other's
+  std::atomic<size_t> Head;
+  char HeadPadding[64];
+  std::atomic<size_t> Tail;
+  char TailPadding[64];
+  std::atomic<vtkTypeUInt64> Dropped;
+  //ETX
+
+private:
+  vtkSlicerPathPlannerTrackerBuffer(const vtkSlicerPathPlannerTrackerBuffer&); // Not implemented
+  void operator=(const vtkSlicerPathPlannerTrackerBuffer&);                  // Not implemented
+};
+
+#endif
@@ -0,0 +1,117 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner Logic includes
+#include "vtkSlicerPathPlannerTrackerRecorder.h"
+#include "vtkSlicerPathPlannerTrackerRecording.h"
+
+// VTK includes
+#include <vtkObjectFactory.h>
+
+// STD includes
+#include <algorithm>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerPathPlannerTrackerRecorder);
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerTrackerRecorder::vtkSlicerPathPlannerTrackerRecorder()
+{
+  this->File = 0;
+  this->NumberOfSamples = 0;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerTrackerRecorder::~vtkSlicerPathPlannerTrackerRecorder()
+{
+  this->Close();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerTrackerRecorder::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "Open: " << this->IsOpen() << "\n";
+  os << indent << "NumberOfSamples: " << this->NumberOfSamples << "\n";
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerPathPlannerTrackerRecorder::Open(const char* fileName)
+{
+  this->Close();
+  this->NumberOfSamples = 0;
+  if (!fileName)
+    {
+    return false;
+    }
+  this->File = fopen(fileName, "wb");
+  if (!this->File)
+    {
+    vtkErrorMacro(<< "Open: cannot write " << fileName);
+    return false;
+    }
+  // About 600 samples, a second or two of tracking, per write
+  this->Buffer.resize(1 << 16);
+  setvbuf(this->File, &this->Buffer[0], _IOFBF, this->Buffer.size());
+
+  vtkSlicerPathPlannerTrackerRecording::Header header;
+  vtkSlicerPathPlannerTrackerRecording::InitializeHeader(header);
+  if (fwrite(&header, sizeof(header), 1, this->File) != 1)
+    {
+    vtkErrorMacro(<< "Open: cannot write " << fileName);
+    this->Close();
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerPathPlannerTrackerRecorder::IsOpen() const
+{
+  return this->File != 0;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerPathPlannerTrackerRecorder::Record(double time, const double matrix[16])
+{
+  if (!this->File)
+    {
+    return false;
+    }
+  double record[vtkSlicerPathPlannerTrackerRecording::RecordValues];
+  record[0] = time;
+  std::copy(matrix, matrix + 12, record + 1);
+  if (fwrite(record, sizeof(record), 1, this->File) != 1)
+    {
+    return false;
+    }
+  this->NumberOfSamples ++;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerTrackerRecorder::Close()
+{
+  if (this->File)
+    {
+    fclose(this->File);
+    this->File = 0;
+    }
+  // release the buffer once the stream no longer uses it
+  std::vector<char>().swap(this->Buffer);
+}
@@ -0,0 +1,81 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkSlicerPathPlannerTrackerRecorder - binary recording of tracker poses
+// .SECTION Description
+// Appends the tracker samples to a binary file: a 24 byte header (see
+// vtkSlicerPathPlannerTrackerRecording, which reads it back) followed by
+// one fixed size record per sample, its time and the 12 affine elements
+// of the pose as native doubles (104 bytes). Records go through a write
+// buffer allocated by Open(), so Record() does not allocate and only
+// reaches the disk every few hundred samples. A recording cut short (e.g.
+// by a crash) stays readable up to its last complete record.
+
+#ifndef __vtkSlicerPathPlannerTrackerRecorder_h
+#define __vtkSlicerPathPlannerTrackerRecorder_h
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <cstdio>
+#include <vector>
+
+#include "vtkSlicerPathPlannerModuleLogicExport.h"
+
+/// \ingroup Slicer_QtModules_PathPlanner
+class VTK_SLICER_PATHPLANNER_MODULE_LOGIC_EXPORT vtkSlicerPathPlannerTrackerRecorder :
+  public vtkObject
+{
+public:
+
+  static vtkSlicerPathPlannerTrackerRecorder *New();
+  vtkTypeMacro(vtkSlicerPathPlannerTrackerRecorder, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Create (overwrite) the recording and write its header. Return false
+  /// if the file cannot be written.
+  bool Open(const char* fileName);
+  bool IsOpen() const;
+
+  /// Append a sample: time in seconds and the 16 row-major elements of the
+  /// 4x4 pose. Return false if the recording is not open or the write
+  /// failed.
+  bool Record(double time, const double matrix[16]);
+
+  /// Write the buffered samples and close the file
+  void Close();
+
+  /// Number of samples recorded since Open()
+  vtkGetMacro(NumberOfSamples, vtkIdType);
+
+protected:
+  vtkSlicerPathPlannerTrackerRecorder();
+  virtual ~vtkSlicerPathPlannerTrackerRecorder();
+
+  FILE* File;
+  //BTX
+  std::vector<char> Buffer;
+  //ETX
+  vtkIdType NumberOfSamples;
+
+private:
+  vtkSlicerPathPlannerTrackerRecorder(const vtkSlicerPathPlannerTrackerRecorder&); // Not implemented
+  void operator=(const vtkSlicerPathPlannerTrackerRecorder&);                    // Not implemented
+};
+
+#endif
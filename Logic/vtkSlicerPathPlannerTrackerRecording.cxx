@@ -0,0 +1,273 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner Logic includes
+#include "vtkSlicerPathPlannerTrackerRecording.h"
+
+// VTK includes
+#include <vtkObjectFactory.h>
+
+// STD includes
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerPathPlannerTrackerRecording);
+
+//----------------------------------------------------------------------------
+namespace
+{
+const char Magic[8] = "PPTRACK";
+const vtkTypeUInt32 Version = 1;
+const vtkTypeUInt32 ByteOrderMark = 0x01020304;
+const size_t RecordSize =
+  vtkSlicerPathPlannerTrackerRecording::RecordValues * sizeof(double);
+}
+
+//----------------------------------------------------------------------------
+// Mapping of the file
+class vtkSlicerPathPlannerTrackerRecording::vtkInternal
+{
+public:
+  vtkInternal() : Data(0), Size(0)
+#ifdef _WIN32
+    , File(INVALID_HANDLE_VALUE), Mapping(0)
+#endif
+  {
+  }
+
+  bool Map(const char* fileName)
+  {
+#ifdef _WIN32
+    this->File = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, 0,
+                             OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    LARGE_INTEGER size;
+    if (this->File == INVALID_HANDLE_VALUE || !GetFileSizeEx(this->File, &size) ||
+        size.QuadPart == 0)
+      {
+      return false;
+      }
+    this->Mapping = CreateFileMappingA(this->File, 0, PAGE_READONLY, 0, 0, 0);
+    if (!this->Mapping)
+      {
+      return false;
+      }
+    this->Data = static_cast<const char*>(MapViewOfFile(this->Mapping, FILE_MAP_READ, 0, 0, 0));
+    this->Size = static_cast<size_t>(size.QuadPart);
+#else
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0)
+      {
+      return false;
+      }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || status.st_size == 0)
+      {
+      close(fd);
+      return false;
+      }
+    void* data = mmap(0, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping keeps the file open
+    close(fd);
+    if (data == MAP_FAILED)
+      {
+      return false;
+      }
+    // the samples are read in order
+    madvise(data, static_cast<size_t>(status.st_size), MADV_SEQUENTIAL);
+    this->Data = static_cast<const char*>(data);
+    this->Size = static_cast<size_t>(status.st_size);
+#endif
+    return this->Data != 0;
+  }
+
+  void Unmap()
+  {
+#ifdef _WIN32
+    if (this->Data)
+      {
+      UnmapViewOfFile(this->Data);
+      }
+    if (this->Mapping)
+      {
+      CloseHandle(this->Mapping);
+      }
+    if (this->File != INVALID_HANDLE_VALUE)
+      {
+      CloseHandle(this->File);
+      }
+    this->Mapping = 0;
+    this->File = INVALID_HANDLE_VALUE;
+#else
+    if (this->Data)
+      {
+      munmap(const_cast<char*>(this->Data), this->Size);
+      }
+#endif
+    this->Data = 0;
+    this->Size = 0;
+  }
+
+  const char* Data;
+  size_t Size;
+#ifdef _WIN32
+  HANDLE File;
+  HANDLE Mapping;
+#endif
+};
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerTrackerRecording::vtkSlicerPathPlannerTrackerRecording()
+{
+  this->Internal = new vtkInternal;
+  this->Records = 0;
+  this->NumberOfSamples = 0;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerTrackerRecording::~vtkSlicerPathPlannerTrackerRecording()
+{
+  this->Close();
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerTrackerRecording::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "NumberOfSamples: " << this->NumberOfSamples << "\n";
+  os << indent << "Duration: " << this->GetDuration() << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerTrackerRecording::InitializeHeader(Header& header)
+{
+  memset(&header, 0, sizeof(header));
+  memcpy(header.Magic, Magic, sizeof(header.Magic));
+  header.Version = Version;
+  header.RecordSize = static_cast<vtkTypeUInt32>(RecordSize);
+  header.ByteOrder = ByteOrderMark;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerPathPlannerTrackerRecording::Open(const char* fileName)
+{
+  this->Close();
+  if (!fileName || !this->Internal->Map(fileName))
+    {
+    vtkErrorMacro(<< "Open: cannot read " << (fileName ? fileName : "(null)"));
+    this->Close();
+    return false;
+    }
+
+  Header header;
+  if (this->Internal->Size < sizeof(header))
+    {
+    vtkErrorMacro(<< "Open: " << fileName << " is not a tracker recording");
+    this->Close();
+    return false;
+    }
+  memcpy(&header, this->Internal->Data, sizeof(header));
+  if (memcmp(header.Magic, Magic, sizeof(header.Magic)) != 0 ||
+      header.Version != Version || header.RecordSize != RecordSize)
+    {
+    vtkErrorMacro(<< "Open: " << fileName << " is not a tracker recording");
+    this->Close();
+    return false;
+    }
+  if (header.ByteOrder != ByteOrderMark)
+    {
+    vtkErrorMacro(<< "Open: " << fileName << " was recorded in another byte order");
+    this->Close();
+    return false;
+    }
+
+  // The header keeps the records aligned on doubles
+  this->Records = reinterpret_cast<const double*>(this->Internal->Data + sizeof(header));
+  this->NumberOfSamples =
+    static_cast<vtkIdType>((this->Internal->Size - sizeof(header)) / RecordSize);
+  this->Modified();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerPathPlannerTrackerRecording::IsOpen() const
+{
+  return this->Records != 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerTrackerRecording::Close()
+{
+  this->Internal->Unmap();
+  this->Records = 0;
+  this->NumberOfSamples = 0;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerTrackerRecording::GetNumberOfSamples() const
+{
+  return this->NumberOfSamples;
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerPathPlannerTrackerRecording::GetTime(vtkIdType index) const
+{
+  if (index < 0 || index >= this->NumberOfSamples)
+    {
+    return 0.0;
+    }
+  return this->Records[index * RecordValues];
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerTrackerRecording
+::GetSample(vtkIdType index, double* time, double matrix[16]) const
+{
+  if (index < 0 || index >= this->NumberOfSamples)
+    {
+    return;
+    }
+  const double* record = this->Records + index * RecordValues;
+  if (time)
+    {
+    *time = record[0];
+    }
+  std::copy(record + 1, record + RecordValues, matrix);
+  matrix[12] = matrix[13] = matrix[14] = 0.0;
+  matrix[15] = 1.0;
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerPathPlannerTrackerRecording::GetDuration() const
+{
+  if (this->NumberOfSamples == 0)
+    {
+    return 0.0;
+    }
+  return this->GetTime(this->NumberOfSamples - 1) - this->GetTime(0);
+}
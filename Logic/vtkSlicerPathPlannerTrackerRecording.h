@@ -0,0 +1,100 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkSlicerPathPlannerTrackerRecording - memory-mapped tracker recording
+// .SECTION Description
+// Read-only view of a recording written by
+// vtkSlicerPathPlannerTrackerRecorder. The file is memory-mapped, so
+// opening it costs nothing whatever its length and the samples are read
+// straight from the page cache. The layout, in the byte order of the
+// machine that recorded it:
+//   header:  char[8] "PPTRACK", uint32 version (1), uint32 record size
+//            (104), uint32 byte order mark (0x01020304), uint32 reserved
+//   records: double time, double[12] first three rows of the 4x4 pose
+// The number of samples is given by the file size; a trailing partial
+// record is ignored.
+
+#ifndef __vtkSlicerPathPlannerTrackerRecording_h
+#define __vtkSlicerPathPlannerTrackerRecording_h
+
+// VTK includes
+#include <vtkObject.h>
+
+#include "vtkSlicerPathPlannerModuleLogicExport.h"
+
+/// \ingroup Slicer_QtModules_PathPlanner
+class VTK_SLICER_PATHPLANNER_MODULE_LOGIC_EXPORT vtkSlicerPathPlannerTrackerRecording :
+  public vtkObject
+{
+public:
+
+  static vtkSlicerPathPlannerTrackerRecording *New();
+  vtkTypeMacro(vtkSlicerPathPlannerTrackerRecording, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Map a recording. Return false if the file cannot be read or is not a
+  /// recording of this machine's byte order.
+  bool Open(const char* fileName);
+  bool IsOpen() const;
+  void Close();
+
+  vtkIdType GetNumberOfSamples() const;
+
+  /// Time in seconds of the sample at index
+  double GetTime(vtkIdType index) const;
+  /// Time and 16 row-major elements of the 4x4 pose of the sample at index
+  void GetSample(vtkIdType index, double* time, double matrix[16]) const;
+
+  /// Time between the first and the last sample, in seconds
+  double GetDuration() const;
+
+  //BTX
+  /// Layout of the file, shared with vtkSlicerPathPlannerTrackerRecorder
+  struct Header
+    {
+    char Magic[8];
+    vtkTypeUInt32 Version;
+    vtkTypeUInt32 RecordSize;
+    vtkTypeUInt32 ByteOrder;
+    vtkTypeUInt32 Reserved;
+    };
+  enum
+    {
+    RecordValues = 13
+    };
+  static void InitializeHeader(Header& header);
+  //ETX
+
+protected:
+  vtkSlicerPathPlannerTrackerRecording();
+  virtual ~vtkSlicerPathPlannerTrackerRecording();
+
+  //BTX
+  class vtkInternal;
+  vtkInternal* Internal;
+  //ETX
+
+  // Records in the mapped file and their number
+  const double* Records;
+  vtkIdType NumberOfSamples;
+
+private:
+  vtkSlicerPathPlannerTrackerRecording(const vtkSlicerPathPlannerTrackerRecording&); // Not implemented
+  void operator=(const vtkSlicerPathPlannerTrackerRecording&);                     // Not implemented
+};
+
+#endif
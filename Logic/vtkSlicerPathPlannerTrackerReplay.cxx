@@ -0,0 +1,175 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner Logic includes
+#include "vtkSlicerPathPlannerTrackerBuffer.h"
+#include "vtkSlicerPathPlannerTrackerRecording.h"
+#include "vtkSlicerPathPlannerTrackerReplay.h"
+
+// VTK includes
+#include <vtkObjectFactory.h>
+
+// STD includes
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerPathPlannerTrackerReplay);
+vtkCxxSetObjectMacro(vtkSlicerPathPlannerTrackerReplay, Recording,
+                     vtkSlicerPathPlannerTrackerRecording);
+vtkCxxSetObjectMacro(vtkSlicerPathPlannerTrackerReplay, Buffer,
+                     vtkSlicerPathPlannerTrackerBuffer);
+
+//----------------------------------------------------------------------------
+class vtkSlicerPathPlannerTrackerReplay::vtkInternal
+{
+public:
+  vtkInternal() : Running(false), StopRequested(false), Replayed(0) {}
+
+  std::thread Thread;
+  std::atomic<bool> Running;
+  std::atomic<bool> StopRequested;
+  std::atomic<vtkIdType> Replayed;
+};
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerTrackerReplay::vtkSlicerPathPlannerTrackerReplay()
+{
+  this->Recording = 0;
+  this->Buffer = 0;
+  this->Speed = 1.0;
+  this->RebaseTime = true;
+  this->StartTime = 0.0;
+  this->Internal = new vtkInternal;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerTrackerReplay::~vtkSlicerPathPlannerTrackerReplay()
+{
+  this->Stop();
+  delete this->Internal;
+  this->SetRecording(0);
+  this->SetBuffer(0);
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerTrackerReplay::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "Recording: " << this->Recording << "\n";
+  os << indent << "Buffer: " << this->Buffer << "\n";
+  os << indent << "Speed: " << this->Speed << "\n";
+  os << indent << "RebaseTime: " << this->RebaseTime << "\n";
+  os << indent << "Running: " << this->IsRunning() << "\n";
+  os << indent << "NumberOfReplayedSamples: " << this->GetNumberOfReplayedSamples() << "\n";
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerPathPlannerTrackerReplay::Start()
+{
+  if (!this->Recording || !this->Recording->IsOpen() || !this->Buffer || this->IsRunning())
+    {
+    return false;
+    }
+  // join the thread of the previous replay
+  this->Stop();
+  this->Internal->StopRequested = false;
+  this->Internal->Replayed = 0;
+  this->Internal->Running = true;
+  this->StartTime = vtkSlicerPathPlannerTrackerBuffer::GetTime();
+  this->Internal->Thread = std::thread(&vtkSlicerPathPlannerTrackerReplay::Run, this);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerTrackerReplay::Stop()
+{
+  this->Internal->StopRequested = true;
+  this->Wait();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerTrackerReplay::Wait()
+{
+  if (this->Internal->Thread.joinable())
+    {
+    this->Internal->Thread.join();
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerPathPlannerTrackerReplay::IsRunning() const
+{
+  return this->Internal->Running;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerTrackerReplay::GetNumberOfReplayedSamples() const
+{
+  return this->Internal->Replayed;
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerPathPlannerTrackerReplay::GetScheduledTime(vtkIdType index) const
+{
+  if (!this->Recording || this->Speed <= 0.0)
+    {
+    return this->StartTime;
+    }
+  return this->StartTime +
+    (this->Recording->GetTime(index) - this->Recording->GetTime(0)) / this->Speed;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerTrackerReplay::Run()
+{
+  vtkIdType nSamples = this->Recording->GetNumberOfSamples();
+  double firstTime = this->Recording->GetTime(0);
+  double matrix[16];
+  for (vtkIdType i = 0; i < nSamples && !this->Internal->StopRequested; i ++)
+    {
+    double time;
+    this->Recording->GetSample(i, &time, matrix);
+    if (this->Speed > 0.0)
+      {
+      double wait = this->GetScheduledTime(i) - vtkSlicerPathPlannerTrackerBuffer::GetTime();
+      if (wait > 0.0)
+        {
+        std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+        }
+      }
+    if (this->RebaseTime)
+      {
+      time = this->StartTime + (time - firstTime);
+      }
+    // wait for the consumer rather than dropping the sample
+    while (this->Buffer->GetNumberOfSamples() >= this->Buffer->GetCapacity() &&
+           !this->Internal->StopRequested)
+      {
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+    if (this->Internal->StopRequested)
+      {
+      break;
+      }
+    this->Buffer->Push(time, matrix);
+    this->Internal->Replayed ++;
+    }
+  this->Internal->Running = false;
+}
@@ -0,0 +1,110 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkSlicerPathPlannerTrackerReplay - replay of a tracker recording
+// .SECTION Description
+// Pushes the samples of a vtkSlicerPathPlannerTrackerRecording into a
+// vtkSlicerPathPlannerTrackerBuffer from its own thread, the producer of
+// the buffer in place of the tracker observer, so that the recording
+// drives the same pose filter and deviation pipeline as live tracking.
+// Samples are pushed on the schedule of the recording divided by Speed
+// (1 for real time), or as fast as possible when Speed is 0. The replay
+// waits for room in the buffer rather than dropping samples, so every
+// sample reaches the consumer in order.
+
+#ifndef __vtkSlicerPathPlannerTrackerReplay_h
+#define __vtkSlicerPathPlannerTrackerReplay_h
+
+// VTK includes
+#include <vtkObject.h>
+
+#include "vtkSlicerPathPlannerModuleLogicExport.h"
+
+class vtkSlicerPathPlannerTrackerBuffer;
+class vtkSlicerPathPlannerTrackerRecording;
+
+/// \ingroup Slicer_QtModules_PathPlanner
+class VTK_SLICER_PATHPLANNER_MODULE_LOGIC_EXPORT vtkSlicerPathPlannerTrackerReplay :
+  public vtkObject
+{
+public:
+
+  static vtkSlicerPathPlannerTrackerReplay *New();
+  vtkTypeMacro(vtkSlicerPathPlannerTrackerReplay, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Recording replayed and buffer it is pushed into. They must not be
+  /// changed while the replay runs.
+  virtual void SetRecording(vtkSlicerPathPlannerTrackerRecording* recording);
+  vtkGetObjectMacro(Recording, vtkSlicerPathPlannerTrackerRecording);
+  virtual void SetBuffer(vtkSlicerPathPlannerTrackerBuffer* buffer);
+  vtkGetObjectMacro(Buffer, vtkSlicerPathPlannerTrackerBuffer);
+
+  /// Replay speed: 1 (default) for real time, 4 for four times faster,
+  /// 0 for as fast as possible
+  vtkSetClampMacro(Speed, double, 0.0, VTK_DOUBLE_MAX);
+  vtkGetMacro(Speed, double);
+
+  /// Shift the time of the samples so that the first one is the time the
+  /// replay starts (see vtkSlicerPathPlannerTrackerBuffer::GetTime()), as
+  /// live samples would be (default). Off, the recorded times are pushed
+  /// as they are, which makes the replay bitwise repeatable. The spacing
+  /// of the samples is kept at any speed.
+  vtkSetMacro(RebaseTime, bool);
+  vtkGetMacro(RebaseTime, bool);
+  vtkBooleanMacro(RebaseTime, bool);
+
+  /// Start the replay thread. Return false if there is no recording or no
+  /// buffer, or if a replay is already running.
+  bool Start();
+  /// Stop the replay and wait for its thread
+  void Stop();
+  /// Wait for the replay to push its last sample
+  void Wait();
+  bool IsRunning() const;
+
+  /// Number of samples pushed since Start()
+  vtkIdType GetNumberOfReplayedSamples() const;
+
+  /// Time (see vtkSlicerPathPlannerTrackerBuffer::GetTime()) at which the
+  /// sample at index is due, e.g. to measure the latency of its display.
+  /// Only meaningful when Speed is not 0.
+  double GetScheduledTime(vtkIdType index) const;
+
+protected:
+  vtkSlicerPathPlannerTrackerReplay();
+  virtual ~vtkSlicerPathPlannerTrackerReplay();
+
+  void Run();
+
+  vtkSlicerPathPlannerTrackerRecording* Recording;
+  vtkSlicerPathPlannerTrackerBuffer* Buffer;
+  double Speed;
+  bool RebaseTime;
+  double StartTime;
+
+  //BTX
+  class vtkInternal;
+  vtkInternal* Internal;
+  //ETX
+
+private:
+  vtkSlicerPathPlannerTrackerReplay(const vtkSlicerPathPlannerTrackerReplay&); // Not implemented
+  void operator=(const vtkSlicerPathPlannerTrackerReplay&);                  // Not implemented
+};
+
+#endif
@@ -0,0 +1,132 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner Logic includes
+#include "vtkSlicerPathPlannerTrajectoryKernel.h"
+
+// STD includes
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PATHPLANNER_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+//----------------------------------------------------------------------------
+namespace
+{
+
+//----------------------------------------------------------------------------
+inline void EvaluateOne(double er, double ea, double es, const double target[3],
+                        const double reference[3], double maximumLength,
+                        double minimumCosine, double* length,
+                        double* dirR, double* dirA, double* dirS,
+                        unsigned char* feasible)
+{
+  double dx = target[0] - er;
+  double dy = target[1] - ea;
+  double dz = target[2] - es;
+  double l = sqrt(dx*dx + dy*dy + dz*dz);
+  double inverse = (l > 0.0) ? 1.0 / l : 0.0;
+  dx *= inverse;
+  dy *= inverse;
+  dz *= inverse;
+  double cosine = dx*reference[0] + dy*reference[1] + dz*reference[2];
+
+  *length = l;
+  if (dirR)
+    {
+    *dirR = dx;
+    *dirA = dy;
+    *dirS = dz;
+    }
+  *feasible = vtkSlicerPathPlannerTrajectoryKernel::IsFeasible(
+    l, cosine, maximumLength, minimumCosine) ? 1 : 0;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerTrajectoryKernel
+::EvaluateTarget(const double* entryR, const double* entryA,
+                 const double* entryS, vtkIdType numberOfEntryPoints,
+                 const double targetPoint[3], const double reference[3],
+                 double maximumLength, double minimumCosine,
+                 double* lengths, double* directionR,
+                 double* directionA, double* directionS,
+                 unsigned char* feasible)
+{
+  bool withDirections = (directionR && directionA && directionS);
+  vtkIdType i = 0;
+
+#ifdef PATHPLANNER_USE_SSE2
+  const __m128d tr = _mm_set1_pd(targetPoint[0]);
+  const __m128d ta = _mm_set1_pd(targetPoint[1]);
+  const __m128d ts = _mm_set1_pd(targetPoint[2]);
+  const __m128d rr = _mm_set1_pd(reference[0]);
+  const __m128d ra = _mm_set1_pd(reference[1]);
+  const __m128d rs = _mm_set1_pd(reference[2]);
+  const __m128d zero = _mm_setzero_pd();
+  const __m128d one = _mm_set1_pd(1.0);
+  const __m128d maxLength = _mm_set1_pd(maximumLength);
+  const __m128d minCosine = _mm_set1_pd(minimumCosine);
+
+  for (; i + 2 <= numberOfEntryPoints; i += 2)
+    {
+    __m128d dx = _mm_sub_pd(tr, _mm_loadu_pd(entryR + i));
+    __m128d dy = _mm_sub_pd(ta, _mm_loadu_pd(entryA + i));
+    __m128d dz = _mm_sub_pd(ts, _mm_loadu_pd(entryS + i));
+    __m128d l2 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)),
+                            _mm_mul_pd(dz, dz));
+    __m128d l = _mm_sqrt_pd(l2);
+
+    // 1/l where l > 0, 0 elsewhere (the division by zero is masked out)
+    __m128d positive = _mm_cmpgt_pd(l, zero);
+    __m128d inverse = _mm_and_pd(positive, _mm_div_pd(one, l));
+    dx = _mm_mul_pd(dx, inverse);
+    dy = _mm_mul_pd(dy, inverse);
+    dz = _mm_mul_pd(dz, inverse);
+    __m128d cosine = _mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, rr), _mm_mul_pd(dy, ra)),
+                                _mm_mul_pd(dz, rs));
+
+    // IsFeasible(), two trajectories at a time
+    __m128d ok = _mm_and_pd(positive, _mm_cmple_pd(l, maxLength));
+    ok = _mm_and_pd(ok, _mm_cmpge_pd(cosine, minCosine));
+    int mask = _mm_movemask_pd(ok);
+
+    _mm_storeu_pd(lengths + i, l);
+    if (withDirections)
+      {
+      _mm_storeu_pd(directionR + i, dx);
+      _mm_storeu_pd(directionA + i, dy);
+      _mm_storeu_pd(directionS + i, dz);
+      }
+    feasible[i]   = (unsigned char)(mask & 1);
+    feasible[i+1] = (unsigned char)((mask >> 1) & 1);
+    }
+#endif
+
+  for (; i < numberOfEntryPoints; i ++)
+    {
+    EvaluateOne(entryR[i], entryA[i], entryS[i], targetPoint, reference,
+                maximumLength, minimumCosine, lengths + i,
+                withDirections ? directionR + i : 0,
+                withDirections ? directionA + i : 0,
+                withDirections ? directionS + i : 0,
+                feasible + i);
+    }
+}
@@ -0,0 +1,64 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkSlicerPathPlannerTrajectoryKernel - vectorized trajectory evaluation
+// .SECTION Description
+// Evaluates the trajectories from a set of entry points to one target point.
+// The entry points are given as structure of arrays (separate R, A and S
+// arrays) so that two entry points are processed per SSE2 instruction. The
+// per-trajectory definition is the one of
+// vtkSlicerPathPlannerLogic::ComputeTrajectories(), and the scalar tail
+// gives bitwise identical results.
+
+#ifndef __vtkSlicerPathPlannerTrajectoryKernel_h
+#define __vtkSlicerPathPlannerTrajectoryKernel_h
+
+// VTK includes
+#include <vtkType.h>
+
+#include "vtkSlicerPathPlannerModuleLogicExport.h"
+
+/// \ingroup Slicer_QtModules_PathPlanner
+class VTK_SLICER_PATHPLANNER_MODULE_LOGIC_EXPORT vtkSlicerPathPlannerTrajectoryKernel
+{
+public:
+  /// Evaluate the trajectories from every entry point to targetPoint.
+  /// reference must be a unit vector. A trajectory is feasible when its
+  /// length is in (0, maximumLength] and the cosine of its insertion angle
+  /// against reference is at least minimumCosine.
+  /// lengths and feasible receive numberOfEntryPoints values. The direction
+  /// outputs are optional (NULL to skip them).
+  static void EvaluateTarget(const double* entryR, const double* entryA,
+                             const double* entryS, vtkIdType numberOfEntryPoints,
+                             const double targetPoint[3], const double reference[3],
+                             double maximumLength, double minimumCosine,
+                             double* lengths, double* directionR,
+                             double* directionA, double* directionS,
+                             unsigned char* feasible);
+
+  /// Feasibility test applied by EvaluateTarget(), shared by every planner
+  /// of vtkSlicerPathPlannerLogic: the length of the trajectory is in
+  /// (0, maximumLength] and the cosine of its insertion angle is at least
+  /// minimumCosine.
+  static bool IsFeasible(double length, double cosine,
+                         double maximumLength, double minimumCosine)
+    {
+    return length > 0.0 && length <= maximumLength && cosine >= minimumCosine;
+    }
+};
+
+#endif
@@ -0,0 +1,707 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner Logic includes
+#include "vtkSlicerPathPlannerTriangleTree.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkObjectFactory.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerPathPlannerTriangleTree);
+vtkCxxSetObjectMacro(vtkSlicerPathPlannerTriangleTree, Surface, vtkPolyData);
+
+//----------------------------------------------------------------------------
+namespace
+{
+// Largest number of triangles of a leaf
+const int LeafSize = 4;
+// Deepest tree: the median split halves the triangles at each level
+const int StackSize = 128;
+
+//----------------------------------------------------------------------------
+inline double Dot(const double a[3], const double b[3])
+{
+  return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+//----------------------------------------------------------------------------
+inline void Cross(const double a[3], const double b[3], double c[3])
+{
+  c[0] = a[1] * b[2] - a[2] * b[1];
+  c[1] = a[2] * b[0] - a[0] * b[2];
+  c[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+//----------------------------------------------------------------------------
+inline void Subtract(const double a[3], const double b[3], double c[3])
+{
+  c[0] = a[0] - b[0];
+  c[1] = a[1] - b[1];
+  c[2] = a[2] - b[2];
+}
+
+//----------------------------------------------------------------------------
+inline double Distance2(const double a[3], const double b[3])
+{
+  double d[3];
+  Subtract(a, b, d);
+  return Dot(d, d);
+}
+
+//----------------------------------------------------------------------------
+inline double Clamp(double x, double lower, double upper)
+{
+  return std::min(std::max(x, lower), upper);
+}
+
+//----------------------------------------------------------------------------
+// Order triangles by the coordinate of their centroid along an axis
+struct CentroidLess
+{
+  const double* Centroids;
+  int Axis;
+  bool operator()(vtkIdType a, vtkIdType b) const
+  {
+    return this->Centroids[3 * a + this->Axis] < this->Centroids[3 * b + this->Axis];
+  }
+};
+
+//----------------------------------------------------------------------------
+// Clip the segment start + t * direction, t in [0, tMax], to a box.
+// Return false if it misses the box, otherwise tEnter receives the first t
+// inside of it.
+bool ClipSegment(const double bounds[6], const double start[3], const double direction[3],
+                 double tMax, double* tEnter)
+{
+  double t0 = 0.0;
+  double t1 = tMax;
+  for (int axis = 0; axis < 3; axis ++)
+    {
+    if (direction[axis] == 0.0)
+      {
+      if (start[axis] < bounds[2*axis] || start[axis] > bounds[2*axis+1])
+        {
+        return false;
+        }
+      continue;
+      }
+    double inverse = 1.0 / direction[axis];
+    double ta = (bounds[2*axis] - start[axis]) * inverse;
+    double tb = (bounds[2*axis+1] - start[axis]) * inverse;
+    if (ta > tb)
+      {
+      std::swap(ta, tb);
+      }
+    t0 = std::max(t0, ta);
+    t1 = std::min(t1, tb);
+    if (t0 > t1)
+      {
+      return false;
+      }
+    }
+  *tEnter = t0;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Squared distance between the segment start + t * direction, t in [0, 1],
+// and a box. Along each axis the point is below, inside or above the slab
+// of the box, which splits [0, 1] in at most 7 intervals where the squared
+// distance is a quadratic in t, minimized in closed form.
+double SegmentBoxDistance2(const double bounds[6], const double start[3],
+                           const double direction[3])
+{
+  double breaks[8];
+  int nBreaks = 0;
+  breaks[nBreaks++] = 0.0;
+  breaks[nBreaks++] = 1.0;
+  for (int axis = 0; axis < 3; axis ++)
+    {
+    if (direction[axis] == 0.0)
+      {
+      continue;
+      }
+    for (int side = 0; side < 2; side ++)
+      {
+      double t = (bounds[2*axis+side] - start[axis]) / direction[axis];
+      if (t > 0.0 && t < 1.0)
+        {
+        breaks[nBreaks++] = t;
+        }
+      }
+    }
+  std::sort(breaks, breaks + nBreaks);
+
+  double best = VTK_DOUBLE_MAX;
+  for (int i = 0; i + 1 < nBreaks; i ++)
+    {
+    double t0 = breaks[i];
+    double t1 = breaks[i+1];
+    double middle = 0.5 * (t0 + t1);
+    // squared distance a t^2 + b t + c on [t0, t1]
+    double a = 0.0;
+    double b = 0.0;
+    double c = 0.0;
+    for (int axis = 0; axis < 3; axis ++)
+      {
+      double p = start[axis] + middle * direction[axis];
+      double offset;
+      if (p < bounds[2*axis])
+        {
+        offset = start[axis] - bounds[2*axis];
+        }
+      else if (p > bounds[2*axis+1])
+        {
+        offset = start[axis] - bounds[2*axis+1];
+        }
+      else
+        {
+        continue;
+        }
+      a += direction[axis] * direction[axis];
+      b += 2.0 * direction[axis] * offset;
+      c += offset * offset;
+      }
+    double t = (a > 0.0) ? Clamp(-b / (2.0 * a), t0, t1) : t0;
+    best = std::min(best, (a * t + b) * t + c);
+    }
+  return std::max(best, 0.0);
+}
+
+//----------------------------------------------------------------------------
+// Moller-Trumbore: intersection of start + t * direction, t in [0, tMax],
+// with the triangle (a, b, c)
+bool IntersectTriangle(const double start[3], const double direction[3], double tMax,
+                       const double a[3], const double b[3], const double c[3], double* t)
+{
+  double e1[3];
+  double e2[3];
+  Subtract(b, a, e1);
+  Subtract(c, a, e2);
+  double p[3];
+  Cross(direction, e2, p);
+  double det = Dot(e1, p);
+  if (det == 0.0)
+    {
+    // parallel to the triangle
+    return false;
+    }
+  double inverse = 1.0 / det;
+  double s[3];
+  Subtract(start, a, s);
+  double u = Dot(s, p) * inverse;
+  if (u < 0.0 || u > 1.0)
+    {
+    return false;
+    }
+  double q[3];
+  Cross(s, e1, q);
+  double v = Dot(direction, q) * inverse;
+  if (v < 0.0 || u + v > 1.0)
+    {
+    return false;
+    }
+  double tHit = Dot(e2, q) * inverse;
+  if (tHit < 0.0 || tHit > tMax)
+    {
+    return false;
+    }
+  *t = tHit;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Squared distance from p to the triangle (a, b, c) (Ericson, Real-Time
+// Collision Detection, 5.1.5)
+double PointTriangleDistance2(const double p[3],
+                              const double a[3], const double b[3], const double c[3])
+{
+  double ab[3], ac[3], ap[3];
+  Subtract(b, a, ab);
+  Subtract(c, a, ac);
+  Subtract(p, a, ap);
+  double d1 = Dot(ab, ap);
+  double d2 = Dot(ac, ap);
+  if (d1 <= 0.0 && d2 <= 0.0)
+    {
+    return Dot(ap, ap);
+    }
+  double bp[3];
+  Subtract(p, b, bp);
+  double d3 = Dot(ab, bp);
+  double d4 = Dot(ac, bp);
+  if (d3 >= 0.0 && d4 <= d3)
+    {
+    return Dot(bp, bp);
+    }
+  double vc = d1 * d4 - d3 * d2;
+  if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0)
+    {
+    double v = d1 / (d1 - d3);
+    double closest[3] = { a[0] + v * ab[0], a[1] + v * ab[1], a[2] + v * ab[2] };
+    return Distance2(p, closest);
+    }
+  double cp[3];
+  Subtract(p, c, cp);
+  double d5 = Dot(ab, cp);
+  double d6 = Dot(ac, cp);
+  if (d6 >= 0.0 && d5 <= d6)
+    {
+    return Dot(cp, cp);
+    }
+  double vb = d5 * d2 - d1 * d6;
+  if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0)
+    {
+    double w = d2 / (d2 - d6);
+    double closest[3] = { a[0] + w * ac[0], a[1] + w * ac[1], a[2] + w * ac[2] };
+    return Distance2(p, closest);
+    }
+  double va = d3 * d6 - d5 * d4;
+  if (va <= 0.0 && (d4 - d3) >= 0.0 && (d5 - d6) >= 0.0)
+    {
+    double w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+    double closest[3] = { b[0] + w * (c[0] - b[0]),
+                          b[1] + w * (c[1] - b[1]),
+                          b[2] + w * (c[2] - b[2]) };
+    return Distance2(p, closest);
+    }
+  double denominator = 1.0 / (va + vb + vc);
+  double v = vb * denominator;
+  double w = vc * denominator;
+  double closest[3] = { a[0] + ab[0] * v + ac[0] * w,
+                        a[1] + ab[1] * v + ac[1] * w,
+                        a[2] + ab[2] * v + ac[2] * w };
+  return Distance2(p, closest);
+}
+
+//----------------------------------------------------------------------------
+// Squared distance between the segments p1 + s * d1 and q1 + t * d2, s and
+// t in [0, 1]; s receives the parameter of the closest point on the first
+// one (Ericson, Real-Time Collision Detection, 5.1.9)
+double SegmentSegmentDistance2(const double p1[3], const double d1[3],
+                               const double q1[3], const double q2[3], double* s)
+{
+  double d2[3];
+  Subtract(q2, q1, d2);
+  double r[3];
+  Subtract(p1, q1, r);
+  double a = Dot(d1, d1);
+  double e = Dot(d2, d2);
+  double f = Dot(d2, r);
+  double sc = 0.0;
+  double tc = 0.0;
+  if (a <= 0.0 && e <= 0.0)
+    {
+    // both segments are points
+    }
+  else if (a <= 0.0)
+    {
+    tc = Clamp(f / e, 0.0, 1.0);
+    }
+  else
+    {
+    double c = Dot(d1, r);
+    if (e <= 0.0)
+      {
+      sc = Clamp(-c / a, 0.0, 1.0);
+      }
+    else
+      {
+      double b = Dot(d1, d2);
+      double denominator = a * e - b * b;
+      sc = (denominator != 0.0) ? Clamp((b * f - c * e) / denominator, 0.0, 1.0) : 0.0;
+      tc = (b * sc + f) / e;
+      if (tc < 0.0)
+        {
+        tc = 0.0;
+        sc = Clamp(-c / a, 0.0, 1.0);
+        }
+      else if (tc > 1.0)
+        {
+        tc = 1.0;
+        sc = Clamp((b - c) / a, 0.0, 1.0);
+        }
+      }
+    }
+  *s = sc;
+  double closest1[3] = { p1[0] + sc * d1[0], p1[1] + sc * d1[1], p1[2] + sc * d1[2] };
+  double closest2[3] = { q1[0] + tc * d2[0], q1[1] + tc * d2[1], q1[2] + tc * d2[2] };
+  return Distance2(closest1, closest2);
+}
+
+//----------------------------------------------------------------------------
+// Squared distance between a segment and a triangle it does not cross: the
+// closest points are a segment end point and the triangle, or the segment
+// and a triangle edge.
+double SegmentTriangleDistance2(const double start[3], const double end[3],
+                                const double direction[3], const double* triangle,
+                                double* fraction)
+{
+  const double* a = triangle;
+  const double* b = triangle + 3;
+  const double* c = triangle + 6;
+  double best = PointTriangleDistance2(start, a, b, c);
+  *fraction = 0.0;
+  double d = PointTriangleDistance2(end, a, b, c);
+  if (d < best)
+    {
+    best = d;
+    *fraction = 1.0;
+    }
+  const double* edges[3][2] = { { a, b }, { b, c }, { c, a } };
+  for (int edge = 0; edge < 3; edge ++)
+    {
+    double s;
+    d = SegmentSegmentDistance2(start, direction, edges[edge][0], edges[edge][1], &s);
+    if (d < best)
+      {
+      best = d;
+      *fraction = s;
+      }
+    }
+  return best;
+}
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerTriangleTree::vtkSlicerPathPlannerTriangleTree()
+{
+  this->Surface = 0;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerPathPlannerTriangleTree::~vtkSlicerPathPlannerTriangleTree()
+{
+  this->SetSurface(0);
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerTriangleTree::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "Surface: " << this->Surface << "\n";
+  os << indent << "NumberOfTriangles: " << this->GetNumberOfTriangles() << "\n";
+  os << indent << "NumberOfNodes: " << this->Nodes.size() << "\n";
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerTriangleTree::GetNumberOfTriangles() const
+{
+  return static_cast<vtkIdType>(this->CellIds.size());
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerTriangleTree::Update()
+{
+  if (this->NeedsUpdate())
+    {
+    this->Build();
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerPathPlannerTriangleTree::NeedsUpdate()
+{
+  return this->BuildTime.GetMTime() < this->GetMTime() ||
+    (this->Surface && this->BuildTime.GetMTime() < this->Surface->GetMTime());
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerPathPlannerTriangleTree::Build()
+{
+  this->Nodes.clear();
+  this->Triangles.clear();
+  this->CellIds.clear();
+  this->BuildTime.Modified();
+  vtkPoints* points = this->Surface ? this->Surface->GetPoints() : 0;
+  if (!points)
+    {
+    return;
+    }
+
+  // Triangles of the polygons (fans) and of the strips, with their cell
+  // IDs: the polygons follow the vertices and lines in the cell order
+  vtkIdType cellId = this->Surface->GetNumberOfVerts() + this->Surface->GetNumberOfLines();
+  vtkCellArray* cellArrays[2] = { this->Surface->GetPolys(), this->Surface->GetStrips() };
+  for (int strips = 0; strips < 2; strips ++)
+    {
+    vtkCellArray* cells = cellArrays[strips];
+    if (!cells)
+      {
+      continue;
+      }
+    vtkIdType npts = 0;
+    vtkIdType* pts = 0;
+    for (cells->InitTraversal(); cells->GetNextCell(npts, pts); cellId ++)
+      {
+      for (vtkIdType k = 0; k + 2 < npts; k ++)
+        {
+        vtkIdType ids[3] = { strips ? pts[k] : pts[0], pts[k+1], pts[k+2] };
+        for (int vertex = 0; vertex < 3; vertex ++)
+          {
+          double p[3];
+          points->GetPoint(ids[vertex], p);
+          this->Triangles.insert(this->Triangles.end(), p, p + 3);
+          }
+        this->CellIds.push_back(cellId);
+        }
+      }
+    }
+
+  vtkIdType nTriangles = static_cast<vtkIdType>(this->CellIds.size());
+  if (nTriangles == 0)
+    {
+    return;
+    }
+  this->Order.resize(nTriangles);
+  this->Centroids.resize(3 * nTriangles);
+  for (vtkIdType i = 0; i < nTriangles; i ++)
+    {
+    this->Order[i] = i;
+    const double* t = &this->Triangles[9 * i];
+    for (int axis = 0; axis < 3; axis ++)
+      {
+      this->Centroids[3 * i + axis] = (t[axis] + t[3 + axis] + t[6 + axis]) / 3.0;
+      }
+    }
+  this->Nodes.reserve(2 * nTriangles / LeafSize + 1);
+  this->BuildNode(0, nTriangles, 0);
+
+  // Store the triangles in the order of the leaves
+  std::vector<double> triangles(9 * nTriangles);
+  std::vector<vtkIdType> cellIds(nTriangles);
+  for (vtkIdType i = 0; i < nTriangles; i ++)
+    {
+    vtkIdType source = this->Order[i];
+    std::copy(&this->Triangles[9 * source], &this->Triangles[9 * source] + 9, &triangles[9 * i]);
+    cellIds[i] = this->CellIds[source];
+    }
+  this->Triangles.swap(triangles);
+  this->CellIds.swap(cellIds);
+  std::vector<vtkIdType>().swap(this->Order);
+  std::vector<double>().swap(this->Centroids);
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkSlicerPathPlannerTriangleTree::BuildNode(vtkIdType first, vtkIdType count, int depth)
+{
+  vtkIdType index = static_cast<vtkIdType>(this->Nodes.size());
+  this->Nodes.push_back(Node());
+
+  double bounds[6] = { VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX, VTK_DOUBLE_MAX,
+                       -VTK_DOUBLE_MAX, VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX };
+  double centroidBounds[6] = { VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX, VTK_DOUBLE_MAX,
+                               -VTK_DOUBLE_MAX, VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX };
+  for (vtkIdType i = first; i < first + count; i ++)
+    {
+    const double* t = &this->Triangles[9 * this->Order[i]];
+    const double* centroid = &this->Centroids[3 * this->Order[i]];
+    for (int axis = 0; axis < 3; axis ++)
+      {
+      for (int vertex = 0; vertex < 3; vertex ++)
+        {
+        bounds[2*axis] = std::min(bounds[2*axis], t[3 * vertex + axis]);
+        bounds[2*axis+1] = std::max(bounds[2*axis+1], t[3 * vertex + axis]);
+        }
+      centroidBounds[2*axis] = std::min(centroidBounds[2*axis], centroid[axis]);
+      centroidBounds[2*axis+1] = std::max(centroidBounds[2*axis+1], centroid[axis]);
+      }
+    }
+  std::copy(bounds, bounds + 6, this->Nodes[index].Bounds);
+
+  int axis = 0;
+  for (int i = 1; i < 3; i ++)
+    {
+    if (centroidBounds[2*i+1] - centroidBounds[2*i] >
+        centroidBounds[2*axis+1] - centroidBounds[2*axis])
+      {
+      axis = i;
+      }
+    }
+  if (count <= LeafSize || depth >= StackSize - 2 ||
+      centroidBounds[2*axis+1] <= centroidBounds[2*axis])
+    {
+    this->Nodes[index].Child = first;
+    this->Nodes[index].Count = static_cast<int>(count);
+    return index;
+    }
+
+  // Split at the median centroid along the longest axis
+  vtkIdType half = count / 2;
+  CentroidLess less;
+  less.Centroids = &this->Centroids[0];
+  less.Axis = axis;
+  std::nth_element(this->Order.begin() + first, this->Order.begin() + first + half,
+                   this->Order.begin() + first + count, less);
+  this->BuildNode(first, half, depth + 1);
+  vtkIdType right = this->BuildNode(first + half, count - half, depth + 1);
+  this->Nodes[index].Child = right;
+  this->Nodes[index].Count = 0;
+  return index;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerPathPlannerTriangleTree
+::IntersectSegment(const double start[3], const double end[3],
+                   double* fraction, vtkIdType* cellId) const
+{
+  if (this->Nodes.empty())
+    {
+    return false;
+    }
+  double direction[3];
+  Subtract(end, start, direction);
+
+  bool hit = false;
+  double best = 1.0;
+  vtkIdType stack[StackSize];
+  int top = 0;
+  stack[top++] = 0;
+  while (top > 0)
+    {
+    const Node& node = this->Nodes[stack[--top]];
+    double tEnter;
+    if (!ClipSegment(node.Bounds, start, direction, best, &tEnter))
+      {
+      continue;
+      }
+    if (node.Count > 0)
+      {
+      for (vtkIdType i = node.Child; i < node.Child + node.Count; i ++)
+        {
+        const double* t = &this->Triangles[9 * i];
+        double tHit;
+        if (IntersectTriangle(start, direction, best, t, t + 3, t + 6, &tHit))
+          {
+          hit = true;
+          best = tHit;
+          if (cellId)
+            {
+            *cellId = this->CellIds[i];
+            }
+          }
+        }
+      continue;
+      }
+
+    // Visit the child entered first along the segment first
+    vtkIdType left = (&node - &this->Nodes[0]) + 1;
+    vtkIdType right = node.Child;
+    double tLeft = VTK_DOUBLE_MAX;
+    double tRight = VTK_DOUBLE_MAX;
+    bool hitLeft = ClipSegment(this->Nodes[left].Bounds, start, direction, best, &tLeft);
+    bool hitRight = ClipSegment(this->Nodes[right].Bounds, start, direction, best, &tRight);
+    if (hitLeft && hitRight)
+      {
+      stack[top++] = (tLeft < tRight) ? right : left;
+      stack[top++] = (tLeft < tRight) ? left : right;
+      }
+    else if (hitLeft || hitRight)
+      {
+      stack[top++] = hitLeft ? left : right;
+      }
+    }
+  if (hit && fraction)
+    {
+    *fraction = best;
+    }
+  return hit;
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerPathPlannerTriangleTree
+::ComputeDistance(const double start[3], const double end[3], double* fraction,
+                  double maximumDistance) const
+{
+  if (this->Nodes.empty())
+    {
+    return VTK_DOUBLE_MAX;
+    }
+  double t;
+  if (this->IntersectSegment(start, end, &t))
+    {
+    if (fraction)
+      {
+      *fraction = t;
+      }
+    return 0.0;
+    }
+
+  double direction[3];
+  Subtract(end, start, direction);
+
+  // Only the triangles closer than maximumDistance are looked at
+  double best2 = (maximumDistance < sqrt(VTK_DOUBLE_MAX)) ?
+    maximumDistance * maximumDistance : VTK_DOUBLE_MAX;
+  double bestFraction = 0.0;
+  bool found = false;
+  // nodes to visit and their squared distance to the segment
+  vtkIdType stack[StackSize];
+  double bounds[StackSize];
+  int top = 0;
+  stack[top] = 0;
+  bounds[top++] = 0.0;
+  while (top > 0)
+    {
+    --top;
+    if (bounds[top] >= best2)
+      {
+      continue;
+      }
+    const Node& node = this->Nodes[stack[top]];
+    if (node.Count > 0)
+      {
+      for (vtkIdType i = node.Child; i < node.Child + node.Count; i ++)
+        {
+        double s;
+        double d2 = SegmentTriangleDistance2(start, end, direction, &this->Triangles[9 * i], &s);
+        if (d2 < best2)
+          {
+          best2 = d2;
+          bestFraction = s;
+          found = true;
+          }
+        }
+      continue;
+      }
+
+    // Visit the closer child first
+    vtkIdType left = (&node - &this->Nodes[0]) + 1;
+    vtkIdType right = node.Child;
+    double lowerLeft = SegmentBoxDistance2(this->Nodes[left].Bounds, start, direction);
+    double lowerRight = SegmentBoxDistance2(this->Nodes[right].Bounds, start, direction);
+    bool leftFirst = (lowerLeft <= lowerRight);
+    stack[top] = leftFirst ? right : left;
+    bounds[top++] = leftFirst ? lowerRight : lowerLeft;
+    stack[top] = leftFirst ? left : right;
+    bounds[top++] = leftFirst ? lowerLeft : lowerRight;
+    }
+  if (fraction)
+    {
+    *fraction = bestFraction;
+    }
+  return found ? sqrt(best2) : VTK_DOUBLE_MAX;
+}
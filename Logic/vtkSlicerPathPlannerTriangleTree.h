@@ -0,0 +1,110 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkSlicerPathPlannerTriangleTree - bounding volume hierarchy of a surface
+// .SECTION Description
+// Binary tree of axis aligned boxes over the triangles of a surface (the
+// polygons and triangle strips of a vtkPolyData), split at the median
+// centroid along the longest axis down to a few triangles per leaf. It
+// answers segment queries in logarithmic time: first intersection
+// (Moller-Trumbore test) and closest distance. The tree is rebuilt by
+// Update() when the surface is modified; queries are read-only and may run
+// concurrently.
+
+#ifndef __vtkSlicerPathPlannerTriangleTree_h
+#define __vtkSlicerPathPlannerTriangleTree_h
+
+// VTK includes
+#include <vtkObject.h>
+
+// STD includes
+#include <vector>
+
+#include "vtkSlicerPathPlannerModuleLogicExport.h"
+
+class vtkPolyData;
+
+/// \ingroup Slicer_QtModules_PathPlanner
+class VTK_SLICER_PATHPLANNER_MODULE_LOGIC_EXPORT vtkSlicerPathPlannerTriangleTree :
+  public vtkObject
+{
+public:
+
+  static vtkSlicerPathPlannerTriangleTree *New();
+  vtkTypeMacro(vtkSlicerPathPlannerTriangleTree, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Surface whose triangles are indexed
+  virtual void SetSurface(vtkPolyData* surface);
+  vtkGetObjectMacro(Surface, vtkPolyData);
+
+  /// Build the tree if the surface was modified since the last build
+  void Update();
+  bool NeedsUpdate();
+
+  vtkIdType GetNumberOfTriangles() const;
+
+  /// First intersection of the segment from start to end with the surface.
+  /// Return false if there is none, otherwise fraction receives its position
+  /// (0 at start, 1 at end) and cellId, if not NULL, the ID of the cell of
+  /// the surface that is hit.
+  bool IntersectSegment(const double start[3], const double end[3],
+                        double* fraction, vtkIdType* cellId = 0) const;
+
+  /// Smallest distance between the segment and the surface (0 if they
+  /// intersect). fraction, if not NULL, receives the position of the closest
+  /// point of the segment. The search is cut short at maximumDistance:
+  /// return VTK_DOUBLE_MAX if the surface is empty or not closer than that.
+  double ComputeDistance(const double start[3], const double end[3],
+                         double* fraction = 0,
+                         double maximumDistance = VTK_DOUBLE_MAX) const;
+
+protected:
+  vtkSlicerPathPlannerTriangleTree();
+  virtual ~vtkSlicerPathPlannerTriangleTree();
+
+  void Build();
+  vtkIdType BuildNode(vtkIdType first, vtkIdType count, int depth);
+
+  vtkPolyData* Surface;
+  vtkTimeStamp BuildTime;
+
+  //BTX
+  struct Node
+    {
+    double Bounds[6];
+    // Leaf: first triangle and number of triangles. Inner node: the left
+    // child follows the node, Child is the right child and Count is 0.
+    vtkIdType Child;
+    int Count;
+    };
+  std::vector<Node> Nodes;
+  // Vertex coordinates of the triangles (9 values per triangle), in the
+  // order of the leaves, and the surface cell each one comes from
+  std::vector<double> Triangles;
+  std::vector<vtkIdType> CellIds;
+  // Scratch of the build: triangle order and centroids
+  std::vector<vtkIdType> Order;
+  std::vector<double> Centroids;
+  //ETX
+
+private:
+  vtkSlicerPathPlannerTriangleTree(const vtkSlicerPathPlannerTriangleTree&); // Not implemented
+  void operator=(const vtkSlicerPathPlannerTriangleTree&);                 // Not implemented
+};
+
+#endif
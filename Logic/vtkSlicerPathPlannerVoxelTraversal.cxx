@@ -0,0 +1,160 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner Logic includes
+#include "vtkSlicerPathPlannerVoxelTraversal.h"
+
+// VTK includes
+#include <vtkSetGet.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+//----------------------------------------------------------------------------
+namespace
+{
+
+//----------------------------------------------------------------------------
+template <class T>
+int TraceSegmentTemplate(const T* scalars, const int dimensions[3],
+                         const double start[3], const double end[3],
+                         std::vector<int>& labels, std::vector<double>& fractions)
+{
+  double direction[3] = { end[0] - start[0], end[1] - start[1], end[2] - start[2] };
+
+  // Clip the segment to the volume: t in [tFirst, tLast]
+  double tFirst = 0.0;
+  double tLast = 1.0;
+  for (int axis = 0; axis < 3; axis ++)
+    {
+    double lower = -0.5;
+    double upper = dimensions[axis] - 0.5;
+    if (direction[axis] == 0.0)
+      {
+      if (start[axis] < lower || start[axis] > upper)
+        {
+        return 0;
+        }
+      continue;
+      }
+    double tLower = (lower - start[axis]) / direction[axis];
+    double tUpper = (upper - start[axis]) / direction[axis];
+    if (tLower > tUpper)
+      {
+      std::swap(tLower, tUpper);
+      }
+    tFirst = std::max(tFirst, tLower);
+    tLast = std::min(tLast, tUpper);
+    }
+  if (tFirst > tLast)
+    {
+    return 0;
+    }
+
+  // First voxel, and parameter of the next voxel boundary along each axis
+  int voxel[3];
+  int step[3];
+  double tMax[3];
+  double tDelta[3];
+  for (int axis = 0; axis < 3; axis ++)
+    {
+    double p = start[axis] + tFirst * direction[axis] + 0.5;
+    voxel[axis] = static_cast<int>(floor(p));
+    if (direction[axis] < 0.0 && p == voxel[axis])
+      {
+      // on a boundary, moving down: the voxel below is entered
+      voxel[axis] --;
+      }
+    voxel[axis] = std::min(std::max(voxel[axis], 0), dimensions[axis] - 1);
+
+    if (direction[axis] > 0.0)
+      {
+      step[axis] = 1;
+      tMax[axis] = (voxel[axis] + 0.5 - start[axis]) / direction[axis];
+      tDelta[axis] = 1.0 / direction[axis];
+      }
+    else if (direction[axis] < 0.0)
+      {
+      step[axis] = -1;
+      tMax[axis] = (voxel[axis] - 0.5 - start[axis]) / direction[axis];
+      tDelta[axis] = -1.0 / direction[axis];
+      }
+    else
+      {
+      step[axis] = 0;
+      tMax[axis] = VTK_DOUBLE_MAX;
+      tDelta[axis] = VTK_DOUBLE_MAX;
+      }
+    }
+
+  vtkIdType increments[3] =
+    { 1, dimensions[0], static_cast<vtkIdType>(dimensions[0]) * dimensions[1] };
+  int hits = 0;
+  int previous = 0;
+  double tEnter = tFirst;
+  for (;;)
+    {
+    int label = static_cast<int>(scalars[voxel[0] * increments[0] +
+                                         voxel[1] * increments[1] +
+                                         voxel[2] * increments[2]]);
+    if (label != 0 && label != previous)
+      {
+      labels.push_back(label);
+      fractions.push_back(tEnter);
+      hits ++;
+      }
+    previous = label;
+
+    int axis = (tMax[0] < tMax[1]) ? ((tMax[0] < tMax[2]) ? 0 : 2) :
+                                     ((tMax[1] < tMax[2]) ? 1 : 2);
+    if (tMax[axis] > tLast)
+      {
+      break;
+      }
+    tEnter = tMax[axis];
+    voxel[axis] += step[axis];
+    if (voxel[axis] < 0 || voxel[axis] >= dimensions[axis])
+      {
+      break;
+      }
+    tMax[axis] += tDelta[axis];
+    }
+  return hits;
+}
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerPathPlannerVoxelTraversal
+::TraceSegment(const void* scalars, int scalarType, const int dimensions[3],
+               const double start[3], const double end[3],
+               std::vector<int>& labels, std::vector<double>& fractions)
+{
+  if (!scalars || dimensions[0] <= 0 || dimensions[1] <= 0 || dimensions[2] <= 0)
+    {
+    return 0;
+    }
+
+  switch (scalarType)
+    {
+    vtkTemplateMacro(
+      return TraceSegmentTemplate(static_cast<const VTK_TT*>(scalars), dimensions,
+                                  start, end, labels, fractions));
+    default:
+      return 0;
+    }
+}
@@ -0,0 +1,52 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// .NAME vtkSlicerPathPlannerVoxelTraversal - labels crossed by a segment
+// .SECTION Description
+// Walks the voxels of a labelmap crossed by a segment with the 3D-DDA of
+// Amanatides and Woo: every voxel the segment passes through is visited
+// exactly once, in order, without sampling. Coordinates are continuous IJK
+// indices: voxel (i,j,k) is centered on (i,j,k) and spans +/- 0.5 voxel.
+
+#ifndef __vtkSlicerPathPlannerVoxelTraversal_h
+#define __vtkSlicerPathPlannerVoxelTraversal_h
+
+// VTK includes
+#include <vtkType.h>
+
+// STD includes
+#include <vector>
+
+#include "vtkSlicerPathPlannerModuleLogicExport.h"
+
+/// \ingroup Slicer_QtModules_PathPlanner
+class VTK_SLICER_PATHPLANNER_MODULE_LOGIC_EXPORT vtkSlicerPathPlannerVoxelTraversal
+{
+public:
+  /// Traverse the segment from start to end through a single component
+  /// volume of dimensions voxels of scalarType (VTK_UNSIGNED_CHAR,
+  /// VTK_SHORT...). Each time the segment enters a non-zero label different
+  /// from the label of the previous voxel, the label and the fraction of the
+  /// segment at which it is entered (0 at start, 1 at end) are appended to
+  /// labels and fractions. Voxels outside of the volume have label 0.
+  /// Return the number of hits appended.
+  static int TraceSegment(const void* scalars, int scalarType, const int dimensions[3],
+                          const double start[3], const double end[3],
+                          std::vector<int>& labels, std::vector<double>& fractions);
+};
+
+#endif
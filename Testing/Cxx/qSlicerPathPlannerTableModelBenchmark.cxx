@@ -0,0 +1,319 @@
+/*==============================================================================
+
+  Program: Path Planner User Interface for 3D Slicer
+
+  Copyright (c) Brigham and Women's Hospital
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+ This file was developed by Atsushi Yamada, Brigham and Women's
+ Hospital. The project was supported by NIH P41EB015898.
+
+==============================================================================*/
+
+// Qt includes
+#include <QCoreApplication>
+
+// PathPlanner includes
+#include "qSlicerPathPlannerTableModel.h"
+#include "qSlicerPathPlannerUpdateScheduler.h"
+#include "vtkSlicerPathPlannerLogic.h"
+#include "vtkSlicerPathPlannerPathStore.h"
+#include "vtkSlicerPathPlannerPointStore.h"
+
+// MRML includes
+#include "vtkMRMLAnnotationFiducialNode.h"
+#include "vtkMRMLAnnotationHierarchyNode.h"
+#include "vtkMRMLAnnotationNode.h"
+#include "vtkMRMLAnnotationRulerNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+// Benchmark of the point and path table models on synthetic annotation
+// hierarchies of 100, 1k, 10k and 100k fiducials and rulers in a headless
+// scene. One CSV line is printed per timed operation:
+//   size,operation,count,seconds
+// where count is the number of times the operation was repeated.
+// Usage: qSlicerPathPlannerTableModelBenchmark [maximumSize]
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+class Stopwatch
+{
+public:
+  Stopwatch(vtkIdType size, const char* operation, vtkIdType count = 1)
+    : Size(size), Operation(operation), Count(count)
+  {
+    this->Timer->StartTimer();
+  }
+  ~Stopwatch()
+  {
+    this->Timer->StopTimer();
+    std::cout << this->Size << "," << this->Operation << "," << this->Count << ","
+              << this->Timer->GetElapsedTime() << std::endl;
+  }
+private:
+  vtkNew<vtkTimerLog> Timer;
+  vtkIdType Size;
+  const char* Operation;
+  vtkIdType Count;
+};
+
+//-----------------------------------------------------------------------------
+vtkMRMLAnnotationHierarchyNode* createHierarchy(vtkMRMLScene* scene, const char* name)
+{
+  vtkNew<vtkMRMLAnnotationHierarchyNode> hierarchy;
+  hierarchy->SetName(name);
+  scene->AddNode(hierarchy.GetPointer());
+  return hierarchy.GetPointer();
+}
+
+//-----------------------------------------------------------------------------
+// Same layout as the Annotations module: each annotation is referenced by a
+// one-child hierarchy node under its list.
+void addChild(vtkMRMLScene* scene, vtkMRMLAnnotationHierarchyNode* parent,
+              vtkMRMLAnnotationNode* annotation)
+{
+  scene->AddNode(annotation);
+  vtkNew<vtkMRMLAnnotationHierarchyNode> hierarchy;
+  hierarchy->HideFromEditorsOn();
+  hierarchy->SetAllowMultipleChildren(0);
+  hierarchy->SetParentNodeID(parent->GetID());
+  hierarchy->SetDisplayableNodeID(annotation->GetID());
+  scene->AddNode(hierarchy.GetPointer());
+}
+
+//-----------------------------------------------------------------------------
+void addFiducials(vtkMRMLScene* scene, vtkMRMLAnnotationHierarchyNode* parent,
+                  const char* prefix, double s, vtkIdType size)
+{
+  for (vtkIdType i = 0; i < size; i ++)
+    {
+    std::stringstream name;
+    name << prefix << i;
+    vtkSmartPointer<vtkMRMLAnnotationFiducialNode> fiducial =
+      vtkSmartPointer<vtkMRMLAnnotationFiducialNode>::New();
+    fiducial->SetName(name.str().c_str());
+    fiducial->SetFiducialCoordinates(i % 100, i / 100 % 100, s + i / 10000);
+    addChild(scene, parent, fiducial);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void addRulers(vtkMRMLScene* scene, vtkMRMLAnnotationHierarchyNode* parent,
+               vtkIdType size)
+{
+  for (vtkIdType i = 0; i < size; i ++)
+    {
+    std::stringstream name;
+    name << "P_" << (i + 1);
+    vtkSmartPointer<vtkMRMLAnnotationRulerNode> ruler =
+      vtkSmartPointer<vtkMRMLAnnotationRulerNode>::New();
+    ruler->SetName(name.str().c_str());
+    addChild(scene, parent, ruler);
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool setNode(qSlicerPathPlannerTableModel* model, vtkMRMLNode* node)
+{
+  // setNode() is a protected slot, connected to the node selectors
+  return QMetaObject::invokeMethod(model, "setNode", Qt::DirectConnection,
+                                   Q_ARG(vtkMRMLNode*, node));
+}
+
+//-----------------------------------------------------------------------------
+bool checkRowCount(qSlicerPathPlannerTableModel* model, vtkIdType expected,
+                   const char* operation, int line)
+{
+  if (model->rowCount() != expected)
+    {
+    std::cerr << "Line " << line << " - " << operation << ": "
+              << model->rowCount() << " rows instead of " << expected << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool runBenchmark(vtkIdType size)
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkSlicerPathPlannerLogic> logic;
+
+  // the scene is populated before the models observe it
+  vtkMRMLAnnotationHierarchyNode* entryList = createHierarchy(scene.GetPointer(), "Entry Points");
+  vtkMRMLAnnotationHierarchyNode* targetList = createHierarchy(scene.GetPointer(), "Target Points");
+  vtkMRMLAnnotationHierarchyNode* pathList = createHierarchy(scene.GetPointer(), "Paths");
+  scene->StartState(vtkMRMLScene::BatchProcessState);
+  addFiducials(scene.GetPointer(), entryList, "E_", 100.0, size);
+  addFiducials(scene.GetPointer(), targetList, "T_", 0.0, size);
+  addRulers(scene.GetPointer(), pathList, size);
+  scene->EndState(vtkMRMLScene::BatchProcessState);
+
+  qSlicerPathPlannerTableModel entries;
+  qSlicerPathPlannerTableModel targets;
+  qSlicerPathPlannerTableModel paths;
+  entries.initList(qSlicerPathPlannerTableModel::LABEL_RAS_ENTRY);
+  targets.initList(qSlicerPathPlannerTableModel::LABEL_RAS_TARGET);
+  paths.initList(qSlicerPathPlannerTableModel::LABEL_RAS_PATH);
+  entries.setCoordinateLabel(qSlicerPathPlannerTableModel::LABEL_RAS_ENTRY);
+  targets.setCoordinateLabel(qSlicerPathPlannerTableModel::LABEL_RAS_TARGET);
+  paths.setCoordinateLabel(qSlicerPathPlannerTableModel::LABEL_RAS_PATH);
+  entries.setLogic(logic.GetPointer());
+  targets.setLogic(logic.GetPointer());
+  paths.setLogic(logic.GetPointer());
+  entries.setMRMLScene(scene.GetPointer());
+  targets.setMRMLScene(scene.GetPointer());
+  paths.setMRMLScene(scene.GetPointer());
+  QObject::connect(&entries, SIGNAL(pointModified(vtkIdType)),
+                   &paths, SLOT(onEntryPointModified(vtkIdType)));
+  QObject::connect(&targets, SIGNAL(pointModified(vtkIdType)),
+                   &paths, SLOT(onTargetPointModified(vtkIdType)));
+
+  {
+  Stopwatch stopwatch(size, "setNodePoints");
+  setNode(&entries, entryList);
+  }
+  setNode(&targets, targetList);
+  {
+  Stopwatch stopwatch(size, "setNodePaths");
+  setNode(&paths, pathList);
+  }
+  if (!checkRowCount(&entries, size, "setNode", __LINE__) ||
+      !checkRowCount(&paths, size, "setNode", __LINE__))
+    {
+    return false;
+    }
+
+  {
+  Stopwatch stopwatch(size, "updateTable");
+  entries.updateTable();
+  }
+  {
+  Stopwatch stopwatch(size, "updateRulerTable");
+  paths.updateRulerTable();
+  }
+
+  // selection-to-path flow of the panel: pick a target and an entry point
+  // for the selected path, the ruler follows and the path is recomputed
+  vtkIdType count = std::min(size, static_cast<vtkIdType>(1000));
+  {
+  Stopwatch stopwatch(size, "selectionToPath", count);
+  for (vtkIdType row = 0; row < count; row ++)
+    {
+    paths.setPathTarget(row, targets.identifyTipOfPath(row, 0));
+    paths.setPathEntry(row, entries.identifyTipOfPath(row, 0));
+    }
+  }
+  if (logic->GetPaths()->GetTargetPointId(count - 1) !=
+      logic->GetTargetPoints()->GetId(count - 1))
+    {
+    std::cerr << "Line " << __LINE__ << " - selectionToPath: target point not set" << std::endl;
+    return false;
+    }
+  vtkMRMLAnnotationRulerNode* ruler = vtkMRMLAnnotationRulerNode::SafeDownCast(
+    scene->GetNodeByID(logic->GetPaths()->GetNodeID(count - 1)));
+  double targetPosition[3];
+  double entryPosition[3];
+  double rulerTarget[3] = { 0.0, 0.0, 0.0 };
+  double rulerEntry[3] = { 0.0, 0.0, 0.0 };
+  logic->GetTargetPoints()->GetPosition(count - 1, targetPosition);
+  logic->GetEntryPoints()->GetPosition(count - 1, entryPosition);
+  if (ruler)
+    {
+    ruler->GetPosition1(rulerTarget);
+    ruler->GetPosition2(rulerEntry);
+    }
+  // the control points of the ruler are single precision
+  if (!ruler || vtkMath::Distance2BetweenPoints(targetPosition, rulerTarget) > 1e-6 ||
+      vtkMath::Distance2BetweenPoints(entryPosition, rulerEntry) > 1e-6)
+    {
+    std::cerr << "Line " << __LINE__ << " - selectionToPath: ruler not moved" << std::endl;
+    return false;
+    }
+
+  // cell edits, each one followed by the event-loop pass refreshing the row
+  {
+  Stopwatch stopwatch(size, "setData", count);
+  for (vtkIdType row = 0; row < count; row ++)
+    {
+    entries.setData(entries.index(row, qSlicerPathPlannerTableModel::RColumn),
+                    QString::number(static_cast<double>(row) + 0.5));
+    entries.updateScheduler()->flush();
+    }
+  }
+
+  // drag of every fiducial: one refresh for the whole storm of events
+  {
+  Stopwatch stopwatch(size, "valueModified", size);
+  vtkSlicerPathPlannerPointStore* points = logic->GetEntryPoints();
+  for (vtkIdType row = 0; row < size; row ++)
+    {
+    vtkMRMLAnnotationFiducialNode* fiducial = vtkMRMLAnnotationFiducialNode::SafeDownCast(
+      scene->GetNodeByID(points->GetNodeID(row)));
+    double position[4];
+    fiducial->GetFiducialCoordinates(position);
+    fiducial->SetFiducialCoordinates(position[0], position[1], position[2] + 1.0);
+    }
+  entries.updateScheduler()->flush();
+  }
+
+  // "Delete" button of the panel
+  {
+  Stopwatch stopwatch(size, "bulkDelete", size);
+  entryList->RemoveChildrenNodes();
+  entryList->InvokeEvent(vtkMRMLAnnotationHierarchyNode::HierarchyModifiedEvent);
+  entries.updateScheduler()->flush();
+  }
+  if (!checkRowCount(&entries, 0, "bulkDelete", __LINE__))
+    {
+    return false;
+    }
+
+  return true;
+}
+
+}
+
+//-----------------------------------------------------------------------------
+int qSlicerPathPlannerTableModelBenchmark(int argc, char * argv [] )
+{
+  QCoreApplication app(argc, argv);
+
+  vtkIdType maximumSize = 100000;
+  if (argc > 1)
+    {
+    maximumSize = atoi(argv[1]);
+    }
+
+  std::cout << "size,operation,count,seconds" << std::endl;
+  for (vtkIdType size = 100; size <= maximumSize; size *= 10)
+    {
+    if (!runBenchmark(size))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,194 @@
+/*==============================================================================
+
+  Program: Path Planner User Interface for 3D Slicer
+
+  Copyright (c) Brigham and Women's Hospital
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner includes
+#include "vtkSlicerPathPlannerDeviation.h"
+#include "vtkSlicerPathPlannerLogic.h"
+#include "vtkSlicerPathPlannerPathStore.h"
+#include "vtkSlicerPathPlannerPointStore.h"
+
+// VTK includes
+#include <vtkMath.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+// Deviation of needle poses from three parallel paths along S, against
+// distances and angles computed by hand.
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+// Add a path from entry to target and return its ID
+vtkIdType AddPath(vtkSlicerPathPlannerLogic* logic, const double entry[3], const double target[3])
+{
+  vtkSlicerPathPlannerPathStore* paths = logic->GetPaths();
+  vtkIdType id = paths->AddPath("Path");
+  vtkIdType index = paths->GetIndex(id);
+  paths->SetEntry(index, logic->GetEntryPoints()->AddPoint(entry, "Entry"), entry);
+  paths->SetTarget(index, logic->GetTargetPoints()->AddPoint(target, "Target"), target);
+  return id;
+}
+
+//-----------------------------------------------------------------------------
+// Needle pose with its tip at tip and the rotation rows
+void SetPose(const double tip[3], const double rotation[9], double needleToRAS[16])
+{
+  for (int i = 0; i < 3; i ++)
+    {
+    for (int j = 0; j < 3; j ++)
+      {
+      needleToRAS[4 * i + j] = rotation[3 * i + j];
+      }
+    needleToRAS[4 * i + 3] = tip[i];
+    }
+  needleToRAS[12] = needleToRAS[13] = needleToRAS[14] = 0.0;
+  needleToRAS[15] = 1.0;
+}
+
+//-----------------------------------------------------------------------------
+bool CheckDeviation(int line, vtkSlicerPathPlannerDeviation* deviation,
+                    double tipDistance, double angularDeviation, double remainingDepth,
+                    vtkIdType nearestPathId, double nearestPathDistance)
+{
+  const double tolerance = 1e-9;
+  if (fabs(deviation->GetTipDistance() - tipDistance) > tolerance ||
+      fabs(deviation->GetAngularDeviation() - angularDeviation) > tolerance ||
+      fabs(deviation->GetRemainingDepth() - remainingDepth) > tolerance ||
+      deviation->GetNearestPathId() != nearestPathId ||
+      fabs(deviation->GetNearestPathDistance() - nearestPathDistance) > tolerance)
+    {
+    std::cerr << "Line " << line << " - tip distance " << deviation->GetTipDistance()
+              << ", angle " << deviation->GetAngularDeviation()
+              << ", remaining depth " << deviation->GetRemainingDepth()
+              << ", nearest path " << deviation->GetNearestPathId()
+              << " at " << deviation->GetNearestPathDistance()
+              << "; expected " << tipDistance << ", " << angularDeviation << ", "
+              << remainingDepth << ", " << nearestPathId << " at " << nearestPathDistance
+              << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int vtkSlicerPathPlannerDeviationTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv) [] )
+{
+  const double identity[9] = { 1, 0, 0, 0, 1, 0, 0, 0, 1 };
+  double needleToRAS[16];
+  const double origin[3] = { 0.0, 0.0, 0.0 };
+  SetPose(origin, identity, needleToRAS);
+
+  vtkNew<vtkSlicerPathPlannerDeviation> deviation;
+  if (deviation->Update(needleToRAS) || deviation->GetNearestPathId() != -1)
+    {
+    std::cerr << "Line " << __LINE__ << " - deviation without paths" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Planned path along S through the origin, 100 mm long, and two other
+  // paths 10 mm to the right and 20 mm behind it
+  vtkNew<vtkSlicerPathPlannerLogic> logic;
+  const double plannedEntry[3] = { 0.0, 0.0, 0.0 };
+  const double plannedTarget[3] = { 0.0, 0.0, 100.0 };
+  const double rightEntry[3] = { 10.0, 0.0, 0.0 };
+  const double rightTarget[3] = { 10.0, 0.0, 100.0 };
+  const double backEntry[3] = { 0.0, -20.0, 0.0 };
+  const double backTarget[3] = { 0.0, -20.0, 100.0 };
+  vtkIdType planned = AddPath(logic.GetPointer(), plannedEntry, plannedTarget);
+  vtkIdType right = AddPath(logic.GetPointer(), rightEntry, rightTarget);
+  vtkIdType back = AddPath(logic.GetPointer(), backEntry, backTarget);
+  logic->UpdatePathGeometry();
+  deviation->SetPaths(logic->GetPaths());
+
+  // Without a planned path, only the nearest path is found
+  const double tip[3] = { 3.0, 4.0, 20.0 };
+  SetPose(tip, identity, needleToRAS);
+  if (deviation->Update(needleToRAS) ||
+      !CheckDeviation(__LINE__, deviation.GetPointer(), VTK_DOUBLE_MAX, VTK_DOUBLE_MAX,
+                      VTK_DOUBLE_MAX, planned, 5.0))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Needle parallel to the planned path, 5 mm off its line and 20 mm deep:
+  // the right path is sqrt(7^2 + 4^2) mm away
+  deviation->SetPlannedPathId(planned);
+  if (!deviation->Update(needleToRAS) ||
+      !CheckDeviation(__LINE__, deviation.GetPointer(), 5.0, 0.0, 80.0, right, sqrt(65.0)))
+    {
+    return EXIT_FAILURE;
+    }
+  double position[3];
+  deviation->GetTipPosition(position);
+  if (position[0] != tip[0] || position[1] != tip[1] || position[2] != tip[2])
+    {
+    std::cerr << "Line " << __LINE__ << " - tip at (" << position[0] << ", " << position[1]
+              << ", " << position[2] << ")" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Needle tilted by 30 degrees towards A, 10 mm past the target on the
+  // line of the path: the right path is 10 mm away
+  const double c = cos(vtkMath::RadiansFromDegrees(30.0));
+  const double s = sin(vtkMath::RadiansFromDegrees(30.0));
+  const double tilted[9] = { 1, 0, 0, 0, c, s, 0, -s, c };
+  const double pastTarget[3] = { 0.0, 0.0, 110.0 };
+  SetPose(pastTarget, tilted, needleToRAS);
+  if (!deviation->Update(needleToRAS) ||
+      !CheckDeviation(__LINE__, deviation.GetPointer(), 0.0, 30.0, -10.0, right, 10.0))
+    {
+    return EXIT_FAILURE;
+    }
+  double direction[3];
+  deviation->GetNeedleDirection(direction);
+  if (fabs(direction[0]) > 1e-12 || fabs(direction[1] - s) > 1e-12 ||
+      fabs(direction[2] - c) > 1e-12)
+    {
+    std::cerr << "Line " << __LINE__ << " - needle direction (" << direction[0] << ", "
+              << direction[1] << ", " << direction[2] << ")" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The needle axis is normalized: along R the needle is perpendicular to
+  // the paths. The tip is now closest to the back path.
+  deviation->SetNeedleAxis(2.0, 0.0, 0.0);
+  const double behind[3] = { 0.0, -12.0, 50.0 };
+  SetPose(behind, identity, needleToRAS);
+  if (!deviation->Update(needleToRAS) ||
+      !CheckDeviation(__LINE__, deviation.GetPointer(), 12.0, 90.0, 50.0, back, 8.0))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Planned path removed
+  logic->GetPaths()->RemovePath(logic->GetPaths()->GetIndex(planned));
+  if (deviation->Update(needleToRAS) ||
+      !CheckDeviation(__LINE__, deviation.GetPointer(), VTK_DOUBLE_MAX, VTK_DOUBLE_MAX,
+                      VTK_DOUBLE_MAX, back, 8.0))
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
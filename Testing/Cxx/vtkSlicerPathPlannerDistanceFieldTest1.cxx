@@ -0,0 +1,202 @@
+/*==============================================================================
+
+  Program: Path Planner User Interface for 3D Slicer
+
+  Copyright (c) Brigham and Women's Hospital
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner includes
+#include "vtkSlicerPathPlannerDistanceField.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+// Signed distance field of a small labelmap with anisotropic voxels against
+// the brute force distances between voxel centers, and the minimum along
+// segments against a dense sampling of the interpolated field.
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+// Deterministic pseudo-random numbers in [0, 1)
+double Random(unsigned int& seed)
+{
+  seed = seed * 1103515245u + 12345u;
+  return ((seed >> 8) & 0xFFFF) / 65536.0;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int vtkSlicerPathPlannerDistanceFieldTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv) [] )
+{
+  const int dimensions[3] = { 9, 7, 5 };
+  const double spacing[3] = { 0.5, 1.0, 2.5 };
+
+  vtkNew<vtkImageData> labelMap;
+  labelMap->SetDimensions(dimensions[0], dimensions[1], dimensions[2]);
+  labelMap->SetScalarTypeToUnsignedChar();
+  labelMap->SetNumberOfScalarComponents(1);
+  labelMap->AllocateScalars();
+  unsigned char* scalars = static_cast<unsigned char*>(labelMap->GetScalarPointer());
+  const int nVoxels = dimensions[0] * dimensions[1] * dimensions[2];
+
+  // No structure: empty field
+  std::fill(scalars, scalars + nVoxels, 0);
+  vtkNew<vtkSlicerPathPlannerDistanceField> field;
+  field->Compute(labelMap.GetPointer(), spacing);
+  if (!field->IsEmpty())
+    {
+    std::cerr << "Line " << __LINE__ << " - the field of an empty labelmap is not empty"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // A block of label 1, a voxel of label 2 and a structure on the border
+  for (int k = 0; k < dimensions[2]; k ++)
+    {
+    for (int j = 0; j < dimensions[1]; j ++)
+      {
+      for (int i = 0; i < dimensions[0]; i ++)
+        {
+        unsigned char label = 0;
+        if (i >= 2 && i <= 5 && j >= 1 && j <= 4 && k >= 1 && k <= 3)
+          {
+          label = 1;
+          }
+        else if (i == 7 && j == 5 && k == 0)
+          {
+          label = 2;
+          }
+        else if (i == 0 && k == 4)
+          {
+          label = 3;
+          }
+        scalars[(k * dimensions[1] + j) * dimensions[0] + i] = label;
+        }
+      }
+    }
+  field->Compute(labelMap.GetPointer(), spacing);
+
+  int fieldDimensions[3];
+  field->GetDimensions(fieldDimensions);
+  if (field->IsEmpty() || fieldDimensions[0] != dimensions[0] ||
+      fieldDimensions[1] != dimensions[1] || fieldDimensions[2] != dimensions[2])
+    {
+    std::cerr << "Line " << __LINE__ << " - field of dimensions " << fieldDimensions[0]
+              << "x" << fieldDimensions[1] << "x" << fieldDimensions[2] << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Outside of the structures: distance to the nearest structure voxel;
+  // inside: minus the distance to the nearest background voxel
+  const float* values = field->GetValues();
+  for (int v = 0; v < nVoxels; v ++)
+    {
+    int vi = v % dimensions[0];
+    int vj = (v / dimensions[0]) % dimensions[1];
+    int vk = v / (dimensions[0] * dimensions[1]);
+    bool structure = scalars[v] != 0;
+    double nearest2 = VTK_DOUBLE_MAX;
+    for (int w = 0; w < nVoxels; w ++)
+      {
+      if ((scalars[w] != 0) == structure)
+        {
+        continue;
+        }
+      double d[3] = { (w % dimensions[0] - vi) * spacing[0],
+                      ((w / dimensions[0]) % dimensions[1] - vj) * spacing[1],
+                      (w / (dimensions[0] * dimensions[1]) - vk) * spacing[2] };
+      nearest2 = std::min(nearest2, d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+      }
+    double expected = structure ? -sqrt(nearest2) : sqrt(nearest2);
+    double ijk[3] = { static_cast<double>(vi), static_cast<double>(vj),
+                      static_cast<double>(vk) };
+    if (fabs(values[v] - expected) > 1e-4 ||
+        fabs(field->GetDistance(ijk) - expected) > 1e-4)
+      {
+      std::cerr << "Line " << __LINE__ << " - voxel (" << vi << ", " << vj << ", " << vk
+                << "): distance " << values[v] << ", interpolated "
+                << field->GetDistance(ijk) << ", expected " << expected << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // Halfway between two voxel centers, the interpolation is their mean
+  const double between[3] = { 6.5, 2.0, 2.0 };
+  int v0 = (2 * dimensions[1] + 2) * dimensions[0] + 6;
+  double expected = 0.5 * (values[v0] + values[v0 + 1]);
+  if (fabs(field->GetDistance(between) - expected) > 1e-4)
+    {
+    std::cerr << "Line " << __LINE__ << " - interpolated distance "
+              << field->GetDistance(between) << ", expected " << expected << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The minimum along a segment is never missed by more than the change of
+  // the field between two samples, half a voxel apart at most, even where
+  // the segment crosses the surfaces
+  unsigned int seed = 11;
+  for (int s = 0; s < 500; s ++)
+    {
+    double start[3];
+    double end[3];
+    double length2 = 0.0;
+    for (int axis = 0; axis < 3; axis ++)
+      {
+      start[axis] = (dimensions[axis] - 1) * Random(seed);
+      end[axis] = (dimensions[axis] - 1) * Random(seed);
+      length2 += (end[axis] - start[axis]) * spacing[axis] *
+                 (end[axis] - start[axis]) * spacing[axis];
+      }
+    double length = sqrt(length2);
+    double fraction = -1.0;
+    double minimum = field->ComputeMinimum(start, end, length, &fraction);
+    double sampled = VTK_DOUBLE_MAX;
+    const int nSamples = 2000;
+    for (int i = 0; i <= nSamples; i ++)
+      {
+      double t = static_cast<double>(i) / nSamples;
+      double p[3] = { start[0] + t * (end[0] - start[0]),
+                      start[1] + t * (end[1] - start[1]),
+                      start[2] + t * (end[2] - start[2]) };
+      sampled = std::min(sampled, field->GetDistance(p));
+      }
+    double extent = 0.0;
+    for (int axis = 0; axis < 3; axis ++)
+      {
+      extent = std::max(extent, fabs(end[axis] - start[axis]));
+      }
+    double step = (extent > 0.5) ? 0.5 / extent * length : length;
+    double p[3] = { start[0] + fraction * (end[0] - start[0]),
+                    start[1] + fraction * (end[1] - start[1]),
+                    start[2] + fraction * (end[2] - start[2]) };
+    if (minimum > sampled + sqrt(3.0) * step + 1e-4 || fraction < 0.0 || fraction > 1.0 ||
+        fabs(field->GetDistance(p) - minimum) > 1e-4)
+      {
+      std::cerr << "Line " << __LINE__ << " - segment " << s << ": minimum " << minimum
+                << " at " << fraction << ", sampled " << sampled << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,232 @@
+/*==============================================================================
+
+  Program: Path Planner User Interface for 3D Slicer
+
+  Copyright (c) Brigham and Women's Hospital
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner includes
+#include "vtkSlicerPathPlannerExecutor.h"
+
+// VTK includes
+#include <vtkNew.h>
+
+// STD includes
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Jobs run and deleted by Wait(), jobs of a canceled token dropped while
+// every worker is held by a gate job, and loops covering their range once or
+// skipping their remaining chunks once canceled.
+
+namespace
+{
+
+typedef vtkSlicerPathPlannerExecutor::CancellationToken CancellationToken;
+
+//-----------------------------------------------------------------------------
+// Counts its runs on a worker and its deletion; a gate job holds its worker
+// until the gate opens
+class CountingJob : public vtkSlicerPathPlannerExecutor::Job
+{
+public:
+  CountingJob(std::atomic<int>* runs, std::atomic<int>* deletions,
+              const std::atomic<bool>* gate = 0)
+    : Runs(runs), Deletions(deletions), Gate(gate) {}
+  virtual ~CountingJob()
+    {
+    (*this->Deletions) ++;
+    }
+  virtual void Run(const CancellationToken& vtkNotUsed(token))
+    {
+    if (vtkSlicerPathPlannerExecutor::GetCurrent() &&
+        vtkSlicerPathPlannerExecutor::GetCurrentToken())
+      {
+      (*this->Runs) ++;
+      }
+    while (this->Gate && !this->Gate->load())
+      {
+      std::this_thread::yield();
+      }
+    }
+  std::atomic<int>* Runs;
+  std::atomic<int>* Deletions;
+  const std::atomic<bool>* Gate;
+};
+
+//-----------------------------------------------------------------------------
+// Counts the visits of each item; cancels its token once it visited
+// CancelAfter items
+class CountingFunctor : public vtkSlicerPathPlannerParallel::Functor
+{
+public:
+  CountingFunctor(vtkIdType size, CancellationToken* token = 0, int cancelAfter = 0)
+    : Visits(size), Token(token), CancelAfter(cancelAfter)
+    {
+    this->Count.store(0);
+    for (vtkIdType i = 0; i < size; i ++)
+      {
+      this->Visits[i].store(0);
+      }
+    }
+  virtual void operator()(vtkIdType begin, vtkIdType end)
+    {
+    for (vtkIdType i = begin; i < end; i ++)
+      {
+      this->Visits[i] ++;
+      if (++ this->Count >= this->CancelAfter && this->Token)
+        {
+        this->Token->Cancel();
+        }
+      }
+    }
+  std::vector< std::atomic<int> > Visits;
+  std::atomic<int> Count;
+  CancellationToken* Token;
+  int CancelAfter;
+};
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int vtkSlicerPathPlannerExecutorTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv) [] )
+{
+  const int nThreads = 3;
+  vtkNew<vtkSlicerPathPlannerExecutor> executor;
+  executor->SetNumberOfThreads(nThreads);
+  if (executor->GetNumberOfThreads() != nThreads || executor->GetNumberOfPendingJobs() != 0 ||
+      vtkSlicerPathPlannerExecutor::GetCurrent() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - " << executor->GetNumberOfThreads()
+              << " threads, " << executor->GetNumberOfPendingJobs() << " pending jobs"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  // Nothing to wait for
+  executor->Wait();
+
+  // Every job runs once on a worker, and is deleted, by the end of Wait()
+  std::atomic<int> runs(0);
+  std::atomic<int> deletions(0);
+  const int nJobs = 100;
+  CancellationToken token;
+  for (int i = 0; i < nJobs; i ++)
+    {
+    executor->Submit(new CountingJob(&runs, &deletions), token);
+    }
+  executor->Wait();
+  if (runs.load() != nJobs || deletions.load() != nJobs ||
+      executor->GetNumberOfPendingJobs() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - " << runs.load() << " runs, "
+              << deletions.load() << " deletions of " << nJobs << " jobs, "
+              << executor->GetNumberOfPendingJobs() << " pending" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Jobs queued behind the gate jobs are dropped, and deleted, once their
+  // token is canceled; the others still run
+  runs.store(0);
+  deletions.store(0);
+  std::atomic<int> gateRuns(0);
+  std::atomic<bool> gate(false);
+  for (int i = 0; i < nThreads; i ++)
+    {
+    executor->Submit(new CountingJob(&gateRuns, &deletions, &gate), token);
+    }
+  while (gateRuns.load() < nThreads)
+    {
+    std::this_thread::yield();
+    }
+  CancellationToken canceledToken;
+  std::atomic<int> liveRuns(0);
+  for (int i = 0; i < nJobs; i ++)
+    {
+    executor->Submit(new CountingJob(&runs, &deletions), canceledToken);
+    executor->Submit(new CountingJob(&liveRuns, &deletions), token);
+    }
+  if (executor->GetNumberOfPendingJobs() != nThreads + 2 * nJobs)
+    {
+    std::cerr << "Line " << __LINE__ << " - " << executor->GetNumberOfPendingJobs()
+              << " pending jobs, expected " << nThreads + 2 * nJobs << std::endl;
+    return EXIT_FAILURE;
+    }
+  CancellationToken copy = canceledToken;
+  copy.Cancel();
+  gate.store(true);
+  executor->Wait();
+  if (!canceledToken.IsCanceled() || token.IsCanceled() || runs.load() != 0 ||
+      liveRuns.load() != nJobs || gateRuns.load() != nThreads ||
+      deletions.load() != nThreads + 2 * nJobs)
+    {
+    std::cerr << "Line " << __LINE__ << " - " << runs.load() << " canceled runs, "
+              << liveRuns.load() << " live runs, " << deletions.load() << " deletions"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // A loop visits every item once
+  const vtkIdType nItems = 10000;
+    {
+    CountingFunctor functor(nItems);
+    bool done = executor->For(0, nItems, 7, functor, token);
+    for (vtkIdType i = 0; i < nItems; i ++)
+      {
+      if (!done || functor.Visits[i].load() != 1)
+        {
+        std::cerr << "Line " << __LINE__ << " - item " << i << " visited "
+                  << functor.Visits[i].load() << " times, done " << done << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  // A loop whose token is canceled skips the chunks it did not start
+    {
+    CancellationToken loopToken;
+    CountingFunctor functor(nItems, &loopToken, 1);
+    bool done = executor->For(0, nItems, 1, functor, loopToken);
+    int visited = 0;
+    for (vtkIdType i = 0; i < nItems; i ++)
+      {
+      int visits = functor.Visits[i].load();
+      if (visits > 1)
+        {
+        std::cerr << "Line " << __LINE__ << " - item " << i << " visited "
+                  << visits << " times" << std::endl;
+        return EXIT_FAILURE;
+        }
+      visited += visits;
+      }
+    if (done || visited == 0 || visited >= nItems / 2)
+      {
+      std::cerr << "Line " << __LINE__ << " - canceled loop: " << visited
+                << " items visited, done " << done << std::endl;
+      return EXIT_FAILURE;
+      }
+    // and a canceled loop does not start
+    CountingFunctor skipped(nItems);
+    if (executor->For(0, nItems, 1, skipped, loopToken) || skipped.Count.load() != 0 ||
+        executor->For(0, 1, 1, skipped, loopToken) || skipped.Count.load() != 0)
+      {
+      std::cerr << "Line " << __LINE__ << " - " << skipped.Count.load()
+                << " items visited by a canceled loop" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
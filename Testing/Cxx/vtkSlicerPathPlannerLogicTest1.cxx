@@ -0,0 +1,274 @@
+/*==============================================================================
+
+  Program: Path Planner User Interface for 3D Slicer
+
+  Copyright (c) Brigham and Women's Hospital
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner includes
+#include "vtkSlicerPathPlannerLogic.h"
+#include "vtkSlicerPathPlannerPathStore.h"
+#include "vtkSlicerPathPlannerPointStore.h"
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkIdList.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+// Length, direction and insertion angle of trajectories computed by hand,
+// one at a time, in a batch and on arrays, against the default and other
+// reference directions; and the paths of a moved point recomputed alone.
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+// Entry point, target point, length, direction and insertion angle
+// against (0, 0, 1)
+struct Trajectory
+{
+  double Entry[3];
+  double Target[3];
+  double Length;
+  double Direction[3];
+  double InsertionAngle;
+};
+
+const double Sqrt2 = 1.4142135623730951;
+
+const Trajectory Trajectories[] =
+  {
+    { { 0, 0, 0 }, { 3, 4, 0 }, 5.0, { 0.6, 0.8, 0.0 }, 90.0 },
+    { { 1, 1, 1 }, { 1, 1, 11 }, 10.0, { 0.0, 0.0, 1.0 }, 0.0 },
+    { { 0, 0, 10 }, { 0, 0, 0 }, 10.0, { 0.0, 0.0, -1.0 }, 180.0 },
+    { { -1, 2, 3 }, { 0, 2, 4 }, Sqrt2, { 1.0 / Sqrt2, 0.0, 1.0 / Sqrt2 }, 45.0 },
+    { { 5, 5, 5 }, { 5, 5, 5 }, 0.0, { 0.0, 0.0, 0.0 }, 0.0 }
+  };
+const int NumberOfTrajectories =
+  static_cast<int>(sizeof(Trajectories) / sizeof(Trajectories[0]));
+
+//-----------------------------------------------------------------------------
+bool CheckTrajectory(int line, int t, double length, const double direction[3],
+                     double insertionAngle)
+{
+  const Trajectory& trajectory = Trajectories[t];
+  double error = fabs(length - trajectory.Length);
+  error = std::max(error, fabs(insertionAngle - trajectory.InsertionAngle));
+  for (int j = 0; j < 3; j ++)
+    {
+    error = std::max(error, fabs(direction[j] - trajectory.Direction[j]));
+    }
+  if (error > 1e-9)
+    {
+    std::cerr << "Line " << line << " - trajectory " << t << ": length " << length
+              << ", direction (" << direction[0] << ", " << direction[1] << ", "
+              << direction[2] << "), insertion angle " << insertionAngle << "; expected "
+              << trajectory.Length << ", " << trajectory.InsertionAngle << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+// Check that the path at index joins its end points and that its length
+// is the distance between them
+bool CheckPath(int line, vtkSlicerPathPlannerLogic* logic, vtkIdType index,
+               const double entry[3], const double target[3])
+{
+  vtkSlicerPathPlannerPathStore* paths = logic->GetPaths();
+  double entryPosition[3];
+  double targetPosition[3];
+  paths->GetEntryPosition(index, entryPosition);
+  paths->GetTargetPosition(index, targetPosition);
+  double length = sqrt(vtkMath::Distance2BetweenPoints(entry, target));
+  bool same = fabs(paths->GetLength(index) - length) < 1e-9;
+  for (int j = 0; j < 3; j ++)
+    {
+    same = same && entryPosition[j] == entry[j] && targetPosition[j] == target[j];
+    }
+  if (!same)
+    {
+    std::cerr << "Line " << line << " - path " << index << " of length "
+              << paths->GetLength(index) << ", expected " << length << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int vtkSlicerPathPlannerLogicTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv) [] )
+{
+  vtkNew<vtkSlicerPathPlannerLogic> logic;
+  double* reference = logic->GetReferenceDirection();
+  if (reference[0] != 0.0 || reference[1] != 0.0 || reference[2] != 1.0)
+    {
+    std::cerr << "Line " << __LINE__ << " - reference direction (" << reference[0] << ", "
+              << reference[1] << ", " << reference[2] << ")" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // One at a time; the reference direction does not need to be normalized
+  logic->SetReferenceDirection(0.0, 0.0, 5.0);
+  for (int t = 0; t < NumberOfTrajectories; t ++)
+    {
+    double direction[3];
+    double insertionAngle = -1.0;
+    double length = logic->ComputeTrajectory(Trajectories[t].Entry, Trajectories[t].Target,
+                                             direction, &insertionAngle);
+    if (!CheckTrajectory(__LINE__, t, length, direction, insertionAngle) ||
+        logic->ComputeTrajectory(Trajectories[t].Entry, Trajectories[t].Target) != length)
+      {
+      return EXIT_FAILURE;
+      }
+    }
+
+  // In a batch, and on arrays
+  double entries[3 * NumberOfTrajectories];
+  double targets[3 * NumberOfTrajectories];
+  vtkNew<vtkDoubleArray> entryArray;
+  vtkNew<vtkDoubleArray> targetArray;
+  entryArray->SetNumberOfComponents(3);
+  targetArray->SetNumberOfComponents(3);
+  for (int t = 0; t < NumberOfTrajectories; t ++)
+    {
+    for (int j = 0; j < 3; j ++)
+      {
+      entries[3 * t + j] = Trajectories[t].Entry[j];
+      targets[3 * t + j] = Trajectories[t].Target[j];
+      }
+    entryArray->InsertNextTuple3(Trajectories[t].Entry[0], Trajectories[t].Entry[1],
+                                 Trajectories[t].Entry[2]);
+    targetArray->InsertNextTuple3(Trajectories[t].Target[0], Trajectories[t].Target[1],
+                                  Trajectories[t].Target[2]);
+    }
+  double lengths[NumberOfTrajectories];
+  double directions[3 * NumberOfTrajectories];
+  double insertionAngles[NumberOfTrajectories];
+  logic->ComputeTrajectories(entries, targets, NumberOfTrajectories, lengths, directions,
+                             insertionAngles);
+  vtkNew<vtkDoubleArray> lengthArray;
+  vtkNew<vtkDoubleArray> directionArray;
+  vtkNew<vtkDoubleArray> angleArray;
+  logic->ComputeTrajectories(entryArray.GetPointer(), targetArray.GetPointer(),
+                             lengthArray.GetPointer(), directionArray.GetPointer(),
+                             angleArray.GetPointer());
+  if (lengthArray->GetNumberOfTuples() != NumberOfTrajectories ||
+      directionArray->GetNumberOfTuples() != NumberOfTrajectories ||
+      directionArray->GetNumberOfComponents() != 3 ||
+      angleArray->GetNumberOfTuples() != NumberOfTrajectories)
+    {
+    std::cerr << "Line " << __LINE__ << " - output arrays of "
+              << lengthArray->GetNumberOfTuples() << " tuples" << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (int t = 0; t < NumberOfTrajectories; t ++)
+    {
+    double direction[3];
+    directionArray->GetTuple(t, direction);
+    if (!CheckTrajectory(__LINE__, t, lengths[t], directions + 3 * t, insertionAngles[t]) ||
+        !CheckTrajectory(__LINE__, t, lengthArray->GetValue(t), direction,
+                         angleArray->GetValue(t)))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+
+  // Against R, the trajectory along R has no insertion angle and the one
+  // along S is perpendicular
+  logic->SetReferenceDirection(1.0, 0.0, 0.0);
+  double insertionAngle = -1.0;
+  logic->ComputeTrajectory(Trajectories[1].Entry, Trajectories[1].Target, 0, &insertionAngle);
+  double alongR[3] = { 7.0, 2.0, 3.0 };
+  double angleAlongR = -1.0;
+  logic->ComputeTrajectory(Trajectories[3].Entry, alongR, 0, &angleAlongR);
+  if (fabs(insertionAngle - 90.0) > 1e-9 || fabs(angleAlongR) > 1e-6)
+    {
+    std::cerr << "Line " << __LINE__ << " - insertion angles " << insertionAngle << " and "
+              << angleAlongR << " against R" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Paths from each of 3 entry points to each of 2 target points
+  vtkSlicerPathPlannerPointStore* entryPoints = logic->GetEntryPoints();
+  vtkSlicerPathPlannerPointStore* targetPoints = logic->GetTargetPoints();
+  vtkSlicerPathPlannerPathStore* paths = logic->GetPaths();
+  double entries2[3][3] = { { 0, 0, 0 }, { 10, 0, 0 }, { 0, 10, 0 } };
+  double targets2[2][3] = { { 5, 5, 50 }, { -5, 5, 40 } };
+  for (int e = 0; e < 3; e ++)
+    {
+    entryPoints->AddPoint(entries2[e], "Entry");
+    }
+  for (int t = 0; t < 2; t ++)
+    {
+    targetPoints->AddPoint(targets2[t], "Target");
+    for (int e = 0; e < 3; e ++)
+      {
+      vtkIdType index = paths->GetIndex(paths->AddPath("Path"));
+      paths->SetEntry(index, entryPoints->GetId(e), entries2[e]);
+      paths->SetTarget(index, targetPoints->GetId(t), targets2[t]);
+      }
+    }
+  logic->UpdatePathGeometry();
+
+  // Moving an entry point, then a target point: only the paths that use it
+  // are recomputed, the others keep their previous end points
+  vtkNew<vtkIdList> pathIndices;
+  double previousEntry[3] = { entries2[1][0], entries2[1][1], entries2[1][2] };
+  entries2[1][2] = -20.0;
+  entryPoints->SetPosition(1, entries2[1]);
+  logic->UpdatePathsOfEntryPoint(entryPoints->GetId(1), pathIndices.GetPointer());
+  targets2[0][0] = 30.0;
+  targetPoints->SetPosition(0, targets2[0]);
+  vtkNew<vtkIdList> targetPathIndices;
+  logic->UpdatePathsOfTargetPoint(targetPoints->GetId(0), targetPathIndices.GetPointer());
+  // the paths at index 3 e + t join entry e and target t
+  const double previousTarget[3] = { 5.0, 5.0, 50.0 };
+  if (pathIndices->GetNumberOfIds() != 2 || pathIndices->GetId(0) != 1 ||
+      pathIndices->GetId(1) != 4 || targetPathIndices->GetNumberOfIds() != 3 ||
+      targetPathIndices->GetId(0) != 0 || targetPathIndices->GetId(2) != 2 ||
+      !CheckPath(__LINE__, logic.GetPointer(), 0, entries2[0], targets2[0]) ||
+      !CheckPath(__LINE__, logic.GetPointer(), 1, entries2[1], targets2[0]) ||
+      !CheckPath(__LINE__, logic.GetPointer(), 4, entries2[1], targets2[1]) ||
+      !CheckPath(__LINE__, logic.GetPointer(), 5, entries2[2], targets2[1]))
+    {
+    std::cerr << "Line " << __LINE__ << " - " << pathIndices->GetNumberOfIds()
+              << " paths of the entry point and " << targetPathIndices->GetNumberOfIds()
+              << " paths of the target point updated" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // A point moved without an update leaves its paths as they were
+  entryPoints->SetPosition(0, previousEntry);
+  if (!CheckPath(__LINE__, logic.GetPointer(), 3, entries2[0], targets2[1]) ||
+      previousTarget[0] == targets2[0][0])
+    {
+    return EXIT_FAILURE;
+    }
+  logic->UpdatePathsOfEntryPoint(entryPoints->GetId(2) + 100, pathIndices.GetPointer());
+  if (pathIndices->GetNumberOfIds() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - paths of an unknown point updated" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
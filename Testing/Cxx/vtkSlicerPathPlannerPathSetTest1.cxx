@@ -0,0 +1,238 @@
+/*==============================================================================
+
+  Program: Path Planner User Interface for 3D Slicer
+
+  Copyright (c) Brigham and Women's Hospital
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner includes
+#include "vtkSlicerPathPlannerPathSet.h"
+#include "vtkSlicerPathPlannerPathStore.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkCellData.h>
+#include <vtkFloatArray.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkUnsignedCharArray.h>
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+
+// Polydata of a path store: the end points of the path at index i are the
+// points 2 i and 2 i + 1, each path without a ruler node has a line cell
+// carrying its cost and selection state, and the arrays follow the paths
+// added and removed.
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+// Add a path from (i, 0, 0) to (i, 10, 20 + i) and return its ID
+vtkIdType AddPath(vtkSlicerPathPlannerPathStore* paths, int i, double cost,
+                  const char* nodeID = 0)
+{
+  vtkIdType id = paths->AddPath("Path", nodeID);
+  vtkIdType index = paths->GetIndex(id);
+  const double entry[3] = { static_cast<double>(i), 0.0, 0.0 };
+  const double target[3] = { static_cast<double>(i), 10.0, 20.0 + i };
+  paths->SetEntry(index, -1, entry);
+  paths->SetTarget(index, -1, target);
+  paths->SetCost(index, cost);
+  return id;
+}
+
+//-----------------------------------------------------------------------------
+bool SamePoint(vtkPoints* points, vtkIdType point, const double expected[3])
+{
+  double position[3];
+  points->GetPoint(point, position);
+  // the coordinates are stored as floats
+  return position[0] == static_cast<float>(expected[0]) &&
+         position[1] == static_cast<float>(expected[1]) &&
+         position[2] == static_cast<float>(expected[2]);
+}
+
+//-----------------------------------------------------------------------------
+// Compare the output of pathSet with its path store
+bool CheckOutput(int line, vtkSlicerPathPlannerPathSet* pathSet)
+{
+  vtkSlicerPathPlannerPathStore* paths = pathSet->GetPaths();
+  vtkPolyData* output = pathSet->GetOutput();
+  vtkIdType nPaths = paths->GetNumberOfPaths();
+  vtkIdType nCells = 0;
+  for (vtkIdType i = 0; i < nPaths; i ++)
+    {
+    nCells += (paths->GetNodeID(i)[0] == '\0') ? 1 : 0;
+    }
+  vtkFloatArray* costs = vtkFloatArray::SafeDownCast(output->GetCellData()->GetArray("Cost"));
+  vtkUnsignedCharArray* selection =
+    vtkUnsignedCharArray::SafeDownCast(output->GetCellData()->GetArray("Selected"));
+  if (output->GetPoints()->GetNumberOfPoints() != 2 * nPaths ||
+      output->GetNumberOfLines() != nCells || !costs || !selection ||
+      costs->GetNumberOfTuples() != nCells || selection->GetNumberOfTuples() != nCells)
+    {
+    std::cerr << "Line " << line << " - " << output->GetPoints()->GetNumberOfPoints()
+              << " points and " << output->GetNumberOfLines() << " lines for "
+              << nPaths << " paths, " << nCells << " without ruler" << std::endl;
+    return false;
+    }
+
+  // Highest cost of the evaluated paths
+  double highestCost = VTK_DOUBLE_MIN;
+  for (vtkIdType i = 0; i < nPaths; i ++)
+    {
+    if (paths->GetCost(i) != VTK_DOUBLE_MAX && paths->GetCost(i) > highestCost)
+      {
+      highestCost = paths->GetCost(i);
+      }
+    }
+
+  vtkIdType selectedIndex = paths->GetIndex(pathSet->GetSelectedPathId());
+  vtkCellArray* lines = output->GetLines();
+  lines->InitTraversal();
+  vtkIdType c = 0;
+  for (vtkIdType i = 0; i < nPaths; i ++)
+    {
+    double entry[3];
+    double target[3];
+    paths->GetEntryPosition(i, entry);
+    paths->GetTargetPosition(i, target);
+    if (!SamePoint(output->GetPoints(), 2 * i, entry) ||
+        !SamePoint(output->GetPoints(), 2 * i + 1, target))
+      {
+      std::cerr << "Line " << line << " - end points of path " << i << std::endl;
+      return false;
+      }
+    // the paths with a ruler node have no cell
+    if (paths->GetNodeID(i)[0] != '\0')
+      {
+      continue;
+      }
+    vtkIdType nCellPoints = 0;
+    vtkIdType* cellPoints = 0;
+    double cost = paths->GetCost(i) != VTK_DOUBLE_MAX ? paths->GetCost(i) : highestCost;
+    if (!lines->GetNextCell(nCellPoints, cellPoints) || nCellPoints != 2 ||
+        cellPoints[0] != 2 * i || cellPoints[1] != 2 * i + 1 ||
+        costs->GetValue(c) != static_cast<float>(cost) ||
+        selection->GetValue(c) != (i == selectedIndex ? 1 : 0))
+      {
+      std::cerr << "Line " << line << " - path " << i << ", cell " << c << " of "
+                << nCellPoints << " points, cost " << costs->GetValue(c) << ", expected "
+                << cost << ", selected " << static_cast<int>(selection->GetValue(c))
+                << std::endl;
+      return false;
+      }
+    c ++;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int vtkSlicerPathPlannerPathSetTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv) [] )
+{
+  vtkNew<vtkSlicerPathPlannerPathStore> paths;
+  vtkNew<vtkSlicerPathPlannerPathSet> pathSet;
+  vtkPolyData* output = pathSet->GetOutput();
+  pathSet->Update();
+  if (output->GetNumberOfLines() != 0 || pathSet->GetCostRange()[0] != 0.0 ||
+      pathSet->GetCostRange()[1] != 1.0)
+    {
+    std::cerr << "Line " << __LINE__ << " - path set without paths" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Five paths, one of which is not evaluated yet
+  pathSet->SetPaths(paths.GetPointer());
+  const double pathCosts[5] = { 3.0, 1.5, VTK_DOUBLE_MAX, 7.0, 2.0 };
+  vtkIdType ids[5];
+  for (int i = 0; i < 5; i ++)
+    {
+    ids[i] = AddPath(paths.GetPointer(), i, pathCosts[i]);
+    }
+  pathSet->Update();
+  if (!CheckOutput(__LINE__, pathSet.GetPointer()))
+    {
+    return EXIT_FAILURE;
+    }
+  if (pathSet->GetCostRange()[0] != 1.5 || pathSet->GetCostRange()[1] != 7.0 ||
+      output->GetCellData()->GetScalars() != output->GetCellData()->GetArray("Cost"))
+    {
+    std::cerr << "Line " << __LINE__ << " - cost range " << pathSet->GetCostRange()[0]
+              << ", " << pathSet->GetCostRange()[1] << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Selection
+  pathSet->SetSelectedPathId(ids[3]);
+  pathSet->SetScalarModeToSelection();
+  pathSet->Update();
+  if (!CheckOutput(__LINE__, pathSet.GetPointer()) ||
+      output->GetCellData()->GetScalars() != output->GetCellData()->GetArray("Selected"))
+    {
+    std::cerr << "Line " << __LINE__ << " - selection scalars" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The points and the scalars follow the removed paths, into the same
+  // polydata
+  paths->RemovePath(paths->GetIndex(ids[1]));
+  paths->RemovePath(paths->GetIndex(ids[4]));
+  pathSet->Update();
+  if (pathSet->GetOutput() != output || !CheckOutput(__LINE__, pathSet.GetPointer()) ||
+      pathSet->GetCostRange()[0] != 3.0 || pathSet->GetCostRange()[1] != 7.0)
+    {
+    std::cerr << "Line " << __LINE__ << " - cost range " << pathSet->GetCostRange()[0]
+              << ", " << pathSet->GetCostRange()[1] << " after removals" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The paths backed by a ruler node keep their points but have no cell
+  vtkIdType rulerId = AddPath(paths.GetPointer(), 5, 4.0, "vtkMRMLAnnotationRulerNode1");
+  AddPath(paths.GetPointer(), 6, 5.0);
+  pathSet->SetSelectedPathId(rulerId);
+  pathSet->Update();
+  if (output->GetNumberOfLines() != 4 || !CheckOutput(__LINE__, pathSet.GetPointer()))
+    {
+    return EXIT_FAILURE;
+    }
+  paths->RemovePath(paths->GetIndex(ids[0]));
+  pathSet->Update();
+  if (!CheckOutput(__LINE__, pathSet.GetPointer()))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // A cost computed later is drawn
+  paths->SetCost(paths->GetIndex(ids[2]), 0.5);
+  pathSet->Update();
+  if (!CheckOutput(__LINE__, pathSet.GetPointer()) || pathSet->GetCostRange()[0] != 0.5)
+    {
+    return EXIT_FAILURE;
+    }
+
+  paths->RemoveAllPaths();
+  pathSet->Update();
+  if (!CheckOutput(__LINE__, pathSet.GetPointer()) || pathSet->GetCostRange()[0] != 0.0 ||
+      pathSet->GetCostRange()[1] != 1.0)
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
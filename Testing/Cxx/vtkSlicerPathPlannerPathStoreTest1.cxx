@@ -0,0 +1,277 @@
+/*==============================================================================
+
+  Program: Path Planner User Interface for 3D Slicer
+
+  Copyright (c) Brigham and Women's Hospital
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner includes
+#include "vtkSlicerPathPlannerPathStore.h"
+
+// VTK includes
+#include <vtkIdList.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Paths added, given end points and removed (one by one or in batches) in
+// a pseudo-random order, against a plain list of the same paths: the IDs
+// stay stable while the indices shift, the packed end point arrays follow,
+// and the lookups by ID and node ID find the paths still in the store.
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+struct ReferencePath
+{
+  vtkIdType Id;
+  std::string Name;
+  std::string NodeID;
+  vtkIdType TargetPointId;
+  vtkIdType EntryPointId;
+  double Target[3];
+  double Entry[3];
+};
+
+//-----------------------------------------------------------------------------
+// Deterministic pseudo-random numbers in [0, 1)
+double Random(unsigned int& seed)
+{
+  seed = seed * 1103515245u + 12345u;
+  return ((seed >> 8) & 0xFFFF) / 65536.0;
+}
+
+//-----------------------------------------------------------------------------
+bool CheckStore(int line, vtkSlicerPathPlannerPathStore* paths,
+                const std::vector<ReferencePath>& reference,
+                const std::vector<vtkIdType>& removedIds)
+{
+  vtkIdType n = static_cast<vtkIdType>(reference.size());
+  if (paths->GetNumberOfPaths() != n)
+    {
+    std::cerr << "Line " << line << " - " << paths->GetNumberOfPaths()
+              << " paths, expected " << n << std::endl;
+    return false;
+    }
+  const double* targets = paths->GetTargetPositions();
+  const double* entries = paths->GetEntryPositions();
+  for (vtkIdType i = 0; i < n; i ++)
+    {
+    const ReferencePath& path = reference[i];
+    double target[3];
+    double entry[3];
+    paths->GetTargetPosition(i, target);
+    paths->GetEntryPosition(i, entry);
+    bool same = paths->GetId(i) == path.Id && paths->GetIndex(path.Id) == i &&
+      path.Name == paths->GetName(i) && path.NodeID == paths->GetNodeID(i) &&
+      paths->GetTargetPointId(i) == path.TargetPointId &&
+      paths->GetEntryPointId(i) == path.EntryPointId &&
+      paths->FindIndexByNodeID(path.NodeID.c_str()) == (path.NodeID.empty() ? -1 : i);
+    for (int j = 0; j < 3; j ++)
+      {
+      same = same && target[j] == path.Target[j] && entry[j] == path.Entry[j] &&
+        targets[3 * i + j] == path.Target[j] && entries[3 * i + j] == path.Entry[j];
+      }
+    if (!same)
+      {
+      std::cerr << "Line " << line << " - path " << i << ": ID " << paths->GetId(i)
+                << ", expected " << path.Id << ", index of the ID "
+                << paths->GetIndex(path.Id) << ", target point " << paths->GetTargetPointId(i)
+                << ", entry point " << paths->GetEntryPointId(i) << ", node ID "
+                << paths->GetNodeID(i) << std::endl;
+      return false;
+      }
+    }
+  for (size_t i = 0; i < removedIds.size(); i ++)
+    {
+    if (paths->GetIndex(removedIds[i]) != -1)
+      {
+      std::cerr << "Line " << line << " - removed ID " << removedIds[i] << " at index "
+                << paths->GetIndex(removedIds[i]) << std::endl;
+      return false;
+      }
+    }
+  if (paths->FindIndexByNodeID("") != -1 || paths->FindIndexByNodeID(0) != -1 ||
+      paths->FindIndexByNodeID("vtkMRMLAnnotationRulerNodeNone") != -1)
+    {
+    std::cerr << "Line " << line << " - lookups out of the store" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int vtkSlicerPathPlannerPathStoreTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv) [] )
+{
+  vtkNew<vtkSlicerPathPlannerPathStore> paths;
+  std::vector<ReferencePath> reference;
+  std::vector<vtkIdType> removedIds;
+
+  // Mostly additions; every third path is backed by a ruler node
+  unsigned int seed = 11;
+  int nNodes = 0;
+  vtkIdType lastId = -1;
+  for (int step = 0; step < 2000; step ++)
+    {
+    double choice = Random(seed);
+    vtkIdType n = static_cast<vtkIdType>(reference.size());
+    vtkIdType index = static_cast<vtkIdType>(Random(seed) * n);
+    if (choice < 0.5 || n == 0)
+      {
+      // New paths have no end points yet
+      ReferencePath path;
+      std::ostringstream name;
+      name << "P-" << step;
+      path.Name = name.str();
+      if (step % 3 == 0)
+        {
+        std::ostringstream nodeID;
+        nodeID << "vtkMRMLAnnotationRulerNode" << nNodes ++;
+        path.NodeID = nodeID.str();
+        }
+      path.TargetPointId = path.EntryPointId = -1;
+      for (int j = 0; j < 3; j ++)
+        {
+        path.Target[j] = path.Entry[j] = 0.0;
+        }
+      path.Id = paths->AddPath(path.Name.c_str(),
+                               path.NodeID.empty() ? 0 : path.NodeID.c_str());
+      if (path.Id <= lastId)
+        {
+        std::cerr << "Line " << __LINE__ << " - ID " << path.Id << " after " << lastId
+                  << std::endl;
+        return EXIT_FAILURE;
+        }
+      lastId = path.Id;
+      reference.push_back(path);
+      }
+    else if (choice < 0.62)
+      {
+      removedIds.push_back(reference[index].Id);
+      reference.erase(reference.begin() + index);
+      paths->RemovePath(index);
+      }
+    else if (choice < 0.7)
+      {
+      // A few indices in any order, repeated or out of range
+      vtkNew<vtkIdList> indices;
+      std::vector<vtkIdType> sorted;
+      int nIndices = 1 + static_cast<int>(6 * Random(seed));
+      for (int k = 0; k < nIndices; k ++)
+        {
+        vtkIdType removed = static_cast<vtkIdType>(Random(seed) * (n + 2)) - 1;
+        indices->InsertNextId(removed);
+        indices->InsertNextId(removed);
+        if (removed >= 0 && removed < n)
+          {
+          sorted.push_back(removed);
+          }
+        }
+      std::sort(sorted.begin(), sorted.end());
+      sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+      for (size_t k = sorted.size(); k > 0; k --)
+        {
+        removedIds.push_back(reference[sorted[k - 1]].Id);
+        reference.erase(reference.begin() + sorted[k - 1]);
+        }
+      paths->RemovePaths(indices.GetPointer());
+      }
+    else
+      {
+      ReferencePath& path = reference[index];
+      bool target = choice < 0.85;
+      vtkIdType pointId = static_cast<vtkIdType>(1000 * Random(seed));
+      double* position = target ? path.Target : path.Entry;
+      for (int j = 0; j < 3; j ++)
+        {
+        position[j] = 200.0 * Random(seed) - 100.0;
+        }
+      if (target)
+        {
+        path.TargetPointId = pointId;
+        paths->SetTarget(index, pointId, position);
+        }
+      else
+        {
+        path.EntryPointId = pointId;
+        paths->SetEntry(index, pointId, position);
+        }
+      }
+    if (step % 100 == 0 && !CheckStore(__LINE__, paths.GetPointer(), reference, removedIds))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+  if (reference.size() < 100 ||
+      !CheckStore(__LINE__, paths.GetPointer(), reference, removedIds))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Removals out of range leave the store as it is
+  paths->RemovePath(-1);
+  paths->RemovePath(paths->GetNumberOfPaths());
+  if (!CheckStore(__LINE__, paths.GetPointer(), reference, removedIds))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Oldest paths removed first, as a sliding window over the IDs
+  for (int step = 0; step < 3000; step ++)
+    {
+    ReferencePath path = reference[step % reference.size()];
+    path.Id = paths->AddPath(path.Name.c_str());
+    path.NodeID = "";
+    paths->SetTarget(paths->GetIndex(path.Id), path.TargetPointId, path.Target);
+    paths->SetEntry(paths->GetIndex(path.Id), path.EntryPointId, path.Entry);
+    reference.push_back(path);
+    removedIds.push_back(reference[0].Id);
+    reference.erase(reference.begin());
+    paths->RemovePath(0);
+    }
+  if (!CheckStore(__LINE__, paths.GetPointer(), reference, removedIds))
+    {
+    return EXIT_FAILURE;
+    }
+  lastId = paths->GetId(paths->GetNumberOfPaths() - 1);
+
+  // IDs are not reused after RemoveAllPaths()
+  for (size_t i = 0; i < reference.size(); i ++)
+    {
+    removedIds.push_back(reference[i].Id);
+    }
+  reference.clear();
+  paths->RemoveAllPaths();
+  if (!CheckStore(__LINE__, paths.GetPointer(), reference, removedIds))
+    {
+    return EXIT_FAILURE;
+    }
+  vtkIdType id = paths->AddPath("Path");
+  if (id <= lastId || paths->GetIndex(id) != 0 || paths->GetNumberOfPaths() != 1 ||
+      paths->GetTargetPointId(0) != -1 || paths->GetEntryPointId(0) != -1)
+    {
+    std::cerr << "Line " << __LINE__ << " - ID " << id << " after " << lastId << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
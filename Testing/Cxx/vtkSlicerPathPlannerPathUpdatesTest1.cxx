@@ -0,0 +1,318 @@
+/*==============================================================================
+
+  Program: Path Planner User Interface for 3D Slicer
+
+  Copyright (c) Brigham and Women's Hospital
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner includes
+#include "vtkSlicerPathPlannerExecutor.h"
+#include "vtkSlicerPathPlannerLogic.h"
+#include "vtkSlicerPathPlannerPathStore.h"
+#include "vtkSlicerPathPlannerPointStore.h"
+
+// VTK includes
+#include <vtkIdList.h>
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// Background updates of the paths of a moved point against the same
+// updates run synchronously: only the latest position of a point dragged
+// around is kept, and the results of the paths moved or removed since the
+// update was submitted, or of canceled updates, are dropped.
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+// Everything an evaluation computes for a path
+struct Evaluation
+{
+  double Length;
+  double InsertionAngle;
+  int NumberOfHits;
+  double Clearance;
+  double Cost;
+};
+
+//-----------------------------------------------------------------------------
+std::vector<Evaluation> GetEvaluations(vtkSlicerPathPlannerPathStore* paths)
+{
+  std::vector<Evaluation> evaluations(paths->GetNumberOfPaths());
+  for (vtkIdType i = 0; i < paths->GetNumberOfPaths(); i ++)
+    {
+    evaluations[i].Length = paths->GetLength(i);
+    evaluations[i].InsertionAngle = paths->GetInsertionAngle(i);
+    evaluations[i].NumberOfHits = paths->GetNumberOfHits(i);
+    evaluations[i].Clearance = paths->GetClearance(i);
+    evaluations[i].Cost = paths->GetCost(i);
+    }
+  return evaluations;
+}
+
+//-----------------------------------------------------------------------------
+// Check that the paths evaluated in the background are the same as the
+// ones evaluated synchronously after them
+bool CheckEvaluations(int line, const std::vector<Evaluation>& evaluations,
+                      const std::vector<Evaluation>& expected)
+{
+  if (evaluations.size() != expected.size())
+    {
+    std::cerr << "Line " << line << " - " << evaluations.size() << " paths, expected "
+              << expected.size() << std::endl;
+    return false;
+    }
+  for (size_t i = 0; i < expected.size(); i ++)
+    {
+    if (fabs(evaluations[i].Length - expected[i].Length) > 1e-9 ||
+        fabs(evaluations[i].InsertionAngle - expected[i].InsertionAngle) > 1e-9 ||
+        evaluations[i].NumberOfHits != expected[i].NumberOfHits ||
+        fabs(evaluations[i].Clearance - expected[i].Clearance) > 1e-9 ||
+        fabs(evaluations[i].Cost - expected[i].Cost) > 1e-9)
+      {
+      std::cerr << "Line " << line << " - path " << i << ": length " << evaluations[i].Length
+                << ", " << evaluations[i].NumberOfHits << " hits, cost " << evaluations[i].Cost
+                << "; expected " << expected[i].Length << ", " << expected[i].NumberOfHits
+                << " hits, cost " << expected[i].Cost << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+void CountUpdate(void* clientData)
+{
+  (*static_cast<std::atomic<int>*>(clientData)) ++;
+}
+
+//-----------------------------------------------------------------------------
+vtkIdType CountPathsOfEntryPoint(vtkSlicerPathPlannerPathStore* paths, vtkIdType pointId)
+{
+  vtkIdType nPaths = 0;
+  for (vtkIdType i = 0; i < paths->GetNumberOfPaths(); i ++)
+    {
+    nPaths += (paths->GetEntryPointId(i) == pointId) ? 1 : 0;
+    }
+  return nPaths;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int vtkSlicerPathPlannerPathUpdatesTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv) [] )
+{
+  vtkNew<vtkSlicerPathPlannerLogic> logic;
+  logic->GetExecutor()->SetNumberOfThreads(2);
+  std::atomic<int> nCallbacks(0);
+  logic->SetPathUpdateCallback(CountUpdate, &nCallbacks);
+
+  // Labelmap of 1 mm voxels with a block between the entry points and the
+  // target points, so that the updates walk the labelmap
+  const int size = 32;
+  vtkNew<vtkImageData> labelMap;
+  labelMap->SetDimensions(size, size, size);
+  labelMap->SetScalarTypeToUnsignedChar();
+  labelMap->SetNumberOfScalarComponents(1);
+  labelMap->AllocateScalars();
+  unsigned char* scalars = static_cast<unsigned char*>(labelMap->GetScalarPointer());
+  for (int k = 0; k < size; k ++)
+    {
+    for (int j = 0; j < size; j ++)
+      {
+      for (int i = 0; i < size; i ++)
+        {
+        scalars[(k * size + j) * size + i] =
+          (i >= 8 && i < 24 && j >= 8 && j < 24 && k >= 14 && k < 17) ? 1 : 0;
+        }
+      }
+    }
+  vtkNew<vtkMatrix4x4> rasToIJK;
+  logic->SetLabelMap(labelMap.GetPointer(), rasToIJK.GetPointer());
+
+  // Every entry x target path
+  vtkSlicerPathPlannerPointStore* entryPoints = logic->GetEntryPoints();
+  vtkSlicerPathPlannerPointStore* targetPoints = logic->GetTargetPoints();
+  vtkSlicerPathPlannerPathStore* paths = logic->GetPaths();
+  for (int i = 0; i < 6; i ++)
+    {
+    double position[3] = { 4.0 + 4.0 * i, 6.0 + 3.0 * i, 2.0 + i };
+    entryPoints->AddPoint(position, "Entry");
+    }
+  for (int i = 0; i < 3; i ++)
+    {
+    double position[3] = { 10.0 + 5.0 * i, 16.0, 24.0 + i };
+    targetPoints->AddPoint(position, "Target");
+    }
+  for (vtkIdType t = 0; t < targetPoints->GetNumberOfPoints(); t ++)
+    {
+    for (vtkIdType e = 0; e < entryPoints->GetNumberOfPoints(); e ++)
+      {
+      vtkIdType index = paths->GetIndex(paths->AddPath("Path"));
+      double position[3];
+      targetPoints->GetPosition(t, position);
+      paths->SetTarget(index, targetPoints->GetId(t), position);
+      entryPoints->GetPosition(e, position);
+      paths->SetEntry(index, entryPoints->GetId(e), position);
+      }
+    }
+  logic->UpdatePathGeometry();
+  vtkNew<vtkIdList> pathIndices;
+
+  // An entry point dragged around: only the paths at its latest position
+  // are updated, whatever the updates of the previous positions became
+  vtkIdType entryId = entryPoints->GetId(2);
+  vtkIdType nEntryPaths = CountPathsOfEntryPoint(paths, entryId);
+  for (int step = 0; step < 5; step ++)
+    {
+    double position[3] = { 6.0 + step, 9.0 + 2.0 * step, 3.0 };
+    entryPoints->SetPosition(entryPoints->GetIndex(entryId), position);
+    logic->UpdatePathsOfEntryPointAsync(entryId);
+    }
+  logic->GetExecutor()->Wait();
+  int nFinished = logic->GetNumberOfPendingPathUpdates();
+  if (nFinished < 1 || nFinished > 5 || nCallbacks.load() != nFinished)
+    {
+    std::cerr << "Line " << __LINE__ << " - " << nFinished << " updates finished, "
+              << nCallbacks.load() << " callbacks" << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkIdType nUpdated = logic->CollectPathUpdates(pathIndices.GetPointer());
+  if (nUpdated != nEntryPaths || pathIndices->GetNumberOfIds() != nEntryPaths ||
+      logic->GetNumberOfPendingPathUpdates() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - " << nUpdated << " paths updated, expected "
+              << nEntryPaths << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::vector<Evaluation> evaluations = GetEvaluations(paths);
+  logic->UpdatePathsOfEntryPoint(entryId);
+  if (!CheckEvaluations(__LINE__, evaluations, GetEvaluations(paths)))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // The results of a target point moved again since its update are dropped
+  vtkIdType targetId = targetPoints->GetId(1);
+  double targetPosition[3] = { 14.0, 18.0, 27.0 };
+  targetPoints->SetPosition(targetPoints->GetIndex(targetId), targetPosition);
+  logic->UpdatePathsOfTargetPointAsync(targetId);
+  logic->GetExecutor()->Wait();
+  targetPosition[2] += 1.0;
+  targetPoints->SetPosition(targetPoints->GetIndex(targetId), targetPosition);
+  logic->UpdateEndPointPositions();
+  if (logic->CollectPathUpdates(pathIndices.GetPointer()) != 0 ||
+      pathIndices->GetNumberOfIds() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - results of a moved point collected" << std::endl;
+    return EXIT_FAILURE;
+    }
+  logic->UpdatePathGeometry();
+
+  // The results of a removed path are dropped, the others still collected
+  entryId = entryPoints->GetId(4);
+  double entryPosition[3] = { 12.0, 20.0, 4.0 };
+  entryPoints->SetPosition(entryPoints->GetIndex(entryId), entryPosition);
+  logic->UpdatePathsOfEntryPointAsync(entryId);
+  logic->GetExecutor()->Wait();
+  for (vtkIdType i = 0; i < paths->GetNumberOfPaths(); i ++)
+    {
+    if (paths->GetEntryPointId(i) == entryId)
+      {
+      paths->RemovePath(i);
+      break;
+      }
+    }
+  nEntryPaths = CountPathsOfEntryPoint(paths, entryId);
+  nUpdated = logic->CollectPathUpdates(pathIndices.GetPointer());
+  for (vtkIdType k = 0; k < pathIndices->GetNumberOfIds(); k ++)
+    {
+    if (paths->GetEntryPointId(pathIndices->GetId(k)) != entryId)
+      {
+      nUpdated = -1;
+      }
+    }
+  if (nUpdated != nEntryPaths || pathIndices->GetNumberOfIds() != nEntryPaths)
+    {
+    std::cerr << "Line " << __LINE__ << " - " << nUpdated << " paths updated, expected "
+              << nEntryPaths << std::endl;
+    return EXIT_FAILURE;
+    }
+  evaluations = GetEvaluations(paths);
+  logic->UpdatePathsOfEntryPoint(entryId);
+  if (!CheckEvaluations(__LINE__, evaluations, GetEvaluations(paths)))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Updates of given paths; canceled updates leave nothing to collect
+  pathIndices->Reset();
+  pathIndices->InsertNextId(0);
+  pathIndices->InsertNextId(paths->GetNumberOfPaths() - 1);
+  logic->UpdatePathsAsync(pathIndices.GetPointer());
+  logic->UpdatePathsAsync(pathIndices.GetPointer());
+  logic->GetExecutor()->Wait();
+  if (logic->CollectPathUpdates(pathIndices.GetPointer()) != 4 ||
+      pathIndices->GetNumberOfIds() != 2)
+    {
+    std::cerr << "Line " << __LINE__ << " - two updates of two paths collected into "
+              << pathIndices->GetNumberOfIds() << " paths" << std::endl;
+    return EXIT_FAILURE;
+    }
+  logic->UpdatePathsOfTargetPointAsync(targetId);
+  logic->UpdatePathsAsync(pathIndices.GetPointer());
+  logic->CancelPathUpdates();
+  if (logic->GetNumberOfPendingPathUpdates() != 0 ||
+      logic->CollectPathUpdates(pathIndices.GetPointer()) != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - results of canceled updates collected" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Setting a limit or a weight to its value keeps the updates; changing it
+  // drops the updates evaluated with the previous value
+  logic->UpdatePathsOfTargetPointAsync(targetId);
+  logic->GetExecutor()->Wait();
+  logic->SetClearanceWeight(logic->GetClearanceWeight());
+  logic->SetReferenceDirection(logic->GetReferenceDirection());
+  if (logic->GetNumberOfPendingPathUpdates() != 1)
+    {
+    std::cerr << "Line " << __LINE__ << " - updates canceled by unchanged parameters" << std::endl;
+    return EXIT_FAILURE;
+    }
+  logic->SetLengthWeight(2.0 * logic->GetLengthWeight());
+  if (logic->GetNumberOfPendingPathUpdates() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - updates kept across a weight change" << std::endl;
+    return EXIT_FAILURE;
+    }
+  logic->UpdatePathsOfTargetPointAsync(targetId);
+  logic->SetMaximumInsertionAngle(60.0);
+  logic->SetReferenceDirection(0.0, 0.2, 1.0);
+  if (logic->GetNumberOfPendingPathUpdates() != 0 ||
+      logic->CollectPathUpdates(pathIndices.GetPointer()) != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - updates kept across a limit change" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,306 @@
+/*==============================================================================
+
+  Program: Path Planner User Interface for 3D Slicer
+
+  Copyright (c) Brigham and Women's Hospital
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner includes
+#include "vtkSlicerPathPlannerPointStore.h"
+
+// VTK includes
+#include <vtkIdList.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Points added, moved, renamed and removed (one by one or in batches) in a
+// pseudo-random order, against a plain list of the same points: the IDs
+// stay stable while the indices shift, the coordinate arrays follow, and
+// the lookups by ID, node ID and name find the points still in the store.
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+struct ReferencePoint
+{
+  vtkIdType Id;
+  double Position[3];
+  std::string Name;
+  std::string NodeID;
+};
+
+//-----------------------------------------------------------------------------
+// Deterministic pseudo-random numbers in [0, 1)
+double Random(unsigned int& seed)
+{
+  seed = seed * 1103515245u + 12345u;
+  return ((seed >> 8) & 0xFFFF) / 65536.0;
+}
+
+//-----------------------------------------------------------------------------
+bool CheckStore(int line, vtkSlicerPathPlannerPointStore* points,
+                const std::vector<ReferencePoint>& reference,
+                const std::vector<vtkIdType>& removedIds)
+{
+  vtkIdType n = static_cast<vtkIdType>(reference.size());
+  if (points->GetNumberOfPoints() != n)
+    {
+    std::cerr << "Line " << line << " - " << points->GetNumberOfPoints()
+              << " points, expected " << n << std::endl;
+    return false;
+    }
+  const double* r = points->GetR();
+  const double* a = points->GetA();
+  const double* s = points->GetS();
+  for (vtkIdType i = 0; i < n; i ++)
+    {
+    const ReferencePoint& point = reference[i];
+    double position[3];
+    points->GetPosition(i, position);
+    bool same = points->GetId(i) == point.Id && points->GetIndex(point.Id) == i &&
+      point.Name == points->GetName(i) && point.NodeID == points->GetNodeID(i) &&
+      r[i] == point.Position[0] && a[i] == point.Position[1] && s[i] == point.Position[2];
+    for (int j = 0; j < 3; j ++)
+      {
+      same = same && position[j] == point.Position[j];
+      }
+    // Node IDs are unique; names are not, the first one is found
+    vtkIdType nodeIndex = points->FindIndexByNodeID(point.NodeID.c_str());
+    vtkIdType firstIndex = 0;
+    while (reference[firstIndex].Name != point.Name)
+      {
+      firstIndex ++;
+      }
+    vtkIdType nameIndex = points->FindIndexByName(point.Name.c_str());
+    same = same && nodeIndex == (point.NodeID.empty() ? -1 : i) && nameIndex == firstIndex;
+    if (!same)
+      {
+      std::cerr << "Line " << line << " - point " << i << ": ID " << points->GetId(i)
+                << ", expected " << point.Id << ", index of the ID "
+                << points->GetIndex(point.Id) << ", name " << points->GetName(i)
+                << " at index " << nameIndex << ", node ID " << points->GetNodeID(i)
+                << " at index " << nodeIndex << std::endl;
+      return false;
+      }
+    }
+  for (size_t i = 0; i < removedIds.size(); i ++)
+    {
+    if (points->GetIndex(removedIds[i]) != -1)
+      {
+      std::cerr << "Line " << line << " - removed ID " << removedIds[i] << " at index "
+                << points->GetIndex(removedIds[i]) << std::endl;
+      return false;
+      }
+    }
+  if (points->GetId(-1) != -1 || points->GetId(n) != -1 ||
+      points->FindIndexByNodeID("") != -1 || points->FindIndexByNodeID(0) != -1 ||
+      points->FindIndexByNodeID("vtkMRMLAnnotationFiducialNodeNone") != -1)
+    {
+    std::cerr << "Line " << line << " - lookups out of the store" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int vtkSlicerPathPlannerPointStoreTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv) [] )
+{
+  vtkNew<vtkSlicerPathPlannerPointStore> points;
+  std::vector<ReferencePoint> reference;
+  std::vector<vtkIdType> removedIds;
+  if (!CheckStore(__LINE__, points.GetPointer(), reference, removedIds))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Mostly additions, so that the store grows to a few hundred points.
+  // Every other point is backed by a node; names repeat.
+  unsigned int seed = 7;
+  int nNodes = 0;
+  vtkIdType lastId = -1;
+  for (int step = 0; step < 2000; step ++)
+    {
+    double choice = Random(seed);
+    vtkIdType n = static_cast<vtkIdType>(reference.size());
+    vtkIdType index = static_cast<vtkIdType>(Random(seed) * n);
+    unsigned long mtime = points->GetMTime();
+    if (choice < 0.6 || n == 0)
+      {
+      ReferencePoint point;
+      for (int j = 0; j < 3; j ++)
+        {
+        point.Position[j] = 200.0 * Random(seed) - 100.0;
+        }
+      std::ostringstream name;
+      name << "F-" << step % 50;
+      point.Name = name.str();
+      if (step % 2 == 0)
+        {
+        std::ostringstream nodeID;
+        nodeID << "vtkMRMLAnnotationFiducialNode" << nNodes ++;
+        point.NodeID = nodeID.str();
+        }
+      point.Id = points->AddPoint(point.Position, point.Name.c_str(),
+                                  point.NodeID.empty() ? 0 : point.NodeID.c_str());
+      if (point.Id <= lastId)
+        {
+        std::cerr << "Line " << __LINE__ << " - ID " << point.Id << " after " << lastId
+                  << std::endl;
+        return EXIT_FAILURE;
+        }
+      lastId = point.Id;
+      reference.push_back(point);
+      }
+    else if (choice < 0.72)
+      {
+      removedIds.push_back(reference[index].Id);
+      reference.erase(reference.begin() + index);
+      points->RemovePoint(index);
+      }
+    else if (choice < 0.8)
+      {
+      // A few indices in any order, repeated or out of range
+      vtkNew<vtkIdList> indices;
+      std::vector<vtkIdType> sorted;
+      int nIndices = 1 + static_cast<int>(6 * Random(seed));
+      for (int k = 0; k < nIndices; k ++)
+        {
+        vtkIdType removed = static_cast<vtkIdType>(Random(seed) * (n + 2)) - 1;
+        indices->InsertNextId(removed);
+        indices->InsertNextId(removed);
+        if (removed >= 0 && removed < n)
+          {
+          sorted.push_back(removed);
+          }
+        }
+      std::sort(sorted.begin(), sorted.end());
+      sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+      for (size_t k = sorted.size(); k > 0; k --)
+        {
+        removedIds.push_back(reference[sorted[k - 1]].Id);
+        reference.erase(reference.begin() + sorted[k - 1]);
+        }
+      points->RemovePoints(indices.GetPointer());
+      if (sorted.empty())
+        {
+        // nothing to remove: touch the store for the check below
+        points->Modified();
+        }
+      }
+    else if (choice < 0.95)
+      {
+      double* position = reference[index].Position;
+      position[static_cast<int>(3 * Random(seed))] += 1.0;
+      points->SetPosition(index, position);
+      }
+    else
+      {
+      reference[index].Name += "'";
+      points->SetName(index, reference[index].Name.c_str());
+      }
+    if (points->GetMTime() <= mtime)
+      {
+      std::cerr << "Line " << __LINE__ << " - store not modified at step " << step << std::endl;
+      return EXIT_FAILURE;
+      }
+    if (step % 100 == 0 && !CheckStore(__LINE__, points.GetPointer(), reference, removedIds))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+  if (reference.size() < 100 ||
+      !CheckStore(__LINE__, points.GetPointer(), reference, removedIds))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Changes to the same values and removals out of range leave the store
+  // as it is
+  unsigned long mtime = points->GetMTime();
+  points->SetPosition(0, reference[0].Position);
+  points->SetName(0, reference[0].Name.c_str());
+  points->RemovePoint(-1);
+  points->RemovePoint(points->GetNumberOfPoints());
+  if (points->GetMTime() != mtime ||
+      !CheckStore(__LINE__, points.GetPointer(), reference, removedIds))
+    {
+    std::cerr << "Line " << __LINE__ << " - store modified by no-op changes" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Oldest points removed first, as a sliding window over the IDs; a copy
+  // has the same lookups
+  for (int step = 0; step < 3000; step ++)
+    {
+    ReferencePoint point = reference[step % reference.size()];
+    std::ostringstream nodeID;
+    nodeID << "vtkMRMLAnnotationFiducialNode" << nNodes ++;
+    point.NodeID = nodeID.str();
+    point.Id = points->AddPoint(point.Position, point.Name.c_str(), point.NodeID.c_str());
+    reference.push_back(point);
+    removedIds.push_back(reference[0].Id);
+    reference.erase(reference.begin());
+    points->RemovePoint(0);
+    }
+  vtkNew<vtkSlicerPathPlannerPointStore> copy;
+  copy->DeepCopy(points.GetPointer());
+  if (!CheckStore(__LINE__, points.GetPointer(), reference, removedIds) ||
+      !CheckStore(__LINE__, copy.GetPointer(), reference, removedIds))
+    {
+    return EXIT_FAILURE;
+    }
+  lastId = points->GetId(points->GetNumberOfPoints() - 1);
+
+  // A node backing two points: the first one is found, then the other
+  const double origin[3] = { 0.0, 0.0, 0.0 };
+  const char* sharedNodeID = reference[1].NodeID.c_str();
+  vtkIdType sharedId = copy->AddPoint(origin, "Shared", sharedNodeID);
+  vtkIdType firstIndex = copy->FindIndexByNodeID(sharedNodeID);
+  copy->RemovePoint(1);
+  if (firstIndex != 1 || copy->FindIndexByNodeID(sharedNodeID) != copy->GetIndex(sharedId))
+    {
+    std::cerr << "Line " << __LINE__ << " - node of two points found at " << firstIndex
+              << ", then at " << copy->FindIndexByNodeID(sharedNodeID) << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // IDs are not reused after RemoveAllPoints()
+  for (size_t i = 0; i < reference.size(); i ++)
+    {
+    removedIds.push_back(reference[i].Id);
+    }
+  reference.clear();
+  points->RemoveAllPoints();
+  if (!CheckStore(__LINE__, points.GetPointer(), reference, removedIds))
+    {
+    return EXIT_FAILURE;
+    }
+  vtkIdType id = points->AddPoint(origin, "Origin");
+  if (id <= lastId || points->GetIndex(id) != 0 || points->GetNumberOfPoints() != 1)
+    {
+    std::cerr << "Line " << __LINE__ << " - ID " << id << " after " << lastId << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
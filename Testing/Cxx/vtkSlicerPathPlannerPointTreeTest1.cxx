@@ -0,0 +1,195 @@
+/*==============================================================================
+
+  Program: Path Planner User Interface for 3D Slicer
+
+  Copyright (c) Brigham and Women's Hospital
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner includes
+#include "vtkSlicerPathPlannerPointStore.h"
+#include "vtkSlicerPathPlannerPointTree.h"
+
+// VTK includes
+#include <vtkIdList.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include <vector>
+
+// Closest points and points within a radius of the k-d tree against a linear
+// scan of the store. Half of the points are on an integer grid, so that many
+// of them are at the same distance of the queries: the results are compared
+// by distance, ties being returned in any order.
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+// Deterministic pseudo-random numbers in [0, 1)
+double Random(unsigned int& seed)
+{
+  seed = seed * 1103515245u + 12345u;
+  return ((seed >> 8) & 0xFFFF) / 65536.0;
+}
+
+//-----------------------------------------------------------------------------
+double Distance2(vtkSlicerPathPlannerPointStore* points, vtkIdType index,
+                 const double position[3])
+{
+  double p[3];
+  points->GetPosition(index, p);
+  return (p[0] - position[0]) * (p[0] - position[0]) +
+    (p[1] - position[1]) * (p[1] - position[1]) +
+    (p[2] - position[2]) * (p[2] - position[2]);
+}
+
+//-----------------------------------------------------------------------------
+// The IDs are distinct points of the store, in the order of expectedDistances2
+bool CheckIds(int line, const char* name, vtkSlicerPathPlannerPointStore* points,
+              const double position[3], vtkIdList* pointIds,
+              const std::vector<double>& expectedDistances2)
+{
+  if (pointIds->GetNumberOfIds() != static_cast<vtkIdType>(expectedDistances2.size()))
+    {
+    std::cerr << "Line " << line << " - " << name << ": " << pointIds->GetNumberOfIds()
+              << " points, expected " << expectedDistances2.size() << std::endl;
+    return false;
+    }
+  std::set<vtkIdType> ids;
+  for (vtkIdType i = 0; i < pointIds->GetNumberOfIds(); i ++)
+    {
+    vtkIdType index = points->GetIndex(pointIds->GetId(i));
+    if (index < 0 || !ids.insert(pointIds->GetId(i)).second ||
+        Distance2(points, index, position) != expectedDistances2[i])
+      {
+      std::cerr << "Line " << line << " - " << name << ": point " << i << " of ID "
+                << pointIds->GetId(i) << " at index " << index << ", expected at "
+                << "squared distance " << expectedDistances2[i] << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int vtkSlicerPathPlannerPointTreeTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv) [] )
+{
+  vtkNew<vtkSlicerPathPlannerPointStore> points;
+  vtkNew<vtkSlicerPathPlannerPointTree> tree;
+  tree->SetPoints(points.GetPointer());
+  vtkNew<vtkIdList> pointIds;
+
+  // Empty store: no result
+  const double origin[3] = { 0.0, 0.0, 0.0 };
+  tree->Update();
+  tree->FindClosestPoints(origin, 5, pointIds.GetPointer());
+  if (tree->GetNumberOfPoints() != 0 || pointIds->GetNumberOfIds() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - " << pointIds->GetNumberOfIds()
+              << " points in an empty store" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  const int nPoints = 2000;
+  const double size = 10.0;
+  unsigned int seed = 7;
+  std::vector<double> positions(3 * nPoints);
+  for (int i = 0; i < nPoints; i ++)
+    {
+    for (int axis = 0; axis < 3; axis ++)
+      {
+      double value = size * Random(seed);
+      positions[3 * i + axis] = (i % 2) ? value : static_cast<int>(value);
+      }
+    }
+  points->AddPoints(nPoints, &positions[0], 0, "Point");
+
+  // Removed points are not found, and the IDs of the others are kept
+  for (vtkIdType index = nPoints - 1; index >= 0; index -= 97)
+    {
+    points->RemovePoint(index);
+    }
+  tree->Update();
+  vtkIdType nStored = points->GetNumberOfPoints();
+  if (tree->GetNumberOfPoints() != nStored)
+    {
+    std::cerr << "Line " << __LINE__ << " - " << tree->GetNumberOfPoints()
+              << " points in the tree, expected " << nStored << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Queries inside the points, on the grid, and away from them
+  const int nQueries = 50;
+  for (int q = 0; q < nQueries; q ++)
+    {
+    double position[3];
+    for (int axis = 0; axis < 3; axis ++)
+      {
+      position[axis] = 3.0 * size * Random(seed) - size;
+      }
+    if (q % 5 == 0)
+      {
+      position[0] = static_cast<int>(0.5 * size);
+      position[1] = static_cast<int>(0.5 * size);
+      position[2] = static_cast<int>(0.5 * size);
+      }
+
+    std::vector<double> distances2(nStored);
+    for (vtkIdType i = 0; i < nStored; i ++)
+      {
+      distances2[i] = Distance2(points.GetPointer(), i, position);
+      }
+    std::sort(distances2.begin(), distances2.end());
+
+    // k nearest, including more than there are points
+    const int counts[] = { 1, 7, 64, nPoints + 1 };
+    for (int c = 0; c < static_cast<int>(sizeof(counts) / sizeof(counts[0])); c ++)
+      {
+      tree->FindClosestPoints(position, counts[c], pointIds.GetPointer());
+      std::vector<double> expected(distances2.begin(),
+        distances2.begin() + std::min<vtkIdType>(counts[c], nStored));
+      if (!CheckIds(__LINE__, "closest points", points.GetPointer(), position,
+                    pointIds.GetPointer(), expected))
+        {
+        std::cerr << "Line " << __LINE__ << " - query " << q << ", "
+                  << counts[c] << " points" << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+
+    // within a radius, bounds included: the radius of a grid query is the
+    // distance of grid points
+    const double radii[] = { 0.0, 1.0, 2.5, 6.0 };
+    for (int r = 0; r < static_cast<int>(sizeof(radii) / sizeof(radii[0])); r ++)
+      {
+      tree->FindPointsWithinRadius(position, radii[r], pointIds.GetPointer());
+      std::vector<double> expected(distances2.begin(),
+        std::upper_bound(distances2.begin(), distances2.end(), radii[r] * radii[r]));
+      if (!CheckIds(__LINE__, "points within radius", points.GetPointer(), position,
+                    pointIds.GetPointer(), expected))
+        {
+        std::cerr << "Line " << __LINE__ << " - query " << q << ", radius "
+                  << radii[r] << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
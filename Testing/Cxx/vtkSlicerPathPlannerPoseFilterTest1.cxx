@@ -0,0 +1,195 @@
+/*==============================================================================
+
+  Program: Path Planner User Interface for 3D Slicer
+
+  Copyright (c) Brigham and Women's Hospital
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner includes
+#include "vtkSlicerPathPlannerPoseFilter.h"
+
+// VTK includes
+#include <vtkMath.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+// Sanity of the latency compensation on noise-free motions: a needle moving
+// at constant velocity is predicted ahead of its latest sample, the
+// predicted rotation stays orthonormal, and the filter passes the latest
+// sample when it is disabled or restarts after a gap.
+
+namespace
+{
+
+const double Velocity[3] = { 20.0, -5.0, 10.0 };
+const double AngularVelocity = 0.5;
+
+//-----------------------------------------------------------------------------
+// Pose at time t: translation at constant velocity from (10, 20, 30), and
+// rotation about S at constant angular velocity
+void Pose(double t, double matrix[16])
+{
+  double angle = 0.3 + AngularVelocity * t;
+  const double rows[16] = {
+    cos(angle), -sin(angle), 0.0, 10.0 + Velocity[0] * t,
+    sin(angle), cos(angle), 0.0, 20.0 + Velocity[1] * t,
+    0.0, 0.0, 1.0, 30.0 + Velocity[2] * t,
+    0.0, 0.0, 0.0, 1.0
+    };
+  for (int e = 0; e < 16; e ++)
+    {
+    matrix[e] = rows[e];
+    }
+}
+
+//-----------------------------------------------------------------------------
+double TranslationError(const double a[16], const double b[16])
+{
+  double d[3] = { a[3] - b[3], a[7] - b[7], a[11] - b[11] };
+  return vtkMath::Norm(d);
+}
+
+//-----------------------------------------------------------------------------
+// Largest element of R^T R - I
+double OrthonormalityError(const double matrix[16])
+{
+  double error = 0.0;
+  for (int i = 0; i < 3; i ++)
+    {
+    for (int j = 0; j < 3; j ++)
+      {
+      double dot = 0.0;
+      for (int k = 0; k < 3; k ++)
+        {
+        dot += matrix[4 * k + i] * matrix[4 * k + j];
+        }
+      error = std::max(error, fabs(dot - (i == j ? 1.0 : 0.0)));
+      }
+    }
+  return error;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int vtkSlicerPathPlannerPoseFilterTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv) [] )
+{
+  vtkNew<vtkSlicerPathPlannerPoseFilter> filter;
+  double matrix[16];
+  matrix[0] = 12.0;
+  if (filter->Predict(0.0, matrix) || matrix[0] != 12.0 || filter->GetLastTime() != -1.0)
+    {
+    std::cerr << "Line " << __LINE__ << " - prediction without sample" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Two seconds of samples at 100 Hz, predicted 50 ms ahead
+  const double latency = 0.05;
+  const double period = 0.01;
+  filter->SetLatency(latency);
+  double sample[16];
+  double time = 0.0;
+  for (int i = 0; i <= 200; i ++)
+    {
+    time = 1.0 + i * period;
+    Pose(time, sample);
+    filter->AddSample(time, sample);
+    }
+  double expected[16];
+  Pose(time + latency, expected);
+  if (!filter->Predict(time, matrix) || filter->GetLastTime() != time)
+    {
+    std::cerr << "Line " << __LINE__ << " - no prediction" << std::endl;
+    return EXIT_FAILURE;
+    }
+  // The latest sample lags by the speed times the latency
+  double lag = TranslationError(sample, expected);
+  double error = TranslationError(matrix, expected);
+  if (error > 0.05 * lag)
+    {
+    std::cerr << "Line " << __LINE__ << " - predicted translation off by " << error
+              << " mm, the latest sample by " << lag << " mm" << std::endl;
+    return EXIT_FAILURE;
+    }
+  double angle = atan2(matrix[4], matrix[0]);
+  double expectedAngle = atan2(expected[4], expected[0]);
+  if (fabs(angle - expectedAngle) > 0.05 * AngularVelocity * latency ||
+      OrthonormalityError(matrix) > 1e-12 || matrix[12] != 0.0 || matrix[15] != 1.0)
+    {
+    std::cerr << "Line " << __LINE__ << " - predicted rotation of " << angle
+              << " rad, expected " << expectedAngle << ", orthonormality error "
+              << OrthonormalityError(matrix) << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Samples older than the latest one are ignored
+  double old[16];
+  Pose(0.0, old);
+  filter->AddSample(time - 0.5 * period, old);
+  double again[16];
+  filter->Predict(time, again);
+  for (int e = 0; e < 16; e ++)
+    {
+    if (again[e] != matrix[e] || filter->GetLastTime() != time)
+      {
+      std::cerr << "Line " << __LINE__ << " - older sample changed element " << e
+                << " to " << again[e] << " from " << matrix[e] << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // After a gap longer than MaximumGap, the filter restarts from the new
+  // sample, at rest
+  time += 2.0 * filter->GetMaximumGap();
+  Pose(time, sample);
+  filter->AddSample(time, sample);
+  filter->Predict(time, matrix);
+  if (TranslationError(matrix, sample) > 1e-12 || filter->GetLastTime() != time)
+    {
+    std::cerr << "Line " << __LINE__ << " - restart off by "
+              << TranslationError(matrix, sample) << " mm" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Disabled, it returns the latest sample
+  filter->EnabledOff();
+  for (int i = 1; i <= 10; i ++)
+    {
+    Pose(time + i * period, sample);
+    filter->AddSample(time + i * period, sample);
+    }
+  filter->Predict(time + 10 * period, matrix);
+  for (int e = 0; e < 16; e ++)
+    {
+    if (fabs(matrix[e] - sample[e]) > 1e-12)
+      {
+      std::cerr << "Line " << __LINE__ << " - disabled filter: element " << e << " is "
+                << matrix[e] << ", latest sample " << sample[e] << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  filter->Reset();
+  if (filter->Predict(time, matrix) || filter->GetLastTime() != -1.0)
+    {
+    std::cerr << "Line " << __LINE__ << " - prediction after Reset()" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,177 @@
+/*==============================================================================
+
+  Program: Path Planner User Interface for 3D Slicer
+
+  Copyright (c) Brigham and Women's Hospital
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner includes
+#include "vtkSlicerPathPlannerLogic.h"
+#include "vtkSlicerPathPlannerPathStore.h"
+#include "vtkSlicerPathPlannerPointStore.h"
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkIdList.h>
+#include <vtkImageData.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+// The cheapest paths of each target kept by RankPaths() against a full sort
+// of the costs of every feasible path (GenerateAllPaths()), through a
+// labelmap so that the pruned candidates include crossings and clearances.
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+// Deterministic pseudo-random numbers in [0, 1)
+double Random(unsigned int& seed)
+{
+  seed = seed * 1103515245u + 12345u;
+  return ((seed >> 8) & 0xFFFF) / 65536.0;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int vtkSlicerPathPlannerRankPathsTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv) [] )
+{
+  vtkNew<vtkSlicerPathPlannerLogic> logic;
+  logic->SetMaximumPathLength(30.0);
+  logic->SetMaximumInsertionAngle(70.0);
+
+  // Labelmap of 1 mm voxels with a block between the entry points, below,
+  // and the target points, above
+  const int size = 32;
+  vtkNew<vtkImageData> labelMap;
+  labelMap->SetDimensions(size, size, size);
+  labelMap->SetScalarTypeToUnsignedChar();
+  labelMap->SetNumberOfScalarComponents(1);
+  labelMap->AllocateScalars();
+  unsigned char* scalars = static_cast<unsigned char*>(labelMap->GetScalarPointer());
+  for (int k = 0; k < size; k ++)
+    {
+    for (int j = 0; j < size; j ++)
+      {
+      for (int i = 0; i < size; i ++)
+        {
+        scalars[(k * size + j) * size + i] =
+          (i >= 10 && i < 20 && j >= 12 && j < 22 && k >= 14 && k < 17) ? 1 : 0;
+        }
+      }
+    }
+  vtkNew<vtkMatrix4x4> rasToIJK;
+  logic->SetLabelMap(labelMap.GetPointer(), rasToIJK.GetPointer());
+
+  unsigned int seed = 3;
+  const int nEntries = 60;
+  const int nTargets = 5;
+  for (int i = 0; i < nEntries; i ++)
+    {
+    double position[3] = { 31.0 * Random(seed), 31.0 * Random(seed), 11.0 * Random(seed) };
+    logic->GetEntryPoints()->AddPoint(position, "Entry");
+    }
+  for (int i = 0; i < nTargets; i ++)
+    {
+    double position[3] = { 8.0 + 16.0 * Random(seed), 8.0 + 16.0 * Random(seed),
+                           20.0 + 8.0 * Random(seed) };
+    logic->GetTargetPoints()->AddPoint(position, "Target");
+    }
+  // A target out of reach of every entry point
+  const double farTarget[3] = { 15.0, 15.0, 80.0 };
+  logic->GetTargetPoints()->AddPoint(farTarget, "Far");
+
+  // Costs of every feasible path, by target
+  logic->GenerateAllPaths();
+  vtkSlicerPathPlannerPathStore* paths = logic->GetPaths();
+  vtkSlicerPathPlannerPointStore* targets = logic->GetTargetPoints();
+  std::vector<std::vector<std::pair<double, vtkIdType> > > sorted(targets->GetNumberOfPoints());
+  for (vtkIdType i = 0; i < paths->GetNumberOfPaths(); i ++)
+    {
+    vtkIdType target = targets->GetIndex(paths->GetTargetPointId(i));
+    sorted[target].push_back(std::make_pair(paths->GetCost(i), paths->GetEntryPointId(i)));
+    }
+  int nCrossing = 0;
+  for (size_t t = 0; t < sorted.size(); t ++)
+    {
+    std::sort(sorted[t].begin(), sorted[t].end());
+    for (size_t k = 0; k < sorted[t].size(); k ++)
+      {
+      nCrossing += (sorted[t][k].first >= logic->GetCrossingWeight()) ? 1 : 0;
+      }
+    }
+  if (nCrossing == 0 || !sorted.back().empty())
+    {
+    std::cerr << "Line " << __LINE__ << " - " << nCrossing << " paths crossing the block, "
+              << sorted.back().size() << " paths to the far target" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  vtkNew<vtkIdList> targetPointIds;
+  vtkNew<vtkIdList> entryPointIds;
+  vtkNew<vtkDoubleArray> costs;
+  const int counts[] = { 1, 4, 25, nEntries + 1 };
+  for (int c = 0; c < static_cast<int>(sizeof(counts) / sizeof(counts[0])); c ++)
+    {
+    vtkIdType nPaths = logic->RankPaths(counts[c], targetPointIds.GetPointer(),
+                                        entryPointIds.GetPointer(), costs.GetPointer());
+    vtkIdType expectedPaths = 0;
+    vtkIdType path = 0;
+    for (size_t t = 0; t < sorted.size(); t ++)
+      {
+      size_t nKept = std::min(sorted[t].size(), static_cast<size_t>(counts[c]));
+      expectedPaths += static_cast<vtkIdType>(nKept);
+      for (size_t k = 0; k < nKept && path < nPaths; k ++, path ++)
+        {
+        if (targetPointIds->GetId(path) != targets->GetId(static_cast<vtkIdType>(t)) ||
+            entryPointIds->GetId(path) != sorted[t][k].second ||
+            fabs(costs->GetValue(path) - sorted[t][k].first) > 1e-9)
+          {
+          std::cerr << "Line " << __LINE__ << " - " << counts[c] << " paths per target, path "
+                    << path << ": target " << targetPointIds->GetId(path) << ", entry "
+                    << entryPointIds->GetId(path) << ", cost " << costs->GetValue(path)
+                    << ", expected target " << targets->GetId(static_cast<vtkIdType>(t))
+                    << ", entry " << sorted[t][k].second << ", cost " << sorted[t][k].first
+                    << std::endl;
+          return EXIT_FAILURE;
+          }
+        }
+      }
+    if (nPaths != expectedPaths || targetPointIds->GetNumberOfIds() != nPaths ||
+        entryPointIds->GetNumberOfIds() != nPaths || costs->GetNumberOfTuples() != nPaths)
+      {
+      std::cerr << "Line " << __LINE__ << " - " << counts[c] << " paths per target: "
+                << nPaths << " paths, expected " << expectedPaths << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // Nothing to keep
+  if (logic->RankPaths(0, targetPointIds.GetPointer(), entryPointIds.GetPointer()) != 0 ||
+      targetPointIds->GetNumberOfIds() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - paths ranked for 0 paths per target" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,333 @@
+/*==============================================================================
+
+  Program: Path Planner User Interface for 3D Slicer
+
+  Copyright (c) Brigham and Women's Hospital
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner includes
+#include "vtkSlicerPathPlannerLogic.h"
+#include "vtkSlicerPathPlannerPointStore.h"
+#include "vtkSlicerPathPlannerSkinSampler.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <vector>
+
+// Samples of the faces of a cube, wound outwards or inwards and given as
+// polygons and triangle strips, and of the skin of a ball with an inner
+// cavity: the samples lie on the skin, about spacing apart, with outward
+// unit normals, and the same input gives the same samples.
+
+namespace
+{
+
+const double CubeSize = 20.0;
+const double BallCenter[3] = { 20.0, 20.0, 20.0 };
+const double BallRadius = 12.0;
+const double CavityRadius = 4.0;
+
+//-----------------------------------------------------------------------------
+// Cube [0, CubeSize]^3 made of one quad per face, wound so that the normals
+// point outwards, or inwards if inwards is true. The faces normal to S are
+// triangle strips.
+void MakeCube(vtkPolyData* cube, vtkPoints* points, vtkCellArray* polys,
+              vtkCellArray* strips, bool inwards)
+{
+  for (int corner = 0; corner < 8; corner ++)
+    {
+    points->InsertNextPoint(CubeSize * (corner & 1), CubeSize * ((corner >> 1) & 1),
+                            CubeSize * ((corner >> 2) & 1));
+    }
+  for (int axis = 0; axis < 3; axis ++)
+    {
+    int u = (axis + 1) % 3;
+    int v = (axis + 2) % 3;
+    for (int side = 0; side < 2; side ++)
+      {
+      // Counterclockwise in (u, v) turns around +axis
+      const int square[4][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+      vtkIdType quad[4];
+      for (int k = 0; k < 4; k ++)
+        {
+        quad[k] = (side << axis) | (square[k][0] << u) | (square[k][1] << v);
+        }
+      if ((side == 0) != inwards)
+        {
+        std::swap(quad[1], quad[3]);
+        }
+      if (axis == 2)
+        {
+        const vtkIdType strip[4] = { quad[0], quad[1], quad[3], quad[2] };
+        strips->InsertNextCell(4, strip);
+        }
+      else
+        {
+        polys->InsertNextCell(4, quad);
+        }
+      }
+    }
+  cube->SetPoints(points);
+  cube->SetPolys(polys);
+  cube->SetStrips(strips);
+}
+
+//-----------------------------------------------------------------------------
+// Check that the samples lie on the faces of the cube, with the outward
+// unit normal of their face, and that each face gets its share
+bool CheckCubeSamples(int line, const std::vector<double>& positions,
+                      const std::vector<double>& normals, double spacing)
+{
+  vtkIdType nSamples = static_cast<vtkIdType>(positions.size() / 3);
+  vtkIdType expectedSamples = static_cast<vtkIdType>(6.0 * CubeSize * CubeSize /
+                                                     (spacing * spacing));
+  if (nSamples != expectedSamples || normals.size() != positions.size())
+    {
+    std::cerr << "Line " << line << " - " << nSamples << " samples, expected "
+              << expectedSamples << std::endl;
+    return false;
+    }
+  int faceSamples[6] = { 0, 0, 0, 0, 0, 0 };
+  for (vtkIdType i = 0; i < nSamples; i ++)
+    {
+    const double* position = &positions[3 * i];
+    const double* normal = &normals[3 * i];
+    int axis = 0;
+    for (int j = 1; j < 3; j ++)
+      {
+      axis = (fabs(normal[j]) > fabs(normal[axis])) ? j : axis;
+      }
+    int side = (normal[axis] > 0.0) ? 1 : 0;
+    bool onFace = fabs(vtkMath::Norm(normal) - 1.0) < 1e-12 &&
+      fabs(fabs(normal[axis]) - 1.0) < 1e-12 &&
+      fabs(position[axis] - side * CubeSize) < 1e-9;
+    for (int j = 0; j < 3; j ++)
+      {
+      onFace = onFace && position[j] >= -1e-9 && position[j] <= CubeSize + 1e-9;
+      }
+    if (!onFace)
+      {
+      std::cerr << "Line " << line << " - sample " << i << " at (" << position[0] << ", "
+                << position[1] << ", " << position[2] << ") with normal (" << normal[0]
+                << ", " << normal[1] << ", " << normal[2] << ")" << std::endl;
+      return false;
+      }
+    faceSamples[2 * axis + side] ++;
+    }
+  // The samples of a face are the multiples of spacing^2 its area crosses
+  int share = static_cast<int>(CubeSize * CubeSize / (spacing * spacing));
+  for (int face = 0; face < 6; face ++)
+    {
+    if (faceSamples[face] < share || faceSamples[face] > share + 1)
+      {
+      std::cerr << "Line " << line << " - " << faceSamples[face] << " samples on face "
+                << face << ", expected " << share << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+// Ball of BallRadius voxels around BallCenter with a cavity of CavityRadius
+// voxels, on a 1 mm grid
+void MakeBall(vtkImageData* volume)
+{
+  const int size = 40;
+  volume->SetDimensions(size, size, size);
+  volume->SetScalarTypeToUnsignedChar();
+  volume->SetNumberOfScalarComponents(1);
+  volume->AllocateScalars();
+  unsigned char* scalars = static_cast<unsigned char*>(volume->GetScalarPointer());
+  for (int k = 0; k < size; k ++)
+    {
+    for (int j = 0; j < size; j ++)
+      {
+      for (int i = 0; i < size; i ++)
+        {
+        double voxel[3] = { static_cast<double>(i), static_cast<double>(j),
+                            static_cast<double>(k) };
+        double distance = sqrt(vtkMath::Distance2BetweenPoints(voxel, BallCenter));
+        scalars[(k * size + j) * size + i] =
+          (distance <= BallRadius && distance > CavityRadius) ? 100 : 0;
+        }
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Check that the samples lie on the outer skin of the ball translated by
+// offset, at most one per cell of spacing voxels, with outward unit normals
+bool CheckBallSamples(int line, const std::vector<double>& positions,
+                      const std::vector<double>& normals, const double offset[3],
+                      double spacing)
+{
+  vtkIdType nSamples = static_cast<vtkIdType>(positions.size() / 3);
+  double area = 4.0 * vtkMath::Pi() * BallRadius * BallRadius;
+  if (normals.size() != positions.size() || nSamples < 0.5 * area / (spacing * spacing) ||
+      nSamples > 3.0 * area / (spacing * spacing))
+    {
+    std::cerr << "Line " << line << " - " << nSamples << " samples on a skin of "
+              << area << " mm2" << std::endl;
+    return false;
+    }
+  std::set<int> cells;
+  for (vtkIdType i = 0; i < nSamples; i ++)
+    {
+    double voxel[3];
+    double radial[3];
+    for (int j = 0; j < 3; j ++)
+      {
+      voxel[j] = positions[3 * i + j] - offset[j];
+      radial[j] = voxel[j] - BallCenter[j];
+      }
+    double distance = vtkMath::Normalize(radial);
+    const double* normal = &normals[3 * i];
+    int cell = 0;
+    for (int j = 2; j >= 0; j --)
+      {
+      cell = cell * 100 + static_cast<int>(voxel[j] / spacing);
+      }
+    if (distance < BallRadius - 1.5 || distance > BallRadius + 0.5 ||
+        fabs(vtkMath::Norm(normal) - 1.0) > 1e-9 || vtkMath::Dot(normal, radial) < 0.8 ||
+        !cells.insert(cell).second)
+      {
+      std::cerr << "Line " << line << " - sample " << i << " at " << distance
+                << " mm from the center, normal (" << normal[0] << ", " << normal[1]
+                << ", " << normal[2] << ")" << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int vtkSlicerPathPlannerSkinSamplerTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv) [] )
+{
+  // Nothing to sample; the output is appended to
+  std::vector<double> positions(3, 1.0);
+  std::vector<double> normals(3, 0.0);
+  vtkNew<vtkPolyData> empty;
+  if (vtkSlicerPathPlannerSkinSampler::SampleSurface(0, 5.0, positions, normals) != 0 ||
+      vtkSlicerPathPlannerSkinSampler::SampleSurface(empty.GetPointer(), 5.0,
+                                                     positions, normals) != 0 ||
+      vtkSlicerPathPlannerSkinSampler::SampleVolume(0, 0, 0.0, 5.0, positions, normals) != 0 ||
+      positions.size() != 3 || normals.size() != 3)
+    {
+    std::cerr << "Line " << __LINE__ << " - samples of nothing" << std::endl;
+    return EXIT_FAILURE;
+    }
+  positions.clear();
+  normals.clear();
+
+  // Cube wound outwards and inwards: the normals point out of both
+  const double spacing = 3.0;
+  for (int inwards = 0; inwards < 2; inwards ++)
+    {
+    vtkNew<vtkPolyData> cube;
+    vtkNew<vtkPoints> points;
+    vtkNew<vtkCellArray> polys;
+    vtkNew<vtkCellArray> strips;
+    MakeCube(cube.GetPointer(), points.GetPointer(), polys.GetPointer(),
+             strips.GetPointer(), inwards != 0);
+    vtkIdType nSamples = vtkSlicerPathPlannerSkinSampler::SampleSurface(
+      cube.GetPointer(), spacing, positions, normals);
+    if (nSamples != static_cast<vtkIdType>(positions.size() / 3) ||
+        !CheckCubeSamples(__LINE__, positions, normals, spacing))
+      {
+      std::cerr << "Line " << __LINE__ << " - cube wound " << (inwards ? "inwards" : "outwards")
+                << std::endl;
+      return EXIT_FAILURE;
+      }
+    positions.clear();
+    normals.clear();
+    }
+
+  // Skin of a translated ball: the cavity is not skin
+  vtkNew<vtkImageData> ball;
+  MakeBall(ball.GetPointer());
+  const double offset[3] = { 100.0, -50.0, 10.0 };
+  vtkNew<vtkMatrix4x4> ijkToRAS;
+  for (int j = 0; j < 3; j ++)
+    {
+    ijkToRAS->SetElement(j, 3, offset[j]);
+    }
+  vtkIdType nSamples = vtkSlicerPathPlannerSkinSampler::SampleVolume(
+    ball.GetPointer(), ijkToRAS.GetPointer(), 50.0, spacing, positions, normals);
+  if (nSamples != static_cast<vtkIdType>(positions.size() / 3) ||
+      !CheckBallSamples(__LINE__, positions, normals, offset, spacing))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // The same volume gives the same samples
+  std::vector<double> positions2;
+  std::vector<double> normals2;
+  vtkSlicerPathPlannerSkinSampler::SampleVolume(
+    ball.GetPointer(), ijkToRAS.GetPointer(), 50.0, spacing, positions2, normals2);
+  if (positions2 != positions || normals2 != normals)
+    {
+    std::cerr << "Line " << __LINE__ << " - samples differ between two runs" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The logic adds the samples to the entry points, with their normals
+  vtkNew<vtkSlicerPathPlannerLogic> logic;
+  vtkNew<vtkMatrix4x4> identity;
+  vtkIdType nPoints = logic->SampleSkinVolume(ball.GetPointer(), identity.GetPointer(),
+                                              50.0, spacing);
+  vtkSlicerPathPlannerPointStore* entryPoints = logic->GetEntryPoints();
+  if (nPoints != nSamples || entryPoints->GetNumberOfPoints() != nSamples)
+    {
+    std::cerr << "Line " << __LINE__ << " - " << nPoints << " entry points added, "
+              << entryPoints->GetNumberOfPoints() << " in the store, expected "
+              << nSamples << std::endl;
+    return EXIT_FAILURE;
+    }
+  for (vtkIdType i = 0; i < nPoints; i ++)
+    {
+    double position[3];
+    double normal[3];
+    entryPoints->GetPosition(i, position);
+    entryPoints->GetNormal(i, normal);
+    std::ostringstream name;
+    name << "Skin_" << entryPoints->GetId(i);
+    for (int j = 0; j < 3; j ++)
+      {
+      if (position[j] != positions[3 * i + j] - offset[j] || normal[j] != normals[3 * i + j] ||
+          name.str() != entryPoints->GetName(i) || entryPoints->GetNodeID(i)[0] != '\0')
+        {
+        std::cerr << "Line " << __LINE__ << " - entry point " << i << " named "
+                  << entryPoints->GetName(i) << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,207 @@
+/*==============================================================================
+
+  Program: Path Planner User Interface for 3D Slicer
+
+  Copyright (c) Brigham and Women's Hospital
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner includes
+#include "vtkSlicerPathPlannerLogic.h"
+#include "vtkSlicerPathPlannerPointStore.h"
+
+// VTK includes
+#include <vtkIdList.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+// Entry points suggested for each target against a linear scan of the
+// feasible entry points sorted by distance (then ID), with and without a path
+// length limit, after entry points are removed, and with entry points on a
+// grid whose many equal distances must not reorder the suggestions.
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+// Deterministic pseudo-random numbers in [0, 1)
+double Random(unsigned int& seed)
+{
+  seed = seed * 1103515245u + 12345u;
+  return ((seed >> 8) & 0xFFFF) / 65536.0;
+}
+
+//-----------------------------------------------------------------------------
+// IDs of the entry points whose path to the target is feasible, closest first
+std::vector<vtkIdType> FeasibleEntryPoints(vtkSlicerPathPlannerLogic* logic, vtkIdType target)
+{
+  vtkSlicerPathPlannerPointStore* entryPoints = logic->GetEntryPoints();
+  double targetPosition[3];
+  logic->GetTargetPoints()->GetPosition(target, targetPosition);
+  std::vector<std::pair<double, vtkIdType> > feasible;
+  for (vtkIdType i = 0; i < entryPoints->GetNumberOfPoints(); i ++)
+    {
+    double entryPosition[3];
+    entryPoints->GetPosition(i, entryPosition);
+    double insertionAngle = 0.0;
+    double length = logic->ComputeTrajectory(entryPosition, targetPosition, 0, &insertionAngle);
+    if ((logic->GetMaximumPathLength() <= 0.0 || length <= logic->GetMaximumPathLength()) &&
+        insertionAngle <= logic->GetMaximumInsertionAngle())
+      {
+      feasible.push_back(std::make_pair(
+        vtkMath::Distance2BetweenPoints(entryPosition, targetPosition), entryPoints->GetId(i)));
+      }
+    }
+  std::sort(feasible.begin(), feasible.end());
+  std::vector<vtkIdType> ids;
+  for (size_t i = 0; i < feasible.size(); i ++)
+    {
+    ids.push_back(feasible[i].second);
+    }
+  return ids;
+}
+
+//-----------------------------------------------------------------------------
+bool CheckSuggestions(int line, vtkSlicerPathPlannerLogic* logic)
+{
+  const int counts[] = { 1, 3, 10, 50, 1000 };
+  vtkNew<vtkIdList> entryPointIds;
+  vtkSlicerPathPlannerPointStore* targetPoints = logic->GetTargetPoints();
+  for (vtkIdType t = 0; t < targetPoints->GetNumberOfPoints(); t ++)
+    {
+    std::vector<vtkIdType> feasible = FeasibleEntryPoints(logic, t);
+    for (int c = 0; c < static_cast<int>(sizeof(counts) / sizeof(counts[0])); c ++)
+      {
+      vtkIdType nFound = logic->SuggestEntryPoints(targetPoints->GetId(t), counts[c],
+                                                   entryPointIds.GetPointer());
+      vtkIdType nExpected = std::min(static_cast<vtkIdType>(counts[c]),
+                                     static_cast<vtkIdType>(feasible.size()));
+      bool same = nFound == nExpected && entryPointIds->GetNumberOfIds() == nExpected;
+      for (vtkIdType i = 0; same && i < nExpected; i ++)
+        {
+        same = entryPointIds->GetId(i) == feasible[i];
+        }
+      if (!same)
+        {
+        std::cerr << "Line " << line << " - target " << t << ", " << counts[c]
+                  << " entry points: " << nFound << " found, expected " << nExpected
+                  << " of " << feasible.size() << " feasible, maximum length "
+                  << logic->GetMaximumPathLength() << std::endl;
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int vtkSlicerPathPlannerSuggestEntryPointsTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv) [] )
+{
+  vtkNew<vtkSlicerPathPlannerLogic> logic;
+  logic->SetMaximumInsertionAngle(30.0);
+  vtkNew<vtkIdList> entryPointIds;
+  if (logic->SuggestEntryPoints(0, 5, entryPointIds.GetPointer()) != 0 ||
+      logic->SuggestEntryPoints(0, 5, 0) != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - suggestions without points" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Entry points below the targets, so that the insertion angle rules out
+  // many of the closest ones
+  unsigned int seed = 5;
+  for (int i = 0; i < 400; i ++)
+    {
+    double position[3] = { 100.0 * Random(seed), 100.0 * Random(seed), 60.0 * Random(seed) };
+    logic->GetEntryPoints()->AddPoint(position, "Entry");
+    }
+  for (int i = 0; i < 4; i ++)
+    {
+    double position[3] = { 20.0 + 60.0 * Random(seed), 20.0 + 60.0 * Random(seed),
+                           70.0 + 20.0 * Random(seed) };
+    logic->GetTargetPoints()->AddPoint(position, "Target");
+    }
+
+  // Without a length limit the candidates grow until enough are feasible
+  if (!CheckSuggestions(__LINE__, logic.GetPointer()))
+    {
+    return EXIT_FAILURE;
+    }
+  logic->SetMaximumPathLength(50.0);
+  if (!CheckSuggestions(__LINE__, logic.GetPointer()))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // The tree follows the entry points removed
+  for (vtkIdType i = logic->GetEntryPoints()->GetNumberOfPoints() - 1; i >= 0; i -= 3)
+    {
+    logic->GetEntryPoints()->RemovePoint(i);
+    }
+  logic->SetMaximumPathLength(0.0);
+  if (!CheckSuggestions(__LINE__, logic.GetPointer()))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Entry points on a grid below a target, added in a shuffled order: the
+  // points at the same distance are suggested by increasing ID whatever the
+  // number asked for
+  vtkNew<vtkSlicerPathPlannerLogic> gridLogic;
+  gridLogic->SetMaximumInsertionAngle(30.0);
+  std::vector<int> cells;
+  for (int cell = 0; cell < 17 * 17; cell ++)
+    {
+    cells.push_back(cell);
+    }
+  for (size_t i = cells.size() - 1; i > 0; i --)
+    {
+    std::swap(cells[i], cells[static_cast<size_t>(Random(seed) * (i + 1))]);
+    }
+  for (size_t i = 0; i < cells.size(); i ++)
+    {
+    double position[3] = { cells[i] % 17 - 8.0, cells[i] / 17 - 8.0, 0.0 };
+    gridLogic->GetEntryPoints()->AddPoint(position, "Entry");
+    }
+  const double gridTarget[3] = { 0.0, 0.0, 10.0 };
+  gridLogic->GetTargetPoints()->AddPoint(gridTarget, "Target");
+  if (!CheckSuggestions(__LINE__, gridLogic.GetPointer()))
+    {
+    return EXIT_FAILURE;
+    }
+  gridLogic->SetMaximumPathLength(12.0);
+  if (!CheckSuggestions(__LINE__, gridLogic.GetPointer()))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Unknown target, or nothing to suggest
+  vtkIdType targetId = logic->GetTargetPoints()->GetId(0);
+  if (logic->SuggestEntryPoints(targetId + 100, 5, entryPointIds.GetPointer()) != 0 ||
+      entryPointIds->GetNumberOfIds() != 0 ||
+      logic->SuggestEntryPoints(targetId, 0, entryPointIds.GetPointer()) != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - suggestions for an unknown target" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
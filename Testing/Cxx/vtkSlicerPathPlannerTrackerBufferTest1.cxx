@@ -0,0 +1,214 @@
+/*==============================================================================
+
+  Program: Path Planner User Interface for 3D Slicer
+
+  Copyright (c) Brigham and Women's Hospital
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner includes
+#include "vtkSlicerPathPlannerTrackerBuffer.h"
+
+// VTK includes
+#include <vtkNew.h>
+
+// STD includes
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+// Capacity rounding, drops of a full buffer, order of the samples across
+// many wraparounds of the ring, PopLatest(), and a producer thread pushing
+// while the consumer pops.
+
+namespace
+{
+
+typedef vtkSlicerPathPlannerTrackerBuffer::Sample Sample;
+
+//-----------------------------------------------------------------------------
+// Matrix of the sample of the given number
+void FillMatrix(int number, double matrix[16])
+{
+  for (int e = 0; e < 16; e ++)
+    {
+    matrix[e] = number + e / 16.0;
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool Push(vtkSlicerPathPlannerTrackerBuffer* buffer, int number)
+{
+  double matrix[16];
+  FillMatrix(number, matrix);
+  return buffer->Push(0.001 * number, matrix);
+}
+
+//-----------------------------------------------------------------------------
+bool IsSample(const Sample& sample, int number)
+{
+  double matrix[16];
+  FillMatrix(number, matrix);
+  bool same = sample.Time == 0.001 * number;
+  for (int e = 0; same && e < 16; e ++)
+    {
+    same = sample.Matrix[e] == matrix[e];
+    }
+  return same;
+}
+
+//-----------------------------------------------------------------------------
+void PushSamples(vtkSlicerPathPlannerTrackerBuffer* buffer, int numberOfSamples)
+{
+  for (int i = 0; i < numberOfSamples; i ++)
+    {
+    Push(buffer, i);
+    }
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int vtkSlicerPathPlannerTrackerBufferTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv) [] )
+{
+  vtkNew<vtkSlicerPathPlannerTrackerBuffer> buffer;
+  Sample sample;
+  if (buffer->GetCapacity() != 255 || buffer->GetNumberOfSamples() != 0 ||
+      buffer->Pop(sample) || buffer->PopLatest(sample) != 0)
+    {
+    std::cerr << "Line " << __LINE__ << " - new buffer of capacity " << buffer->GetCapacity()
+              << " with " << buffer->GetNumberOfSamples() << " samples" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // A power of two minus one
+  const int capacities[][2] = { { 0, 1 }, { 1, 1 }, { 3, 3 }, { 5, 7 }, { 8, 15 } };
+  for (int c = 0; c < static_cast<int>(sizeof(capacities) / sizeof(capacities[0])); c ++)
+    {
+    buffer->SetCapacity(capacities[c][0]);
+    if (buffer->GetCapacity() != capacities[c][1])
+      {
+      std::cerr << "Line " << __LINE__ << " - capacity " << buffer->GetCapacity()
+                << " for " << capacities[c][0] << ", expected " << capacities[c][1]
+                << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // A full buffer drops the samples pushed until some are popped
+  buffer->SetCapacity(7);
+  int pushed = 0;
+  for (int i = 0; i < 10; i ++)
+    {
+    bool queued = Push(buffer.GetPointer(), pushed ++);
+    if (queued != (i < 7))
+      {
+      std::cerr << "Line " << __LINE__ << " - sample " << i << " queued " << queued << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  if (buffer->GetNumberOfSamples() != 7 || buffer->GetNumberOfDroppedSamples() != 3)
+    {
+    std::cerr << "Line " << __LINE__ << " - " << buffer->GetNumberOfSamples() << " samples, "
+              << buffer->GetNumberOfDroppedSamples() << " dropped" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Samples come out in order across the wraparounds of the ring: pop 3,
+  // push 3 at the front of the ring, and so on; the dropped ones are skipped
+  int popped = 0;
+  for (int cycle = 0; cycle < 100; cycle ++)
+    {
+    for (int i = 0; i < 3; i ++)
+      {
+      if (!buffer->Pop(sample) || !IsSample(sample, popped))
+        {
+        std::cerr << "Line " << __LINE__ << " - cycle " << cycle << ": sample at "
+                  << sample.Time << ", expected sample " << popped << std::endl;
+        return EXIT_FAILURE;
+        }
+      popped ++;
+      // the samples 7 to 9 were dropped
+      popped += (popped == 7) ? 3 : 0;
+      }
+    for (int i = 0; i < 3; i ++)
+      {
+      if (!Push(buffer.GetPointer(), pushed ++))
+        {
+        std::cerr << "Line " << __LINE__ << " - cycle " << cycle << ": sample "
+                  << pushed - 1 << " dropped" << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+  if (buffer->GetNumberOfSamples() != 7 || buffer->GetNumberOfDroppedSamples() != 3)
+    {
+    std::cerr << "Line " << __LINE__ << " - " << buffer->GetNumberOfSamples() << " samples, "
+              << buffer->GetNumberOfDroppedSamples() << " dropped" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // PopLatest() drains the buffer into its last sample
+  if (buffer->PopLatest(sample) != 7 || !IsSample(sample, pushed - 1) ||
+      buffer->GetNumberOfSamples() != 0 || buffer->PopLatest(sample) != 0 ||
+      !IsSample(sample, pushed - 1))
+    {
+    std::cerr << "Line " << __LINE__ << " - latest sample at " << sample.Time
+              << ", expected sample " << pushed - 1 << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Clear() drops the samples and the drop count
+  Push(buffer.GetPointer(), 0);
+  buffer->Clear();
+  if (buffer->GetNumberOfSamples() != 0 || buffer->GetNumberOfDroppedSamples() != 0 ||
+      buffer->Pop(sample))
+    {
+    std::cerr << "Line " << __LINE__ << " - cleared buffer with "
+              << buffer->GetNumberOfSamples() << " samples, "
+              << buffer->GetNumberOfDroppedSamples() << " dropped" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // One thread pushes while this one pops: the samples received are in
+  // order, and every sample is either received or dropped
+  buffer->SetCapacity(15);
+  const int nSamples = 200000;
+  std::thread producer(PushSamples, buffer.GetPointer(), nSamples);
+  int received = 0;
+  int last = -1;
+  bool ordered = true;
+  while (received + static_cast<int>(buffer->GetNumberOfDroppedSamples()) < nSamples ||
+         buffer->GetNumberOfSamples() > 0)
+    {
+    if (!buffer->Pop(sample))
+      {
+      std::this_thread::yield();
+      continue;
+      }
+    int number = static_cast<int>(sample.Time * 1000.0 + 0.5);
+    ordered = ordered && number > last && IsSample(sample, number);
+    last = number;
+    received ++;
+    }
+  producer.join();
+  if (!ordered || received + static_cast<int>(buffer->GetNumberOfDroppedSamples()) != nSamples ||
+      buffer->Pop(sample))
+    {
+    std::cerr << "Line " << __LINE__ << " - " << received << " samples received, "
+              << buffer->GetNumberOfDroppedSamples() << " dropped of " << nSamples
+              << ", ordered " << ordered << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
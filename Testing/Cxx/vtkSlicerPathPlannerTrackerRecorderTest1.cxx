@@ -0,0 +1,182 @@
+/*==============================================================================
+
+  Program: Path Planner User Interface for 3D Slicer
+
+  Copyright (c) Brigham and Women's Hospital
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner includes
+#include "vtkSlicerPathPlannerTrackerRecorder.h"
+#include "vtkSlicerPathPlannerTrackerRecording.h"
+
+// VTK includes
+#include <vtkNew.h>
+
+// STD includes
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+// Samples written by the recorder and read back from the mapped recording,
+// through several flushes of the write buffer, a trailing partial record
+// and files that are not recordings. The recording is written in the
+// working directory and removed at the end.
+
+namespace
+{
+
+const char* FileName = "vtkSlicerPathPlannerTrackerRecorderTest1.pptrack";
+
+//-----------------------------------------------------------------------------
+// Pose of the sample of the given number: a rigid bottom row under
+// distinct affine elements
+void FillMatrix(int number, double matrix[16])
+{
+  for (int e = 0; e < 12; e ++)
+    {
+    matrix[e] = number * 0.5 + e * 0.25 - 100.0;
+    }
+  matrix[12] = matrix[13] = matrix[14] = 0.0;
+  matrix[15] = 1.0;
+}
+
+//-----------------------------------------------------------------------------
+double SampleTime(int number)
+{
+  return 12.5 + number / 250.0;
+}
+
+//-----------------------------------------------------------------------------
+bool CheckRecording(int line, int numberOfSamples)
+{
+  vtkNew<vtkSlicerPathPlannerTrackerRecording> recording;
+  if (!recording->Open(FileName) || !recording->IsOpen() ||
+      recording->GetNumberOfSamples() != numberOfSamples)
+    {
+    std::cerr << "Line " << line << " - recording of " << recording->GetNumberOfSamples()
+              << " samples, expected " << numberOfSamples << std::endl;
+    return false;
+    }
+  for (int i = 0; i < numberOfSamples; i ++)
+    {
+    double time;
+    double matrix[16];
+    double expected[16];
+    recording->GetSample(i, &time, matrix);
+    FillMatrix(i, expected);
+    bool same = time == SampleTime(i) && recording->GetTime(i) == time;
+    for (int e = 0; same && e < 16; e ++)
+      {
+      same = matrix[e] == expected[e];
+      }
+    if (!same)
+      {
+      std::cerr << "Line " << line << " - sample " << i << " at " << time
+                << ", expected at " << SampleTime(i) << std::endl;
+      return false;
+      }
+    }
+  double duration = SampleTime(numberOfSamples - 1) - SampleTime(0);
+  if (recording->GetDuration() != duration)
+    {
+    std::cerr << "Line " << line << " - duration " << recording->GetDuration()
+              << ", expected " << duration << std::endl;
+    return false;
+    }
+  recording->Close();
+  return !recording->IsOpen();
+}
+
+//-----------------------------------------------------------------------------
+bool Record(vtkSlicerPathPlannerTrackerRecorder* recorder, int numberOfSamples)
+{
+  if (!recorder->Open(FileName) || !recorder->IsOpen())
+    {
+    return false;
+    }
+  for (int i = 0; i < numberOfSamples; i ++)
+    {
+    double matrix[16];
+    FillMatrix(i, matrix);
+    if (!recorder->Record(SampleTime(i), matrix))
+      {
+      return false;
+      }
+    }
+  bool recorded = recorder->GetNumberOfSamples() == numberOfSamples;
+  recorder->Close();
+  return recorded && !recorder->IsOpen();
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int vtkSlicerPathPlannerTrackerRecorderTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv) [] )
+{
+  vtkNew<vtkSlicerPathPlannerTrackerRecorder> recorder;
+  const double identity[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+  if (recorder->IsOpen() || recorder->Record(0.0, identity))
+    {
+    std::cerr << "Line " << __LINE__ << " - sample recorded before Open()" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // More samples than the write buffer holds
+  const int nSamples = 2500;
+  if (!Record(recorder.GetPointer(), nSamples) || !CheckRecording(__LINE__, nSamples))
+    {
+    remove(FileName);
+    return EXIT_FAILURE;
+    }
+
+  // A record cut short is ignored
+  FILE* file = fopen(FileName, "ab");
+  const char partial[50] = { 0 };
+  bool appended = file && fwrite(partial, 1, sizeof(partial), file) == sizeof(partial);
+  if (file)
+    {
+    fclose(file);
+    }
+  if (!appended || !CheckRecording(__LINE__, nSamples))
+    {
+    remove(FileName);
+    return EXIT_FAILURE;
+    }
+
+  // Open() overwrites the recording
+  if (!Record(recorder.GetPointer(), 3) || !CheckRecording(__LINE__, 3))
+    {
+    remove(FileName);
+    return EXIT_FAILURE;
+    }
+
+  // Files that are not recordings
+  vtkNew<vtkSlicerPathPlannerTrackerRecording> recording;
+  file = fopen(FileName, "wb");
+  const char text[] = "Name,R,A,S\nT1,0,0,0\nT2,1,2,3\nT3,4,5,6\n";
+  if (file)
+    {
+    fwrite(text, 1, sizeof(text), file);
+    fclose(file);
+    }
+  bool opened = recording->Open(FileName);
+  remove(FileName);
+  if (!file || opened || recording->IsOpen() || recording->Open(FileName))
+    {
+    std::cerr << "Line " << __LINE__ << " - not a recording, or a missing file, opened"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
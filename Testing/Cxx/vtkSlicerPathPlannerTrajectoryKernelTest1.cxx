@@ -0,0 +1,126 @@
+/*==============================================================================
+
+  Program: Path Planner User Interface for 3D Slicer
+
+  Copyright (c) Brigham and Women's Hospital
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner includes
+#include "vtkSlicerPathPlannerTrajectoryKernel.h"
+
+// VTK includes
+#include <vtkMath.h>
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// The vectorized pairs of EvaluateTarget() against its scalar tail: a single
+// entry point is always evaluated by the tail. The entry points are an odd
+// number, so that the batch has a tail too, and one of them coincides with
+// the target point.
+
+//-----------------------------------------------------------------------------
+int vtkSlicerPathPlannerTrajectoryKernelTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv) [] )
+{
+  const double target[3] = { 10.0, -5.0, 20.0 };
+  const double reference[3] = { 0.0, 0.0, 1.0 };
+  const double maximumLength = 40.0;
+  const double minimumCosine = cos(vtkMath::RadiansFromDegrees(60.0));
+
+  // entry point 3 is the target point, 4 is too far, 5 too oblique
+  const double entries[][3] = {
+    { 10.0, -5.0, -10.0 },
+    { 0.0, 0.0, -5.0 },
+    { 25.0, -15.0, 0.0 },
+    { 10.0, -5.0, 20.0 },
+    { 10.0, -5.0, -30.0 },
+    { -20.0, -5.0, 15.0 },
+    { 12.5, -2.5, 5.0 }
+    };
+  const int nEntries = sizeof(entries) / sizeof(entries[0]);
+  const unsigned char expectedFeasible[] = { 1, 1, 1, 0, 0, 0, 1 };
+
+  std::vector<double> r(nEntries), a(nEntries), s(nEntries);
+  for (int i = 0; i < nEntries; i ++)
+    {
+    r[i] = entries[i][0];
+    a[i] = entries[i][1];
+    s[i] = entries[i][2];
+    }
+
+  std::vector<double> lengths(nEntries), dirR(nEntries), dirA(nEntries), dirS(nEntries);
+  std::vector<unsigned char> feasible(nEntries);
+  vtkSlicerPathPlannerTrajectoryKernel::EvaluateTarget(
+    &r[0], &a[0], &s[0], nEntries, target, reference, maximumLength, minimumCosine,
+    &lengths[0], &dirR[0], &dirA[0], &dirS[0], &feasible[0]);
+
+  // without the optional direction outputs
+  std::vector<double> lengthsOnly(nEntries);
+  std::vector<unsigned char> feasibleOnly(nEntries);
+  vtkSlicerPathPlannerTrajectoryKernel::EvaluateTarget(
+    &r[0], &a[0], &s[0], nEntries, target, reference, maximumLength, minimumCosine,
+    &lengthsOnly[0], 0, 0, 0, &feasibleOnly[0]);
+
+  for (int i = 0; i < nEntries; i ++)
+    {
+    double length;
+    double direction[3];
+    unsigned char scalarFeasible;
+    vtkSlicerPathPlannerTrajectoryKernel::EvaluateTarget(
+      &r[i], &a[i], &s[i], 1, target, reference, maximumLength, minimumCosine,
+      &length, direction, direction + 1, direction + 2, &scalarFeasible);
+
+    double expectedLength = sqrt(vtkMath::Distance2BetweenPoints(entries[i], target));
+    if (fabs(length - expectedLength) > 1e-12 ||
+        fabs(lengths[i] - length) > 1e-12 ||
+        lengthsOnly[i] != lengths[i])
+      {
+      std::cerr << "Line " << __LINE__ << " - entry point " << i << ": length "
+                << lengths[i] << " (scalar " << length << ", expected "
+                << expectedLength << ")" << std::endl;
+      return EXIT_FAILURE;
+      }
+    if (fabs(dirR[i] - direction[0]) > 1e-12 ||
+        fabs(dirA[i] - direction[1]) > 1e-12 ||
+        fabs(dirS[i] - direction[2]) > 1e-12)
+      {
+      std::cerr << "Line " << __LINE__ << " - entry point " << i << ": direction ("
+                << dirR[i] << ", " << dirA[i] << ", " << dirS[i] << "), scalar ("
+                << direction[0] << ", " << direction[1] << ", " << direction[2] << ")"
+                << std::endl;
+      return EXIT_FAILURE;
+      }
+    if (feasible[i] != expectedFeasible[i] || scalarFeasible != expectedFeasible[i] ||
+        feasibleOnly[i] != expectedFeasible[i])
+      {
+      std::cerr << "Line " << __LINE__ << " - entry point " << i << ": feasible "
+                << int(feasible[i]) << " (scalar " << int(scalarFeasible)
+                << ", expected " << int(expectedFeasible[i]) << ")" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // the coincident entry point has no direction
+  if (lengths[3] != 0.0 || dirR[3] != 0.0 || dirA[3] != 0.0 || dirS[3] != 0.0)
+    {
+    std::cerr << "Line " << __LINE__ << " - coincident entry point: length "
+              << lengths[3] << ", direction (" << dirR[3] << ", " << dirA[3]
+              << ", " << dirS[3] << ")" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,338 @@
+/*==============================================================================
+
+  Program: Path Planner User Interface for 3D Slicer
+
+  Copyright (c) Brigham and Women's Hospital
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner includes
+#include "vtkSlicerPathPlannerTriangleTree.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// First intersections and distances of the tree against a linear scan of the
+// triangles of a pseudo-random surface, ending with a quad split in a fan.
+
+namespace
+{
+
+//-----------------------------------------------------------------------------
+// Deterministic pseudo-random numbers in [0, 1)
+double Random(unsigned int& seed)
+{
+  seed = seed * 1103515245u + 12345u;
+  return ((seed >> 8) & 0xFFFF) / 65536.0;
+}
+
+//-----------------------------------------------------------------------------
+double Dot(const double a[3], const double b[3])
+{
+  return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+//-----------------------------------------------------------------------------
+// Intersection of the segment with the plane of the triangle, kept if it is
+// on the inner side of the three edges
+bool CrossesTriangle(const double start[3], const double end[3],
+                     const double a[3], const double b[3], const double c[3],
+                     double* fraction)
+{
+  const double* vertices[3] = { a, b, c };
+  double e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+  double e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+  double normal[3] = { e1[1] * e2[2] - e1[2] * e2[1],
+                       e1[2] * e2[0] - e1[0] * e2[2],
+                       e1[0] * e2[1] - e1[1] * e2[0] };
+  double direction[3] = { end[0] - start[0], end[1] - start[1], end[2] - start[2] };
+  double denominator = Dot(normal, direction);
+  if (denominator == 0.0)
+    {
+    return false;
+    }
+  double offset[3] = { a[0] - start[0], a[1] - start[1], a[2] - start[2] };
+  double t = Dot(normal, offset) / denominator;
+  if (t < 0.0 || t > 1.0)
+    {
+    return false;
+    }
+  double p[3] = { start[0] + t * direction[0], start[1] + t * direction[1],
+                  start[2] + t * direction[2] };
+  for (int edge = 0; edge < 3; edge ++)
+    {
+    const double* u = vertices[edge];
+    const double* v = vertices[(edge + 1) % 3];
+    double uv[3] = { v[0] - u[0], v[1] - u[1], v[2] - u[2] };
+    double up[3] = { p[0] - u[0], p[1] - u[1], p[2] - u[2] };
+    double side[3] = { uv[1] * up[2] - uv[2] * up[1],
+                       uv[2] * up[0] - uv[0] * up[2],
+                       uv[0] * up[1] - uv[1] * up[0] };
+    if (Dot(side, normal) < 0.0)
+      {
+      return false;
+      }
+    }
+  *fraction = t;
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+// Smallest distance between a point and a dense barycentric sampling of the
+// triangles
+double SampledDistance(const double p[3], const std::vector<double>& triangles,
+                       int numberOfSteps)
+{
+  double best2 = VTK_DOUBLE_MAX;
+  for (size_t t = 0; t < triangles.size(); t += 9)
+    {
+    const double* a = &triangles[t];
+    const double* b = a + 3;
+    const double* c = a + 6;
+    for (int i = 0; i <= numberOfSteps; i ++)
+      {
+      for (int j = 0; i + j <= numberOfSteps; j ++)
+        {
+        double u = static_cast<double>(i) / numberOfSteps;
+        double v = static_cast<double>(j) / numberOfSteps;
+        double d2 = 0.0;
+        for (int axis = 0; axis < 3; axis ++)
+          {
+          double q = a[axis] + u * (b[axis] - a[axis]) + v * (c[axis] - a[axis]);
+          d2 += (q - p[axis]) * (q - p[axis]);
+          }
+        best2 = std::min(best2, d2);
+        }
+      }
+    }
+  return sqrt(best2);
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int vtkSlicerPathPlannerTriangleTreeTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv) [] )
+{
+  // Small triangles scattered in a 20 mm box, and a quad on the side
+  const int nTriangles = 300;
+  const double size = 20.0;
+  const double edge = 2.0;
+  unsigned int seed = 1;
+  vtkNew<vtkPoints> points;
+  vtkNew<vtkCellArray> polys;
+  // the triangles of the linear scan, and the cell each one comes from
+  std::vector<double> triangles;
+  std::vector<vtkIdType> cellIds;
+  for (int i = 0; i < nTriangles; i ++)
+    {
+    double center[3] = { size * Random(seed), size * Random(seed), size * Random(seed) };
+    vtkIdType ids[3];
+    for (int vertex = 0; vertex < 3; vertex ++)
+      {
+      double p[3];
+      for (int axis = 0; axis < 3; axis ++)
+        {
+        p[axis] = center[axis] + edge * (Random(seed) - 0.5);
+        }
+      ids[vertex] = points->InsertNextPoint(p[0], p[1], p[2]);
+      triangles.insert(triangles.end(), p, p + 3);
+      }
+    polys->InsertNextCell(3, ids);
+    cellIds.push_back(i);
+    }
+  const double quad[4][3] = {
+    { size + 1.0, 0.0, 0.0 },
+    { size + 1.0, size, 0.0 },
+    { size + 1.0, size, size },
+    { size + 1.0, 0.0, size }
+    };
+  vtkIdType quadIds[4];
+  for (int vertex = 0; vertex < 4; vertex ++)
+    {
+    quadIds[vertex] = points->InsertNextPoint(quad[vertex][0], quad[vertex][1], quad[vertex][2]);
+    }
+  polys->InsertNextCell(4, quadIds);
+  for (int fan = 1; fan <= 2; fan ++)
+    {
+    triangles.insert(triangles.end(), quad[0], quad[0] + 3);
+    triangles.insert(triangles.end(), quad[fan], quad[fan] + 3);
+    triangles.insert(triangles.end(), quad[fan + 1], quad[fan + 1] + 3);
+    cellIds.push_back(nTriangles);
+    }
+
+  vtkNew<vtkPolyData> surface;
+  vtkNew<vtkSlicerPathPlannerTriangleTree> tree;
+
+  // Empty surface: no intersection, no distance
+  tree->SetSurface(surface.GetPointer());
+  tree->Update();
+  const double origin[3] = { 0.0, 0.0, 0.0 };
+  double fraction;
+  if (tree->GetNumberOfTriangles() != 0 ||
+      tree->IntersectSegment(origin, quad[2], &fraction) ||
+      tree->ComputeDistance(origin, quad[2]) != VTK_DOUBLE_MAX)
+    {
+    std::cerr << "Line " << __LINE__ << " - the empty surface is hit" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  surface->SetPoints(points.GetPointer());
+  surface->SetPolys(polys.GetPointer());
+  surface->Modified();
+  if (!tree->NeedsUpdate())
+    {
+    std::cerr << "Line " << __LINE__ << " - the modified surface needs no update" << std::endl;
+    return EXIT_FAILURE;
+    }
+  tree->Update();
+  if (tree->GetNumberOfTriangles() != static_cast<vtkIdType>(cellIds.size()))
+    {
+    std::cerr << "Line " << __LINE__ << " - " << tree->GetNumberOfTriangles()
+              << " triangles, expected " << cellIds.size() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // First intersections of segments through the box, most of them ending
+  // on the quad
+  const int nSegments = 500;
+  int nHits = 0;
+  for (int s = 0; s < nSegments; s ++)
+    {
+    double start[3] = { -1.0, size * Random(seed), size * Random(seed) };
+    double end[3] = { size + 2.0, size * Random(seed), size * Random(seed) };
+    if (s % 5 == 0)
+      {
+      // short segments, that may end before any triangle
+      end[0] = start[0] + 3.0 + size * Random(seed);
+      }
+    bool expectedHit = false;
+    double expectedFraction = 1.0;
+    vtkIdType expectedCellId = -1;
+    for (size_t t = 0; t < cellIds.size(); t ++)
+      {
+      const double* a = &triangles[9 * t];
+      double f;
+      if (CrossesTriangle(start, end, a, a + 3, a + 6, &f) && f <= expectedFraction)
+        {
+        expectedHit = true;
+        expectedFraction = f;
+        expectedCellId = cellIds[t];
+        }
+      }
+    vtkIdType cellId = -1;
+    fraction = -1.0;
+    bool hit = tree->IntersectSegment(start, end, &fraction, &cellId);
+    if (hit != expectedHit ||
+        (hit && (fabs(fraction - expectedFraction) > 1e-9 || cellId != expectedCellId)))
+      {
+      std::cerr << "Line " << __LINE__ << " - segment " << s << ": hit " << hit
+                << " at " << fraction << " of cell " << cellId << ", expected "
+                << expectedHit << " at " << expectedFraction << " of cell "
+                << expectedCellId << std::endl;
+      return EXIT_FAILURE;
+      }
+    // an intersecting segment is at distance 0 from the surface, where it
+    // first crosses it
+    double distanceFraction = -1.0;
+    double distance = tree->ComputeDistance(start, end, &distanceFraction);
+    if (hit && (distance != 0.0 || fabs(distanceFraction - fraction) > 1e-9))
+      {
+      std::cerr << "Line " << __LINE__ << " - segment " << s << ": distance "
+                << distance << " at " << distanceFraction << std::endl;
+      return EXIT_FAILURE;
+      }
+    nHits += hit ? 1 : 0;
+    }
+  if (nHits == 0 || nHits == nSegments)
+    {
+    std::cerr << "Line " << __LINE__ << " - " << nHits << " segments of "
+              << nSegments << " hit the surface" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Distances of segments outside of the box against a sampling of both the
+  // segments and the triangles: the sampled distance is an upper bound,
+  // larger by less than the sampling steps
+  const int nSegmentSamples = 100;
+  const int nTriangleSteps = 40;
+  const double segments[][6] = {
+    { -3.0, -2.0, -4.0, -1.0, 25.0, -3.0 },
+    { 5.0, 5.0, 24.0, 15.0, 8.0, 23.0 },
+    { -6.0, 10.0, 10.0, -2.5, 12.0, 9.0 },
+    { 2.0, -5.0, 3.0, 18.0, -1.5, 17.0 },
+    { 30.0, 5.0, 5.0, 24.0, 15.0, 15.0 }
+    };
+  const int nDistanceSegments = sizeof(segments) / sizeof(segments[0]);
+  for (int s = 0; s < nDistanceSegments; s ++)
+    {
+    const double* start = segments[s];
+    const double* end = segments[s] + 3;
+    double length = sqrt((end[0] - start[0]) * (end[0] - start[0]) +
+                         (end[1] - start[1]) * (end[1] - start[1]) +
+                         (end[2] - start[2]) * (end[2] - start[2]));
+    double sampled = VTK_DOUBLE_MAX;
+    for (int i = 0; i <= nSegmentSamples; i ++)
+      {
+      double t = static_cast<double>(i) / nSegmentSamples;
+      double p[3] = { start[0] + t * (end[0] - start[0]),
+                      start[1] + t * (end[1] - start[1]),
+                      start[2] + t * (end[2] - start[2]) };
+      sampled = std::min(sampled, SampledDistance(p, triangles, nTriangleSteps));
+      }
+    // the quad is the largest triangle
+    double tolerance = 0.5 * length / nSegmentSamples + 2.0 * size / nTriangleSteps;
+
+    double distanceFraction = -1.0;
+    double distance = tree->ComputeDistance(start, end, &distanceFraction);
+    if (distance > sampled + 1e-9 || distance < sampled - tolerance)
+      {
+      std::cerr << "Line " << __LINE__ << " - segment " << s << ": distance "
+                << distance << ", sampled " << sampled << " (tolerance "
+                << tolerance << ")" << std::endl;
+      return EXIT_FAILURE;
+      }
+    // the closest point of the segment is at that distance
+    double closest[3] = { start[0] + distanceFraction * (end[0] - start[0]),
+                          start[1] + distanceFraction * (end[1] - start[1]),
+                          start[2] + distanceFraction * (end[2] - start[2]) };
+    double closestDistance = SampledDistance(closest, triangles, nTriangleSteps);
+    if (distanceFraction < 0.0 || distanceFraction > 1.0 ||
+        closestDistance < distance - 1e-9 || closestDistance > distance + tolerance)
+      {
+      std::cerr << "Line " << __LINE__ << " - segment " << s << ": closest point at "
+                << distanceFraction << " is at " << closestDistance
+                << " from the surface, expected " << distance << std::endl;
+      return EXIT_FAILURE;
+      }
+
+    // The search is cut short below the distance
+    if (tree->ComputeDistance(start, end, 0, 0.5 * distance) != VTK_DOUBLE_MAX ||
+        tree->ComputeDistance(start, end, 0, 2.0 * distance) != distance)
+      {
+      std::cerr << "Line " << __LINE__ << " - segment " << s
+                << ": distance with maximum distance" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
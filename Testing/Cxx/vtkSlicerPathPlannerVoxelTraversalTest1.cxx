@@ -0,0 +1,229 @@
+/*==============================================================================
+
+  Program: Path Planner User Interface for 3D Slicer
+
+  Copyright (c) Brigham and Women's Hospital
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// PathPlanner includes
+#include "vtkSlicerPathPlannerVoxelTraversal.h"
+
+// VTK includes
+#include <vtkSetGet.h>
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// Labels and depths of the 3D-DDA against a dense sampling of the segments
+// through a synthetic labelmap, and exact entry fractions along an axis.
+
+namespace
+{
+
+const int Dimensions[3] = { 12, 10, 8 };
+
+//-----------------------------------------------------------------------------
+template <class T>
+void FillVolume(std::vector<T>& scalars)
+{
+  scalars.assign(Dimensions[0] * Dimensions[1] * Dimensions[2], 0);
+  for (int k = 0; k < Dimensions[2]; k ++)
+    {
+    for (int j = 0; j < Dimensions[1]; j ++)
+      {
+      for (int i = 0; i < Dimensions[0]; i ++)
+        {
+        T label = 0;
+        if (i >= 2 && i <= 4 && j >= 2 && j <= 6 && k >= 2 && k <= 5)
+          {
+          label = 1;
+          }
+        else if (i >= 5 && i <= 6 && j >= 1 && j <= 7 && k >= 3 && k <= 6)
+          {
+          label = 2;
+          }
+        else if (i == 9 && j >= 3 && j <= 4 && k >= 3 && k <= 4)
+          {
+          label = 1;
+          }
+        else if (i == 7 && j == 8 && k == 1)
+          {
+          label = 3;
+          }
+        scalars[(k * Dimensions[1] + j) * Dimensions[0] + i] = label;
+        }
+      }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Labels entered along the segment and the first sample inside each of them
+template <class T>
+void SampleSegment(const std::vector<T>& scalars, const double start[3],
+                   const double end[3], int numberOfSamples,
+                   std::vector<int>& labels, std::vector<double>& fractions)
+{
+  int previous = 0;
+  for (int s = 0; s <= numberOfSamples; s ++)
+    {
+    double t = static_cast<double>(s) / numberOfSamples;
+    int voxel[3];
+    bool inside = true;
+    for (int axis = 0; axis < 3; axis ++)
+      {
+      voxel[axis] = static_cast<int>(floor(start[axis] + t * (end[axis] - start[axis]) + 0.5));
+      inside = inside && voxel[axis] >= 0 && voxel[axis] < Dimensions[axis];
+      }
+    int label = inside ?
+      static_cast<int>(scalars[(voxel[2] * Dimensions[1] + voxel[1]) * Dimensions[0] + voxel[0]]) : 0;
+    if (label != 0 && label != previous)
+      {
+      labels.push_back(label);
+      fractions.push_back(t);
+      }
+    previous = label;
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool CheckHits(int line, const char* name,
+               const std::vector<int>& labels, const std::vector<double>& fractions,
+               const std::vector<int>& expectedLabels,
+               const std::vector<double>& expectedFractions, double tolerance)
+{
+  bool same = labels == expectedLabels && fractions.size() == expectedFractions.size();
+  for (size_t h = 0; same && h < fractions.size(); h ++)
+    {
+    same = fabs(fractions[h] - expectedFractions[h]) <= tolerance;
+    }
+  if (!same)
+    {
+    std::cerr << "Line " << line << " - " << name << ": hits";
+    for (size_t h = 0; h < labels.size(); h ++)
+      {
+      std::cerr << " " << labels[h] << "@" << fractions[h];
+      }
+    std::cerr << ", expected";
+    for (size_t h = 0; h < expectedLabels.size(); h ++)
+      {
+      std::cerr << " " << expectedLabels[h] << "@" << expectedFractions[h];
+      }
+    std::cerr << std::endl;
+    }
+  return same;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int vtkSlicerPathPlannerVoxelTraversalTest1(int vtkNotUsed(argc), char * vtkNotUsed(argv) [] )
+{
+  std::vector<unsigned char> volume;
+  FillVolume(volume);
+
+  // Along I through the middle of row (j, k) = (3, 4): the voxel boundaries
+  // are at half indices, from a start point 2 voxels before the volume
+    {
+    const double start[3] = { -2.0, 3.0, 4.0 };
+    const double end[3] = { 13.0, 3.0, 4.0 };
+    std::vector<int> labels;
+    std::vector<double> fractions;
+    int hits = vtkSlicerPathPlannerVoxelTraversal::TraceSegment(
+      &volume[0], VTK_UNSIGNED_CHAR, Dimensions, start, end, labels, fractions);
+    std::vector<int> expectedLabels;
+    std::vector<double> expectedFractions;
+    expectedLabels.push_back(1);
+    expectedFractions.push_back(3.5 / 15.0);
+    expectedLabels.push_back(2);
+    expectedFractions.push_back(6.5 / 15.0);
+    expectedLabels.push_back(1);
+    expectedFractions.push_back(10.5 / 15.0);
+    if (hits != 3 ||
+        !CheckHits(__LINE__, "axis", labels, fractions, expectedLabels, expectedFractions, 1e-12))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+
+  // Oblique segments, through the labels, across label boundaries, from
+  // outside of the volume and ending inside a label
+  const double segments[][6] = {
+    { 0.13, 0.27, 0.41, 11.31, 9.17, 7.23 },
+    { -3.1, 4.37, 4.61, 14.2, 4.83, 3.29 },
+    { 10.7, 8.9, 0.23, 2.11, 2.93, 6.87 },
+    { 7.41, 9.6, -1.2, 3.62, 3.18, 3.71 },
+    { 5.5, -2.3, 4.2, 5.8, 11.7, 4.6 }
+    };
+  const int nSegments = sizeof(segments) / sizeof(segments[0]);
+  const int nSamples = 100000;
+  for (int s = 0; s < nSegments; s ++)
+    {
+    const double* start = segments[s];
+    const double* end = segments[s] + 3;
+    std::vector<int> labels;
+    std::vector<double> fractions;
+    int hits = vtkSlicerPathPlannerVoxelTraversal::TraceSegment(
+      &volume[0], VTK_UNSIGNED_CHAR, Dimensions, start, end, labels, fractions);
+    std::vector<int> expectedLabels;
+    std::vector<double> expectedFractions;
+    SampleSegment(volume, start, end, nSamples, expectedLabels, expectedFractions);
+    if (expectedLabels.empty() || hits != static_cast<int>(labels.size()) ||
+        !CheckHits(__LINE__, "oblique", labels, fractions,
+                   expectedLabels, expectedFractions, 1.0 / nSamples))
+      {
+      std::cerr << "Line " << __LINE__ << " - segment " << s << " failed" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // Same labels whatever the scalar type
+    {
+    std::vector<short> shortVolume;
+    FillVolume(shortVolume);
+    const double* start = segments[0];
+    const double* end = segments[0] + 3;
+    std::vector<int> labels;
+    std::vector<double> fractions;
+    vtkSlicerPathPlannerVoxelTraversal::TraceSegment(
+      &shortVolume[0], VTK_SHORT, Dimensions, start, end, labels, fractions);
+    std::vector<int> expectedLabels;
+    std::vector<double> expectedFractions;
+    vtkSlicerPathPlannerVoxelTraversal::TraceSegment(
+      &volume[0], VTK_UNSIGNED_CHAR, Dimensions, start, end,
+      expectedLabels, expectedFractions);
+    if (!CheckHits(__LINE__, "short", labels, fractions, expectedLabels, expectedFractions, 0.0))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+
+  // A segment that misses the volume
+    {
+    const double start[3] = { -5.0, -5.0, -5.0 };
+    const double end[3] = { -1.0, 20.0, 3.0 };
+    std::vector<int> labels;
+    std::vector<double> fractions;
+    if (vtkSlicerPathPlannerVoxelTraversal::TraceSegment(
+          &volume[0], VTK_UNSIGNED_CHAR, Dimensions, start, end, labels, fractions) != 0 ||
+        !labels.empty())
+      {
+      std::cerr << "Line " << __LINE__ << " - outside: " << labels.size() << " hits" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
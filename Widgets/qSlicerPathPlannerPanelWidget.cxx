@@ -23,8 +23,14 @@
 #include "ui_qSlicerPathPlannerPanelWidget.h"
 
 #include <QDebug>
+#include <QHeaderView>
 #include <QList>
+#include <QSortFilterProxyModel>
 #include <QTableWidgetSelectionRange>
+#include <QTimer>
+
+// STD includes
+#include <algorithm>
 
 #include "qSlicerPathPlannerTableModel.h"
 #include "qSlicerAbstractCoreModule.h"
@@ -37,22 +43,36 @@
 #include <vtkSlicerApplicationLogic.h>
 #include "qSlicerMouseModeToolBar.h"
 
+#include "vtkCollection.h"
+#include "vtkIdList.h"
+#include "vtkNew.h"
 #include "vtkObject.h"
 #include "vtkSmartPointer.h"
 #include "vtkMatrix4x4.h"
+#include "vtkMRMLAnnotationFiducialNode.h"
 #include "vtkMRMLAnnotationHierarchyNode.h"
 #include "vtkMRMLLinearTransformNode.h"
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLScalarVolumeNode.h"
 #include "vtkMRMLInteractionNode.h"
 #include "vtkMRMLSelectionNode.h"
 #include "vtkMRMLCommandLineModuleNode.h"
 
 #include "vtkSlicerAnnotationModuleLogic.h"
 #include "vtkSlicerCLIModuleLogic.h"
+#include "vtkSlicerPathPlannerDeviation.h"
+#include "vtkSlicerPathPlannerLogic.h"
+#include "vtkSlicerPathPlannerPathStore.h"
+#include "vtkSlicerPathPlannerPoseFilter.h"
+#include "vtkSlicerPathPlannerProfiler.h"
+#include "vtkSlicerPathPlannerTrace.h"
+#include "vtkSlicerPathPlannerTrackerBuffer.h"
+#include "vtkSlicerPathPlannerTrackerRecorder.h"
+#include "vtkSlicerPathPlannerTrackerRecording.h"
+#include "vtkSlicerPathPlannerTrackerReplay.h"
 
 #include "qtableview.h"
 
-
-
 //-----------------------------------------------------------------------------
 /// \ingroup Slicer_QtModules_PathPlanner
 class qSlicerPathPlannerPanelWidgetPrivate
@@ -72,13 +92,39 @@ public:
   qSlicerPathPlannerTableModel* EntryPointsTableModel;
   qSlicerPathPlannerTableModel* TargetPointsTableModel;
   qSlicerPathPlannerTableModel* PathsTableModel;
+
+  // Sortable view of PathsTableModel shown in PathsTable
+  QSortFilterProxyModel* PathsSortModel;
   
-  // test code
   // Linear transform node to import tacking data
   vtkMRMLLinearTransformNode* TrackerTransform;
+  // Tracker poses queued by the transform observer, and timer consuming
+  // the latest one about once per frame
+  vtkSmartPointer<vtkSlicerPathPlannerTrackerBuffer> TrackerSamples;
+  QTimer TrackerDisplayTimer;
+  // Recording of the tracker poses, and replay of a recording in place of
+  // the tracker
+  vtkSmartPointer<vtkSlicerPathPlannerTrackerRecorder> TrackerRecorder;
+  vtkSmartPointer<vtkSlicerPathPlannerTrackerReplay> TrackerReplay;
+  // Number of replayed samples consumed, -1 with the live tracker
+  vtkIdType ReplayedSamples;
+  // Deviation of the tracked needle from the selected path
+  vtkSmartPointer<vtkSlicerPathPlannerDeviation> Deviation;
   
   // Pointer to Logic class of Annotations module to switch ActiveHierarchy node.
   vtkSlicerAnnotationModuleLogic* AnnotationsLogic;
+
+  // Pointer to Logic class of this module, which computes the path geometry.
+  vtkSlicerPathPlannerLogic* PathPlannerLogic;
+
+  // Number of entry points highlighted for the selected target point
+  int NumberOfSuggestedEntryPoints;
+  // Number of paths of each target point added by "Best Paths"
+  int NumberOfPathsPerTarget;
+  // Distance in mm between the entry points sampled on the skin, and
+  // skin threshold of CT volumes
+  double SkinSpacing;
+  double SkinThreshold;
   
   QString OriginalAnnotationID;  
 };
@@ -92,11 +138,24 @@ qSlicerPathPlannerPanelWidgetPrivate
   this->EntryPointsTableModel = NULL;
   this->TargetPointsTableModel = NULL;
   this->PathsTableModel = NULL;
+  this->PathsSortModel = NULL;
   this->AnnotationsLogic = NULL;
+  this->PathPlannerLogic = NULL;
+  this->NumberOfSuggestedEntryPoints = 5;
+  this->NumberOfPathsPerTarget = 10;
+  this->SkinSpacing = 5.0;
+  this->SkinThreshold = -300.0;
   this->OriginalAnnotationID = "";  
 
-  // test code
   this->TrackerTransform = NULL;
+  this->TrackerSamples = vtkSmartPointer<vtkSlicerPathPlannerTrackerBuffer>::New();
+  this->TrackerDisplayTimer.setSingleShot(true);
+  this->TrackerDisplayTimer.setInterval(16);
+  this->TrackerRecorder = vtkSmartPointer<vtkSlicerPathPlannerTrackerRecorder>::New();
+  this->TrackerReplay = vtkSmartPointer<vtkSlicerPathPlannerTrackerReplay>::New();
+  this->TrackerReplay->SetBuffer(this->TrackerSamples);
+  this->ReplayedSamples = -1;
+  this->Deviation = vtkSmartPointer<vtkSlicerPathPlannerDeviation>::New();
 
 }
 
@@ -153,6 +212,13 @@ qSlicerPathPlannerPanelWidget
     d->AnnotationsLogic =
     vtkSlicerAnnotationModuleLogic::SafeDownCast(annotationsModule->logic());
   }
+  qSlicerAbstractCoreModule* pathPlannerModule =
+    qSlicerCoreApplication::application()->moduleManager()->module("PathPlanner");
+  if (pathPlannerModule)
+  {
+    d->PathPlannerLogic =
+    vtkSlicerPathPlannerLogic::SafeDownCast(pathPlannerModule->logic());
+  }
   vtkMRMLScene * scene = qSlicerCoreApplication::application()->mrmlScene();
 
   // set list models
@@ -168,11 +234,37 @@ qSlicerPathPlannerPanelWidget
   d->EntryPointsTableModel->setCoordinateLabel(qSlicerPathPlannerTableModel::LABEL_RAS_ENTRY);
   d->TargetPointsTableModel->setCoordinateLabel(qSlicerPathPlannerTableModel::LABEL_RAS_TARGET);
   d->PathsTableModel->setCoordinateLabel(qSlicerPathPlannerTableModel::LABEL_RAS_PATH);
+
+  d->EntryPointsTableModel->setLogic(d->PathPlannerLogic);
+  d->TargetPointsTableModel->setLogic(d->PathPlannerLogic);
+  d->PathsTableModel->setLogic(d->PathPlannerLogic);
+  if (d->PathPlannerLogic)
+  {
+    d->Deviation->SetPaths(d->PathPlannerLogic->GetPaths());
+  }
   
   // set model
   d->EntryPointsTable->setModel(d->EntryPointsTableModel);
   d->TargetPointsTable->setModel(d->TargetPointsTableModel);
-  d->PathsTable->setModel(d->PathsTableModel);
+  d->PathsSortModel = new QSortFilterProxyModel(this);
+  d->PathsSortModel->setSourceModel(d->PathsTableModel);
+  d->PathsSortModel->setDynamicSortFilter(true);
+  d->PathsTable->setModel(d->PathsSortModel);
+  // keep the insertion order until a column header is clicked
+  d->PathsTable->horizontalHeader()->setSortIndicator(-1, Qt::AscendingOrder);
+  d->PathsTable->setSortingEnabled(true);
+
+  // moving a point only updates the paths using it
+  QObject::connect(d->EntryPointsTableModel, SIGNAL(pointModified(vtkIdType)),
+                   d->PathsTableModel, SLOT(onEntryPointModified(vtkIdType)));
+  QObject::connect(d->TargetPointsTableModel, SIGNAL(pointModified(vtkIdType)),
+                   d->PathsTableModel, SLOT(onTargetPointModified(vtkIdType)));
+  // the tracked needle is shown at the frame rate, whatever the tracker rate
+  QObject::connect(&d->TrackerDisplayTimer, SIGNAL(timeout()),
+                   this, SLOT(updateTrackerDeviation()));
+  // the paths are planned in the background
+  QObject::connect(d->PathsTableModel, SIGNAL(pathsPlanned(qulonglong,int)),
+                   this, SLOT(onPathsPlanned(qulonglong,int)));
   
   // test codes
   // set item selectors
@@ -360,6 +452,24 @@ qSlicerPathPlannerPanelWidget
 
   
   // test code
+  if (d->generatePathsButton)
+  {
+    connect(d->generatePathsButton, SIGNAL(clicked()),
+            this, SLOT(generateAllPaths()));
+  }
+
+  if (d->generateBestPathsButton)
+  {
+    connect(d->generateBestPathsButton, SIGNAL(clicked()),
+            this, SLOT(generateBestPaths()));
+  }
+
+  if (d->pathSetDisplayCheckBox)
+  {
+    connect(d->pathSetDisplayCheckBox, SIGNAL(toggled(bool)),
+            this, SLOT(setPathSetDisplay(bool)));
+  }
+
   if (d->addPathButton)
   {
     connect(d->addPathButton, SIGNAL(clicked()),
@@ -394,6 +504,26 @@ qSlicerPathPlannerPanelWidget
             this, SLOT(setTrackerTransform(vtkMRMLNode*)));
   }
 
+  if (d->LabelMapNodeSelector)
+  {
+    // only labelmaps
+    d->LabelMapNodeSelector->addAttribute("vtkMRMLScalarVolumeNode", "LabelMap", "1");
+    connect(d->LabelMapNodeSelector, SIGNAL(currentNodeChanged(vtkMRMLNode*)),
+            this, SLOT(setLabelMapVolume(vtkMRMLNode*)));
+  }
+
+  if (d->SurfaceModelsSelector)
+  {
+    connect(d->SurfaceModelsSelector, SIGNAL(checkedNodesChanged()),
+            this, SLOT(setSurfaceModels()));
+  }
+
+  if (d->SampleSkinButton)
+  {
+    connect(d->SampleSkinButton, SIGNAL(clicked()),
+            this, SLOT(sampleSkin()));
+  }
+
 /*
   if(d->AddEntryPointButton)
   {
@@ -479,6 +609,21 @@ void qSlicerPathPlannerPanelWidget
   }  
 
   
+  if (d->LabelMapNodeSelector)
+  {
+    d->LabelMapNodeSelector->setMRMLScene(newScene);
+  }
+
+  if (d->SurfaceModelsSelector)
+  {
+    d->SurfaceModelsSelector->setMRMLScene(newScene);
+  }
+
+  if (d->SkinNodeSelector)
+  {
+    d->SkinNodeSelector->setMRMLScene(newScene);
+  }
+
   // test code
   if (d->TrackerTransformNodeSelector)
   {
@@ -638,8 +783,7 @@ void qSlicerPathPlannerPanelWidget
     std::string original = d->AnnotationsLogic->GetActiveHierarchyNodeID();
     std::string current = "";
     
-    // test code
-    std::cout << "GetActiveHierarchyNodeID = " << original << std::endl;
+    vtkSlicerPathPlannerTraceMacro("GetActiveHierarchyNodeID = " << original);
     
     if (original.compare("") != 0)
     {
@@ -649,12 +793,10 @@ void qSlicerPathPlannerPanelWidget
       (d->PathsAnnotationNodeSelector->currentNode());
       if (hnode && original.compare(hnode->GetID()) != 0)
       {
-        // test code
-        std::cout << "current = hnode->GetID()" << std::endl;
+        vtkSlicerPathPlannerTraceMacro("current = hnode->GetID()");
         current = hnode->GetID();
       }
-      // test code
-      std::cout << "original.compare("") != 0" << std::endl;
+      vtkSlicerPathPlannerTraceMacro("original.compare("") != 0");
       
     }
     else
@@ -666,14 +808,12 @@ void qSlicerPathPlannerPanelWidget
       {
         current = hnode->GetID();
       }
-      // test code
-      std::cout << "else of original.compare("") != 0" << std::endl;
+      vtkSlicerPathPlannerTraceMacro("else of original.compare("") != 0");
       
     }
     if (current.compare("") != 0)
     {
-      // test code
-      std::cout << "current.compare("") != 0" << std::endl;
+      vtkSlicerPathPlannerTraceMacro("current.compare("") != 0");
 
       // Switch the active hierarchy node
       d->AnnotationsLogic->SetActiveHierarchyNodeID(current.c_str());
@@ -696,8 +836,7 @@ void qSlicerPathPlannerPanelWidget
     }
   }
   
-  // test code
-  std::cout << "addTargetPoint() is finished. " << std::endl;
+  vtkSlicerPathPlannerTraceMacro("addTargetPoint() is finished. ");
 }
 
 
@@ -770,21 +909,12 @@ void qSlicerPathPlannerPanelWidget
 {
   Q_D(qSlicerPathPlannerPanelWidget);
 
-  std::cout << "clicked addPathRowButton" << std::endl;
+  vtkSlicerPathPlannerTraceMacro("clicked addPathRowButton");
   
   //d->PathsTableModel->targetPointName[d->PathsTableModel->pathColumnCounter] = (char*)malloc(sizeof(char) * 50);
   //d->PathsTableModel->targetPointName[d->PathsTableModel->pathColumnCounter] = "Set Target Point";
   //d->PathsTableModel->pathColumnCounter++;
 
-  // initialize variables
-  for(int i = 0; i < 4; i++)
-  {
-    //d->EntryPointsTableModel->selectedEntryPoint[this->generatedPathColumnCounter][i] = 0.0;
-    //d->TargetPointsTableModel->selectedTargetPoint[this->generatedPathColumnCounter][i] = 0.0;
-    this->selectedEntryPoint[this->generatedPathColumnCounter][i] = 0.0;
-    this->selectedTargetPoint[this->generatedPathColumnCounter][i] = 0.0;
-  }
-  
   this->generatedPathColumnCounter++;
 
   //d->qSlicerPathPlannerTableModel->updateTable();
@@ -817,7 +947,72 @@ void qSlicerPathPlannerPanelWidget
 }
 
 
-// test code
+//-----------------------------------------------------------------------------
+void qSlicerPathPlannerPanelWidget
+::generateAllPaths()
+{
+  Q_D(qSlicerPathPlannerPanelWidget);
+
+  if (!d->PathPlannerLogic)
+  {
+    return;
+  }
+
+  // Bring the point stores of the logic up to date with the fiducials
+  d->EntryPointsTableModel->updateTable();
+  d->TargetPointsTableModel->updateTable();
+
+  // Feasible paths of the entry x target matrix, shortest first
+  this->setActivePathsHierarchy();
+  d->PathsTableModel->planPaths(0);
+}
+
+
+//-----------------------------------------------------------------------------
+void qSlicerPathPlannerPanelWidget
+::generateBestPaths()
+{
+  Q_D(qSlicerPathPlannerPanelWidget);
+
+  if (!d->PathPlannerLogic)
+  {
+    return;
+  }
+
+  // Bring the point stores of the logic up to date with the fiducials
+  d->EntryPointsTableModel->updateTable();
+  d->TargetPointsTableModel->updateTable();
+
+  // Cheapest paths of each target, target by target
+  this->setActivePathsHierarchy();
+  d->PathsTableModel->planPaths(std::max(d->NumberOfPathsPerTarget, 1));
+}
+
+
+//-----------------------------------------------------------------------------
+void qSlicerPathPlannerPanelWidget
+::onPathsPlanned(qulonglong vtkNotUsed(generation), int numberOfPaths)
+{
+  this->generatedPathColumnCounter += numberOfPaths;
+}
+
+
+//-----------------------------------------------------------------------------
+void qSlicerPathPlannerPanelWidget
+::setActivePathsHierarchy()
+{
+  Q_D(qSlicerPathPlannerPanelWidget);
+
+  // the rulers of the paths are added to the selected hierarchy
+  vtkMRMLAnnotationHierarchyNode* hnode;
+  hnode = vtkMRMLAnnotationHierarchyNode::SafeDownCast(d->PathsAnnotationNodeSelector->currentNode());
+  if (hnode)
+  {
+    d->AnnotationsLogic->SetActiveHierarchyNodeID(hnode->GetID());
+  }
+}
+
+
 //-----------------------------------------------------------------------------
 void qSlicerPathPlannerPanelWidget
 ::setTrackerTransform(vtkMRMLNode* o)
@@ -831,34 +1026,265 @@ void qSlicerPathPlannerPanelWidget
                   vtkMRMLTransformableNode::TransformModifiedEvent,
                   this, SLOT(onTrackerTransformModified()));
     d->TrackerTransform = trans;
+    // the poses of the previous tracker are not shown
+    this->stopTrackerReplay();
+    d->TrackerSamples->Clear();
+    if (d->PathPlannerLogic)
+    {
+      d->PathPlannerLogic->GetPoseFilter()->Reset();
+    }
   }
 }
 
-// test code
 //-----------------------------------------------------------------------------
 void qSlicerPathPlannerPanelWidget
 ::onTrackerTransformModified()
 {
   Q_D(qSlicerPathPlannerPanelWidget);
-  
+  vtkSlicerPathPlannerProbeMacro(TrackerTransformModifiedProbe);
+
+  // A replay is the only producer of the tracker buffer while it runs
+  if (!d->TrackerTransform || d->TrackerReplay->IsRunning())
+  {
+    return;
+  }
+  // Runs at the tracker rate: only queue (and record) the pose, the
+  // display consumes the latest one at the next frame
   vtkMatrix4x4* matrix = d->TrackerTransform->GetMatrixTransformToParent();
-  QString buf;
-  //d->PositionXEdit->setText(buf.setNum(matrix->Element[0][3]));
-  //d->PositionYEdit->setText(buf.setNum(matrix->Element[1][3]));
-  //d->PositionZEdit->setText(buf.setNum(matrix->Element[2][3]));
-  std::cout << "matrix->Element[0][3] = " << matrix->Element[0][3] << std::endl;
-  std::cout << "matrix->Element[1][3] = " << matrix->Element[1][3] << std::endl;
-  std::cout << "matrix->Element[2][3] = " << matrix->Element[2][3] << std::endl;
-  
+  double time = vtkSlicerPathPlannerTrackerBuffer::GetTime();
+  d->TrackerSamples->Push(time, matrix->Element[0]);
+  if (d->TrackerRecorder->IsOpen())
+  {
+    d->TrackerRecorder->Record(time, matrix->Element[0]);
+  }
+  if (!d->TrackerDisplayTimer.isActive())
+  {
+    d->TrackerDisplayTimer.start();
+  }
+}
+
+
+//-----------------------------------------------------------------------------
+bool qSlicerPathPlannerPanelWidget
+::startTrackerRecording(const QString& fileName)
+{
+  Q_D(qSlicerPathPlannerPanelWidget);
+
+  return d->TrackerRecorder->Open(fileName.toLocal8Bit().constData());
+}
+
+
+//-----------------------------------------------------------------------------
+void qSlicerPathPlannerPanelWidget
+::stopTrackerRecording()
+{
+  Q_D(qSlicerPathPlannerPanelWidget);
+
+  d->TrackerRecorder->Close();
+}
+
+
+//-----------------------------------------------------------------------------
+bool qSlicerPathPlannerPanelWidget
+::replayTrackerRecording(const QString& fileName, double speed)
+{
+  Q_D(qSlicerPathPlannerPanelWidget);
+
+  this->stopTrackerReplay();
+  vtkNew<vtkSlicerPathPlannerTrackerRecording> recording;
+  if (!recording->Open(fileName.toLocal8Bit().constData()))
+  {
+    return false;
+  }
+  // the replay takes the place of the tracker, from a fresh filter
+  d->TrackerSamples->Clear();
+  if (d->PathPlannerLogic)
+  {
+    d->PathPlannerLogic->GetPoseFilter()->Reset();
+  }
+  d->TrackerReplay->SetRecording(recording.GetPointer());
+  d->TrackerReplay->SetSpeed(speed);
+  if (!d->TrackerReplay->Start())
+  {
+    return false;
+  }
+  d->ReplayedSamples = 0;
+  // the replay thread cannot start the timer: poll at the frame rate
+  d->TrackerDisplayTimer.setSingleShot(false);
+  d->TrackerDisplayTimer.start();
+  return true;
+}
+
+
+//-----------------------------------------------------------------------------
+void qSlicerPathPlannerPanelWidget
+::stopTrackerReplay()
+{
+  Q_D(qSlicerPathPlannerPanelWidget);
+
+  d->TrackerReplay->Stop();
+}
+
+
+//-----------------------------------------------------------------------------
+void qSlicerPathPlannerPanelWidget
+::updateTrackerDeviation()
+{
+  Q_D(qSlicerPathPlannerPanelWidget);
+
+  // Every sample corrects the pose filter, then the pose is predicted
+  // once, at the time of display; the deviation is compared with the
+  // packed path geometry in place, without any allocation or table update
+  vtkSlicerPathPlannerPoseFilter* filter =
+    d->PathPlannerLogic ? d->PathPlannerLogic->GetPoseFilter() : 0;
+  vtkSlicerPathPlannerTrackerBuffer::Sample sample;
+  int nSamples = 0;
+  while (d->TrackerSamples->Pop(sample))
+  {
+    if (filter)
+    {
+      filter->AddSample(sample.Time, sample.Matrix);
+    }
+    nSamples ++;
+  }
+  double time = vtkSlicerPathPlannerTrackerBuffer::GetTime();
+  if (d->ReplayedSamples >= 0 && nSamples > 0)
+  {
+    // the replay clock: Speed times the real time elapsed since the
+    // latest sample was due, from the time of the sample
+    d->ReplayedSamples += nSamples;
+    double speed = d->TrackerReplay->GetSpeed();
+    double elapsed = 0.0;
+    if (speed > 0.0)
+    {
+      elapsed = time - d->TrackerReplay->GetScheduledTime(d->ReplayedSamples - 1);
+    }
+    time = sample.Time + std::max(elapsed, 0.0) * speed;
+  }
+  if (!d->TrackerReplay->IsRunning() && !d->TrackerDisplayTimer.isSingleShot())
+  {
+    // the replay is over: back to the live tracker
+    d->TrackerDisplayTimer.stop();
+    d->TrackerDisplayTimer.setSingleShot(true);
+    d->ReplayedSamples = -1;
+  }
+  if (nSamples == 0)
+  {
+    return;
+  }
+  if (filter)
+  {
+    filter->Predict(time, sample.Matrix);
+  }
+  vtkSlicerPathPlannerDeviation* deviation = d->Deviation;
+  deviation->Update(sample.Matrix);
+
+  vtkSlicerPathPlannerPathStore* paths = deviation->GetPaths();
+  QString text;
+  if (deviation->GetTipDistance() != VTK_DOUBLE_MAX)
+  {
+    text = QString("Tip %1 mm, %2 deg, depth %3 mm")
+      .arg(deviation->GetTipDistance(), 0, 'f', 1)
+      .arg(deviation->GetAngularDeviation(), 0, 'f', 1)
+      .arg(deviation->GetRemainingDepth(), 0, 'f', 1);
+  }
+  vtkIdType nearest = paths ? paths->GetIndex(deviation->GetNearestPathId()) : -1;
+  if (nearest >= 0)
+  {
+    if (!text.isEmpty())
+    {
+      text += "\n";
+    }
+    text += QString("Nearest %1 (%2 mm)")
+      .arg(paths->GetName(nearest))
+      .arg(deviation->GetNearestPathDistance(), 0, 'f', 1);
+  }
+  d->TrackerDeviationLabel->setText(text);
+}
+
+
+//-----------------------------------------------------------------------------
+void qSlicerPathPlannerPanelWidget
+::setLabelMapVolume(vtkMRMLNode* node)
+{
+  Q_D(qSlicerPathPlannerPanelWidget);
+
+  if (!d->PathPlannerLogic)
+  {
+    return;
+  }
+  // the planned paths would be evaluated against the previous labelmap
+  d->PathsTableModel->cancelPlanning();
+  d->PathPlannerLogic->SetLabelMapVolumeNode(vtkMRMLScalarVolumeNode::SafeDownCast(node));
+  d->PathsTableModel->checkLabelMap();
+}
+
+
+//-----------------------------------------------------------------------------
+void qSlicerPathPlannerPanelWidget
+::setSurfaceModels()
+{
+  Q_D(qSlicerPathPlannerPanelWidget);
+
+  if (!d->PathPlannerLogic)
+  {
+    return;
+  }
+  d->PathsTableModel->cancelPlanning();
+  d->PathPlannerLogic->RemoveAllSurfaceModels();
+  foreach(vtkMRMLNode* node, d->SurfaceModelsSelector->checkedNodes())
+  {
+    d->PathPlannerLogic->AddSurfaceModelNode(vtkMRMLModelNode::SafeDownCast(node));
+  }
+  d->PathsTableModel->checkSurfaceModels();
+}
+
+
+//-----------------------------------------------------------------------------
+void qSlicerPathPlannerPanelWidget
+::setPathSetDisplay(bool enabled)
+{
+  Q_D(qSlicerPathPlannerPanelWidget);
+  d->PathsTableModel->setPathSetDisplay(enabled);
+}
+
+
+//-----------------------------------------------------------------------------
+void qSlicerPathPlannerPanelWidget
+::sampleSkin()
+{
+  Q_D(qSlicerPathPlannerPanelWidget);
+
+  if (!d->PathPlannerLogic || !d->SkinNodeSelector)
+  {
+    return;
+  }
+  vtkMRMLNode* node = d->SkinNodeSelector->currentNode();
+  if (vtkMRMLModelNode::SafeDownCast(node))
+  {
+    d->PathPlannerLogic->SampleSkinModelNode(vtkMRMLModelNode::SafeDownCast(node),
+                                             d->SkinSpacing);
+  }
+  else if (vtkMRMLScalarVolumeNode::SafeDownCast(node))
+  {
+    d->PathPlannerLogic->SampleSkinVolumeNode(vtkMRMLScalarVolumeNode::SafeDownCast(node),
+                                              d->SkinThreshold, d->SkinSpacing);
+  }
+  else
+  {
+    return;
+  }
+  // The samples have no fiducial nodes: they are shown from the point store
+  d->EntryPointsTableModel->updateTable();
 }
 
 
-// test code
 //-----------------------------------------------------------------------------
 void qSlicerPathPlannerPanelWidget
 ::selectTargetPoint(const QItemSelection &selected, const QItemSelection &deselected)
 {
   Q_D(qSlicerPathPlannerPanelWidget);
+  vtkSlicerPathPlannerProbeMacro(SelectTargetPointProbe);
       
   QModelIndexList indexes = this->selectionTargetPointsTableModel->selectedIndexes();
   QModelIndex index;
@@ -871,52 +1297,35 @@ void qSlicerPathPlannerPanelWidget
   {
     foreach(index, indexes)
     {
-      // test code: update the target point name
-      std::cout << "Picked up target!!" << std::endl;
-
+      // update the target point name
       d->PathsTableModel->selectedTargetPointItemRow = index.row();
       d->PathsTableModel->selectedTargetPointItemColumn = index.column();
-      std::cout << "index.row() for target point = " << index.row() << std::endl;      
-      std::cout << "index.column() for target point = " << index.column() << std::endl;      
+      vtkSlicerPathPlannerTraceMacro("index.row() for target point = " << index.row());
+      vtkSlicerPathPlannerTraceMacro("index.column() for target point = " << index.column());
             
-      d->TargetPointsTableModel->identifyTipOfPath(index.row(), index.column());
-      std::cout << "selected target name = " << d->TargetPointsTableModel->selectedName << std::endl;            
-      
-      // test code for renewing path
-      this->targetRow[this->selectedPathIndexOfRow] = index.row();
-      this->targetColumn[this->selectedPathIndexOfRow] = index.column();
-      
-      // update target point name
-      d->PathsTableModel->targetPointName[this->selectedPathIndexOfRow] = d->TargetPointsTableModel->selectedName; 
-      
-      // update target point coordinate;
-      //d->TargetPointsTableModel->selectedTargetPoint[this->selectedPathIndexOfRow][0] = d->TargetPointsTableModel->selectedCoordinate[index.row()][0];
-      //d->TargetPointsTableModel->selectedTargetPoint[this->selectedPathIndexOfRow][1] = d->TargetPointsTableModel->selectedCoordinate[index.row()][1];
-      //d->TargetPointsTableModel->selectedTargetPoint[this->selectedPathIndexOfRow][2] = d->TargetPointsTableModel->selectedCoordinate[index.row()][2];
-      this->selectedTargetPoint[this->selectedPathIndexOfRow][0] = d->TargetPointsTableModel->selectedCoordinate[index.row()][0];
-      this->selectedTargetPoint[this->selectedPathIndexOfRow][1] = d->TargetPointsTableModel->selectedCoordinate[index.row()][1];
-      this->selectedTargetPoint[this->selectedPathIndexOfRow][2] = d->TargetPointsTableModel->selectedCoordinate[index.row()][2];
-      
-      // calculate distance
-      d->PathsTableModel->calculatePath(this->selectedEntryPoint[this->selectedPathIndexOfRow], this->selectedTargetPoint[this->selectedPathIndexOfRow],this->selectedPathIndexOfRow);
-
-      /*
-      // update distance
-      double difference[3];
-      difference[0] = this->selectedTargetPoint[this->selectedPathIndexOfRow][0] - this->selectedEntryPoint[this->selectedPathIndexOfRow][0];
-      difference[0] = this->selectedTargetPoint[this->selectedPathIndexOfRow][1] - this->selectedEntryPoint[this->selectedPathIndexOfRow][1];
-      difference[0] = this->selectedTargetPoint[this->selectedPathIndexOfRow][2] - this->selectedEntryPoint[this->selectedPathIndexOfRow][2];
-      
-      fid->SetDistanceMeasurement(sqrt(difference[0]*difference[0]+difference[1]*difference[1]+difference[2]*difference[2]));
-      */
-      
-      
-      
-      //d->PathsTableModel->updateTable();
-      d->PathsTableModel->updateRulerTable();
+      // set the picked target point to the selected path and
+      // recompute the path
+      vtkIdType pointId = d->TargetPointsTableModel->identifyTipOfPath(index.row(), index.column());
+      if (pointId >= 0)
+      {
+        d->PathsTableModel->setPathTarget(this->selectedPathIndexOfRow, pointId);
+      }
     
     }
   }
+
+  // highlight the closest feasible entry points of the selected target
+  if (d->PathPlannerLogic)
+  {
+    vtkNew<vtkIdList> entryPointIds;
+    if (!indexes.isEmpty())
+    {
+      vtkIdType pointId = d->TargetPointsTableModel->identifyTipOfPath(indexes.first().row(), 0);
+      d->PathPlannerLogic->SuggestEntryPoints(pointId, d->NumberOfSuggestedEntryPoints,
+                                              entryPointIds.GetPointer());
+    }
+    d->EntryPointsTableModel->setHighlightedPoints(entryPointIds.GetPointer());
+  }
   
    /*
    // reset focus
@@ -939,12 +1348,12 @@ void qSlicerPathPlannerPanelWidget
 }
 
 
-// test code
 //-----------------------------------------------------------------------------
 void qSlicerPathPlannerPanelWidget
 ::selectEntryPoint(const QItemSelection &selected, const QItemSelection &deselected)
 {
   Q_D(qSlicerPathPlannerPanelWidget);
+  vtkSlicerPathPlannerProbeMacro(SelectEntryPointProbe);
   
   QModelIndexList indexes = this->selectionEntryPointsTableModel->selectedIndexes();
   QModelIndex index;
@@ -954,37 +1363,20 @@ void qSlicerPathPlannerPanelWidget
   {
     foreach(index, indexes)
     {
-      // test code: update the entry point name
-      std::cout << "Picked up entry!!" << std::endl;      
+      // update the entry point name
       
       d->PathsTableModel->selectedEntryPointItemRow = index.row();
       d->PathsTableModel->selectedEntryPointItemColumn = index.column();
-      std::cout << "index.row() for entry point = " << index.row() << std::endl;      
-      std::cout << "index.column() for entry point = " << index.column() << std::endl;      
+      vtkSlicerPathPlannerTraceMacro("index.row() for entry point = " << index.row());
+      vtkSlicerPathPlannerTraceMacro("index.column() for entry point = " << index.column());
       
-      // identify the selected item name
-      d->EntryPointsTableModel->identifyTipOfPath(index.row(), index.column());
-      std::cout << "selected entry name = " << d->EntryPointsTableModel->selectedName << std::endl;  
-      
-      // test code for renewing path
-      this->entryRow[this->selectedPathIndexOfRow] = index.row();
-      this->entryColumn[this->selectedPathIndexOfRow] = index.column();
-      
-      d->PathsTableModel->entryPointName[this->selectedPathIndexOfRow] = d->EntryPointsTableModel->selectedName; 
-
-      // update entry point coordinate;
-      //d->EntryPointsTableModel->selectedEntryPoint[this->selectedPathIndexOfRow][0] = d->EntryPointsTableModel->selectedCoordinate[index.row()][0];
-      //d->EntryPointsTableModel->selectedEntryPoint[this->selectedPathIndexOfRow][1] = d->EntryPointsTableModel->selectedCoordinate[index.row()][1];
-      //d->EntryPointsTableModel->selectedEntryPoint[this->selectedPathIndexOfRow][2] = d->EntryPointsTableModel->selectedCoordinate[index.row()][2];
-      this->selectedEntryPoint[this->selectedPathIndexOfRow][0] = d->EntryPointsTableModel->selectedCoordinate[index.row()][0];
-      this->selectedEntryPoint[this->selectedPathIndexOfRow][1] = d->EntryPointsTableModel->selectedCoordinate[index.row()][1];
-      this->selectedEntryPoint[this->selectedPathIndexOfRow][2] = d->EntryPointsTableModel->selectedCoordinate[index.row()][2];
-      
-      // calculate distance
-      d->PathsTableModel->calculatePath(this->selectedEntryPoint[this->selectedPathIndexOfRow], this->selectedTargetPoint[this->selectedPathIndexOfRow],this->selectedPathIndexOfRow);
-      
-      //d->PathsTableModel->updateTable();
-      d->PathsTableModel->updateRulerTable();
+      // set the picked entry point to the selected path and
+      // recompute the path
+      vtkIdType pointId = d->EntryPointsTableModel->identifyTipOfPath(index.row(), index.column());
+      if (pointId >= 0)
+      {
+        d->PathsTableModel->setPathEntry(this->selectedPathIndexOfRow, pointId);
+      }
       
     }
   }
@@ -997,6 +1389,7 @@ void qSlicerPathPlannerPanelWidget
 ::selectPathsTable(const QItemSelection &selected, const QItemSelection &deselected)
 {
   Q_D(qSlicerPathPlannerPanelWidget);
+  vtkSlicerPathPlannerProbeMacro(SelectPathsTableProbe);
   
   QModelIndexList indexes = this->selectionPathsTableModel->selectedIndexes();
   QModelIndex index;
@@ -1004,6 +1397,8 @@ void qSlicerPathPlannerPanelWidget
   // selected row and column identification
   foreach(index, indexes)
   {
+    // the view is sorted: go back to the row of the paths table model
+    index = d->PathsSortModel->mapToSource(index);
     
     d->PathsTableModel->selectedPathsTableRow = index.row();
     d->PathsTableModel->selectedPathsTableColumn = index.column();
@@ -1013,6 +1408,11 @@ void qSlicerPathPlannerPanelWidget
     // test code: selected path table
     this->selectedPathIndexOfRow = index.row();
     this->selectedPathIndexofColumn = index.column();
+
+    // the tracked needle is compared with the selected path
+    vtkSlicerPathPlannerPathStore* paths = d->Deviation->GetPaths();
+    d->Deviation->SetPlannedPathId(paths ? paths->GetId(index.row()) : -1);
+    d->PathsTableModel->setSelectedPath(index.row());
   }
   
   d->PathsTableModel->selectedTargetPointItemRow = RESET;
@@ -1020,11 +1420,6 @@ void qSlicerPathPlannerPanelWidget
   d->PathsTableModel->selectedEntryPointItemRow = RESET;
   d->PathsTableModel->selectedEntryPointItemColumn = RESET;
 
-  // calculate distance
-  //d->TargetPointsTableModel->identifyTipOfPath(this->targetRow[this->selectedPathIndexOfRow], this->targetColumn[this->selectedPathIndexOfRow]);
-  //d->EntryPointsTableModel->identifyTipOfPath(this->entryRow[this->selectedPathIndexOfRow], this->entryColumn[this->selectedPathIndexOfRow]);
-  // calculate distance
-  //d->PathsTableModel->calculatePath(d->EntryPointsTableModel->selectedCoordinate[this->entryRow[this->selectedPathIndexOfRow]], d->TargetPointsTableModel->selectedCoordinate[this->targetRow[this->selectedPathIndexOfRow]],this->selectedPathIndexOfRow);
 
 
   // reset entry point
@@ -1052,7 +1447,7 @@ void qSlicerPathPlannerPanelWidget
 {
   Q_D(qSlicerPathPlannerPanelWidget);
   
-  std::cout << "selectTargetPointTableRow =  " << i << std::endl;
+  vtkSlicerPathPlannerTraceMacro("selectTargetPointTableRow =  " << i);
   
 }
 
@@ -72,12 +72,6 @@ public:
   int selectedPathIndexOfRow;
   int selectedPathIndexofColumn;
   double differenceOfTip[3];
-  double selectedEntryPoint[100][3];
-  double selectedTargetPoint[100][3];
-  int targetRow[100];
-  int targetColumn[100];
-  int entryRow[100];
-  int entryColumn[100];
   
 
 public slots:
@@ -97,6 +91,23 @@ public slots:
   void setTrackerTransform(vtkMRMLNode*);
   void onTrackerTransformModified();
 
+  /// Record the poses of the tracker transform to a binary file (see
+  /// vtkSlicerPathPlannerTrackerRecorder) until stopTrackerRecording()
+  bool startTrackerRecording(const QString& fileName);
+  void stopTrackerRecording();
+  /// Replay a recording in place of the tracker: 1 for real time, 0 for as
+  /// fast as possible
+  bool replayTrackerRecording(const QString& fileName, double speed = 1.0);
+  void stopTrackerReplay();
+
+  /// Check the paths against a labelmap volume (NULL for none)
+  void setLabelMapVolume(vtkMRMLNode*);
+  /// Check the paths against the models checked in the surface model list
+  void setSurfaceModels();
+  /// Draw the paths as one model colored by cost instead of one ruler each
+  /// (see qSlicerPathPlannerTableModel::setPathSetDisplay())
+  void setPathSetDisplay(bool enabled);
+
   void setEntryPointsAnnotationNode(vtkMRMLNode*);  
   void setTargetPointsAnnotationNode(vtkMRMLNode*);
   // test code
@@ -112,10 +123,21 @@ protected slots:
   void addEntryPointButtonClicked();
   void switchCurrentAnotationNode(int);
   void addPathRow();
+  void generateAllPaths();
+  /// Add the NumberOfPathsPerTarget cheapest paths of each target point
+  void generateBestPaths();
+  /// Add entry points sampled on the skin model or CT volume selected
+  void sampleSkin();
+  void onPathsPlanned(qulonglong generation, int numberOfPaths);
+  /// Show the deviation of the latest tracker pose from the selected path
+  void updateTrackerDeviation();
     
 protected:
   QScopedPointer<qSlicerPathPlannerPanelWidgetPrivate> d_ptr;
 
+  /// Make the selected paths hierarchy the one new rulers are added to
+  void setActivePathsHierarchy();
+
 private:
   Q_DECLARE_PRIVATE(qSlicerPathPlannerPanelWidget);
   Q_DISABLE_COPY(qSlicerPathPlannerPanelWidget);
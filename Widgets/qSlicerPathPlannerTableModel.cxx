@@ -20,21 +20,47 @@
 
 // PathPlannerPanel Widgets includes
 #include "qSlicerPathPlannerTableModel.h"
+#include "qSlicerPathPlannerUpdateScheduler.h"
+
+// Qt includes
+#include <QAtomicInt>
+#include <QColor>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+#include <QStringList>
+
+// PathPlanner Logic includes
+#include "vtkSlicerPathPlannerExecutor.h"
+#include "vtkSlicerPathPlannerLogic.h"
+#include "vtkSlicerPathPlannerPathSet.h"
+#include "vtkSlicerPathPlannerPathStore.h"
+#include "vtkSlicerPathPlannerPointStore.h"
+#include "vtkSlicerPathPlannerProfiler.h"
+#include "vtkSlicerPathPlannerTrace.h"
 
 #include "vtkMRMLAnnotationHierarchyNode.h"
+#include "vtkMRMLAnnotationNode.h"
 #include "vtkMRMLAnnotationFiducialNode.h"
 #include "vtkMRMLAnnotationRulerNode.h"
 
 
 #include "vtkMRMLAnnotationPointDisplayNode.h"
+#include "vtkMRMLModelDisplayNode.h"
+#include "vtkMRMLModelNode.h"
 #include "vtkMRMLScene.h"
 
 #include "vtkNew.h"
 #include "vtkSmartPointer.h"
 #include "vtkCollection.h"
+#include "vtkIdList.h"
 
+#include <algorithm>
+#include <cstring>
 #include <map>
 #include <sstream>
+#include <vector>
 
 
 class Q_SLICER_MODULE_PATHPLANNER_WIDGETS_EXPORT qSlicerPathPlannerTableModelPrivate
@@ -52,12 +78,151 @@ class Q_SLICER_MODULE_PATHPLANNER_WIDGETS_EXPORT qSlicerPathPlannerTableModelPri
   void initForEntryList();
   void initForTargetList();
   void initForPathList();
+  void setHeaderLabels(const QStringList& labels);
+
+  // Stores of the logic shown by this list (NULL if there is none)
+  vtkSlicerPathPlannerPointStore* pointStore()const;
+  vtkSlicerPathPlannerPathStore* pathStore()const;
+  vtkIdType storeSize()const;
+
+  // Reset the view if the store was changed behind the back of the model
+  void checkRowCount();
+
+  // Row of the point (path) mirroring the node, -1 if there is none
+  vtkIdType rowOfNode(const char* nodeID)const;
+  void rebuildNodeIndex();
+
+  // Append/remove rows of the store, notifying the views
+  vtkIdType appendPoint(const double position[3], const char* name, const char* nodeID);
+  vtkIdType appendPath(const char* name, const char* nodeID);
+  vtkIdType appendFiducial(vtkMRMLAnnotationFiducialNode* fnode);
+  vtkIdType appendRuler(vtkMRMLAnnotationRulerNode* rnode);
+  void removeRow(vtkIdType row);
+  void removeRows(vtkIdList* rows);
+
+  // Fiducial and ruler children of HierarchyNode. The lists are cached
+  // and only rebuilt after a hierarchy event invalidated them.
+  void invalidateChildren();
+  void updateChildren();
+
+  // Mirror the fiducial (ruler) children of HierarchyNode into the point
+  // (path) store. RulerOfRow receives the ruler node of each path, if any.
+  void synchronizePointStore();
+  void synchronizePathStore();
+
+  // Copy the fiducial into the point at index. Return true if it changed.
+  bool updatePoint(vtkIdType index, vtkMRMLAnnotationFiducialNode* fnode);
+  // Move the ruler to the end points of the path at index
+  void moveRuler(vtkIdType index, vtkMRMLAnnotationRulerNode* rnode);
+  // Recompute the paths using the entry (target) point pointId only, in
+  // the background
+  void updatePathsOfPoint(vtkIdType pointId, bool target);
+  // Recompute the paths at pathIndices in the background
+  void updatePaths(vtkIdList* pathIndices);
+  // Move the rulers and refresh the rows of the updated paths
+  void updatePathRows(vtkIdList* pathIndices);
+
+  // Model node drawing the path set, created if create is true and the
+  // node is missing. NULL if there is none.
+  vtkMRMLModelNode* pathSetNode(bool create);
+
+  // Called on a worker thread when a background path update finished:
+  // queue a pathUpdatesFinished() signal unless one is pending already
+  static void onPathUpdateFinished(void* clientData);
+
   vtkMRMLAnnotationHierarchyNode* HierarchyNode;
   int PendingItemModified; // -1 means not updating
   vtkMRMLScene* Scene;
+  vtkSlicerPathPlannerLogic* Logic;
+  qSlicerPathPlannerUpdateScheduler* Scheduler;
+  int ListType;
   int Counter;
-  
+
+  // Number of rows known by the views
+  int RowCount;
+  QStringList HeaderLabels;
+
+  std::vector<vtkMRMLAnnotationFiducialNode*> Fiducials;
+  std::vector<vtkMRMLAnnotationRulerNode*> Rulers;
+  bool ChildrenModified;
+
+  // Buffers reused by the synchronization
+  std::vector<bool> Found;
+  std::vector<vtkMRMLAnnotationRulerNode*> RulerOfRow;
+  std::vector<double> PreviousGeometry;
+
+  // ID of the point (path) mirroring each node, by node ID. The node of a
+  // row is the node ID kept by the store.
+  QHash<QString, vtkIdType> NodeIDToId;
+
+  // Time stamp and memo of the rows, by point (path) ID
+  QHash<vtkIdType, QString> Times;
+  QHash<vtkIdType, QString> Memos;
+
+  // Highlighted points, by point ID
+  QSet<vtkIdType> HighlightedIds;
+
+  // Background planning: generation of the latest request and its token,
+  // and the plans finished but not applied yet, by generation
+  qulonglong PlanGeneration;
+  vtkSlicerPathPlannerExecutor::CancellationToken PlanToken;
+  QMutex PlanMutex;
+  QHash<qulonglong, vtkSlicerPathPlannerPathStore*> PlannedPaths;
+
+  // 1 while a pathUpdatesFinished() signal is queued
+  QAtomicInt PathUpdatesQueued;
+
+  // Path set display and the ID of its model node in Scene
+  bool PathSetDisplay;
+  QString PathSetNodeID;
+};
+
+namespace
+{
+//------------------------------------------------------------------------------
+// Planning run on the executor of the logic, on snapshots of the point
+// stores: the paths found wait in PlannedPaths until the queued
+// planFinished() signal reaches the model.
+class PlanJob : public vtkSlicerPathPlannerExecutor::Job
+{
+public:
+  qSlicerPathPlannerTableModel* Model;
+  qSlicerPathPlannerTableModelPrivate* Private;
+  vtkSlicerPathPlannerLogic* Logic;
+  qulonglong Generation;
+  int NumberOfPathsPerTarget;
+  vtkSlicerPathPlannerPointStore* EntryPoints;
+  vtkSlicerPathPlannerPointStore* TargetPoints;
+  vtkSlicerPathPlannerPathStore* Paths;
+
+  virtual ~PlanJob()
+  {
+    this->EntryPoints->Delete();
+    this->TargetPoints->Delete();
+    if (this->Paths)
+      {
+      this->Paths->Delete();
+      }
+  }
+
+  virtual void Run(const vtkSlicerPathPlannerExecutor::CancellationToken& token)
+  {
+    this->Logic->PlanPaths(this->EntryPoints, this->TargetPoints,
+                           this->NumberOfPathsPerTarget, this->Paths);
+    if (token.IsCanceled())
+      {
+      return;
+      }
+      {
+      QMutexLocker locker(&this->Private->PlanMutex);
+      this->Private->PlannedPaths.insert(this->Generation, this->Paths);
+      this->Paths = 0;
+      }
+    QMetaObject::invokeMethod(this->Model, "planFinished", Qt::QueuedConnection,
+                              Q_ARG(qulonglong, this->Generation));
+  }
 };
+}
 
 qSlicerPathPlannerTableModelPrivate
 ::qSlicerPathPlannerTableModelPrivate(
@@ -67,1208 +232,2027 @@ qSlicerPathPlannerTableModelPrivate
   this->HierarchyNode = NULL;
   this->PendingItemModified = -1; // -1 means not updating
   this->Scene = NULL;
+  this->Logic = NULL;
+  this->ListType = qSlicerPathPlannerTableModel::LABEL_RAS;
   this->Counter = 0;
+  this->RowCount = 0;
+  this->ChildrenModified = true;
+  this->PlanGeneration = 0;
+  this->PathUpdatesQueued = 0;
+  this->PathSetDisplay = false;
+
+  this->Scheduler = new qSlicerPathPlannerUpdateScheduler(&object);
+  QObject::connect(this->Scheduler, SIGNAL(updateRequested(QList<vtkIdType>,bool)),
+                   &object, SLOT(onScheduledUpdate(QList<vtkIdType>,bool)));
+
+  // Emitted by the workers of the executor: run the slots on this thread
+  QObject::connect(&object, SIGNAL(planFinished(qulonglong)),
+                   &object, SLOT(onPlanFinished(qulonglong)), Qt::QueuedConnection);
+  QObject::connect(&object, SIGNAL(pathUpdatesFinished()),
+                   &object, SLOT(collectPathUpdates()), Qt::QueuedConnection);
 }
 
 qSlicerPathPlannerTableModelPrivate
 ::~qSlicerPathPlannerTableModelPrivate()
 {
   //Q_D(qSlicerPathPlannerTableModel);
+
+  // The jobs use this object
+  if (this->Logic && this->ListType == qSlicerPathPlannerTableModel::LABEL_RAS_PATH)
+    {
+    this->PlanToken.Cancel();
+    this->Logic->SetPathUpdateCallback(0, 0);
+    this->Logic->CancelPathUpdates();
+    }
+  foreach (vtkSlicerPathPlannerPathStore* planned, this->PlannedPaths)
+    {
+    planned->Delete();
+    }
 }
 
 
 void qSlicerPathPlannerTableModelPrivate
 ::init()
 {
-  Q_Q(qSlicerPathPlannerTableModel);
-
-  q->setColumnCount(6);
-  q->setHorizontalHeaderLabels(QStringList()
-                               << "Point Name"
-                               << "R"
-                               << "A"
-                               << "S"
-                               << "Time"
-                               << "Memo");
-  QObject::connect(q, SIGNAL(itemChanged(QStandardItem*)),
-                   q, SLOT(onItemChanged(QStandardItem*)));
-
+  this->setHeaderLabels(QStringList()
+                        << "Point Name"
+                        << "R"
+                        << "A"
+                        << "S"
+                        << "Time"
+                        << "Memo");
 }
 
 void qSlicerPathPlannerTableModelPrivate
 ::initForEntryList()
 {
-  Q_Q(qSlicerPathPlannerTableModel);
-  
-  q->setColumnCount(6);
-  q->setHorizontalHeaderLabels(QStringList()
-                               << "Entry Point"
-                               << "R"
-                               << "A"
-                               << "S"
-                               << "Time"
-                               << "Memo");
-  QObject::connect(q, SIGNAL(itemChanged(QStandardItem*)),
-                   q, SLOT(onRulerItemChanged(QStandardItem*)));
-  
+  this->setHeaderLabels(QStringList()
+                        << "Entry Point"
+                        << "R"
+                        << "A"
+                        << "S"
+                        << "Time"
+                        << "Memo");
 }
 
 void qSlicerPathPlannerTableModelPrivate
 ::initForTargetList()
 {
-  Q_Q(qSlicerPathPlannerTableModel);
-  
-  q->setColumnCount(6);
-  q->setHorizontalHeaderLabels(QStringList()
-                               << "Target Point"
-                               << "R"
-                               << "A"
-                               << "S"
-                               << "Time"
-                               << "Memo");
-  QObject::connect(q, SIGNAL(itemChanged(QStandardItem*)),
-                   q, SLOT(onItemChanged(QStandardItem*)));
-  
+  this->setHeaderLabels(QStringList()
+                        << "Target Point"
+                        << "R"
+                        << "A"
+                        << "S"
+                        << "Time"
+                        << "Memo");
 }
 
 void qSlicerPathPlannerTableModelPrivate
 ::initForPathList()
 {
-  Q_Q(qSlicerPathPlannerTableModel);
-  
-  q->setColumnCount(6);
-  q->setHorizontalHeaderLabels(QStringList()
-                               << "Path"
-                               << "Target"
-                               << "Entry"
-                               << "Length"
-                               << "Time"
-                               << "Memo");
-  QObject::connect(q, SIGNAL(itemChanged(QStandardItem*)),
-                   q, SLOT(onRulerItemChanged(QStandardItem*)));
-  
+  this->setHeaderLabels(QStringList()
+                        << "Path"
+                        << "Target"
+                        << "Entry"
+                        << "Length"
+                        << "Time"
+                        << "Memo"
+                        << "Hits"
+                        << "Clearance"
+                        << "Models"
+                        << "Cost");
 }
 
-qSlicerPathPlannerTableModel
-::qSlicerPathPlannerTableModel(QObject *parent)
-  : QStandardItemModel(parent)
-  , d_ptr( new qSlicerPathPlannerTableModelPrivate(*this) )
+//------------------------------------------------------------------------------
+void qSlicerPathPlannerTableModelPrivate
+::setHeaderLabels(const QStringList& labels)
 {
-  Q_D(qSlicerPathPlannerTableModel);
-  d->init();
-  
-  // initialize
-  this->addRowFlag = 0;
-  this->nItemsPrevious = 1;
-  
-  this->selectedTargetPointItemRow = RESET;
-  this->selectedTargetPointItemColumn = RESET;
-  this->selectedEntryPointItemRow = RESET;
-  this->selectedEntryPointItemColumn = RESET;
-  this->selectedPathsTableRow = RESET;
-  this->selectedPathsTableColumn = RESET;
-  this->pathColumnCounter = 0;
-  //this->pathDistance = 0.0;
-}
+  Q_Q(qSlicerPathPlannerTableModel);
 
-qSlicerPathPlannerTableModel
-::~qSlicerPathPlannerTableModel()
-{
+  // Only the path list has the Hits, Clearance, Models and Cost columns
+  if (labels.size() != this->HeaderLabels.size())
+    {
+    q->beginResetModel();
+    this->HeaderLabels = labels;
+    q->endResetModel();
+    return;
+    }
+  this->HeaderLabels = labels;
+  emit q->headerDataChanged(Qt::Horizontal, 0, labels.size() - 1);
 }
 
-qSlicerPathPlannerTableModel
-::qSlicerPathPlannerTableModel(qSlicerPathPlannerTableModelPrivate* pimpl, QObject *parent)
-  : QStandardItemModel(parent)
-  , d_ptr(pimpl)
+//------------------------------------------------------------------------------
+vtkSlicerPathPlannerPointStore* qSlicerPathPlannerTableModelPrivate
+::pointStore()const
 {
-  Q_D(qSlicerPathPlannerTableModel);
-  d->init();
+  if (!this->Logic)
+    {
+    return NULL;
+    }
+  switch (this->ListType)
+    {
+    case qSlicerPathPlannerTableModel::LABEL_RAS_ENTRY:
+      return this->Logic->GetEntryPoints();
+    case qSlicerPathPlannerTableModel::LABEL_RAS_TARGET:
+      return this->Logic->GetTargetPoints();
+    default:
+      return NULL;
+    }
 }
 
-void qSlicerPathPlannerTableModel
-::initList(int i)
+//------------------------------------------------------------------------------
+vtkSlicerPathPlannerPathStore* qSlicerPathPlannerTableModelPrivate
+::pathStore()const
 {
-  Q_D(qSlicerPathPlannerTableModel);
-  
-  switch (i)
-  {
-    case LABEL_RAS_ENTRY:
-    {
-      d->initForEntryList();  
-      break;
-    }
-    case LABEL_RAS_TARGET:
+  if (!this->Logic || this->ListType != qSlicerPathPlannerTableModel::LABEL_RAS_PATH)
     {
-      d->initForTargetList();  
-      break;
+    return NULL;
     }
-    case LABEL_RAS_PATH:
+  return this->Logic->GetPaths();
+}
+
+//------------------------------------------------------------------------------
+vtkIdType qSlicerPathPlannerTableModelPrivate
+::storeSize()const
+{
+  if (vtkSlicerPathPlannerPointStore* points = this->pointStore())
     {
-      d->initForPathList();  
-      break;
+    return points->GetNumberOfPoints();
     }
-    default:
+  if (vtkSlicerPathPlannerPathStore* paths = this->pathStore())
     {
-      d->init();  
-      break;
+    return paths->GetNumberOfPaths();
     }
-  }
-  
+  return 0;
 }
 
-
-void qSlicerPathPlannerTableModel
-::setNode(vtkMRMLNode* node)
+//------------------------------------------------------------------------------
+void qSlicerPathPlannerTableModelPrivate
+::checkRowCount()
 {
-  Q_D(qSlicerPathPlannerTableModel);
+  Q_Q(qSlicerPathPlannerTableModel);
 
-  if (node == NULL)
+  int size = static_cast<int>(this->storeSize());
+  if (size != this->RowCount)
     {
-    d->HierarchyNode = NULL;
+    q->beginResetModel();
+    this->RowCount = size;
+    this->rebuildNodeIndex();
+    q->endResetModel();
     }
-  
-  vtkMRMLAnnotationHierarchyNode* hnode;
-  hnode = vtkMRMLAnnotationHierarchyNode::SafeDownCast(node);
-  if (hnode)
-  {
-    qvtkReconnect(d->HierarchyNode, node,
-                  vtkMRMLHierarchyNode::ChildNodeAddedEvent,
-                  this, SLOT(onMRMLChildNodeAdded(vtkObject*)));
-    qvtkReconnect(d->HierarchyNode, node,
-                  vtkMRMLHierarchyNode::ChildNodeRemovedEvent,
-                  this, SLOT(onMRMLChildNodeRemoved(vtkObject*)));
-    // NOTE (10/13/2012): ChildNodeRemovedEvent works when a child node is moved
-    // to another annotation hierarchy, but doesn't work when a child
-    // node is removed. For this reason,in addition to ChildNodeRemovedEvent,
-    // onMRMLNodeRemovedEvent() is connected to NodeRemovedEvent invoked by the scene.
+}
 
-    // Disconnect slots from old child nodes
-    if (d->HierarchyNode)
+//------------------------------------------------------------------------------
+vtkIdType qSlicerPathPlannerTableModelPrivate
+::rowOfNode(const char* nodeID)const
+{
+  if (!nodeID)
     {
-      vtkNew<vtkCollection> collection;
-      d->HierarchyNode->GetDirectChildren(collection.GetPointer());
-      int nItems = collection->GetNumberOfItems();
-      collection->InitTraversal();
-      for (int i = 0; i < nItems; i ++)
-      {
-        vtkMRMLAnnotationFiducialNode* fnode;
-        fnode = vtkMRMLAnnotationFiducialNode::SafeDownCast(collection->GetNextItemAsObject());
-        if (fnode)
-        {
-          qvtkDisconnect(fnode, vtkMRMLAnnotationFiducialNode::ValueModifiedEvent,
-                         this, SLOT(onMRMLChildNodeValueModified(vtkObject*)));
-          fnode->SetAttribute("RFTEvent", NULL);
-        }
-      }
-    
-      // test code
-      for (int i = 0; i < nItems; i ++)
-      {
-        vtkMRMLAnnotationRulerNode* rnode;
-        rnode = vtkMRMLAnnotationRulerNode::SafeDownCast(collection->GetNextItemAsObject());
-        if (rnode)
-        {
-          qvtkDisconnect(rnode, vtkMRMLAnnotationRulerNode::ValueModifiedEvent,
-                         this, SLOT(onMRMLChildNodeValueModified(vtkObject*)));
-          rnode->SetAttribute("RFTEvent", NULL);
-        }
-      }
-      
+    return -1;
     }
-
-    vtkNew<vtkCollection> collection;
-    // Connect slots to handle chlid node event
-    hnode->GetDirectChildren(collection.GetPointer());
-    int nItems = collection->GetNumberOfItems();
-    collection->InitTraversal();
-    for (int i = 0; i < nItems; i ++)
+  QHash<QString, vtkIdType>::const_iterator it = this->NodeIDToId.find(nodeID);
+  if (it == this->NodeIDToId.end())
     {
-      vtkMRMLAnnotationFiducialNode* fnode;
-      fnode = vtkMRMLAnnotationFiducialNode::SafeDownCast(collection->GetNextItemAsObject());
-      if (fnode)
-      {
-        // Connect the fiducial node to onMRMLChildNodeValueModified().
-        // An attribute "RFTEvent" is set "Yes" to mark that the fiducial node is connected. 
-        qvtkConnect(fnode, vtkMRMLAnnotationFiducialNode::ValueModifiedEvent,
-                    this, SLOT(onMRMLChildNodeValueModified(vtkObject*)));
-        fnode->SetAttribute("RFTEvent", "Yes");
-      }
+    return -1;
+    }
+  if (vtkSlicerPathPlannerPointStore* points = this->pointStore())
+    {
+    return points->GetIndex(it.value());
+    }
+  if (vtkSlicerPathPlannerPathStore* paths = this->pathStore())
+    {
+    return paths->GetIndex(it.value());
     }
+  return -1;
+}
 
-    // test code
-    for (int i = 0; i < nItems; i ++)
+//------------------------------------------------------------------------------
+void qSlicerPathPlannerTableModelPrivate
+::rebuildNodeIndex()
+{
+  this->NodeIDToId.clear();
+  vtkSlicerPathPlannerPointStore* points = this->pointStore();
+  vtkSlicerPathPlannerPathStore* paths = this->pathStore();
+  vtkIdType n = this->storeSize();
+  for (vtkIdType i = 0; i < n; i ++)
     {
-      vtkMRMLAnnotationRulerNode* rnode;
-      rnode = vtkMRMLAnnotationRulerNode::SafeDownCast(collection->GetNextItemAsObject());
-      if (rnode)
+    const char* nodeID = points ? points->GetNodeID(i) : paths->GetNodeID(i);
+    if (nodeID[0] != '\0')
       {
-        // Connect the fiducial node to onMRMLChildNodeValueModified().
-        // An attribute "RFTEvent" is set "Yes" to mark that the fiducial node is connected. 
-        qvtkConnect(rnode, vtkMRMLAnnotationRulerNode::ValueModifiedEvent,
-                    this, SLOT(onMRMLChildNodeValueModified(vtkObject*)));
-        rnode->SetAttribute("RFTEvent", "Yes");
+      this->NodeIDToId.insert(nodeID, points ? points->GetId(i) : paths->GetId(i));
       }
     }
-    
-    
-    d->HierarchyNode = hnode;
-  }
+}
 
-  this->updateTable();
+//------------------------------------------------------------------------------
+vtkIdType qSlicerPathPlannerTableModelPrivate
+::appendPoint(const double position[3], const char* name, const char* nodeID)
+{
+  Q_Q(qSlicerPathPlannerTableModel);
 
+  q->beginInsertRows(QModelIndex(), this->RowCount, this->RowCount);
+  vtkIdType id = this->pointStore()->AddPoint(position, name, nodeID);
+  if (nodeID && nodeID[0] != '\0')
+    {
+    this->NodeIDToId.insert(nodeID, id);
+    }
+  this->Times[id] = QTime::currentTime().toString();
+  this->RowCount ++;
+  q->endInsertRows();
+  return id;
 }
 
-
 //------------------------------------------------------------------------------
-void qSlicerPathPlannerTableModel
-::setCoordinateLabel(int m)
+vtkIdType qSlicerPathPlannerTableModelPrivate
+::appendPath(const char* name, const char* nodeID)
 {
-  Q_D(qSlicerPathPlannerTableModel);
+  Q_Q(qSlicerPathPlannerTableModel);
 
-  QStringList list;
-  
-  switch (m)
+  q->beginInsertRows(QModelIndex(), this->RowCount, this->RowCount);
+  vtkIdType id = this->pathStore()->AddPath(name, nodeID);
+  if (nodeID && nodeID[0] != '\0')
     {
-    case LABEL_RAS:
-      {
-      list << "Point Name" << "R" << "A" << "S" << "Time" << "Memo";
-      break;
-      }
-    case LABEL_RAS_ENTRY:
-      {
-      list << "Entry Point" << "R" << "A" << "S" << "Time" << "Memo";
-      break;
-      }
-    case LABEL_RAS_TARGET:
-      {
-      list << "Target Point" << "R" << "A" << "S" << "Time" << "Memo";
-      break;
-      }
-    case LABEL_RAS_PATH:
-      {
-        list << "Path" << "Target" << "Entry" << "Length" << "Time" << "Memo";
-        break;
-      }
-    case LABEL_XYZ:
-      {
-      list << "Point Name" << "X" << "Y" << "Z" << "Time" << "Memo";
-      break;
-      }
-    default:
-      {
-      return;
-      break;
-      }
+    this->NodeIDToId.insert(nodeID, id);
     }
-  this->setHorizontalHeaderLabels(list);
+  this->Times[id] = QTime::currentTime().toString();
+  this->RowCount ++;
+  q->endInsertRows();
+  return id;
 }
 
+//------------------------------------------------------------------------------
+vtkIdType qSlicerPathPlannerTableModelPrivate
+::appendFiducial(vtkMRMLAnnotationFiducialNode* fnode)
+{
+  return this->appendPoint(fnode->GetFiducialCoordinates(), fnode->GetName(), fnode->GetID());
+}
 
 //------------------------------------------------------------------------------
-void qSlicerPathPlannerTableModel
-::updateTable()
+vtkIdType qSlicerPathPlannerTableModelPrivate
+::appendRuler(vtkMRMLAnnotationRulerNode* rnode)
 {
-  Q_D(qSlicerPathPlannerTableModel);
+  // ruler that was not created by this model (e.g. loaded with the scene):
+  // keep its end points until points are picked for it
+  vtkSlicerPathPlannerPathStore* store = this->pathStore();
+  vtkIdType id = this->appendPath(rnode->GetName(), rnode->GetID());
+  vtkIdType index = store->GetIndex(id);
+  double position[3];
+  rnode->GetPosition1(position);
+  store->SetTarget(index, -1, position);
+  rnode->GetPosition2(position);
+  store->SetEntry(index, -1, position);
+  return id;
+}
 
-  
-  // test code
-  std::cout << "updatedTable" << std::endl;  
+//------------------------------------------------------------------------------
+void qSlicerPathPlannerTableModelPrivate
+::removeRow(vtkIdType row)
+{
+  Q_Q(qSlicerPathPlannerTableModel);
 
-  if (d->HierarchyNode == 0)
-    {
-    this->setRowCount(0);
+  vtkSlicerPathPlannerPointStore* points = this->pointStore();
+  vtkSlicerPathPlannerPathStore* paths = this->pathStore();
+  vtkIdType id = points ? points->GetId(row) : paths->GetId(row);
 
-    return;
+  q->beginRemoveRows(QModelIndex(), row, row);
+  this->NodeIDToId.remove(points ? points->GetNodeID(row) : paths->GetNodeID(row));
+  if (points)
+    {
+    points->RemovePoint(row);
     }
+  else
+    {
+    paths->RemovePath(row);
+    }
+  this->Times.remove(id);
+  this->Memos.remove(id);
+  this->HighlightedIds.remove(id);
+  this->RowCount --;
+  q->endRemoveRows();
+}
 
-  d->PendingItemModified = 0;
-
-  //QObject::disconnect(this, SIGNAL(itemChanged(QStandardItem*)),
-  //                    this, SLOT(onItemChanged(QStandardItem*)));
+//------------------------------------------------------------------------------
+void qSlicerPathPlannerTableModelPrivate
+::removeRows(vtkIdList* rows)
+{
+  Q_Q(qSlicerPathPlannerTableModel);
 
-  // Count the number of child Fiducial nodes 
-  vtkNew<vtkCollection> collection;
-  d->HierarchyNode->GetDirectChildren(collection.GetPointer());
-  int nItems = collection->GetNumberOfItems();
-  int nFiducials = 0;
-  
-  // flag if time and memo should be refreshed in column 5 and 6
-  if (nItems > this->nItemsPrevious)
-  {
-    this->addRowFlag = 1;
-    this->nItemsPrevious = nItems;
-  }
-  else
-  {
-    this->addRowFlag = 0;    
-    this->nItemsPrevious = nItems;
-  }
-  
-  collection->InitTraversal();
-  for (int i = 0; i < nItems; i ++)
+  vtkIdType nRows = rows->GetNumberOfIds();
+  if (nRows <= 1)
     {
-    vtkMRMLAnnotationFiducialNode* fnode;
-    fnode = vtkMRMLAnnotationFiducialNode::SafeDownCast(collection->GetNextItemAsObject());
-    if (fnode)
+    if (nRows == 1)
       {
-      nFiducials ++;
+      this->removeRow(rows->GetId(0));
       }
+    return;
     }
-  this->setRowCount(nFiducials);
 
-  collection->InitTraversal();
-  for (int i = 0; i < nItems; i ++)
+  // Rows scattered over the table (e.g. a bulk delete): the store removes
+  // them in one pass and the views are reset once
+  vtkSlicerPathPlannerPointStore* points = this->pointStore();
+  vtkSlicerPathPlannerPathStore* paths = this->pathStore();
+  q->beginResetModel();
+  for (vtkIdType k = 0; k < nRows; k ++)
     {
-    vtkMRMLAnnotationFiducialNode* fnode;
-    fnode = vtkMRMLAnnotationFiducialNode::SafeDownCast(collection->GetNextItemAsObject());
-    if (fnode)
-      {
-      QStandardItem* item = this->invisibleRootItem()->child(i, 0);
-      if (item == NULL)
-        {
-        item = new QStandardItem();
-        this->invisibleRootItem()->setChild(i, 0, item);
-        }
-      item->setText(fnode->GetName());
-      item->setData(fnode->GetID(),qSlicerPathPlannerTableModel::NodeIDRole);
+    vtkIdType row = rows->GetId(k);
+    vtkIdType id = points ? points->GetId(row) : paths->GetId(row);
+    this->NodeIDToId.remove(points ? points->GetNodeID(row) : paths->GetNodeID(row));
+    this->Times.remove(id);
+    this->Memos.remove(id);
+    this->HighlightedIds.remove(id);
+    }
+  if (points)
+    {
+    points->RemovePoints(rows);
+    }
+  else
+    {
+    paths->RemovePaths(rows);
+    }
+  this->RowCount = static_cast<int>(this->storeSize());
+  q->endResetModel();
+}
 
-      for (int j = 0; j < 5; j ++)
-        {
-        QStandardItem* item = this->invisibleRootItem()->child(i, j+1);
-        if (item == NULL)
-          {
-          item = new QStandardItem();
-          this->invisibleRootItem()->setChild(i, j+1, item);
-          }
-        QString str;
-        str.setNum(fnode->GetFiducialCoordinates()[j]);
-          if(j<3)
+//------------------------------------------------------------------------------
+void qSlicerPathPlannerTableModelPrivate
+::synchronizePointStore()
+{
+  Q_Q(qSlicerPathPlannerTableModel);
+
+  vtkSlicerPathPlannerPointStore* store = this->pointStore();
+  if (!store)
+    {
+    return;
+    }
+  this->checkRowCount();
+
+  this->updateChildren();
+  this->Found.assign(store->GetNumberOfPoints(), false);
+  int firstChanged = this->RowCount;
+  int lastChanged = -1;
+  for (size_t i = 0; i < this->Fiducials.size(); i ++)
+    {
+    vtkMRMLAnnotationFiducialNode* fnode = this->Fiducials[i];
+    vtkIdType index = this->rowOfNode(fnode->GetID());
+    if (index < 0)
+      {
+      this->appendFiducial(fnode);
+      this->Found.push_back(true);
+      continue;
+      }
+
+    if (this->updatePoint(index, fnode))
+      {
+      firstChanged = std::min(firstChanged, static_cast<int>(index));
+      lastChanged = std::max(lastChanged, static_cast<int>(index));
+      }
+    this->Found[index] = true;
+    }
+
+  if (firstChanged <= lastChanged)
+    {
+    emit q->dataChanged(q->index(firstChanged, qSlicerPathPlannerTableModel::NameColumn),
+                        q->index(lastChanged, qSlicerPathPlannerTableModel::SColumn));
+    }
+
+  // Forget the points whose fiducial is gone
+  vtkNew<vtkIdList> removedRows;
+  for (vtkIdType i = 0; i < store->GetNumberOfPoints(); i ++)
+    {
+    if (!this->Found[i] && store->GetNodeID(i)[0] != '\0')
+      {
+      removedRows->InsertNextId(i);
+      }
+    }
+  this->removeRows(removedRows.GetPointer());
+}
+
+//------------------------------------------------------------------------------
+void qSlicerPathPlannerTableModelPrivate
+::synchronizePathStore()
+{
+  Q_Q(qSlicerPathPlannerTableModel);
+
+  vtkSlicerPathPlannerPathStore* store = this->pathStore();
+  std::vector<vtkMRMLAnnotationRulerNode*>& rulers = this->RulerOfRow;
+  rulers.clear();
+  if (!store)
+    {
+    return;
+    }
+  this->checkRowCount();
+  this->updateChildren();
+
+  rulers.resize(store->GetNumberOfPaths(), NULL);
+  int firstChanged = this->RowCount;
+  int lastChanged = -1;
+  for (size_t i = 0; i < this->Rulers.size(); i ++)
+    {
+    vtkMRMLAnnotationRulerNode* rnode = this->Rulers[i];
+    const char* name = rnode->GetName() ? rnode->GetName() : "";
+    vtkIdType index = this->rowOfNode(rnode->GetID());
+    if (index < 0)
+      {
+      this->appendRuler(rnode);
+      rulers.push_back(rnode);
+      continue;
+      }
+
+    if (strcmp(store->GetName(index), name) != 0)
+      {
+      store->SetName(index, name);
+      firstChanged = std::min(firstChanged, static_cast<int>(index));
+      lastChanged = std::max(lastChanged, static_cast<int>(index));
+      }
+    rulers[index] = rnode;
+    }
+
+  if (firstChanged <= lastChanged)
+    {
+    emit q->dataChanged(q->index(firstChanged, qSlicerPathPlannerTableModel::NameColumn),
+                        q->index(lastChanged, qSlicerPathPlannerTableModel::NameColumn));
+    }
+
+  // Forget the paths whose ruler is gone
+  vtkNew<vtkIdList> removedRows;
+  size_t nKept = 0;
+  for (vtkIdType i = 0; i < store->GetNumberOfPaths(); i ++)
+    {
+    if (!rulers[i] && store->GetNodeID(i)[0] != '\0')
+      {
+      removedRows->InsertNextId(i);
+      continue;
+      }
+    rulers[nKept ++] = rulers[i];
+    }
+  rulers.resize(nKept);
+  this->removeRows(removedRows.GetPointer());
+}
+
+//------------------------------------------------------------------------------
+void qSlicerPathPlannerTableModelPrivate
+::invalidateChildren()
+{
+  this->ChildrenModified = true;
+}
+
+//------------------------------------------------------------------------------
+void qSlicerPathPlannerTableModelPrivate
+::updateChildren()
+{
+  if (!this->ChildrenModified)
+    {
+    return;
+    }
+  this->Fiducials.clear();
+  this->Rulers.clear();
+  if (this->HierarchyNode)
+    {
+    vtkNew<vtkCollection> collection;
+    this->HierarchyNode->GetDirectChildren(collection.GetPointer());
+    int nItems = collection->GetNumberOfItems();
+    collection->InitTraversal();
+    for (int i = 0; i < nItems; i ++)
+      {
+      vtkObject* child = collection->GetNextItemAsObject();
+      if (vtkMRMLAnnotationFiducialNode* fnode = vtkMRMLAnnotationFiducialNode::SafeDownCast(child))
+        {
+        this->Fiducials.push_back(fnode);
+        }
+      else if (vtkMRMLAnnotationRulerNode* rnode = vtkMRMLAnnotationRulerNode::SafeDownCast(child))
+        {
+        this->Rulers.push_back(rnode);
+        }
+      }
+    }
+  this->ChildrenModified = false;
+}
+
+//------------------------------------------------------------------------------
+bool qSlicerPathPlannerTableModelPrivate
+::updatePoint(vtkIdType index, vtkMRMLAnnotationFiducialNode* fnode)
+{
+  Q_Q(qSlicerPathPlannerTableModel);
+
+  vtkSlicerPathPlannerPointStore* store = this->pointStore();
+  const char* name = fnode->GetName() ? fnode->GetName() : "";
+  double* coord = fnode->GetFiducialCoordinates();
+  double position[3];
+  store->GetPosition(index, position);
+  if (position[0] == coord[0] && position[1] == coord[1] && position[2] == coord[2] &&
+      strcmp(store->GetName(index), name) == 0)
+    {
+    return false;
+    }
+  store->SetPosition(index, coord);
+  store->SetName(index, name);
+  emit q->pointModified(store->GetId(index));
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void qSlicerPathPlannerTableModelPrivate
+::moveRuler(vtkIdType index, vtkMRMLAnnotationRulerNode* rnode)
+{
+  vtkSlicerPathPlannerPathStore* paths = this->pathStore();
+  if (!rnode || !paths)
+    {
+    return;
+    }
+  double targetPosition[3];
+  double entryPosition[3];
+  paths->GetTargetPosition(index, targetPosition);
+  paths->GetEntryPosition(index, entryPosition);
+  rnode->SetDistanceMeasurement(paths->GetLength(index));
+  rnode->SetPosition1(targetPosition);
+  rnode->SetPosition2(entryPosition);
+}
+
+//------------------------------------------------------------------------------
+void qSlicerPathPlannerTableModelPrivate
+::updatePathsOfPoint(vtkIdType pointId, bool target)
+{
+  if (!this->pathStore() || this->PendingItemModified >= 0)
+    {
+    return;
+    }
+
+  this->Logic->SetPathUpdateCallback(
+    &qSlicerPathPlannerTableModelPrivate::onPathUpdateFinished, this);
+  if (target)
+    {
+    this->Logic->UpdatePathsOfTargetPointAsync(pointId);
+    }
+  else
+    {
+    this->Logic->UpdatePathsOfEntryPointAsync(pointId);
+    }
+}
+
+//------------------------------------------------------------------------------
+void qSlicerPathPlannerTableModelPrivate
+::updatePaths(vtkIdList* pathIndices)
+{
+  if (!this->pathStore() || pathIndices->GetNumberOfIds() == 0)
+    {
+    return;
+    }
+  this->Logic->SetPathUpdateCallback(
+    &qSlicerPathPlannerTableModelPrivate::onPathUpdateFinished, this);
+  this->Logic->UpdatePathsAsync(pathIndices);
+}
+
+//------------------------------------------------------------------------------
+void qSlicerPathPlannerTableModelPrivate
+::onPathUpdateFinished(void* clientData)
+{
+  qSlicerPathPlannerTableModelPrivate* self =
+    static_cast<qSlicerPathPlannerTableModelPrivate*>(clientData);
+  if (self->PathUpdatesQueued.testAndSetOrdered(0, 1))
+    {
+    QMetaObject::invokeMethod(self->q_ptr, "pathUpdatesFinished", Qt::QueuedConnection);
+    }
+}
+
+//------------------------------------------------------------------------------
+void qSlicerPathPlannerTableModelPrivate
+::updatePathRows(vtkIdList* pathIndices)
+{
+  Q_Q(qSlicerPathPlannerTableModel);
+
+  vtkSlicerPathPlannerPathStore* paths = this->pathStore();
+  if (!paths)
+    {
+    return;
+    }
+  // Moving the rulers invokes events that lead back to this model
+  this->PendingItemModified = 0;
+  for (vtkIdType i = 0; i < pathIndices->GetNumberOfIds(); i ++)
+    {
+    vtkIdType index = pathIndices->GetId(i);
+    if (this->Scene)
+      {
+      this->moveRuler(index, vtkMRMLAnnotationRulerNode::SafeDownCast(
+                        this->Scene->GetNodeByID(paths->GetNodeID(index))));
+      }
+    if (index < this->RowCount)
+      {
+      emit q->dataChanged(q->index(index, qSlicerPathPlannerTableModel::TargetColumn),
+                          q->index(index, qSlicerPathPlannerTableModel::CostColumn));
+      }
+    }
+  this->PendingItemModified = -1;
+  q->updatePathSet();
+}
+
+//------------------------------------------------------------------------------
+vtkMRMLModelNode* qSlicerPathPlannerTableModelPrivate
+::pathSetNode(bool create)
+{
+  if (!this->Scene || !this->Logic)
+    {
+    return NULL;
+    }
+  vtkPolyData* polyData = this->Logic->GetPathSet()->GetOutput();
+  vtkMRMLModelNode* node = vtkMRMLModelNode::SafeDownCast(
+    this->Scene->GetNodeByID(this->PathSetNodeID.toAscii()));
+  // the ID may have been reused by another node since ours was removed
+  if (node && node->GetPolyData() == polyData)
+    {
+    return node;
+    }
+  this->PathSetNodeID.clear();
+  if (!create)
+    {
+    return NULL;
+    }
+
+  // The polydata is owned by the logic: the nodes are not saved
+  vtkNew<vtkMRMLModelDisplayNode> display;
+  display->SetScalarVisibility(1);
+  display->SetSliceIntersectionVisibility(1);
+  display->SetAndObserveColorNodeID("vtkMRMLColorTableNodeRainbow");
+  display->SetSaveWithScene(0);
+  this->Scene->AddNode(display.GetPointer());
+
+  vtkNew<vtkMRMLModelNode> model;
+  model->SetName(this->Scene->GetUniqueNameByString("PathSet"));
+  model->SetSaveWithScene(0);
+  model->SetAndObservePolyData(polyData);
+  this->Scene->AddNode(model.GetPointer());
+  model->SetAndObserveDisplayNodeID(display->GetID());
+  this->PathSetNodeID = model->GetID();
+  return model.GetPointer();
+}
+
+//------------------------------------------------------------------------------
+qSlicerPathPlannerTableModel
+::qSlicerPathPlannerTableModel(QObject *parent)
+  : QAbstractTableModel(parent)
+  , d_ptr( new qSlicerPathPlannerTableModelPrivate(*this) )
+{
+  Q_D(qSlicerPathPlannerTableModel);
+  d->init();
+
+  // initialize
+  this->selectedTargetPointItemRow = RESET;
+  this->selectedTargetPointItemColumn = RESET;
+  this->selectedEntryPointItemRow = RESET;
+  this->selectedEntryPointItemColumn = RESET;
+  this->selectedPathsTableRow = RESET;
+  this->selectedPathsTableColumn = RESET;
+}
+
+qSlicerPathPlannerTableModel
+::~qSlicerPathPlannerTableModel()
+{
+}
+
+qSlicerPathPlannerTableModel
+::qSlicerPathPlannerTableModel(qSlicerPathPlannerTableModelPrivate* pimpl, QObject *parent)
+  : QAbstractTableModel(parent)
+  , d_ptr(pimpl)
+{
+  Q_D(qSlicerPathPlannerTableModel);
+  d->init();
+}
+
+void qSlicerPathPlannerTableModel
+::initList(int i)
+{
+  Q_D(qSlicerPathPlannerTableModel);
+
+  d->ListType = i;
+  switch (i)
+  {
+    case LABEL_RAS_ENTRY:
+    {
+      d->initForEntryList();
+      break;
+    }
+    case LABEL_RAS_TARGET:
+    {
+      d->initForTargetList();
+      break;
+    }
+    case LABEL_RAS_PATH:
+    {
+      d->initForPathList();
+      break;
+    }
+    default:
+    {
+      d->init();
+      break;
+    }
+  }
+  d->checkRowCount();
+
+}
+
+
+//------------------------------------------------------------------------------
+int qSlicerPathPlannerTableModel
+::rowCount(const QModelIndex& parent)const
+{
+  Q_D(const qSlicerPathPlannerTableModel);
+  return parent.isValid() ? 0 : d->RowCount;
+}
+
+
+//------------------------------------------------------------------------------
+int qSlicerPathPlannerTableModel
+::columnCount(const QModelIndex& parent)const
+{
+  Q_D(const qSlicerPathPlannerTableModel);
+  return parent.isValid() ? 0 : d->HeaderLabels.size();
+}
+
+
+//------------------------------------------------------------------------------
+QVariant qSlicerPathPlannerTableModel
+::data(const QModelIndex& index, int role)const
+{
+  Q_D(const qSlicerPathPlannerTableModel);
+
+  int row = index.row();
+  if (!index.isValid() || row >= d->storeSize())
+    {
+    return QVariant();
+    }
+  if (role != Qt::DisplayRole && role != Qt::EditRole &&
+      !(role == NodeIDRole && index.column() == NameColumn) &&
+      !(role == Qt::ToolTipRole && index.column() == ClearanceColumn) &&
+      role != Qt::BackgroundRole)
+    {
+    return QVariant();
+    }
+
+  vtkSlicerPathPlannerPointStore* points = d->pointStore();
+  vtkSlicerPathPlannerPathStore* paths = d->pathStore();
+  vtkIdType id = points ? points->GetId(row) : paths->GetId(row);
+  if (role == Qt::BackgroundRole)
+    {
+    // suggested points in light yellow
+    bool highlighted = points && d->HighlightedIds.contains(id);
+    return highlighted ? QVariant(QColor(255, 255, 160)) : QVariant();
+    }
+  switch (index.column())
+    {
+    case NameColumn:
+      if (role == NodeIDRole)
+        {
+        return QString(points ? points->GetNodeID(row) : paths->GetNodeID(row));
+        }
+      return QString(points ? points->GetName(row) : paths->GetName(row));
+    case TimeColumn:
+      return d->Times.value(id);
+    case MemoColumn:
+      return d->Memos.value(id);
+    default:
+      break;
+    }
+
+  if (points)
+    {
+    if (index.column() > SColumn)
+      {
+      return QVariant();
+      }
+    const double* coordinates[3] = { points->GetR(), points->GetA(), points->GetS() };
+    return QString::number(coordinates[index.column() - RColumn][row]);
+    }
+
+  switch (index.column())
+    {
+    case TargetColumn:
+      {
+      vtkSlicerPathPlannerPointStore* targets = d->Logic->GetTargetPoints();
+      vtkIdType target = targets->GetIndex(paths->GetTargetPointId(row));
+      return QString(target >= 0 ? targets->GetName(target) : "Set Target Point");
+      }
+    case EntryColumn:
+      {
+      vtkSlicerPathPlannerPointStore* entries = d->Logic->GetEntryPoints();
+      vtkIdType entry = entries->GetIndex(paths->GetEntryPointId(row));
+      return QString(entry >= 0 ? entries->GetName(entry) : "Set Entry Point");
+      }
+    case HitsColumn:
+      {
+      // labels crossed by the path, e.g. "3 @ 12.5 mm, 7 @ 40.2 mm"
+      QStringList hits;
+      int nHits = paths->GetNumberOfHits(row);
+      for (int k = 0; k < nHits; k ++)
+        {
+        hits << QString("%1 @ %2 mm").arg(paths->GetHitLabel(row, k))
+                                      .arg(paths->GetHitDepth(row, k), 0, 'f', 1);
+        }
+      return hits.join(", ");
+      }
+    case ClearanceColumn:
+      {
+      // numeric data so that the paths can be sorted by clearance, empty
+      // without labelmap
+      double clearance = paths->GetClearance(row);
+      if (clearance >= VTK_DOUBLE_MAX)
+        {
+        return QVariant();
+        }
+      if (role == Qt::ToolTipRole)
+        {
+        return QString("%1 mm at %2 mm from the entry point")
+          .arg(clearance, 0, 'f', 1).arg(paths->GetClearanceDepth(row), 0, 'f', 1);
+        }
+      return clearance;
+      }
+    case ModelsColumn:
+      {
+      // e.g. "Vessels: hit at 32.1 mm, Skull: 4.2 mm at 10.0 mm"
+      QStringList models;
+      int nModels = paths->GetNumberOfSurfaceModels();
+      for (int model = 0; model < nModels; model ++)
+        {
+        double distance = paths->GetModelDistance(row, model);
+        if (distance >= VTK_DOUBLE_MAX)
           {
-            item->setText(str);
+          continue;
           }
-          else if(j==3)
+        QString name(d->Logic->GetSurfaceModelName(model));
+        double depth = paths->GetModelDepth(row, model);
+        if (distance == 0.0)
           {
-            // time stamp for each row
-            if(i == nItems-1 && this->addRowFlag == 1)
-            {
-              QString timeStamp = QTime::currentTime().toString();
-              QByteArray byteArray(timeStamp.toAscii());
-              const char *timeStampStr = byteArray.constData();
-              item->setText(timeStampStr);                
-            }
+          models << QString("%1: hit at %2 mm").arg(name).arg(depth, 0, 'f', 1);
           }
-          else
+        else
           {
-            // memo column for each row
-            if(i == nItems-1 && this->addRowFlag == 1)
-            {
-              item->setText("");                
-            }            
+          models << QString("%1: %2 mm at %3 mm").arg(name)
+            .arg(distance, 0, 'f', 1).arg(depth, 0, 'f', 1);
           }
         }
+      return models.join(", ");
+      }
+    case CostColumn:
+      {
+      // numeric data so that the paths can be sorted by cost
+      double cost = paths->GetCost(row);
+      return (cost < VTK_DOUBLE_MAX) ? QVariant(cost) : QVariant();
+      }
+    default:
+      // numeric data so that the paths can be sorted by length
+      return paths->GetLength(row);
+    }
+}
+
+
+//------------------------------------------------------------------------------
+bool qSlicerPathPlannerTableModel
+::setData(const QModelIndex& index, const QVariant& value, int role)
+{
+  Q_D(qSlicerPathPlannerTableModel);
+
+  vtkSlicerPathPlannerTraceMacro("setData()");
+
+  int row = index.row();
+  if (!index.isValid() || role != Qt::EditRole || row >= d->storeSize())
+    {
+    return false;
+    }
+  if (d->PendingItemModified >= 0)
+    {
+    return false;
+    }
+
+  vtkSlicerPathPlannerPointStore* points = d->pointStore();
+  vtkSlicerPathPlannerPathStore* paths = d->pathStore();
+  QString qstr = value.toString();
+
+  if (index.column() == MemoColumn)
+    {
+    d->Memos[points ? points->GetId(row) : paths->GetId(row)] = qstr;
+    emit dataChanged(index, index);
+    return true;
+    }
+
+  if (points)
+    {
+    // Edit the fiducial; the store is updated from it
+    vtkMRMLAnnotationFiducialNode* fnode = NULL;
+    if (d->Scene)
+      {
+      fnode = vtkMRMLAnnotationFiducialNode::SafeDownCast(
+        d->Scene->GetNodeByID(points->GetNodeID(row)));
+      }
+    if (!fnode)
+      {
+      return false;
+      }
+    double coord[4];
+    switch (index.column())
+      {
+      case NameColumn:
+        fnode->SetName(qstr.toAscii());
+        break;
+      case RColumn:
+      case AColumn:
+      case SColumn:
+        fnode->GetFiducialCoordinates(coord);
+        coord[index.column() - RColumn] = qstr.toDouble();
+        fnode->SetFiducialCoordinates(coord);
+        break;
+      default:
+        return false;
+      }
+    fnode->Modified();
+    this->onMRMLChildNodeValueModified(fnode);
+    return true;
+    }
+
+  switch (index.column())
+    {
+    // path name
+    case NameColumn:
+      {
+      vtkMRMLAnnotationRulerNode* rnode = NULL;
+      if (d->Scene)
+        {
+        rnode = vtkMRMLAnnotationRulerNode::SafeDownCast(
+          d->Scene->GetNodeByID(paths->GetNodeID(row)));
+        }
+      if (rnode)
+        {
+        rnode->SetName(qstr.toAscii());
+        rnode->Modified();
+        }
+      paths->SetName(row, qstr.toAscii());
+      emit dataChanged(index, index);
+      return true;
+      }
+
+    // target point name: pick the target point of that name
+    case TargetColumn:
+      {
+      vtkSlicerPathPlannerPointStore* targets = d->Logic->GetTargetPoints();
+      vtkIdType target = targets->FindIndexByName(qstr.toAscii());
+      if (target < 0)
+        {
+        return false;
+        }
+      this->setPathTarget(row, targets->GetId(target));
+      return true;
+      }
+
+    // entry point name: pick the entry point of that name
+    case EntryColumn:
+      {
+      vtkSlicerPathPlannerPointStore* entries = d->Logic->GetEntryPoints();
+      vtkIdType entry = entries->FindIndexByName(qstr.toAscii());
+      if (entry < 0)
+        {
+        return false;
+        }
+      this->setPathEntry(row, entries->GetId(entry));
+      return true;
+      }
+
+    // the length is computed from the end points
+    default:
+      return false;
+    }
+}
+
+
+//------------------------------------------------------------------------------
+Qt::ItemFlags qSlicerPathPlannerTableModel
+::flags(const QModelIndex& index)const
+{
+  Q_D(const qSlicerPathPlannerTableModel);
+
+  if (!index.isValid())
+    {
+    return Qt::NoItemFlags;
+    }
+  Qt::ItemFlags flags = Qt::ItemIsSelectable | Qt::ItemIsEnabled;
+  if (index.column() == TimeColumn ||
+      (d->ListType == LABEL_RAS_PATH &&
+       (index.column() == LengthColumn || index.column() >= HitsColumn)))
+    {
+    return flags;
+    }
+  return flags | Qt::ItemIsEditable;
+}
+
+
+//------------------------------------------------------------------------------
+QVariant qSlicerPathPlannerTableModel
+::headerData(int section, Qt::Orientation orientation, int role)const
+{
+  Q_D(const qSlicerPathPlannerTableModel);
+
+  if (orientation == Qt::Horizontal && role == Qt::DisplayRole &&
+      section >= 0 && section < d->HeaderLabels.size())
+    {
+    return d->HeaderLabels.at(section);
+    }
+  return this->Superclass::headerData(section, orientation, role);
+}
+
+
+void qSlicerPathPlannerTableModel
+::setNode(vtkMRMLNode* node)
+{
+  Q_D(qSlicerPathPlannerTableModel);
+
+  if (node == NULL)
+    {
+    d->HierarchyNode = NULL;
+    d->invalidateChildren();
+    }
+  
+  vtkMRMLAnnotationHierarchyNode* hnode;
+  hnode = vtkMRMLAnnotationHierarchyNode::SafeDownCast(node);
+  if (hnode)
+  {
+    qvtkReconnect(d->HierarchyNode, node,
+                  vtkMRMLHierarchyNode::ChildNodeAddedEvent,
+                  this, SLOT(onMRMLChildNodeAdded(vtkObject*)));
+    qvtkReconnect(d->HierarchyNode, node,
+                  vtkMRMLHierarchyNode::ChildNodeRemovedEvent,
+                  this, SLOT(onMRMLChildNodeRemoved(vtkObject*)));
+    // NOTE (10/13/2012): ChildNodeRemovedEvent works when a child node is moved
+    // to another annotation hierarchy, but doesn't work when a child
+    // node is removed. For this reason,in addition to ChildNodeRemovedEvent,
+    // onMRMLNodeRemovedEvent() is connected to NodeRemovedEvent invoked by the scene.
+
+    // Disconnect slots from old child nodes
+    if (d->HierarchyNode)
+    {
+      d->updateChildren();
+      for (size_t i = 0; i < d->Fiducials.size(); i ++)
+      {
+        vtkMRMLAnnotationFiducialNode* fnode = d->Fiducials[i];
+        qvtkDisconnect(fnode, vtkMRMLAnnotationFiducialNode::ValueModifiedEvent,
+                       this, SLOT(onMRMLChildNodeValueModified(vtkObject*)));
+        fnode->SetAttribute("RFTEvent", NULL);
+      }
+    
+      for (size_t i = 0; i < d->Rulers.size(); i ++)
+      {
+        vtkMRMLAnnotationRulerNode* rnode = d->Rulers[i];
+        qvtkDisconnect(rnode, vtkMRMLAnnotationRulerNode::ValueModifiedEvent,
+                       this, SLOT(onMRMLChildNodeValueModified(vtkObject*)));
+        rnode->SetAttribute("RFTEvent", NULL);
+      }
+      
+    }
+
+    d->HierarchyNode = hnode;
+    d->invalidateChildren();
+    d->updateChildren();
+
+    // Connect slots to handle chlid node event
+    for (size_t i = 0; i < d->Fiducials.size(); i ++)
+    {
+      // Connect the fiducial node to onMRMLChildNodeValueModified().
+      // An attribute "RFTEvent" is set "Yes" to mark that the fiducial node is connected. 
+      vtkMRMLAnnotationFiducialNode* fnode = d->Fiducials[i];
+      qvtkConnect(fnode, vtkMRMLAnnotationFiducialNode::ValueModifiedEvent,
+                  this, SLOT(onMRMLChildNodeValueModified(vtkObject*)));
+      fnode->SetAttribute("RFTEvent", "Yes");
+    }
+
+    for (size_t i = 0; i < d->Rulers.size(); i ++)
+    {
+      // Connect the fiducial node to onMRMLChildNodeValueModified().
+      // An attribute "RFTEvent" is set "Yes" to mark that the fiducial node is connected. 
+      vtkMRMLAnnotationRulerNode* rnode = d->Rulers[i];
+      qvtkConnect(rnode, vtkMRMLAnnotationRulerNode::ValueModifiedEvent,
+                  this, SLOT(onMRMLChildNodeValueModified(vtkObject*)));
+      rnode->SetAttribute("RFTEvent", "Yes");
+    }
+    
+  }
+
+  this->updateTable();
+
+}
+
+
+//------------------------------------------------------------------------------
+void qSlicerPathPlannerTableModel
+::setCoordinateLabel(int m)
+{
+  Q_D(qSlicerPathPlannerTableModel);
+
+  QStringList list;
+  
+  switch (m)
+    {
+    case LABEL_RAS:
+      {
+      list << "Point Name" << "R" << "A" << "S" << "Time" << "Memo";
+      break;
+      }
+    case LABEL_RAS_ENTRY:
+      {
+      list << "Entry Point" << "R" << "A" << "S" << "Time" << "Memo";
+      break;
+      }
+    case LABEL_RAS_TARGET:
+      {
+      list << "Target Point" << "R" << "A" << "S" << "Time" << "Memo";
+      break;
+      }
+    case LABEL_RAS_PATH:
+      {
+        list << "Path" << "Target" << "Entry" << "Length" << "Time" << "Memo" << "Hits" << "Clearance"
+             << "Models" << "Cost";
+        break;
+      }
+    case LABEL_XYZ:
+      {
+      list << "Point Name" << "X" << "Y" << "Z" << "Time" << "Memo";
+      break;
+      }
+    default:
+      {
+      return;
+      break;
+      }
+    }
+  d->setHeaderLabels(list);
+}
+
+
+//------------------------------------------------------------------------------
+void qSlicerPathPlannerTableModel
+::updateTable()
+{
+  Q_D(qSlicerPathPlannerTableModel);
+  vtkSlicerPathPlannerProbeMacro(UpdateTableProbe);
+
+  
+  vtkSlicerPathPlannerTraceMacro("updatedTable");
+
+  // the paths list shows ruler nodes
+  if (d->ListType == LABEL_RAS_PATH)
+    {
+    this->updateRulerTable();
+    return;
+    }
+
+  // Without a hierarchy the store keeps its rows (the planners use them):
+  // the row count follows it, as the incremental updates expect
+  if (d->HierarchyNode == 0)
+    {
+    d->checkRowCount();
+    return;
+    }
+
+  d->PendingItemModified = 0;
+
+  // Mirror the child Fiducial nodes into the point store. Only the rows
+  // that changed are signaled to the views.
+  d->synchronizePointStore();
+
+  d->PendingItemModified = -1;
+
+}
+
+
+//-----------------------------------------------------------------------------
+void qSlicerPathPlannerTableModel
+::addPoint(double x, double y, double z)
+{
+  Q_D(qSlicerPathPlannerTableModel);
+
+  if (d->Scene && d->HierarchyNode)
+    {
+    // Generate fiducial point name
+    d->updateChildren();
+    int nItems = static_cast<int>(d->Fiducials.size() + d->Rulers.size());
+
+    std::stringstream ss;
+    ss << "Path_" << (nItems+1);
+
+    //vtkSmartPointer< vtkMRMLAnnotationFiducialNode > fid = vtkSmartPointer< vtkMRMLAnnotationFiducialNode >::New();
+    vtkSmartPointer< vtkMRMLAnnotationFiducialNode > fid = vtkSmartPointer< vtkMRMLAnnotationFiducialNode >::New();
+    fid->SetName(ss.str().c_str());
+    double coord[3] = {x, y, z};
+    fid->SetFiducialCoordinates(x, y, z);
+    d->Scene->AddNode(fid);
+    fid->CreateAnnotationTextDisplayNode();
+    fid->CreateAnnotationPointDisplayNode();
+    fid->GetAnnotationPointDisplayNode()->SetGlyphScale(5);
+    fid->GetAnnotationPointDisplayNode()->SetGlyphType(vtkMRMLAnnotationPointDisplayNode::Sphere3D);
+    this->updateTable();
+    }
+}
+
+
+//-----------------------------------------------------------------------------
+void qSlicerPathPlannerTableModel
+::addRuler(void)
+{
+  this->addPath(-1, -1);
+}
+
+
+//-----------------------------------------------------------------------------
+void qSlicerPathPlannerTableModel
+::addPath(vtkIdType targetPointId, vtkIdType entryPointId)
+{
+  QList< QPair<vtkIdType, vtkIdType> > targetEntryPairs;
+  targetEntryPairs << qMakePair(targetPointId, entryPointId);
+  this->addPaths(targetEntryPairs);
+}
+
+
+//-----------------------------------------------------------------------------
+void qSlicerPathPlannerTableModel
+::addPaths(const QList< QPair<vtkIdType, vtkIdType> >& targetEntryPairs,
+           vtkSlicerPathPlannerPathStore* evaluatedPaths)
+{
+  Q_D(qSlicerPathPlannerTableModel);
+  
+  vtkSlicerPathPlannerPathStore* paths = d->pathStore();
+  if (d->Scene && d->HierarchyNode && paths)
+  {
+    vtkSlicerPathPlannerPointStore* targets = d->Logic->GetTargetPoints();
+    vtkSlicerPathPlannerPointStore* entries = d->Logic->GetEntryPoints();
+    d->checkRowCount();
+
+    // Adding many rulers is a batch: the tables are refreshed once at the
+    // end. The paths drawn by the path set have no ruler.
+    bool rulers = !d->PathSetDisplay;
+    bool batch = rulers && targetEntryPairs.size() > 1;
+    if (batch)
+    {
+      d->Scene->StartState(vtkMRMLScene::BatchProcessState);
+    }
+
+    for (int k = 0; k < targetEntryPairs.size(); k ++)
+    {
+      double targetPosition[3] = {0.0, 0.0, 0.0};
+      double entryPosition[3] = {0.0, 0.0, 0.0};
+      vtkIdType targetIndex = targets->GetIndex(targetEntryPairs[k].first);
+      vtkIdType entryIndex = entries->GetIndex(targetEntryPairs[k].second);
+      if (targetIndex >= 0)
+      {
+        targets->GetPosition(targetIndex, targetPosition);
+      }
+      if (entryIndex >= 0)
+      {
+        entries->GetPosition(entryIndex, entryPosition);
+      }
+
+      // Generate ruler name
+      std::stringstream ss;
+      ss << "P_" << (paths->GetNumberOfPaths()+1);
+
+      vtkIdType index = -1;
+      if (!rulers)
+      {
+        index = paths->GetIndex(d->appendPath(ss.str().c_str(), 0));
+      }
+      else
+      {
+        vtkSmartPointer< vtkMRMLAnnotationRulerNode > fid = vtkSmartPointer< vtkMRMLAnnotationRulerNode >::New();
+        fid->SetPosition1(targetPosition);
+        fid->SetPosition2(entryPosition);
+
+        // the ruler is locked.
+        fid->SetLocked(!fid->GetLocked());
+
+        fid->SetName(ss.str().c_str());
+        d->Scene->AddNode(fid);
+        fid->CreateAnnotationTextDisplayNode();
+
+        // The ruler may already have been mirrored by an event handler
+        index = d->rowOfNode(fid->GetID());
+        if (index < 0)
+        {
+          index = paths->GetIndex(d->appendPath(fid->GetName(), fid->GetID()));
+        }
+      }
+      paths->SetTarget(index, targetEntryPairs[k].first, targetPosition);
+      paths->SetEntry(index, targetEntryPairs[k].second, entryPosition);
+      if (evaluatedPaths && k < evaluatedPaths->GetNumberOfPaths())
+      {
+        // Evaluated in the background, at the positions of the snapshot:
+        // updateRulerTable() reevaluates it if a point moved since
+        paths->CopyPath(index, evaluatedPaths, k);
       }
     }
 
-  // test code
-  /*
-  if(this->pathTableExistance == 1)
+    if (batch)
+    {
+      d->Scene->EndState(vtkMRMLScene::BatchProcessState);
+    }
+    
+    
+    this->updateRulerTable();
+    
+  }
+}
+
+
+//------------------------------------------------------------------------------
+void qSlicerPathPlannerTableModel
+::updateRulerTable()
+{
+  
+  Q_D(qSlicerPathPlannerTableModel);
+  vtkSlicerPathPlannerProbeMacro(UpdateRulerTableProbe);
+  
+  
+  vtkSlicerPathPlannerTraceMacro("updatedRulerTable");
+
+  
+  if (d->HierarchyNode == 0)
+  {
+    d->checkRowCount();
+    vtkSlicerPathPlannerTraceMacro("d->HierarchyNode == 0");
+    
+    return;
+  }
+
+  // Setting the ruler positions below invokes events that lead back here
+  if (d->PendingItemModified >= 0)
+  {
+    return;
+  }
+  
+  d->PendingItemModified = 0;
+  
+  // Mirror the child Ruler nodes into the path store
+  d->synchronizePathStore();
+
+  vtkSlicerPathPlannerPathStore* paths = d->pathStore();
+  int nPaths = paths ? static_cast<int>(paths->GetNumberOfPaths()) : 0;
+  if (nPaths == 0)
+  {
+    d->PendingItemModified = -1;
+    this->updatePathSet();
+    return;
+  }
+
+  // Refresh the end points and find the paths that moved or were never
+  // evaluated (previous target and entry of each path). They are
+  // evaluated in the background.
+  std::vector<double>& previous = d->PreviousGeometry;
+  previous.resize(6 * nPaths);
+  std::copy(paths->GetTargetPositions(), paths->GetTargetPositions() + 3 * nPaths,
+            previous.begin());
+  std::copy(paths->GetEntryPositions(), paths->GetEntryPositions() + 3 * nPaths,
+            previous.begin() + 3 * nPaths);
+  d->Logic->UpdateEndPointPositions();
+
+  const double* targets = paths->GetTargetPositions();
+  const double* entries = paths->GetEntryPositions();
+  const double* costs = paths->GetCosts();
+  vtkNew<vtkIdList> moved;
+  int firstChanged = nPaths;
+  int lastChanged = -1;
+  for (int i = 0; i < nPaths; i ++)
+  {
+    if (costs[i] != VTK_DOUBLE_MAX &&
+        std::equal(targets + 3 * i, targets + 3 * i + 3, previous.begin() + 3 * i) &&
+        std::equal(entries + 3 * i, entries + 3 * i + 3, previous.begin() + 3 * nPaths + 3 * i))
+    {
+      continue;
+    }
+    firstChanged = std::min(firstChanged, i);
+    lastChanged = i;
+    moved->InsertNextId(i);
+
+    // move the ruler to the path
+    d->moveRuler(i, d->RulerOfRow[i]);
+  }
+  d->updatePaths(moved.GetPointer());
+
+  if (firstChanged <= lastChanged)
   {
-    this->updateRulerTable();
-    std::cout << "updateRulerTable in updateTable()" << std::endl;
-  }   
-  */
+    emit dataChanged(this->index(firstChanged, TargetColumn),
+                     this->index(lastChanged, CostColumn));
+  }
+  
   d->PendingItemModified = -1;
-
+  this->updatePathSet();
+  
 }
 
 
 //-----------------------------------------------------------------------------
 void qSlicerPathPlannerTableModel
-::addPoint(double x, double y, double z)
+::setLogic(vtkSlicerPathPlannerLogic* logic)
 {
   Q_D(qSlicerPathPlannerTableModel);
+  d->Logic = logic;
+  d->checkRowCount();
+  d->rebuildNodeIndex();
+}
 
-  if (d->Scene && d->HierarchyNode)
-    {
-    // Generate fiducial point name
-    vtkNew<vtkCollection> collection;
-    d->HierarchyNode->GetDirectChildren(collection.GetPointer());
-    int nItems = collection->GetNumberOfItems();
 
-    std::stringstream ss;
-    ss << "Path_" << (nItems+1);
+//-----------------------------------------------------------------------------
+vtkSlicerPathPlannerLogic* qSlicerPathPlannerTableModel
+::logic()const
+{
+  Q_D(const qSlicerPathPlannerTableModel);
+  return d->Logic;
+}
 
-    //vtkSmartPointer< vtkMRMLAnnotationFiducialNode > fid = vtkSmartPointer< vtkMRMLAnnotationFiducialNode >::New();
-    vtkSmartPointer< vtkMRMLAnnotationFiducialNode > fid = vtkSmartPointer< vtkMRMLAnnotationFiducialNode >::New();
-    fid->SetName(ss.str().c_str());
-    double coord[3] = {x, y, z};
-    fid->SetFiducialCoordinates(x, y, z);
-    d->Scene->AddNode(fid);
-    fid->CreateAnnotationTextDisplayNode();
-    fid->CreateAnnotationPointDisplayNode();
-    fid->GetAnnotationPointDisplayNode()->SetGlyphScale(5);
-    fid->GetAnnotationPointDisplayNode()->SetGlyphType(vtkMRMLAnnotationPointDisplayNode::Sphere3D);
-    //this->updateTable();
-    
-    // test code  
-    this->updateRulerTable();
-    
-    }
+
+//-----------------------------------------------------------------------------
+void qSlicerPathPlannerTableModel
+::setMRMLScene(vtkMRMLScene *newScene)
+{
+  Q_D(qSlicerPathPlannerTableModel);
+
+  qvtkReconnect(d->Scene, newScene,
+                vtkMRMLScene::NodeRemovedEvent,
+                this, SLOT(onMRMLNodeRemovedEvent(vtkObject*,vtkObject*)));
+  d->Scene = newScene;
+  d->Scheduler->setMRMLScene(newScene);
+  d->PathSetNodeID.clear();
 }
 
 
 //-----------------------------------------------------------------------------
+qSlicerPathPlannerUpdateScheduler* qSlicerPathPlannerTableModel
+::updateScheduler()const
+{
+  Q_D(const qSlicerPathPlannerTableModel);
+  return d->Scheduler;
+}
+
+
+
 void qSlicerPathPlannerTableModel
-::addRuler(void)
+::onMRMLChildNodeAdded(vtkObject* o)
 {
   Q_D(qSlicerPathPlannerTableModel);
-  
-  if (d->Scene && d->HierarchyNode)
-  {
-        
-    // test code
-    std::cout << "this->pathColumnCounter = " << this->pathColumnCounter << std::endl;
-    this->targetPointName[this->pathColumnCounter] = "Set Target Point";
-    this->entryPointName[this->pathColumnCounter] = "Set Entry Point";
-    this->pathDistance[this->pathColumnCounter] = 0.0;
-    
-    this->pathColumnCounter++;
-    
-    // Generate fiducial point name
-    vtkNew<vtkCollection> collection;
-    d->HierarchyNode->GetDirectChildren(collection.GetPointer());
-    int nItems = collection->GetNumberOfItems();
-    
-    std::stringstream ss;
-    ss << "P_" << (nItems+1);
-    
-    vtkSmartPointer< vtkMRMLAnnotationRulerNode > fid = vtkSmartPointer< vtkMRMLAnnotationRulerNode >::New();
-    
-    double tipPosition[2][3];
-    
-    tipPosition[0][0] = 0.0;
-    tipPosition[0][1] = 0.0;
-    tipPosition[0][2] = 0.0;
 
-    tipPosition[1][0] = 0.0;
-    tipPosition[1][1] = 0.0;
-    tipPosition[1][2] = 0.0;
-    
-    fid->SetPosition1(tipPosition[0]);
-    fid->SetPosition2(tipPosition[1]);
-    
-    double difference[3];
+  if (d->HierarchyNode == 0)
+    {
+    return;
+    }
 
-    // calculate distance
-    difference[0] = tipPosition[0][0] - tipPosition[1][0];
-    difference[1] = tipPosition[0][1] - tipPosition[1][1];
-    difference[2] = tipPosition[0][2] - tipPosition[1][2];    
-    fid->SetDistanceMeasurement(sqrt(difference[0]*difference[0]+difference[1]*difference[1]+difference[2]*difference[2]));
-    
-    // test code
-    // the ruler is locked.
-    fid->SetLocked(!fid->GetLocked());
+  // one synchronization when the batch ends
+  d->invalidateChildren();
+  if (d->Scheduler->isBatchProcessing())
+    {
+    d->Scheduler->markAllDirty();
+    return;
+    }
+  d->checkRowCount();
 
-    fid->SetName(ss.str().c_str());
-    d->Scene->AddNode(fid);
-    fid->CreateAnnotationTextDisplayNode();
-    //fid->CreateAnnotationPointDisplayNode();
-    //fid->GetAnnotationPointDisplayNode()->SetGlyphScale(5);
-    //fid->GetAnnotationPointDisplayNode()->SetGlyphType(vtkMRMLAnnotationPointDisplayNode::Sphere3D);    
-    
-    std::cout << "AddRuler!! " << std::endl;  
-    
-    /*
-    fid->SetName(ss.str().c_str());
-    double coord[3] = {x, y, z};
-    fid->SetFiducialCoordinates(x, y, z);
-    d->Scene->AddNode(fid);
-    fid->CreateAnnotationTextDisplayNode();
-    fid->CreateAnnotationPointDisplayNode();
-    fid->GetAnnotationPointDisplayNode()->SetGlyphScale(5);
-    fid->GetAnnotationPointDisplayNode()->SetGlyphType(vtkMRMLAnnotationPointDisplayNode::Sphere3D);
-    */
-    //this->updateTable();
-    this->updateRulerTable();
-    
+  // Find the newly added node
+  d->updateChildren();
+
+  for (size_t i = 0; i < d->Fiducials.size(); i ++)
+    {
+    vtkMRMLAnnotationFiducialNode* fnode = d->Fiducials[i];
+    if (!fnode->GetAttribute("RFTEvent"))
+      {
+      qvtkConnect(fnode, vtkMRMLAnnotationFiducialNode::ValueModifiedEvent,
+                  this, SLOT(onMRMLChildNodeValueModified(vtkObject*)));
+      fnode->SetAttribute("RFTEvent", "Yes");
+      }
+    if (d->pointStore() && d->rowOfNode(fnode->GetID()) < 0)
+      {
+      d->appendFiducial(fnode);
+      }
+    }
+
+  for (size_t i = 0; i < d->Rulers.size(); i ++)
+    {
+    vtkMRMLAnnotationRulerNode* rnode = d->Rulers[i];
+    if (!rnode->GetAttribute("RFTEvent"))
+      {
+      qvtkConnect(rnode, vtkMRMLAnnotationRulerNode::ValueModifiedEvent,
+                  this, SLOT(onMRMLChildNodeValueModified(vtkObject*)));
+      rnode->SetAttribute("RFTEvent", "Yes");
+      }
+    if (d->pathStore() && d->rowOfNode(rnode->GetID()) < 0)
+      {
+      d->appendRuler(rnode);
+      }
+    }
+}
+
+void qSlicerPathPlannerTableModel
+::onMRMLChildNodeRemoved(vtkObject* o)
+{  
+  Q_D(qSlicerPathPlannerTableModel);
+
+  vtkMRMLNode* n = vtkMRMLNode::SafeDownCast(o);
+  if (!n)
+    {
+    return;
+    }
+
+  // A child was moved to another hierarchy
+  if (n == d->HierarchyNode)
+    {
+    d->invalidateChildren();
+    this->updateTable();
+    return;
+    }
+
+  // Only the model showing the node handles it
+  vtkIdType row = d->rowOfNode(n->GetID());
+  if (vtkMRMLAnnotationNode::SafeDownCast(n))
+    {
+    d->invalidateChildren();
+    }
+  if (row < 0)
+    {
+    return;
+    }
+
+  vtkMRMLAnnotationFiducialNode* fnode = vtkMRMLAnnotationFiducialNode::SafeDownCast(n);
+  if (fnode && fnode->GetAttribute("RFTEvent"))
+    {
+    if (strcmp("Yes", fnode->GetAttribute("RFTEvent")) == 0)
+      {
+      qvtkDisconnect(fnode, vtkMRMLAnnotationFiducialNode::ValueModifiedEvent,
+                     this, SLOT(onMRMLChildNodeValueModified(vtkObject*)));
+      fnode->SetAttribute("RFTEvent", NULL);
+      }
+    }
+
+  
+  vtkMRMLAnnotationRulerNode* rnode = vtkMRMLAnnotationRulerNode::SafeDownCast(n);
+  if (rnode && rnode->GetAttribute("RFTEvent"))
+  {
+    if (strcmp("Yes", rnode->GetAttribute("RFTEvent")) == 0)
+    {
+      qvtkDisconnect(rnode, vtkMRMLAnnotationRulerNode::ValueModifiedEvent,
+                     this, SLOT(onMRMLChildNodeValueModified(vtkObject*)));
+      rnode->SetAttribute("RFTEvent", NULL);
+    }
   }
+
+  if (d->Scheduler->isBatchProcessing())
+    {
+    d->Scheduler->markAllDirty();
+    }
+  else if (d->RowCount == d->storeSize())
+    {
+    d->removeRow(row);
+    this->updatePathSet();
+    }
+  else
+    {
+    this->updateTable();
+    }
+
 }
 
+void qSlicerPathPlannerTableModel
+::onMRMLNodeRemovedEvent(vtkObject* caller, vtkObject* callData)
+{
+  Q_D(qSlicerPathPlannerTableModel);
+
+  vtkMRMLScene* scene = vtkMRMLScene::SafeDownCast(caller);
+  if (scene && d->Scene && scene == d->Scene)
+    {
+    onMRMLChildNodeRemoved(callData);
+    }
+}
 
-//------------------------------------------------------------------------------
 void qSlicerPathPlannerTableModel
-::updateRulerTable()
+::onMRMLChildNodeValueModified(vtkObject* obj)
 {
-  
   Q_D(qSlicerPathPlannerTableModel);
-  
-  
-  // test code
-  std::cout << "updatedRulerTable" << std::endl;  
 
-  
-  if (d->HierarchyNode == 0)
+  if (d->PendingItemModified >= 0)
   {
-    this->setRowCount(0);
-    // test code
-    std::cout << "d->HierarchyNode == 0" << std::endl;
-    
     return;
   }
-  
-  d->PendingItemModified = 0;
-  
-  //QObject::disconnect(this, SIGNAL(itemChanged(QStandardItem*)),
-  //                    this, SLOT(onItemChanged(QStandardItem*)));
-  
-  // Count the number of child Fiducial nodes 
-  vtkNew<vtkCollection> collection;
-  d->HierarchyNode->GetDirectChildren(collection.GetPointer());
-  int nItems = collection->GetNumberOfItems();
-  int nFiducials = 0;
-  
-  // flag if time and memo should be refreshed in column 5 and 6
-  if (nItems > this->nItemsPrevious)
+
+  // A drag sends a burst of events: only mark the row of the modified node
+  // dirty, it is refreshed once by onScheduledUpdate(). The whole table is
+  // synchronized if the node is unknown.
+  vtkMRMLNode* node = vtkMRMLNode::SafeDownCast(obj);
+  vtkIdType row = -1;
+  if (node && d->RowCount == d->storeSize())
   {
-    this->addRowFlag = 1;
-    this->nItemsPrevious = nItems;
+    row = d->rowOfNode(node->GetID());
   }
-  else
+  if (row < 0)
   {
-    this->addRowFlag = 0;    
-    this->nItemsPrevious = nItems;
+    d->Scheduler->markAllDirty();
+    return;
   }
-  
-  collection->InitTraversal();
-  for (int i = 0; i < nItems; i ++)
+
+  vtkSlicerPathPlannerPointStore* points = d->pointStore();
+  d->Scheduler->markDirty(points ? points->GetId(row) : d->pathStore()->GetId(row));
+}
+
+
+//------------------------------------------------------------------------------
+void qSlicerPathPlannerTableModel
+::onScheduledUpdate(const QList<vtkIdType>& ids, bool all)
+{
+  Q_D(qSlicerPathPlannerTableModel);
+
+  if (all || d->RowCount != d->storeSize() || !d->Scene)
   {
-    //vtkMRMLAnnotationFiducialNode* fnode;
-    //fnode = vtkMRMLAnnotationFiducialNode::SafeDownCast(collection->GetNextItemAsObject());
-    vtkMRMLAnnotationRulerNode* fnode;
-    fnode = vtkMRMLAnnotationRulerNode::SafeDownCast(collection->GetNextItemAsObject());
-    if (fnode)
-    {
-      nFiducials ++;
-    }
+    // connect the children added during a batch, then synchronize
+    this->onMRMLChildNodeAdded(d->HierarchyNode);
+    this->updateTable();
+    return;
   }
-  this->setRowCount(nFiducials);
-  
-  collection->InitTraversal();
-  for (int i = 0; i < nItems; i ++)
+
+  vtkSlicerPathPlannerPointStore* points = d->pointStore();
+  vtkSlicerPathPlannerPathStore* paths = d->pathStore();
+  int firstChanged = d->RowCount;
+  int lastChanged = -1;
+  foreach (vtkIdType id, ids)
   {
-    //vtkMRMLAnnotationFiducialNode* fnode;
-    //fnode = vtkMRMLAnnotationFiducialNode::SafeDownCast(collection->GetNextItemAsObject());
-    vtkMRMLAnnotationRulerNode* fnode;
-    fnode = vtkMRMLAnnotationRulerNode::SafeDownCast(collection->GetNextItemAsObject());
-    if (fnode)
+    vtkIdType row = points ? points->GetIndex(id) : (paths ? paths->GetIndex(id) : -1);
+    if (row < 0)
     {
-      
-      // test code
-      //std::cout << "if(fnode)" << std::endl;
-      
-      
-      QStandardItem* item = this->invisibleRootItem()->child(i, 0);
-      if (item == NULL)
+      continue;
+    }
+
+    if (points)
+    {
+      // the paths using the point are updated through pointModified()
+      vtkMRMLAnnotationFiducialNode* fnode = vtkMRMLAnnotationFiducialNode::SafeDownCast(
+        d->Scene->GetNodeByID(points->GetNodeID(row)));
+      if (!fnode || !d->updatePoint(row, fnode))
       {
-        item = new QStandardItem();
-        this->invisibleRootItem()->setChild(i, 0, item);
+        continue;
       }
-      item->setText(fnode->GetName());
-      item->setData(fnode->GetID(),qSlicerPathPlannerTableModel::NodeIDRole);
-      
-      // test code
-      //item->getText(fnode->GetName());
-      //std::cout << "fnode->GetName() = " << fnode->GetName() << std::endl;  
-      //printf("fnode->GetName() = %s", fnode->GetName());  
-
-      
-      for (int j = 0; j < 5; j ++)
+    }
+    else
+    {
+      // the geometry of a path comes from its points, only its name is
+      // taken from the ruler
+      vtkMRMLAnnotationRulerNode* rnode = vtkMRMLAnnotationRulerNode::SafeDownCast(
+        d->Scene->GetNodeByID(paths->GetNodeID(row)));
+      const char* name = (rnode && rnode->GetName()) ? rnode->GetName() : "";
+      if (!rnode || strcmp(paths->GetName(row), name) == 0)
       {
-        QStandardItem* item = this->invisibleRootItem()->child(i, j+1);
-        if (item == NULL)
-        {
-          item = new QStandardItem();
-          this->invisibleRootItem()->setChild(i, j+1, item);
-        }
-        QString str;
-        /*
-        str.setNum(fnode->GetFiducialCoordinates()[j]);
-        if(j<3)
-        {
-          item->setText(str);
-        }
-        */
-        
-        // set tip position
-        if(j==0)
-        {
-          QString string;
-          string.append(this->targetPointName[i]);
-          item->setText(string);
-        }
-        else if(j==1)
-        {
-          // test code
-          QString string;
-          string.append(this->entryPointName[i]);
-          item->setText(string);          
-        }
-        else if(j==2) 
-        { // get distance
-          //str.setNum(fnode->GetDistanceMeasurement());          
-          // test code
-          std::cout << "SetDistanceMeasurement = " << this->pathDistance[i] << std::endl;
-          str.setNum(this->pathDistance[i]);  
-          fnode->SetDistanceMeasurement(this->pathDistance[i]);
-          item->setText(str);
-          
-          // test code
-          this->calculatePath(this->selectedEntryPoint[i], this->selectedTargetPoint[i], i);
-          fnode->SetPosition1(this->selectedTargetPoint[i]);
-          fnode->SetPosition2(this->selectedEntryPoint[i]);
-          
-        }
-        else if(j==3)
-        {
-          // time stamp for each row
-          if(i == nItems-1 && this->addRowFlag == 1)
-          {
-            QString timeStamp = QTime::currentTime().toString();
-            QByteArray byteArray(timeStamp.toAscii());
-            const char *timeStampStr = byteArray.constData();
-            item->setText(timeStampStr);
-          }
-        }
-        else
-        {
-          // memo column for each row
-          if(i == nItems-1 && this->addRowFlag == 1)
-          {
-            item->setText("");                
-          }            
-        }
+        continue;
       }
+      paths->SetName(row, name);
     }
+    firstChanged = std::min(firstChanged, static_cast<int>(row));
+    lastChanged = std::max(lastChanged, static_cast<int>(row));
+  }
+
+  if (firstChanged <= lastChanged)
+  {
+    emit dataChanged(this->index(firstChanged, NameColumn),
+                     this->index(lastChanged, points ? SColumn : NameColumn));
   }
-  
-  d->PendingItemModified = -1;
-  
 }
 
 
-//-----------------------------------------------------------------------------
+//------------------------------------------------------------------------------
+void qSlicerPathPlannerTableModel
+::onEntryPointModified(vtkIdType pointId)
+{
+  Q_D(qSlicerPathPlannerTableModel);
+  d->updatePathsOfPoint(pointId, false);
+}
+
+
+//------------------------------------------------------------------------------
 void qSlicerPathPlannerTableModel
-::setMRMLScene(vtkMRMLScene *newScene)
+::onTargetPointModified(vtkIdType pointId)
 {
   Q_D(qSlicerPathPlannerTableModel);
-
-  qvtkReconnect(d->Scene, newScene,
-                vtkMRMLScene::NodeRemovedEvent,
-                this, SLOT(onMRMLNodeRemovedEvent(vtkObject*,vtkObject*)));
-  d->Scene = newScene;
+  d->updatePathsOfPoint(pointId, true);
 }
 
 
-
+//------------------------------------------------------------------------------
 void qSlicerPathPlannerTableModel
-::onItemChanged(QStandardItem * item)
+::collectPathUpdates()
 {
   Q_D(qSlicerPathPlannerTableModel);
-
-  // test code
-  std::cout << "onItemChanged()" << std::endl;
-  
-  if (item == this->invisibleRootItem())
+  // Updates finishing from now on queue a new signal
+  d->PathUpdatesQueued.fetchAndStoreOrdered(0);
+  if (!d->Logic)
     {
     return;
     }
   if (d->PendingItemModified >= 0)
     {
+    // collect them once the current update returned
+    qSlicerPathPlannerTableModelPrivate::onPathUpdateFinished(d);
     return;
     }
-
-  // TODO:  item->parent()-> does not work here...
-  QStandardItem* nameItem = this->invisibleRootItem()->child(item->row(), 0);
-  if (nameItem)
+  vtkNew<vtkIdList> updated;
+  if (d->Logic->CollectPathUpdates(updated.GetPointer()) > 0)
     {
-    QString id = nameItem->data(qSlicerPathPlannerTableModel::NodeIDRole).toString();
+    d->updatePathRows(updated.GetPointer());
+    }
+}
 
-    // Find fiducial node from item
-    vtkNew<vtkCollection> collection;
-    d->HierarchyNode->GetDirectChildren(collection.GetPointer());
-    int nItems = collection->GetNumberOfItems();
-    int nFiducials = 0;
-    collection->InitTraversal();
 
-    for (int i = 0; i < nItems; i ++)
-      {
-      vtkMRMLAnnotationFiducialNode* fnode;
-      fnode = vtkMRMLAnnotationFiducialNode::SafeDownCast(collection->GetNextItemAsObject());
-      if (fnode)
-        {
-        if (id == fnode->GetID())
-          {
-          QString qstr = item->text();
-          double coord[4];
-          switch (item->column())
-            {
-            case 0:
-              {
-              const char* str = qstr.toAscii();
-              fnode->SetName(str);
-              break;
-              }
-            case 1:
-              {
-              fnode->GetFiducialCoordinates(coord);
-              coord[0] = qstr.toDouble();
-              fnode->SetFiducialCoordinates(coord);
-              break;
-              }              
-            case 2:
-              {
-              fnode->GetFiducialCoordinates(coord);
-              coord[1] = qstr.toDouble();
-              fnode->SetFiducialCoordinates(coord);
-              break;
-              }              
-            case 3:
-              {
-              fnode->GetFiducialCoordinates(coord);
-              coord[2] = qstr.toDouble();
-              fnode->SetFiducialCoordinates(coord);
-              break;
-              }
-            }
-          fnode->Modified();
-          this->updateTable();
-          }
-        }
-      }
-    
+//------------------------------------------------------------------------------
+qulonglong qSlicerPathPlannerTableModel
+::planPaths(int numberOfPathsPerTarget)
+{
+  Q_D(qSlicerPathPlannerTableModel);
+
+  if (!d->pathStore())
+    {
+    return 0;
     }
+  // Supersede the previous request
+  d->PlanToken.Cancel();
+  d->PlanToken = vtkSlicerPathPlannerExecutor::CancellationToken();
+  qulonglong generation = ++ d->PlanGeneration;
+
+  PlanJob* job = new PlanJob;
+  job->Model = this;
+  job->Private = d;
+  job->Logic = d->Logic;
+  job->Generation = generation;
+  job->NumberOfPathsPerTarget = std::max(numberOfPathsPerTarget, 0);
+  job->EntryPoints = vtkSlicerPathPlannerPointStore::New();
+  job->EntryPoints->DeepCopy(d->Logic->GetEntryPoints());
+  job->TargetPoints = vtkSlicerPathPlannerPointStore::New();
+  job->TargetPoints->DeepCopy(d->Logic->GetTargetPoints());
+  job->Paths = vtkSlicerPathPlannerPathStore::New();
+  d->Logic->PrepareEvaluation();
+  d->Logic->GetExecutor()->Submit(job, d->PlanToken);
+  return generation;
+}
 
-  
-  // test code
-  if(this->selectedPathsTableRow != RESET)
-  {
-    this->updateRulerTable();
-    std::cout << "updateRulerTable in onItemChanged()" << std::endl;
-  } 
-  
-  // test
-  std::cout << "finish onItemChanged()" << std::endl;
-  
+
+//------------------------------------------------------------------------------
+void qSlicerPathPlannerTableModel
+::cancelPlanning()
+{
+  Q_D(qSlicerPathPlannerTableModel);
+
+  // Its loops return within a chunk and onPlanFinished() drops its result
+  d->PlanToken.Cancel();
+  d->PlanToken = vtkSlicerPathPlannerExecutor::CancellationToken();
+  ++ d->PlanGeneration;
+}
+
+
+//------------------------------------------------------------------------------
+qulonglong qSlicerPathPlannerTableModel
+::planGeneration()const
+{
+  Q_D(const qSlicerPathPlannerTableModel);
+  return d->PlanGeneration;
 }
 
 
-// test code
+//------------------------------------------------------------------------------
 void qSlicerPathPlannerTableModel
-::onRulerItemChanged(QStandardItem * item)
+::setPathSetDisplay(bool enabled)
 {
   Q_D(qSlicerPathPlannerTableModel);
-  
-  // test code
-  std::cout << "onRulerItemChanged()" << std::endl;  
-  
-  if (item == this->invisibleRootItem())
-  {
-    return;
-  }
-  if (d->PendingItemModified >= 0)
-  {
-    return;
-  }
-  
-  // TODO:  item->parent()-> does not work here...
-  QStandardItem* nameItem = this->invisibleRootItem()->child(item->row(), 0);
-  if (nameItem)
-  {
-    QString id = nameItem->data(qSlicerPathPlannerTableModel::NodeIDRole).toString();
-    
-    // Find ruler node from item
-    vtkNew<vtkCollection> collection;
-    d->HierarchyNode->GetDirectChildren(collection.GetPointer());
-    int nItems = collection->GetNumberOfItems();
-    int nFiducials = 0;
-    collection->InitTraversal();
-    
-    for (int i = 0; i < nItems; i ++)
-    {
-      vtkMRMLAnnotationRulerNode* rnode;
-      rnode = vtkMRMLAnnotationRulerNode::SafeDownCast(collection->GetNextItemAsObject());
-      if (rnode)
-      {
-        if (id == rnode->GetID())
-        {
-          QString qstr = item->text();
-          double value;
-          switch (item->column())
-          {
-            // path name
-            case 0:
-            {
-              const char* str = qstr.toAscii();
-              rnode->SetName(str);
-              break;
-            }
-              
-            // target point name
-            case 1:
-            {
-              this->targetPointName[i] = qstr.toAscii();
-              std::cout << "this->targetPointName[i] = "<< this->targetPointName[i] << std::endl;            
-              break;
-            }
-
-            // entry point name
-            case 2:
-            {
-              this->entryPointName[i] = qstr.toAscii();
-              std::cout << "this->entryPointName[i] = "<< this->entryPointName[i] << std::endl;            
-              break;
-            }
-            
-            // distance  
-            case 3:
-            {
-              //value = qstr.toDouble();
-              this->pathDistance[i] = qstr.toDouble(); 
-              std::cout << "this->pathDistance[i] = "<< this->pathDistance[i] << std::endl;            
-              //rnode->SetDistanceMeasurement(value);
-              rnode->SetDistanceMeasurement(this->pathDistance[i]);
-              
-              break;
-            }
-              /*
-               case 2:
-               {
-               fnode->GetFiducialCoordinates(coord);
-               coord[1] = qstr.toDouble();
-               fnode->SetFiducialCoordinates(coord);
-               break;
-               }              
-               case 3:
-               {
-               fnode->GetFiducialCoordinates(coord);
-               coord[2] = qstr.toDouble();
-               fnode->SetFiducialCoordinates(coord);
-               break;
-               }
-               */
-          }
-          rnode->Modified();
-          //this->updateTable();
-          // test code
-          if(this->selectedPathsTableRow != RESET)
-          {
-            this->updateRulerTable();
-            std::cout << "this->selectedPathsTableRow != RESET" << std::endl;            
-          }else{
-            std::cout << "this->selectedPathsTableRow == RESET" << std::endl;            
-          }
-        }
-      }
-    }
-    
-    
-  }
-  
-  /*
-   // test code
-   if(this->selectedPathsTableRow != RESET)
-   {
-   this->updateRulerTable();
-   } 
-   */
-  // test
-  //std::cout << "finish onItemChanged()" << std::endl;
-  
+  d->PathSetDisplay = enabled;
+  this->updatePathSet();
 }
 
 
+//------------------------------------------------------------------------------
+bool qSlicerPathPlannerTableModel
+::pathSetDisplay()const
+{
+  Q_D(const qSlicerPathPlannerTableModel);
+  return d->PathSetDisplay;
+}
 
 
+//------------------------------------------------------------------------------
 void qSlicerPathPlannerTableModel
-::onMRMLChildNodeAdded(vtkObject* o)
+::setSelectedPath(int row)
 {
   Q_D(qSlicerPathPlannerTableModel);
 
-  // Find the newly added node
-  vtkNew<vtkCollection> collection;
-  d->HierarchyNode->GetDirectChildren(collection.GetPointer());
-  int nItems = collection->GetNumberOfItems();
-  int nFiducials = 0;
-  collection->InitTraversal();
+  vtkSlicerPathPlannerPathStore* paths = d->pathStore();
+  if (!paths)
+    {
+    return;
+    }
+  vtkSlicerPathPlannerPathSet* pathSet = d->Logic->GetPathSet();
+  bool selected = row >= 0 && row < paths->GetNumberOfPaths();
+  pathSet->SetSelectedPathId(selected ? paths->GetId(row) : -1);
+  pathSet->SetScalarMode(selected ? vtkSlicerPathPlannerPathSet::SelectionScalars
+                                  : vtkSlicerPathPlannerPathSet::CostScalars);
+  this->updatePathSet();
+}
+
+
+//------------------------------------------------------------------------------
+void qSlicerPathPlannerTableModel
+::updatePathSet()
+{
+  Q_D(qSlicerPathPlannerTableModel);
 
-  for (int i = 0; i < nItems; i ++)
+  if (!d->pathStore())
     {
-    vtkMRMLAnnotationFiducialNode* fnode;
-    fnode = vtkMRMLAnnotationFiducialNode::SafeDownCast(collection->GetNextItemAsObject());
-    if (fnode)
-      {
-      if (!fnode->GetAttribute("RFTEvent"))
-        {
-        qvtkConnect(fnode, vtkMRMLAnnotationFiducialNode::ValueModifiedEvent,
-                    this, SLOT(onMRMLChildNodeValueModified(vtkObject*)));
-        fnode->SetAttribute("RFTEvent", "Yes");
-        }
-      }
+    return;
+    }
+  vtkMRMLModelNode* node = d->pathSetNode(d->PathSetDisplay);
+  vtkMRMLModelDisplayNode* display = node ? node->GetModelDisplayNode() : NULL;
+  if (display)
+    {
+    display->SetVisibility(d->PathSetDisplay);
+    }
+  if (!d->PathSetDisplay)
+    {
+    return;
     }
 
-  
-  // test code
-  for (int i = 0; i < nItems; i ++)
-  {
-    vtkMRMLAnnotationRulerNode* rnode;
-    rnode = vtkMRMLAnnotationRulerNode::SafeDownCast(collection->GetNextItemAsObject());
-    if (rnode)
+  // Only the arrays of the shared polydata are rewritten
+  vtkSlicerPathPlannerPathSet* pathSet = d->Logic->GetPathSet();
+  pathSet->Update();
+  if (display)
     {
-      if (!rnode->GetAttribute("RFTEvent"))
+    if (pathSet->GetScalarMode() == vtkSlicerPathPlannerPathSet::CostScalars)
+      {
+      display->SetScalarRange(pathSet->GetCostRange());
+      }
+    else
       {
-        qvtkConnect(rnode, vtkMRMLAnnotationRulerNode::ValueModifiedEvent,
-                    this, SLOT(onMRMLChildNodeValueModified(vtkObject*)));
-        rnode->SetAttribute("RFTEvent", "Yes");
+      display->SetScalarRange(0.0, 1.0);
       }
     }
-  }
-  
-  
-  // test
-  //this->updateTable();
 }
 
+
+//------------------------------------------------------------------------------
 void qSlicerPathPlannerTableModel
-::onMRMLChildNodeRemoved(vtkObject* o)
-{  
-  vtkMRMLNode* n = vtkMRMLNode::SafeDownCast(o);
-  vtkMRMLAnnotationFiducialNode* fnode = vtkMRMLAnnotationFiducialNode::SafeDownCast(n);
-  if (fnode && fnode->GetAttribute("RFTEvent"))
+::onPlanFinished(qulonglong generation)
+{
+  Q_D(qSlicerPathPlannerTableModel);
+
+  vtkSlicerPathPlannerPathStore* planned = 0;
     {
-    if (strcmp("Yes", fnode->GetAttribute("RFTEvent")) == 0)
-      {
-      qvtkDisconnect(fnode, vtkMRMLAnnotationFiducialNode::ValueModifiedEvent,
-                     this, SLOT(onMRMLChildNodeValueModified(vtkObject*)));
-      fnode->SetAttribute("RFTEvent", NULL);
-      this->updateTable();
-      }
+    QMutexLocker locker(&d->PlanMutex);
+    planned = d->PlannedPaths.take(generation);
+    }
+  if (!planned)
+    {
+    return;
+    }
+  // Out of date: a later request superseded it
+  if (generation != d->PlanGeneration)
+    {
+    planned->Delete();
+    return;
     }
 
-  
-  // test code
-  vtkMRMLAnnotationRulerNode* rnode = vtkMRMLAnnotationRulerNode::SafeDownCast(n);
-  if (rnode && rnode->GetAttribute("RFTEvent"))
-  {
-    if (strcmp("Yes", rnode->GetAttribute("RFTEvent")) == 0)
+  QList< QPair<vtkIdType, vtkIdType> > targetEntryPairs;
+  vtkIdType nPaths = planned->GetNumberOfPaths();
+  for (vtkIdType i = 0; i < nPaths; i ++)
     {
-      qvtkDisconnect(rnode, vtkMRMLAnnotationRulerNode::ValueModifiedEvent,
-                     this, SLOT(onMRMLChildNodeValueModified(vtkObject*)));
-      rnode->SetAttribute("RFTEvent", NULL);
-      this->updateTable();
+    targetEntryPairs << qMakePair(planned->GetTargetPointId(i), planned->GetEntryPointId(i));
     }
-  }
+  this->addPaths(targetEntryPairs, planned);
+  planned->Delete();
+  emit pathsPlanned(generation, targetEntryPairs.size());
+}
 
+
+//------------------------------------------------------------------------------
+vtkIdType qSlicerPathPlannerTableModel
+::identifyTipOfPath(int row, int column)
+{
+  Q_D(qSlicerPathPlannerTableModel);
+  Q_UNUSED(column);
+  vtkSlicerPathPlannerProbeMacro(IdentifyTipOfPathProbe);
+  
+  vtkSlicerPathPlannerTraceMacro("identifyName");
+  
+  vtkSlicerPathPlannerPointStore* store = d->pointStore();
+  if (d->HierarchyNode == 0 || store == 0)
+  {
+    return -1;
+  }
+  
+  // rows are the points of the store
+  if (row < 0 || row >= store->GetNumberOfPoints())
+  {
+    return -1;
+  }
+  return store->GetId(row);
 }
 
+
+//------------------------------------------------------------------------------
 void qSlicerPathPlannerTableModel
-::onMRMLNodeRemovedEvent(vtkObject* caller, vtkObject* callData)
+::checkLabelMap()
 {
   Q_D(qSlicerPathPlannerTableModel);
 
-  vtkMRMLScene* scene = vtkMRMLScene::SafeDownCast(caller);
-  if (scene && d->Scene && scene == d->Scene)
+  if (d->ListType != LABEL_RAS_PATH || !d->Logic)
     {
-    onMRMLChildNodeRemoved(callData);
+    return;
     }
+  // The distance field is computed by the job: collectPathUpdates()
+  // refreshes the rows once the paths are evaluated
+  d->Logic->UpdateAllPathsAsync();
 }
 
+
+//------------------------------------------------------------------------------
 void qSlicerPathPlannerTableModel
-::onMRMLChildNodeValueModified(vtkObject* obj)
+::checkSurfaceModels()
 {
   Q_D(qSlicerPathPlannerTableModel);
 
-  vtkMRMLAnnotationFiducialNode* fnode;
-  fnode = vtkMRMLAnnotationFiducialNode::SafeDownCast(obj);
-  
-  // test
-  std::cout << "onMRMLChildNodeValueModified" << std::endl;
-  std::cout << "this->selectedPathsTableRow = " << this->selectedPathsTableRow << std::endl;
-  //std::cout << "it's enough to add only UpdateTable function here" << std::endl;
-  
-  //this->addPoint(1,1,1);
-  this->updateTable();
-  
-  /*
-  // test code
-  vtkMRMLAnnotationRulerNode* rnode;
-  rnode = vtkMRMLAnnotationRulerNode::SafeDownCast(obj);
-  */
-  // test code
-  if(this->selectedPathsTableRow != RESET)
-  {
-    this->updateRulerTable();
-  }
-  
+  if (d->ListType != LABEL_RAS_PATH || !d->Logic)
+    {
+    return;
+    }
+  // Same for the trees of the surface models
+  d->Logic->UpdateAllPathsAsync();
 }
 
 
 //------------------------------------------------------------------------------
 void qSlicerPathPlannerTableModel
-::identifyTipOfPath(int row, int column)
+::setHighlightedPoints(vtkIdList* pointIds)
 {
   Q_D(qSlicerPathPlannerTableModel);
-  
-  //const char* selectedName;
-  
-  // test code
-  std::cout << "identifyName" << std::endl;  
-  
-  if (d->HierarchyNode == 0)
-  {
-    this->setRowCount(0);
-    
-    return;
-  }
-  
-  d->PendingItemModified = 0;
-  
-  // Count the number of child Fiducial nodes 
-  vtkNew<vtkCollection> collection;
-  d->HierarchyNode->GetDirectChildren(collection.GetPointer());
-  int nItems = collection->GetNumberOfItems();
-  int nFiducials = 0;
-  
-  // flag if time and memo should be refreshed in column 5 and 6
-  if (nItems > this->nItemsPrevious)
-  {
-    this->addRowFlag = 1;
-    this->nItemsPrevious = nItems;
-  }
-  else
-  {
-    this->addRowFlag = 0;    
-    this->nItemsPrevious = nItems;
-  }
-  
-  collection->InitTraversal();
-  
-  /*
-  for (int i = 0; i < nItems; i ++)
-  {
-    vtkMRMLAnnotationFiducialNode* fnode;
-    fnode = vtkMRMLAnnotationFiducialNode::SafeDownCast(collection->GetNextItemAsObject());
-    if (fnode)
+
+  QSet<vtkIdType> ids;
+  vtkIdType nIds = pointIds ? pointIds->GetNumberOfIds() : 0;
+  for (vtkIdType i = 0; i < nIds; i ++)
     {
-      nFiducials ++;
+    ids.insert(pointIds->GetId(i));
     }
-  }
-  this->setRowCount(nFiducials);
-  */
-  
-  collection->InitTraversal();
-  for (int i = 0; i < nItems; i ++)
-  {
-    vtkMRMLAnnotationFiducialNode* fnode;
-    fnode = vtkMRMLAnnotationFiducialNode::SafeDownCast(collection->GetNextItemAsObject());
-    if (fnode)
+  if (ids == d->HighlightedIds)
     {
-      QStandardItem* item = this->invisibleRootItem()->child(i, 0);
-      if (item == NULL)
-      {
-        item = new QStandardItem();
-        this->invisibleRootItem()->setChild(i, 0, item);
-      }
+    return;
+    }
+  d->HighlightedIds = ids;
+  int nRows = this->rowCount();
+  if (nRows > 0)
+    {
+    emit dataChanged(this->index(0, 0), this->index(nRows - 1, this->columnCount() - 1));
+    }
+}
 
-      if(i == row)
-      {
-        this->selectedName = fnode->GetName(); 
-        std::cout << "selectedName = " << this->selectedName << std::endl;  
-      }else
-      {
-        item->setText(fnode->GetName());        
-        std::cout << "item->setText(fnode->GetName()) = " << fnode->GetName() << std::endl;  
-      }
 
-      // ----------
-      for (int j = 0; j < 5; j ++)
-      {
-        QStandardItem* item = this->invisibleRootItem()->child(i, j+1);
-        if (item == NULL)
-        {
-          item = new QStandardItem();
-          this->invisibleRootItem()->setChild(i, j+1, item);
-        }
-        QString str;
-        str.setNum(fnode->GetFiducialCoordinates()[j]);
-        if(j<3)
-        {
-          // test code
-          //QByteArray byteArray(str.toAscii());
-          //this->selectedCoordinate[j] = byteArray.constData();
-          this->selectedCoordinate[i][j] = fnode->GetFiducialCoordinates()[j];
-          //item->setText(str);
-        }
-        else if(j==3)
-        {
-          // time stamp for each row
-          if(i == nItems-1 && this->addRowFlag == 1)
-          {
-            QString timeStamp = QTime::currentTime().toString();
-            QByteArray byteArray(timeStamp.toAscii());
-            const char *timeStampStr = byteArray.constData();
-            
-            // test code
-            this->selectedTime = timeStampStr;
-            //item->setText(timeStampStr);                
-          }
-        }
-        else
-        {
-          // memo column for each row
-          if(i == nItems-1 && this->addRowFlag == 1)
-          {
-            item->setText("");                
-          }else
-          {
-             // write memo column reading part
-          }
-            
-        }
-      }
-      // ----------
-      
+//------------------------------------------------------------------------------
+void qSlicerPathPlannerTableModel
+::calculatePath(int row)
+{
+  Q_D(qSlicerPathPlannerTableModel);
+  vtkSlicerPathPlannerProbeMacro(CalculatePathProbe);
 
+  // the geometry itself is computed by the logic
+  if (d->pathStore() && row >= 0)
+    {
+    d->Logic->UpdatePathGeometry(row);
     }
-  }
-  
 }
 
 
 //------------------------------------------------------------------------------
 void qSlicerPathPlannerTableModel
-::calculatePath(double entryPoint[3], double targetPoint[3], int row)
+::setPathTarget(int row, vtkIdType targetPointId)
 {
   Q_D(qSlicerPathPlannerTableModel);
 
-  double difference[3];
+  vtkSlicerPathPlannerPathStore* paths = d->pathStore();
+  if (!paths || row < 0 || row >= paths->GetNumberOfPaths())
+    {
+    return;
+    }
+  // Keep the previous position: updateRulerTable() sees the end point
+  // move, moves the ruler and evaluates the path in the background
+  double position[3];
+  paths->GetTargetPosition(row, position);
+  paths->SetTarget(row, targetPointId, position);
+  this->updateRulerTable();
+  emit dataChanged(this->index(row, TargetColumn), this->index(row, CostColumn));
+}
+
 
-  // set the tip positions
-  this->selectedTargetPoint[row][0] = targetPoint[0];
-  this->selectedTargetPoint[row][1] = targetPoint[1];
-  this->selectedTargetPoint[row][2] = targetPoint[2];
-  
-  this->selectedEntryPoint[row][0] = entryPoint[0];
-  this->selectedEntryPoint[row][1] = entryPoint[1];
-  this->selectedEntryPoint[row][2] = entryPoint[2];
-    
-  // test code
-  std::cout << "pathDistance row = " << row << std::endl;
-  
-  // calculate distance
-  difference[0] = entryPoint[0] - targetPoint[0];
-  difference[1] = entryPoint[1] - targetPoint[1];
-  difference[2] = entryPoint[2] - targetPoint[2];    
-  
-  this->pathDistance[row] = sqrt(difference[0]*difference[0]+difference[1]*difference[1]+difference[2]*difference[2]);
-    
+//------------------------------------------------------------------------------
+void qSlicerPathPlannerTableModel
+::setPathEntry(int row, vtkIdType entryPointId)
+{
+  Q_D(qSlicerPathPlannerTableModel);
+
+  vtkSlicerPathPlannerPathStore* paths = d->pathStore();
+  if (!paths || row < 0 || row >= paths->GetNumberOfPaths())
+    {
+    return;
+    }
+  // Keep the previous position: updateRulerTable() sees the end point
+  // move, moves the ruler and evaluates the path in the background
+  double position[3];
+  paths->GetEntryPosition(row, position);
+  paths->SetEntry(row, entryPointId, position);
+  this->updateRulerTable();
+  emit dataChanged(this->index(row, TargetColumn), this->index(row, CostColumn));
 }
@@ -23,23 +23,32 @@
 
 #define RESET -1
 
-//#include <QAbstractTableModel>
-#include <QStandardItemModel>
+#include <QAbstractTableModel>
 
 #include <ctkPimpl.h>
 #include <ctkVTKObject.h>
 #include <qdatetime.h>
 
+// VTK includes
+#include <vtkType.h>
+
 #include "qSlicerPathPlannerModuleWidgetsExport.h"
 
+class vtkIdList;
 class vtkObject;
 class vtkMRMLNode;
 class vtkMRMLScene;
+class vtkSlicerPathPlannerLogic;
+class vtkSlicerPathPlannerPathStore;
+class qSlicerPathPlannerUpdateScheduler;
 class qSlicerPathPlannerTableModelPrivate;
 
+/// Table of the entry points, the target points or the paths.
+/// The rows are not stored in the model: data() reads them on demand from
+/// the point and path stores of vtkSlicerPathPlannerLogic, so that only the
+/// rows shown by the view are formatted.
 class Q_SLICER_MODULE_PATHPLANNER_WIDGETS_EXPORT qSlicerPathPlannerTableModel
-//  : public QAbstractTableModel
-  : public QStandardItemModel
+  : public QAbstractTableModel
 {
   Q_OBJECT
   QVTK_OBJECT
@@ -61,8 +70,22 @@ public:
     LABEL_RAS_TARGET = 4,
     LABEL_RAS_PATH = 5,
   };
-  int addRowFlag;
-  int nItemsPrevious;
+  enum Column {
+    NameColumn = 0,
+    RColumn = 1,      // point lists
+    AColumn = 2,
+    SColumn = 3,
+    TargetColumn = 1, // path list
+    EntryColumn = 2,
+    LengthColumn = 3,
+    TimeColumn = 4,
+    MemoColumn = 5,
+    HitsColumn = 6,   // path list
+    ClearanceColumn = 7,
+    ModelsColumn = 8,
+    CostColumn = 9,
+    NumberOfColumns = 10,
+  };
   
   // test code
   int selectedTargetPointItemRow;
@@ -76,45 +99,118 @@ protected:
   qSlicerPathPlannerTableModel(qSlicerPathPlannerTableModelPrivate* pimpl, QObject *parent=0);
 
 public:  
+  virtual int rowCount(const QModelIndex& parent = QModelIndex())const;
+  virtual int columnCount(const QModelIndex& parent = QModelIndex())const;
+  virtual QVariant data(const QModelIndex& index, int role = Qt::DisplayRole)const;
+  virtual bool setData(const QModelIndex& index, const QVariant& value, int role = Qt::EditRole);
+  virtual Qt::ItemFlags flags(const QModelIndex& index)const;
+  virtual QVariant headerData(int section, Qt::Orientation orientation,
+                              int role = Qt::DisplayRole)const;
+
+  /// Scheduler coalescing the refreshes caused by MRML events
+  qSlicerPathPlannerUpdateScheduler* updateScheduler()const;
+
+  /// Logic used to compute the path geometry. Not owned.
+  /// The entry and target lists mirror their annotation hierarchy into the
+  /// entry and target point stores of the logic, the path list mirrors its
+  /// ruler nodes into the path store of the logic.
+  void setLogic(vtkSlicerPathPlannerLogic* logic);
+  vtkSlicerPathPlannerLogic* logic()const;
+
   void setCoordinateLabel(int m); // LABEL_RAS or LABEL_XYZ
   void updateTable();
   void updateRulerTable();
   
-  // test code
-  void identifyTipOfPath(int row, int column);
-  void calculatePath(double entryPoint[3], double targetPoint[3], int row);
-  const char* selectedName;
-  double selectedCoordinate[100][3];
-  double selectedTargetPoint[100][3];
-  double selectedEntryPoint[100][3];
-  
-  const char* selectedTime;
-  //char selectedTargetName;
-  //char selectedEntryName;
+  /// Return the stable ID (in the point store) of the point shown in row.
+  vtkIdType identifyTipOfPath(int row, int column);
+  /// Recompute the geometry of the path shown in row.
+  void calculatePath(int row);
+  /// Check all the paths against the labelmap of the logic (labels hit
+  /// and clearance) in the background, distance field included, and
+  /// refresh the Hits, Clearance and Cost columns once done.
+  /// Call cancelPlanning() before changing the labelmap.
+  void checkLabelMap();
+  /// Same against the surface models of the logic, for the Models and
+  /// Cost columns.
+  void checkSurfaceModels();
+  /// Highlight the rows of the points of the given IDs (e.g. the entry
+  /// points suggested for a target), NULL to clear.
+  void setHighlightedPoints(vtkIdList* pointIds);
+  /// Set an end point of the path shown in row, given its point ID.
+  void setPathTarget(int row, vtkIdType targetPointId);
+  void setPathEntry(int row, vtkIdType entryPointId);
   
   void addPoint(double x, double y, double z);
   void addRuler(void);
+  /// Add one path (-1 for an end point that is not set yet)
+  void addPath(vtkIdType targetPointId, vtkIdType entryPointId);
+  /// Add a batch of (target point ID, entry point ID) paths. The geometry,
+  /// checks and cost of the k-th path are copied from the k-th path of
+  /// evaluatedPaths if not NULL, instead of being computed.
+  void addPaths(const QList< QPair<vtkIdType, vtkIdType> >& targetEntryPairs,
+                vtkSlicerPathPlannerPathStore* evaluatedPaths = 0);
   void initList(int);
-  const char* targetPointName[100];
-  const char* entryPointName[100];
-  double pathDistance[100];
-  int** columItemFlag;
-  int pathColumnCounter;
-  int pathTableExistance;
-  //double pathDistance;
+
+  /// Plan the numberOfPathsPerTarget cheapest paths of each target (every
+  /// feasible path if 0) on a worker thread, from snapshots of the entry
+  /// and target points, and append them to the path list once evaluated
+  /// (see pathsPlanned()). A later request supersedes it: the results of
+  /// out of date generations are dropped. Return the generation number of
+  /// the request, 0 if the model is not a path list.
+  qulonglong planPaths(int numberOfPathsPerTarget);
+  /// Cancel the planPaths() request in progress and drop its results, e.g.
+  /// before the labelmap or the surface models of the logic change, which
+  /// waits for the running jobs.
+  void cancelPlanning();
+  /// Generation of the latest planPaths() request
+  qulonglong planGeneration()const;
+
+  /// Path set display: the paths are drawn by a single model node sharing
+  /// the polydata of vtkSlicerPathPlannerLogic::GetPathSet(), colored by
+  /// cost, and the paths added while the mode is on (e.g. planned paths)
+  /// have no ruler node. Those paths are only drawn while the mode is on;
+  /// the paths that have a ruler are drawn by it. Off by default.
+  void setPathSetDisplay(bool enabled);
+  bool pathSetDisplay()const;
+  /// Highlight the path shown in row in the path set (-1 for none): the
+  /// path set is then colored by selection instead of cost.
+  void setSelectedPath(int row);
+  /// Refresh the path set model in place after the paths changed. Done by
+  /// the model whenever it changes the paths.
+  void updatePathSet();
   
 public slots:
   void setMRMLScene(vtkMRMLScene *newScene);
+  /// Recompute the paths that use the given entry (target) point, in the
+  /// background: the rows are refreshed once the update finished
+  void onEntryPointModified(vtkIdType pointId);
+  void onTargetPointModified(vtkIdType pointId);
+
+signals:
+  /// Emitted by the entry and target lists when the position or the name of
+  /// a point changed
+  void pointModified(vtkIdType pointId);
+
+  /// Emitted once the paths of the given planPaths() request were added
+  void pathsPlanned(qulonglong generation, int numberOfPaths);
+
+  /// Emitted from the worker threads when a planPaths() request (a
+  /// background path update) finished. The model receives them through
+  /// queued connections.
+  void planFinished(qulonglong generation);
+  void pathUpdatesFinished();
 
 protected slots:
   void setNode(vtkMRMLNode* node);
-  void onItemChanged(QStandardItem * item);
-  // test code
-  void onRulerItemChanged(QStandardItem * item);
   void onMRMLChildNodeAdded(vtkObject*);
   void onMRMLChildNodeRemoved(vtkObject*);
   void onMRMLChildNodeValueModified(vtkObject*);
   void onMRMLNodeRemovedEvent(vtkObject*,vtkObject*);
+  void onScheduledUpdate(const QList<vtkIdType>& ids, bool all);
+  /// Show the background path updates that finished
+  void collectPathUpdates();
+  /// Add the paths of a planPaths() request unless it is out of date
+  void onPlanFinished(qulonglong generation);
   
 protected:
   QScopedPointer<qSlicerPathPlannerTableModelPrivate> d_ptr;
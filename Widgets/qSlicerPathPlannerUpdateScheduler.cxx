@@ -0,0 +1,170 @@
+/*==============================================================================
+
+  Program: Path Planner User Interface for 3D Slicer
+
+  Copyright (c) Brigham and Women's Hospital
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+ This file was developed by Atsushi Yamada, Brigham and Women's
+ Hospital. The project was supported by NIH P41EB015898.
+
+==============================================================================*/
+
+// PathPlanner Widgets includes
+#include "qSlicerPathPlannerUpdateScheduler.h"
+
+// Qt includes
+#include <QSet>
+#include <QTimer>
+
+// MRML includes
+#include "vtkMRMLScene.h"
+
+//-----------------------------------------------------------------------------
+class qSlicerPathPlannerUpdateSchedulerPrivate
+{
+public:
+  qSlicerPathPlannerUpdateSchedulerPrivate();
+
+  QTimer Timer;
+  vtkMRMLScene* Scene;
+  QSet<vtkIdType> DirtyIds;
+  bool AllDirty;
+};
+
+//-----------------------------------------------------------------------------
+qSlicerPathPlannerUpdateSchedulerPrivate
+::qSlicerPathPlannerUpdateSchedulerPrivate()
+{
+  this->Scene = NULL;
+  this->AllDirty = false;
+  this->Timer.setSingleShot(true);
+  this->Timer.setInterval(0);
+}
+
+//-----------------------------------------------------------------------------
+qSlicerPathPlannerUpdateScheduler
+::qSlicerPathPlannerUpdateScheduler(QObject* parent)
+  : Superclass(parent)
+  , d_ptr(new qSlicerPathPlannerUpdateSchedulerPrivate)
+{
+  Q_D(qSlicerPathPlannerUpdateScheduler);
+  connect(&d->Timer, SIGNAL(timeout()), this, SLOT(flush()));
+}
+
+//-----------------------------------------------------------------------------
+qSlicerPathPlannerUpdateScheduler
+::~qSlicerPathPlannerUpdateScheduler()
+{
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerPathPlannerUpdateScheduler
+::setInterval(int msec)
+{
+  Q_D(qSlicerPathPlannerUpdateScheduler);
+  d->Timer.setInterval(msec);
+}
+
+//-----------------------------------------------------------------------------
+int qSlicerPathPlannerUpdateScheduler
+::interval()const
+{
+  Q_D(const qSlicerPathPlannerUpdateScheduler);
+  return d->Timer.interval();
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerPathPlannerUpdateScheduler
+::setMRMLScene(vtkMRMLScene* scene)
+{
+  Q_D(qSlicerPathPlannerUpdateScheduler);
+
+  qvtkReconnect(d->Scene, scene,
+                vtkMRMLScene::EndBatchProcessEvent,
+                this, SLOT(onBatchProcessEnded()));
+  d->Scene = scene;
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerPathPlannerUpdateScheduler
+::markDirty(vtkIdType id)
+{
+  Q_D(qSlicerPathPlannerUpdateScheduler);
+
+  if (!d->AllDirty)
+    {
+    d->DirtyIds.insert(id);
+    }
+  if (!d->Timer.isActive() && !this->isBatchProcessing())
+    {
+    d->Timer.start();
+    }
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerPathPlannerUpdateScheduler
+::markAllDirty()
+{
+  Q_D(qSlicerPathPlannerUpdateScheduler);
+
+  d->AllDirty = true;
+  d->DirtyIds.clear();
+  if (!d->Timer.isActive() && !this->isBatchProcessing())
+    {
+    d->Timer.start();
+    }
+}
+
+//-----------------------------------------------------------------------------
+bool qSlicerPathPlannerUpdateScheduler
+::isPending()const
+{
+  Q_D(const qSlicerPathPlannerUpdateScheduler);
+  return d->AllDirty || !d->DirtyIds.isEmpty();
+}
+
+//-----------------------------------------------------------------------------
+bool qSlicerPathPlannerUpdateScheduler
+::isBatchProcessing()const
+{
+  Q_D(const qSlicerPathPlannerUpdateScheduler);
+  return d->Scene && d->Scene->IsBatchProcessing();
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerPathPlannerUpdateScheduler
+::flush()
+{
+  Q_D(qSlicerPathPlannerUpdateScheduler);
+
+  d->Timer.stop();
+  if (!this->isPending() || this->isBatchProcessing())
+    {
+    return;
+    }
+
+  // reset first: the receivers may mark rows dirty again
+  bool all = d->AllDirty;
+  QList<vtkIdType> ids = d->DirtyIds.toList();
+  d->AllDirty = false;
+  d->DirtyIds.clear();
+  emit updateRequested(ids, all);
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerPathPlannerUpdateScheduler
+::onBatchProcessEnded()
+{
+  // The events sent during the batch may be incomplete
+  this->markAllDirty();
+  this->flush();
+}
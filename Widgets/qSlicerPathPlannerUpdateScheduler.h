@@ -0,0 +1,92 @@
+/*==============================================================================
+
+  Program: Path Planner User Interface for 3D Slicer
+
+  Copyright (c) Brigham and Women's Hospital
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+ This file was developed by Atsushi Yamada, Brigham and Women's
+ Hospital. The project was supported by NIH P41EB015898.
+
+==============================================================================*/
+
+#ifndef __qSlicerPathPlannerUpdateScheduler_h
+#define __qSlicerPathPlannerUpdateScheduler_h
+
+// Qt includes
+#include <QObject>
+#include <QList>
+
+#include <ctkPimpl.h>
+#include <ctkVTKObject.h>
+
+// VTK includes
+#include <vtkType.h>
+
+#include "qSlicerPathPlannerModuleWidgetsExport.h"
+
+class vtkMRMLScene;
+class qSlicerPathPlannerUpdateSchedulerPrivate;
+
+/// Collect the rows made dirty by a burst of MRML events and flush them in
+/// one go, at the next event-loop iteration (or after interval() ms).
+/// Nothing is flushed while the scene is batch processing: the whole table
+/// is flushed once when the batch ends.
+class Q_SLICER_MODULE_PATHPLANNER_WIDGETS_EXPORT qSlicerPathPlannerUpdateScheduler
+  : public QObject
+{
+  Q_OBJECT
+  QVTK_OBJECT
+
+public:
+  typedef QObject Superclass;
+  qSlicerPathPlannerUpdateScheduler(QObject *parent=0);
+  virtual ~qSlicerPathPlannerUpdateScheduler();
+
+  /// Delay between the first dirty row and the flush, in ms. 0 (default)
+  /// flushes at the next event-loop iteration, 16 about once per frame.
+  void setInterval(int msec);
+  int interval()const;
+
+  /// Scene whose batch processing state is honored
+  void setMRMLScene(vtkMRMLScene* scene);
+
+  /// Mark the row of the given point (path) ID dirty
+  void markDirty(vtkIdType id);
+  /// Mark the whole table dirty
+  void markAllDirty();
+
+  /// Return true if a flush is pending
+  bool isPending()const;
+  /// Return true if the scene is batch processing
+  bool isBatchProcessing()const;
+
+public slots:
+  /// Emit the pending updates now (unless the scene is batch processing)
+  void flush();
+
+signals:
+  /// Rows to update. all is true if the whole table must be synchronized,
+  /// ids is empty then.
+  void updateRequested(const QList<vtkIdType>& ids, bool all);
+
+protected slots:
+  void onBatchProcessEnded();
+
+protected:
+  QScopedPointer<qSlicerPathPlannerUpdateSchedulerPrivate> d_ptr;
+
+private:
+  Q_DECLARE_PRIVATE(qSlicerPathPlannerUpdateScheduler);
+  Q_DISABLE_COPY(qSlicerPathPlannerUpdateScheduler);
+};
+
+#endif